@@ -0,0 +1,423 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/thread.hpp>
+
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "core/misc/defines.h"
+#include "core/misc/rundata.h"
+
+#include "chi2mappointfitter.h"
+
+#include "chi2mapgenerator.h"
+
+Chi2MapSettings::Chi2MapSettings() :
+    x_parameter(0),
+    y_parameter(1),
+    x_min(0.),
+    x_max(1.),
+    y_min(0.),
+    y_max(1.),
+    width(64),
+    height(64),
+    n_threads(0),
+    max_maps_in_memory(0)
+{
+}
+
+double Chi2Map::GetX(int i) const
+{
+    return GridPoint(x_min, x_max, chi2_values.rows(), i);
+}
+
+double Chi2Map::GetY(int j) const
+{
+    return GridPoint(y_min, y_max, chi2_values.cols(), j);
+}
+
+double Chi2Map::GridPoint(double min, double max, int n, int i)
+{
+    return min + i * (max - min) / n;
+}
+
+namespace
+{
+//! Karte, deren Spalten noch berechnet werden.
+struct ActiveMap
+{
+    Chi2Map map;
+    int columns_left;
+};
+
+//! Kennung einer Zellkante: waagrecht von (i, j) nach (i + 1, j) oder senkrecht nach (i, j + 1).
+typedef long long EdgeId;
+
+EdgeId HorizontalEdge(int i, int j, int height)
+{
+    return 2 * (EdgeId(i) * height + j);
+}
+
+EdgeId VerticalEdge(int i, int j, int height)
+{
+    return 2 * (EdgeId(i) * height + j) + 1;
+}
+
+//! Strecke einer Höhenlinie innerhalb einer Zelle.
+struct Segment
+{
+    EdgeId edges[2];
+};
+}
+
+struct Chi2MapGenerator::SharedState
+{
+    const RunData* concentrations;
+    std::vector<std::string> sample_names;
+    const std::vector<FitConfiguration>* fit_configurations;
+    MapProcessor processor;
+    unsigned max_maps;
+
+    boost::mutex mutex;
+    boost::condition_variable map_released;
+    unsigned next_map;
+    int next_column;
+    //! Nach Index der Konfiguration. Die Elemente bleiben beim Einfügen und Löschen an ihrem Platz.
+    std::map<unsigned, ActiveMap> active_maps;
+
+    boost::mutex processor_mutex;
+
+    //! Erste Ausnahme eines Threads, wird nach dem Ende aller Threads weitergeworfen.
+    std::exception_ptr error;
+};
+
+Chi2MapGenerator::Chi2MapGenerator(const Chi2MapSettings& settings) :
+    settings_(settings)
+{
+    if (settings.width < 2 || settings.height < 2)
+        throw std::invalid_argument("Chi2 map needs at least two points per axis");
+    if (!(settings.x_min < settings.x_max) || !(settings.y_min < settings.y_max))
+        throw std::invalid_argument("Invalid chi2 map range");
+}
+
+void Chi2MapGenerator::Generate(
+        const RunData& concentrations,
+        const std::vector<FitConfiguration>& fit_configurations,
+        MapProcessor processor) const
+{
+    for (const FitConfiguration& config : fit_configurations)
+    {
+        const int n_parameters = config.fit_parameter_config.size();
+        if (settings_.x_parameter < 0 || settings_.x_parameter >= n_parameters ||
+            settings_.y_parameter < 0 || settings_.y_parameter >= n_parameters ||
+            settings_.x_parameter == settings_.y_parameter)
+            throw std::invalid_argument("Parameter indices equal or too high");
+    }
+
+    SharedState state;
+    state.concentrations = &concentrations;
+    state.sample_names = concentrations.GetEnabledSampleNames();
+    state.fit_configurations = &fit_configurations;
+    state.processor = processor;
+    state.next_map = 0;
+    state.next_column = 0;
+
+    unsigned n_threads = settings_.n_threads;
+    if (n_threads == 0) n_threads = boost::thread::hardware_concurrency();
+    if (n_threads == 0) n_threads = 1;
+    state.max_maps = settings_.max_maps_in_memory ? settings_.max_maps_in_memory :
+                                                    n_threads + 1;
+
+    boost::thread_group threads;
+    try
+    {
+        for (unsigned l = 1; l < n_threads; ++l)
+            threads.create_thread(std::bind(&Chi2MapGenerator::PerformJobs,
+                                            this,
+                                            std::ref(state)));
+        PerformJobs(state);
+        threads.join_all();
+    }
+    catch (...)
+    {
+        threads.interrupt_all();
+        threads.join_all();
+        throw;
+    }
+
+    if (state.error)
+        std::rethrow_exception(state.error);
+}
+
+noble_align_function void Chi2MapGenerator::PerformJobs(SharedState& state) const
+{
+    try
+    {
+        PerformJobsUntilDone(state);
+    }
+    catch (...)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(state.mutex);
+            if (!state.error)
+                state.error = std::current_exception();
+            // Keine weiteren Spalten vergeben.
+            state.next_map = state.fit_configurations->size();
+        }
+        state.map_released.notify_all();
+    }
+}
+
+noble_align_function void Chi2MapGenerator::PerformJobsUntilDone(SharedState& state) const
+{
+    const std::vector<FitConfiguration>& configurations = *state.fit_configurations;
+    const int width = settings_.width;
+    const int height = settings_.height;
+
+    // Wird nur bei einem Wechsel der Probe neu aufgebaut.
+    unsigned fitter_index = configurations.size();
+    std::unique_ptr<Chi2MapPointFitter> fitter;
+
+    while (true)
+    {
+        unsigned index;
+        int column;
+        ActiveMap* active;
+        {
+            boost::unique_lock<boost::mutex> lock(state.mutex);
+            while (true)
+            {
+                if (state.next_map >= configurations.size())
+                    return;
+                // Eine neue Karte erst anlegen, wenn eine fertige freigegeben wurde.
+                if (state.next_column > 0 || state.active_maps.size() < state.max_maps)
+                    break;
+                state.map_released.wait(lock);
+            }
+
+            index = state.next_map;
+            column = state.next_column;
+            if (column == 0)
+            {
+                ActiveMap& new_map = state.active_maps[index];
+                new_map.map.index = index;
+                const std::vector<unsigned>& samples = configurations[index].sample_numbers;
+                if (samples.size() == 1 && samples[0] < state.sample_names.size())
+                    new_map.map.sample_name = state.sample_names[samples[0]];
+                new_map.map.x_min = settings_.x_min;
+                new_map.map.x_max = settings_.x_max;
+                new_map.map.y_min = settings_.y_min;
+                new_map.map.y_max = settings_.y_max;
+                new_map.map.chi2_values.setConstant(
+                        width, height, std::numeric_limits<double>::quiet_NaN());
+                new_map.columns_left = width;
+            }
+            active = &state.active_maps[index];
+            if (++state.next_column == width)
+            {
+                state.next_column = 0;
+                ++state.next_map;
+            }
+        }
+
+        if (index != fitter_index)
+        {
+            fitter.reset(new Chi2MapPointFitter(configurations[index],
+                                                *state.concentrations,
+                                                settings_.x_parameter,
+                                                settings_.y_parameter));
+            // Gespeichert wird nur χ².
+            fitter->SetResultsRequest(ResultsRequest());
+            fitter->SetGrid(settings_.x_min, settings_.x_max, width,
+                            settings_.y_min, settings_.y_max, height);
+            fitter_index = index;
+        }
+
+        Chi2Map& map = active->map;
+        Eigen::VectorXd start_values;
+        for (int j = 0; j < height; ++j)
+        {
+            std::shared_ptr<FitResults> results = fitter->Fit(column, j, start_values);
+            // Jede Spalte wird von genau einem Thread beschrieben.
+            map.chi2_values(column, j) = results->chi_square;
+            // Benachbarte Punkte liegen meist nahe beieinander.
+            if (Chi2MapPointFitter::IsConverged(results->exit_flag, results->chi_square))
+                start_values = results->best_estimate;
+            else
+                start_values.resize(0);
+
+            boost::this_thread::interruption_point();
+        }
+
+        bool finished;
+        {
+            boost::lock_guard<boost::mutex> lock(state.mutex);
+            // Nach einem Fehler in einem anderen Thread wird keine Karte mehr übergeben.
+            if (state.error)
+                return;
+            finished = --active->columns_left == 0;
+        }
+        if (!finished)
+            continue;
+
+        // Alle Spalten sind fertig, niemand sonst greift mehr auf die Karte zu.
+        {
+            boost::lock_guard<boost::mutex> lock(state.processor_mutex);
+            state.processor(map);
+        }
+        {
+            boost::lock_guard<boost::mutex> lock(state.mutex);
+            state.active_maps.erase(index);
+        }
+        state.map_released.notify_all();
+    }
+}
+
+std::vector<ContourLine> Chi2MapGenerator::FindContours(
+        const Chi2Map& map,
+        const std::vector<double>& delta_chi_squares)
+{
+    const Eigen::MatrixXd& values = map.chi2_values;
+    const int width = values.rows();
+    const int height = values.cols();
+
+    double chi2_min = std::numeric_limits<double>::quiet_NaN();
+    for (int i = 0; i < width; ++i)
+        for (int j = 0; j < height; ++j)
+            if (std::isfinite(values(i, j)) && !(chi2_min <= values(i, j)))
+                chi2_min = values(i, j);
+
+    std::vector<ContourLine> lines;
+    if (!std::isfinite(chi2_min))
+        return lines;
+
+    for (double delta : delta_chi_squares)
+    {
+        const double level = chi2_min + delta;
+
+        std::unordered_map<EdgeId, std::pair<double, double>> crossings;
+        auto add_crossing = [&](EdgeId edge, int i1, int j1, int i2, int j2) -> bool
+        {
+            const double v1 = values(i1, j1);
+            const double v2 = values(i2, j2);
+            if ((v1 < level) == (v2 < level))
+                return false;
+            const double t = (level - v1) / (v2 - v1);
+            crossings[edge] = std::make_pair(
+                    map.GetX(i1) + t * (map.GetX(i2) - map.GetX(i1)),
+                    map.GetY(j1) + t * (map.GetY(j2) - map.GetY(j1)));
+            return true;
+        };
+
+        std::vector<Segment> segments;
+        for (int i = 0; i + 1 < width; ++i)
+            for (int j = 0; j + 1 < height; ++j)
+            {
+                const double a = values(i, j);
+                const double b = values(i + 1, j);
+                const double c = values(i + 1, j + 1);
+                const double d = values(i, j + 1);
+                if (!std::isfinite(a) || !std::isfinite(b) ||
+                    !std::isfinite(c) || !std::isfinite(d))
+                    continue;
+
+                // Kanten gegen den Uhrzeigersinn, beginnend unten.
+                const EdgeId bottom = HorizontalEdge(i, j, height);
+                const EdgeId right = VerticalEdge(i + 1, j, height);
+                const EdgeId top = HorizontalEdge(i, j + 1, height);
+                const EdgeId left = VerticalEdge(i, j, height);
+                std::vector<EdgeId> crossed;
+                if (add_crossing(bottom, i, j, i + 1, j)) crossed.push_back(bottom);
+                if (add_crossing(right, i + 1, j, i + 1, j + 1)) crossed.push_back(right);
+                if (add_crossing(top, i, j + 1, i + 1, j + 1)) crossed.push_back(top);
+                if (add_crossing(left, i, j, i, j + 1)) crossed.push_back(left);
+
+                if (crossed.size() == 2)
+                {
+                    segments.push_back(Segment{{crossed[0], crossed[1]}});
+                }
+                else if (crossed.size() == 4)
+                {
+                    // Sattelpunkt: Der Mittelwert entscheidet, ob die Ecken a
+                    // und c über die Zellmitte verbunden sind.
+                    const bool center_below = (a + b + c + d) / 4. < level;
+                    if (center_below == (a < level))
+                    {
+                        segments.push_back(Segment{{bottom, right}});
+                        segments.push_back(Segment{{top, left}});
+                    }
+                    else
+                    {
+                        segments.push_back(Segment{{left, bottom}});
+                        segments.push_back(Segment{{right, top}});
+                    }
+                }
+            }
+
+        // Jede Kante gehört zu höchstens zwei Strecken.
+        std::unordered_map<EdgeId, std::vector<unsigned>> segments_at_edge;
+        for (unsigned s = 0; s < segments.size(); ++s)
+            for (EdgeId edge : segments[s].edges)
+                segments_at_edge[edge].push_back(s);
+
+        std::vector<bool> used(segments.size(), false);
+        auto trace = [&](unsigned first, EdgeId start)
+        {
+            ContourLine line;
+            line.delta_chi_square = delta;
+            line.points.push_back(crossings[start]);
+            unsigned s = first;
+            EdgeId edge = start;
+            while (true)
+            {
+                used[s] = true;
+                edge = segments[s].edges[0] == edge ? segments[s].edges[1] :
+                                                      segments[s].edges[0];
+                line.points.push_back(crossings[edge]);
+                bool found = false;
+                for (unsigned next : segments_at_edge[edge])
+                    if (!used[next])
+                    {
+                        s = next;
+                        found = true;
+                        break;
+                    }
+                if (!found)
+                    break;
+            }
+            lines.push_back(line);
+        };
+
+        // Zuerst die offenen Linien von einem ihrer Enden aus, dann die geschlossenen.
+        for (unsigned s = 0; s < segments.size(); ++s)
+            for (EdgeId edge : segments[s].edges)
+                if (!used[s] && segments_at_edge[edge].size() == 1)
+                    trace(s, edge);
+        for (unsigned s = 0; s < segments.size(); ++s)
+            if (!used[s])
+                trace(s, segments[s].edges[0]);
+    }
+    return lines;
+}
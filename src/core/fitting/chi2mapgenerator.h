@@ -0,0 +1,159 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CHI2MAPGENERATOR_H
+#define CHI2MAPGENERATOR_H
+
+#include <Eigen/Core>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fitconfiguration.h"
+
+class RunData;
+
+//! Einstellungen für Chi2MapGenerator.
+struct Chi2MapSettings
+{
+    Chi2MapSettings();
+
+    //! Indizes der Achsenparameter in der Fitkonfiguration.
+    int x_parameter;
+    int y_parameter;
+
+    //! Abgetasteter Bereich, die oberen Grenzen ausgeschlossen (siehe Chi2Map::GridPoint).
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+
+    //! Zahl der Punkte je Achse, jeweils mindestens zwei.
+    int width;
+    int height;
+
+    //! Zahl der Threads, 0 verwendet alle verfügbaren Prozessorkerne.
+    unsigned n_threads;
+
+    //! Höchstzahl gleichzeitig gehaltener Karten, 0 für eine mehr als Threads.
+    unsigned max_maps_in_memory;
+};
+
+//! χ²-Karte einer Probe.
+struct Chi2Map
+{
+    //! Index der Fitkonfiguration, aus der die Karte berechnet wurde.
+    unsigned index;
+
+    std::string sample_name;
+
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+
+    //! \brief Über die übrigen Parameter minimiertes χ², NaN wo der Fit
+    //! fehlschlug. Der Punkt (i, j) liegt bei GetX(i), GetY(j).
+    Eigen::MatrixXd chi2_values;
+
+    double GetX(int i) const;
+    double GetY(int j) const;
+
+    //! Gibt den Punkt i eines Gitters aus n Punkten im Bereich [min, max) zurück.
+    /*!
+     * Jeder Punkt liegt am linken Rand einer von n gleich breiten Zellen, max selbst wird
+     * nicht abgetastet. ContourPlotFitter verwendet dasselbe Gitter, sodass die Karten für
+     * denselben Bereich und dieselbe Rasterung mit denen des Chi2-Explorers übereinstimmen.
+     */
+    static double GridPoint(double min, double max, int n, int i);
+};
+
+//! Höhenlinie einer χ²-Karte.
+struct ContourLine
+{
+    //! Abstand zum kleinsten χ² der Karte.
+    double delta_chi_square;
+
+    //! Punkte (x, y) der Linie. Geschlossene Linien enden mit ihrem ersten Punkt.
+    std::vector<std::pair<double, double>> points;
+};
+
+//! Berechnet χ²-Karten für viele Proben ohne Benutzeroberfläche.
+/*!
+  Wie im Konturplot werden die beiden Achsenparameter auf den Rasterpunkten
+  festgehalten und die übrigen gefittet. Aufträge sind einzelne Spalten einer
+  Karte; innerhalb einer Spalte startet jeder Fit beim Ergebnis des
+  vorherigen. Die Spalten aller Proben werden der Reihe nach an die Threads
+  vergeben, sodass auch wenige Proben alle Kerne auslasten. Eine Karte wird
+  übergeben und freigegeben, sobald ihre letzte Spalte fertig ist. Es werden
+  nie mehr als Chi2MapSettings::max_maps_in_memory Karten gleichzeitig
+  gehalten, der Speicherbedarf hängt daher nicht von der Zahl der Proben ab.
+  */
+class Chi2MapGenerator
+{
+public:
+    //! Wird für jede fertige Karte aufgerufen, nie gleichzeitig.
+    typedef std::function<void(const Chi2Map& map)> MapProcessor;
+
+    //! Konstruktor.
+    /*!
+      \throws std::invalid_argument Falls Raster oder Bereich ungültig sind.
+      */
+    explicit Chi2MapGenerator(const Chi2MapSettings& settings);
+
+    //! Berechnet die Karten.
+    /*!
+      \param concentrations Messdaten aller Proben.
+      \param fit_configurations Eine Konfiguration je Probe, wie sie DefaultFitter verwendet.
+      \param processor Erhält die fertigen Karten, nicht notwendigerweise in
+        der Reihenfolge der Konfigurationen.
+      \throws std::invalid_argument Falls die Achsenparameter nicht zu den
+        Konfigurationen passen.
+      \throws Ausnahmen der Fits und von \a processor, auch aus anderen Threads.
+      */
+    void Generate(const RunData& concentrations,
+                  const std::vector<FitConfiguration>& fit_configurations,
+                  MapProcessor processor) const;
+
+    //! Bestimmt die Höhenlinien einer Karte (Marching Squares).
+    /*!
+      Werte werden entlang der Zellkanten linear interpoliert. Zellen mit
+      NaN-Ecken werden übersprungen, Linien enden dann dort.
+      \param delta_chi_squares Abstände der Linien zum kleinsten χ² der Karte.
+      */
+    static std::vector<ContourLine> FindContours(
+            const Chi2Map& map,
+            const std::vector<double>& delta_chi_squares);
+
+private:
+    struct SharedState;
+
+    //! Arbeitet Spalten ab, bis keine mehr übrig sind.
+    /*!
+      Ausnahmen werden in state gespeichert und beenden die Vergabe weiterer Spalten.
+      */
+    void PerformJobs(SharedState& state) const;
+
+    void PerformJobsUntilDone(SharedState& state) const;
+
+    Chi2MapSettings settings_;
+};
+
+#endif // CHI2MAPGENERATOR_H
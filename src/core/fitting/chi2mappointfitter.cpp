@@ -0,0 +1,151 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "core/misc/rundata.h"
+
+#include "chi2mapgenerator.h"
+#include "levenbergmarquardtfitter.h"
+#include "noblefitfunction.h"
+
+#include "chi2mappointfitter.h"
+
+Chi2MapPointFitter::Chi2MapPointFitter(
+        const FitConfiguration& config,
+        const RunData& concentrations,
+        int x_parameter,
+        int y_parameter,
+        const std::vector<std::pair<int, double>>& fixed_parameters) :
+    function_(std::make_shared<NobleFitFunction>(config.model,
+                                                 *config.GetParameterMap(),
+                                                 concentrations,
+                                                 config.sample_numbers)),
+    pconf_(std::make_shared<FitParameterConfig>(config.fit_parameter_config)),
+    x_min_(0.),
+    x_max_(1.),
+    width_(1),
+    y_min_(0.),
+    y_max_(1.),
+    height_(1)
+{
+    fitter_ = std::make_shared<LevenbergMarquardtFitter>(function_);
+
+    parameters_.push_back(std::make_pair(x_parameter, 0.));
+    parameters_.push_back(std::make_pair(y_parameter, 0.));
+    std::copy_if(fixed_parameters.cbegin(),
+                 fixed_parameters.cend(),
+                 std::back_inserter(parameters_),
+                 [&](const std::pair<int, double>& p)
+                 {
+                     return p.first != x_parameter &&
+                            p.first != y_parameter;
+                 });
+
+    // Von hinten entfernen, damit die Indizes der übrigen gültig bleiben.
+    std::vector<int> parameters_to_remove;
+    for (const auto& parameter : parameters_)
+        parameters_to_remove.push_back(parameter.first);
+    std::sort(parameters_to_remove.begin(),
+              parameters_to_remove.end(),
+              std::greater<int>());
+    parameters_to_remove.erase(std::unique(parameters_to_remove.begin(),
+                                           parameters_to_remove.end()),
+                               parameters_to_remove.end());
+    for (int parameter : parameters_to_remove)
+        pconf_->RemoveParameter(parameter);
+    initials_ = pconf_->initials();
+}
+
+Chi2MapPointFitter::Chi2MapPointFitter(const Chi2MapPointFitter& other) :
+    fitter_(other.fitter_->clone()),
+    function_(fitter_->GetFitFunction()),
+    pconf_(std::make_shared<FitParameterConfig>(*other.pconf_)),
+    initials_(other.initials_),
+    parameters_(other.parameters_),
+    x_min_(other.x_min_),
+    x_max_(other.x_max_),
+    width_(other.width_),
+    y_min_(other.y_min_),
+    y_max_(other.y_max_),
+    height_(other.height_)
+{
+}
+
+void Chi2MapPointFitter::SetResultsRequest(const ResultsRequest& request)
+{
+    fitter_->SetResultsRequest(request);
+}
+
+void Chi2MapPointFitter::SetGrid(double x_min, double x_max, int width,
+                                 double y_min, double y_max, int height)
+{
+    x_min_ = x_min;
+    x_max_ = x_max;
+    width_ = width;
+    y_min_ = y_min;
+    y_max_ = y_max;
+    height_ = height;
+}
+
+double Chi2MapPointFitter::GetX(int i) const
+{
+    return Chi2Map::GridPoint(x_min_, x_max_, width_, i);
+}
+
+double Chi2MapPointFitter::GetY(int j) const
+{
+    return Chi2Map::GridPoint(y_min_, y_max_, height_, j);
+}
+
+std::shared_ptr<FitResults> Chi2MapPointFitter::Fit(int i,
+                                                    int j,
+                                                    const Eigen::VectorXd& start_values)
+{
+    return FitAt(GetX(i), GetY(j), start_values);
+}
+
+std::shared_ptr<FitResults> Chi2MapPointFitter::FitAt(double x,
+                                                      double y,
+                                                      const Eigen::VectorXd& start_values)
+{
+    parameters_[0].second = x;
+    parameters_[1].second = y;
+    function_->FixParameters(parameters_);
+
+    const Eigen::VectorXd& initials =
+            start_values.size() == int(pconf_->size()) ? start_values : initials_;
+    for (unsigned k = 0; k < pconf_->size(); ++k)
+        pconf_->ChangeParameterInitial(k, initials(k));
+
+    return fitter_->fit(pconf_);
+}
+
+const FitParameterConfig& Chi2MapPointFitter::GetParameterConfig() const
+{
+    return *pconf_;
+}
+
+bool Chi2MapPointFitter::IsConverged(Eigen::LM::Status exit_flag, double chi_square)
+{
+    return exit_flag >= Eigen::LM::RelativeReductionTooSmall &&
+           exit_flag <= Eigen::LM::CosinusTooSmall &&
+           std::isfinite(chi_square);
+}
@@ -0,0 +1,110 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CHI2MAPPOINTFITTER_H
+#define CHI2MAPPOINTFITTER_H
+
+#include <Eigen/Core>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "eigen_lm_includes.h"
+#include "fitconfiguration.h"
+#include "fitresults.h"
+#include "resultsrequest.h"
+
+class LevenbergMarquardtFitter;
+class NobleFitFunction;
+class RunData;
+
+//! Fittet einzelne Punkte einer χ²-Karte.
+/*!
+  Die beiden Achsenparameter und gegebenenfalls weitere Parameter werden
+  festgehalten, die übrigen gefittet. Die Achsenparameter liegen auf einem
+  Gitter aus Chi2Map::GridPoint. Konturplot und Batch-Erzeugung der Karten
+  verwenden diese Klasse, damit Punkte für denselben Bereich und dieselbe
+  Rasterung übereinstimmen.
+
+  Ein Objekt darf nur von einem Thread verwendet werden. Kopien besitzen
+  einen eigenen Fitter und können in anderen Threads arbeiten.
+  */
+class Chi2MapPointFitter
+{
+public:
+    //! Konstruktor.
+    /*!
+      \param config Fitkonfiguration einer Probe, wie sie DefaultFitter verwendet.
+      \param concentrations Messdaten aller Proben.
+      \param x_parameter, y_parameter Indizes der Achsenparameter in der Fitkonfiguration.
+      \param fixed_parameters Weitere festgehaltene Parameter mit ihren Werten.
+      */
+    Chi2MapPointFitter(const FitConfiguration& config,
+                       const RunData& concentrations,
+                       int x_parameter,
+                       int y_parameter,
+                       const std::vector<std::pair<int, double>>& fixed_parameters =
+                           std::vector<std::pair<int, double>>());
+
+    Chi2MapPointFitter(const Chi2MapPointFitter& other);
+
+    //! Legt die zu berechnenden Ergebnisgrößen fest, standardmäßig alle.
+    void SetResultsRequest(const ResultsRequest& request);
+
+    //! Legt das Gitter fest, die oberen Grenzen ausgeschlossen.
+    void SetGrid(double x_min, double x_max, int width,
+                 double y_min, double y_max, int height);
+
+    double GetX(int i) const;
+    double GetY(int j) const;
+
+    //! Fittet den Gitterpunkt (i, j).
+    /*!
+      \param start_values Startwerte der gefitteten Parameter, leer für die
+        der Fitkonfiguration.
+      */
+    std::shared_ptr<FitResults> Fit(int i, int j, const Eigen::VectorXd& start_values);
+
+    //! Fittet mit den Achsenparametern bei x und y, auch abseits des Gitters.
+    std::shared_ptr<FitResults> FitAt(double x, double y, const Eigen::VectorXd& start_values);
+
+    //! Konfiguration der gefitteten Parameter.
+    const FitParameterConfig& GetParameterConfig() const;
+
+    //! Gibt an, ob ein Fit konvergiert ist und als Startwert für Nachbarpunkte taugt.
+    static bool IsConverged(Eigen::LM::Status exit_flag, double chi_square);
+
+private:
+    std::shared_ptr<LevenbergMarquardtFitter> fitter_;
+    std::shared_ptr<NobleFitFunction> function_;
+    std::shared_ptr<FitParameterConfig> pconf_;
+    Eigen::VectorXd initials_;
+
+    //! Festgehaltene Parameter, die beiden Achsenparameter zuerst.
+    std::vector<std::pair<int, double>> parameters_;
+
+    double x_min_;
+    double x_max_;
+    int width_;
+    double y_min_;
+    double y_max_;
+    int height_;
+};
+
+#endif // CHI2MAPPOINTFITTER_H
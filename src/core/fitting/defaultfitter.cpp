@@ -16,9 +16,13 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
+
 #include "core/misc/defines.h"
 
+#include "fitresultspool.h"
 #include "levenbergmarquardtfitter.h"
+#include "multistartfitter.h"
 #include "noblefitfunction.h"
 #include "montecarlocontroller.h"
 #include "randomnumberbuffer.h"
@@ -54,13 +58,11 @@ void DefaultFitter::Fit()
     
     std::vector<std::shared_ptr<FitResults>> results(n_samples);
 
-    std::vector<SampleConcentrations> concentrations(
-            concentrations_.concentrations_begin(),
-            concentrations_.concentrations_end());
     std::vector<std::string> sample_names = concentrations_.GetEnabledSampleNames();
     
     std::vector<std::vector<SampleConcentrations>> concentrations_used_by_fits(n_samples);
     std::vector<std::vector<std::string>> samples_used_by_fits(n_samples);
+    std::vector<std::shared_ptr<const NobleFitFunction>> functions(n_samples);
 
     boost::mutex mutex;
     boost::thread_group threads;
@@ -70,10 +72,10 @@ void DefaultFitter::Fit()
                                         this,
                                         std::ref(mutex),
                                         std::ref(counter),
-                                        std::cref(concentrations),
                                         std::cref(sample_names),
                                         std::ref(samples_used_by_fits),
                                         std::ref(concentrations_used_by_fits),
+                                        std::ref(functions),
                                         std::ref(results)));
         threads.join_all();
 
@@ -82,7 +84,7 @@ void DefaultFitter::Fit()
                                           samples_used_by_fits[i],
                                           fit_configurations_[i].
                                               fit_parameter_config.names(),
-                                          concentrations);
+                                          concentrations_used_by_fits[i]);
                                   
     unsigned long n_fits = 0UL;
     std::vector<unsigned long> n_monte_carlos(n_samples);
@@ -95,6 +97,11 @@ void DefaultFitter::Fit()
         MonteCarloController controller(n_monte_carlos);
         RandomNumberGenerator random_number_generator(
                 static_cast<unsigned>(std::time(0)));
+        const ResultsRequest request(
+                results_processor_->GetMonteCarloResultsRequest());
+        // Die Ergebnisse werden direkt nach der Verarbeitung verworfen und können daher
+        // für die folgenden Fits wiederverwendet werden.
+        std::shared_ptr<FitResultsPool> results_pool(std::make_shared<FitResultsPool>());
 
         boost::thread_group worker_threads;
 
@@ -104,7 +111,9 @@ void DefaultFitter::Fit()
                                   this,
                                   std::ref(controller),
                                   std::ref(random_number_generator),
-                                  std::ref(concentrations_used_by_fits)));
+                                  std::cref(functions),
+                                  std::cref(request),
+                                  results_pool));
         try
         {
             try
@@ -120,7 +129,7 @@ void DefaultFitter::Fit()
                         samples_used_by_fits[monte_carlo_result.first],
                         fit_configurations_[monte_carlo_result.first].
                                 fit_parameter_config.names(),
-                        concentrations);
+                        concentrations_used_by_fits[monte_carlo_result.first]);
                 }
             }
             catch(MonteCarloController::NoResultsLeft)
@@ -141,10 +150,10 @@ void DefaultFitter::Fit()
 noble_align_function void DefaultFitter::PerformFits(
         boost::mutex& mutex,
         unsigned& counter,
-        const std::vector<SampleConcentrations>& concentrations,
         const std::vector<std::string>& sample_names,
         std::vector<std::vector<std::string>>& samples_used_by_fits,
         std::vector<std::vector<SampleConcentrations>>& concentrations_used_by_fits,
+        std::vector<std::shared_ptr<const NobleFitFunction>>& functions,
         std::vector<std::shared_ptr<FitResults>>& results) const
 {
     unsigned n_samples = fit_configurations_.size();
@@ -163,9 +172,12 @@ noble_align_function void DefaultFitter::PerformFits(
         std::vector<std::string>& samples_used_by_fit =
                 samples_used_by_fits[i];
 
+        // Die Maps werden nur für die Schnittstelle von FitResultsProcessor einmal je Fit
+        // angelegt; die Fitfunktion liest die Spalten von concentrations_ direkt.
         for (auto j : config.sample_numbers)
         {
-            concentrations_used_by_fit.push_back(concentrations[j]);
+            concentrations_used_by_fit.push_back(concentrations_.GetSampleConcentrations(
+                    concentrations_.GetIndexOfEnabledSample(j)));
             samples_used_by_fit.push_back(sample_names[j]);
         }
 
@@ -173,14 +185,40 @@ noble_align_function void DefaultFitter::PerformFits(
                 std::make_shared<NobleFitFunction>(
                     config.model,
                     *config.GetParameterMap(),
-                    concentrations_used_by_fit));
+                    concentrations_,
+                    config.sample_numbers));
+        functions[i] = function;
 
-        LevenbergMarquardtFitter fitter(function);
+        std::shared_ptr<LevenbergMarquardtFitter> fitter(
+                std::make_shared<LevenbergMarquardtFitter>(function));
 
-        std::shared_ptr<FitResults> results_of_single_fit(
-                std::dynamic_pointer_cast<FitResults>(
-                    fitter.fit(std::make_shared<FitParameterConfig>(
-                        config.fit_parameter_config))));
+        std::shared_ptr<FitResults> results_of_single_fit;
+        if (config.multi_start_settings.n_starts > 1)
+        {
+            // Die Proben werden bereits parallel gefittet, daher nur die übrigen Kerne verwenden.
+            MultiStartSettings settings(config.multi_start_settings);
+            if (settings.n_threads == 0)
+                settings.n_threads =
+                        std::max(1u, boost::thread::hardware_concurrency() / n_samples);
+
+            MultiStartFitter multi_start_fitter(fitter, settings);
+            const MultiStartResults multi_start_results = multi_start_fitter.fit(
+                    std::make_shared<FitParameterConfig>(config.fit_parameter_config));
+            results_of_single_fit = multi_start_results.best;
+
+            // Die weiteren Minima werden mit dem Ergebnis angezeigt.
+            for (const auto& minimum : multi_start_results.local_minima)
+                results_of_single_fit->local_minima.push_back(
+                        LocalMinimum{minimum->chi_square, minimum->best_estimate});
+            results_of_single_fit->n_starts_completed = multi_start_results.n_completed;
+            results_of_single_fit->n_starts_pruned = multi_start_results.n_pruned;
+            results_of_single_fit->n_starts_skipped = multi_start_results.n_skipped;
+        }
+        else
+        {
+            results_of_single_fit = fitter->fit(std::make_shared<FitParameterConfig>(
+                        config.fit_parameter_config));
+        }
 
         assert(results_of_single_fit);
 
@@ -191,7 +229,9 @@ noble_align_function void DefaultFitter::PerformFits(
 noble_align_function void DefaultFitter::PerformMonteCarloFits(
         MonteCarloController& controller,
         RandomNumberGenerator& generator,
-        const std::vector<std::vector<SampleConcentrations>>& concentrations
+        const std::vector<std::shared_ptr<const NobleFitFunction>>& functions,
+        const ResultsRequest& request,
+        std::shared_ptr<FitResultsPool> results_pool
         ) const
 {
     RandomNumberBuffer rnd(generator);
@@ -207,25 +247,14 @@ noble_align_function void DefaultFitter::PerformMonteCarloFits(
                     std::shared_ptr<FitResults> > > promise(
                         controller.GetNewJob(i));
 
-            std::vector<std::map<GasType, Data> > varied_concentrations(concentrations[i]);
-
-            for (unsigned j = 0; j < varied_concentrations.size(); ++j)
-                for (auto it = varied_concentrations[j].begin();
-                     it != varied_concentrations[j].end();
-                     ++it)
-                {
-                    it->second.value += rnd() * it->second.error;
-                }
+            std::shared_ptr<NobleFitFunction> function(functions[i]->clone());
+            function->VaryMeasuredValues(rnd);
                 
             const FitConfiguration& config = fit_configurations_[i];
 
-            std::shared_ptr<NobleFitFunction> function(
-                        std::make_shared<NobleFitFunction>(
-                            config.model,
-                            *config.GetParameterMap(),
-                            varied_concentrations));
-
             LevenbergMarquardtFitter fitter(function);
+            fitter.SetResultsRequest(request);
+            fitter.SetResultsPool(results_pool);
 
             promise->set_value(fitter.fit(std::make_shared<FitParameterConfig>(
                             config.fit_parameter_config)));
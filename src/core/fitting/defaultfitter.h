@@ -27,7 +27,9 @@
 
 #include "fitresultsprocessor.h"
 
+class FitResultsPool;
 class MonteCarloController;
+class NobleFitFunction;
 class RandomNumberGenerator;
 namespace boost { class mutex; }
 
@@ -46,16 +48,18 @@ private:
     void PerformFits(
             boost::mutex& mutex,
             unsigned& counter,
-            const std::vector<SampleConcentrations>& concentrations,
             const std::vector<std::string>& sample_names,
             std::vector<std::vector<std::string>>& samples_used_by_fits,
             std::vector<std::vector<SampleConcentrations>>& concentrations_used_by_fits,
+            std::vector<std::shared_ptr<const NobleFitFunction>>& functions,
             std::vector<std::shared_ptr<FitResults>>& results) const;
 
     void PerformMonteCarloFits(
             MonteCarloController& controller,
             RandomNumberGenerator& generator,
-            const std::vector<std::vector<SampleConcentrations>>& concentrations
+            const std::vector<std::shared_ptr<const NobleFitFunction>>& functions,
+            const ResultsRequest& request,
+            std::shared_ptr<FitResultsPool> results_pool
             ) const;
         
     RunData concentrations_;
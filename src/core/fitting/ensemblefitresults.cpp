@@ -0,0 +1,65 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "ensemblefitresults.h"
+
+double EnsembleFitResults::CorrelationCoefficient(unsigned row, unsigned col) const
+{
+    assert(row < deviations.size());
+    assert(col < deviations.size());
+
+    std::vector<unsigned> indices;
+    indices.push_back(row);
+    indices.push_back(col);
+    return SelectCovariances(indices)(0, 1) / deviations(row) / deviations(col);
+}
+
+Eigen::MatrixXd EnsembleFitResults::SelectCovariances(
+        const std::vector<unsigned>& indices) const
+{
+    assert(sample_parameters.size() == sample_covariances.size());
+
+    const unsigned n = indices.size();
+    std::vector<unsigned> positions(n);
+    for (unsigned k = 0; k < sample_parameters.size(); ++k)
+    {
+        const std::vector<unsigned>& parameters = sample_parameters[k];
+        unsigned i = 0;
+        for (; i < n; ++i)
+        {
+            auto it = std::lower_bound(parameters.begin(), parameters.end(), indices[i]);
+            if (it == parameters.end() || *it != indices[i])
+                break;
+            positions[i] = it - parameters.begin();
+        }
+        if (i < n)
+            continue;
+
+        Eigen::MatrixXd selection(n, n);
+        for (unsigned i = 0; i < n; ++i)
+            for (unsigned j = 0; j < n; ++j)
+                selection(i, j) = sample_covariances[k](positions[i], positions[j]);
+        return selection;
+    }
+
+    throw std::out_of_range("The selected parameters do not belong to a common sample.");
+}
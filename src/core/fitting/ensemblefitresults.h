@@ -0,0 +1,45 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef ENSEMBLEFITRESULTS_H
+#define ENSEMBLEFITRESULTS_H
+
+#include <vector>
+
+#include "fitresults.h"
+
+//! Ergebnisse eines Ensemblefits, deren Kovarianzen blockweise je Probe gespeichert sind.
+/*!
+  Bei Ensemblefits hängt jede Probe nur von den gemeinsamen und ihren eigenen Parametern ab. Die
+  vollständige Kovarianz-Matrix wächst quadratisch mit der Zahl der Proben, benötigt werden aber
+  nur die Blöcke der einzelnen Proben. covariance_matrix bleibt daher leer.
+  */
+class EnsembleFitResults : public FitResults
+{
+public:
+    virtual double CorrelationCoefficient(unsigned row, unsigned col) const;
+    virtual Eigen::MatrixXd SelectCovariances(const std::vector<unsigned>& indices) const;
+
+    //! Aufsteigend sortierte Indizes der Fitparameter, von denen die jeweilige Probe abhängt.
+    std::vector<std::vector<unsigned>> sample_parameters;
+
+    //! Kovarianz-Matrizen der Parameter in sample_parameters.
+    std::vector<Eigen::MatrixXd> sample_covariances;
+};
+
+#endif // ENSEMBLEFITRESULTS_H
@@ -24,6 +24,7 @@ FitConfiguration::FitConfiguration() :
     model_parameter_configs(),
     n_monte_carlos(0UL),
     sample_numbers(),
+    multi_start_settings(),
     parameter_map_()
 {
 }
@@ -34,6 +35,7 @@ FitConfiguration::FitConfiguration(const FitConfiguration& other) :
     model_parameter_configs(other.model_parameter_configs),
     n_monte_carlos(other.n_monte_carlos),
     sample_numbers(other.sample_numbers),
+    multi_start_settings(other.multi_start_settings),
     parameter_map_()
 {
     if (other.parameter_map_)
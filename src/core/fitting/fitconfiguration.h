@@ -22,6 +22,7 @@
 #include <memory>
 
 #include "fitparameterconfig.h"
+#include "multistartfitter.h"
 #include "nobleparametermap.h"
 
 #include "core/models/combinedmodelfactory.h"
@@ -46,6 +47,9 @@ public:
     unsigned long n_monte_carlos;
     std::vector<unsigned> sample_numbers;
 
+    //! Einstellungen für die Suche nach dem globalen Minimum (standardmäßig nur ein Startpunkt).
+    MultiStartSettings multi_start_settings;
+
     
 private:
     mutable std::shared_ptr<NobleParameterMap> parameter_map_;
@@ -25,14 +25,25 @@
 
 struct FitParameter
 {
-    FitParameter(std::string name, double initial_value) :
+    FitParameter(std::string name,
+                 double initial_value,
+                 double lower_bound = -std::numeric_limits<double>::infinity(),
+                 double upper_bound = std::numeric_limits<double>::infinity()) :
             name(name),
-            initial_value(initial_value)
+            initial_value(initial_value),
+            lower_bound(lower_bound),
+            upper_bound(upper_bound)
     {
     }
     
     std::string name;
     double initial_value;
+
+    //! Untere Grenze des Bereichs, aus dem MultiStartFitter Startwerte wählt.
+    double lower_bound;
+
+    //! Obere Grenze des Bereichs, aus dem MultiStartFitter Startwerte wählt.
+    double upper_bound;
 };
 
 #endif // FITPARAMETER_H
\ No newline at end of file
@@ -21,6 +21,28 @@
 
 #include "fitparameterconfig.h"
 
+namespace
+{
+void AppendValue(Eigen::VectorXd& vector, double value)
+{
+    //Workaround weil conservativeResize nicht richtig funktioniert.
+    unsigned size = vector.size();
+    Eigen::VectorXd helper(size);
+    helper.swap(vector);
+    vector.resize(size + 1);
+    vector.topRows(size).swap(helper);
+    vector(size) = value;
+}
+
+void RemoveValue(Eigen::VectorXd& vector, unsigned index)
+{
+    const unsigned n = vector.size() - index - 1;
+    const unsigned new_size = vector.size() - 1;
+    vector.segment(index, n) = vector.tail(n);
+    vector.conservativeResize(new_size);
+}
+}
+
 void FitParameterConfig::AddParameter(const FitParameter& parameter)
 {
     if (std::find(names_.cbegin(), names_.cend(), parameter.name) !=
@@ -30,13 +52,9 @@ void FitParameterConfig::AddParameter(const FitParameter& parameter)
         
     names_.push_back(parameter.name);
 
-	//Workaround weil conservativeResize nicht richtig funktioniert.
-	unsigned size = initials_.size();
-	Eigen::VectorXd helper(size);
-	helper.swap(initials_);
-	initials_.resize(size + 1);
-	initials_.topRows(size).swap(helper);
-	initials_(size) = parameter.initial_value;
+    AppendValue(initials_, parameter.initial_value);
+    AppendValue(lower_bounds_, parameter.lower_bound);
+    AppendValue(upper_bounds_, parameter.upper_bound);
 }
 
 size_t FitParameterConfig::size() const
@@ -54,6 +72,16 @@ const Eigen::VectorXd& FitParameterConfig::initials() const
     return initials_;
 }
 
+const Eigen::VectorXd& FitParameterConfig::lower_bounds() const
+{
+    return lower_bounds_;
+}
+
+const Eigen::VectorXd& FitParameterConfig::upper_bounds() const
+{
+    return upper_bounds_;
+}
+
 void FitParameterConfig::ChangeParameterInitial(unsigned int index,
                                                 double new_value)
 {
@@ -69,14 +97,31 @@ void FitParameterConfig::ChangeParameterInitial(const std::string& name, double
     ChangeParameterInitial(index, new_value);
 }
 
+void FitParameterConfig::ChangeParameterBounds(unsigned index, double lower, double upper)
+{
+    if (!(lower <= upper))
+        throw std::invalid_argument("The lower bound must not exceed the upper bound.");
+    lower_bounds_[index] = lower;
+    upper_bounds_[index] = upper;
+}
+
+void FitParameterConfig::ChangeParameterBounds(const std::string& name,
+                                               double lower,
+                                               double upper)
+{
+    auto it = std::find(names_.begin(), names_.end(), name);
+    if (it == names_.end())
+        throw std::invalid_argument("Parameter not found.");
+    ChangeParameterBounds(it - names_.begin(), lower, upper);
+}
+
 void FitParameterConfig::RemoveParameter(unsigned int index)
 {
     names_.erase(names_.begin() + index);
     
-    const unsigned n = initials_.size() - index - 1;
-    const unsigned new_size = initials_.size() - 1;
-    initials_.segment(index, n) = initials_.tail(n);
-    initials_.conservativeResize(new_size);
+    RemoveValue(initials_, index);
+    RemoveValue(lower_bounds_, index);
+    RemoveValue(upper_bounds_, index);
 }
 
 std::map< std::string, unsigned > FitParameterConfig::GetNameToIndexMap() const
@@ -42,12 +42,24 @@ public:
     
     //! Gibt den Vektor der Anfangswerte für die Parameter zurück.
     const Eigen::VectorXd& initials() const;
+
+    //! Gibt die unteren Grenzen der Parameter zurück (-∞, falls nicht gesetzt).
+    const Eigen::VectorXd& lower_bounds() const;
+
+    //! Gibt die oberen Grenzen der Parameter zurück (∞, falls nicht gesetzt).
+    const Eigen::VectorXd& upper_bounds() const;
     
     //! Ändert einen einzelnen Parameter-Initialwert.
     void ChangeParameterInitial(unsigned index, double new_value);
     
     //! Ändert einen einzelnen Parameter-Initialwert.
     void ChangeParameterInitial(const std::string& name, double new_value);
+
+    //! Ändert die Grenzen eines einzelnen Parameters.
+    void ChangeParameterBounds(unsigned index, double lower, double upper);
+    
+    //! Ändert die Grenzen eines einzelnen Parameters.
+    void ChangeParameterBounds(const std::string& name, double lower, double upper);
     
     //! Entfernt den Parameter mit dem übergebenen Index.
     void RemoveParameter(unsigned index);
@@ -61,6 +73,12 @@ private:
     
     //! Vektor der Anfangswerte für die Parameter.
     Eigen::VectorXd initials_;
+
+    //! Vektor der unteren Grenzen der Parameter.
+    Eigen::VectorXd lower_bounds_;
+
+    //! Vektor der oberen Grenzen der Parameter.
+    Eigen::VectorXd upper_bounds_;
 };
 
 #endif // FITPARAMETERCONFIG_H
@@ -33,6 +33,8 @@ std::string FitResults::GetExitFlagAsString(Eigen::LM::Status flag)
         return "Converged";
     case Eigen::LM::TooManyFunctionEvaluation:
         return "Too many function calls";
+    case Eigen::LM::UserAsked:
+        return "Aborted";
     default:
         return "Error";
     }
@@ -53,3 +55,13 @@ double FitResults::CorrelationCoefficient(unsigned row, unsigned col) const
 
     return covariance_matrix(row, col) / deviations(row) / deviations(col);
 }
+
+Eigen::MatrixXd FitResults::SelectCovariances(const std::vector<unsigned>& indices) const
+{
+    const unsigned n = indices.size();
+    Eigen::MatrixXd selection(n, n);
+    for (unsigned i = 0; i < n; ++i)
+        for (unsigned j = 0; j < n; ++j)
+            selection(i, j) = covariance_matrix(indices[i], indices[j]);
+    return selection;
+}
@@ -32,13 +32,30 @@
 
 #include "eigen_lm_includes.h"
 
+//! Ein von MultiStartFitter gefundenes lokales Minimum.
+struct LocalMinimum
+{
+    //! χ² im Minimum.
+    double chi_square;
+
+    //! Parametersatz des Minimums.
+    Eigen::VectorXd best_estimate;
+};
+
 //! Bündelt die Fitergebnisse
 class FitResults
 {
 
 public:
 
-    FitResults() : chi_square(-1.), n_iterations(0) {}
+    FitResults() :
+        chi_square(-1.),
+        n_iterations(0),
+        n_starts_completed(0),
+        n_starts_pruned(0),
+        n_starts_skipped(0)
+    {
+    }
 
     virtual ~FitResults() {}
 
@@ -46,6 +63,13 @@ public:
     std::string GetExitFlagAsString() const;
     virtual double CorrelationCoefficient(unsigned row, unsigned col) const;
 
+    //! Gibt die Kovarianz-Matrix der ausgewählten Parameter zurück.
+    /*!
+      \param indices Indizes der Parameter in der Reihenfolge, in der sie in der Ergebnismatrix
+      stehen sollen.
+      */
+    virtual Eigen::MatrixXd SelectCovariances(const std::vector<unsigned>& indices) const;
+
     //! χ² des Fits.
     double chi_square;
 
@@ -77,6 +101,20 @@ public:
     std::vector<std::map<GasType, Data>> model_concentrations;
     std::vector<std::map<GasType, Data>> equilibrium_concentrations;
     std::vector<std::map<GasType, Data>> measured_concentrations;
+
+    //! \brief Bei Fits von mehreren Startpunkten die voneinander verschiedenen
+    //! konvergierten Minima, aufsteigend nach χ² sortiert, sonst leer.
+    std::vector<LocalMinimum> local_minima;
+
+    //! Bei Fits von mehreren Startpunkten die Zahl der vollständig durchgeführten Fits.
+    unsigned n_starts_completed;
+
+    //! Bei Fits von mehreren Startpunkten die Zahl der abgebrochenen Fits.
+    unsigned n_starts_pruned;
+
+    //! \brief Bei Fits von mehreren Startpunkten die Zahl der Startpunkte, die wegen
+    //! Zeitüberschreitung nicht mehr begonnen wurden.
+    unsigned n_starts_skipped;
 };
 
 #endif // FITRESULTS_H
\ No newline at end of file
@@ -0,0 +1,73 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "fitresultspool.h"
+
+FitResultsPool::Storage::Storage() :
+    free(),
+    n_created(0),
+    mutex()
+{
+}
+
+void FitResultsPool::Release::operator()(FitResults* results) const
+{
+    std::unique_ptr<FitResults> owned(results);
+
+    std::shared_ptr<Storage> locked(storage.lock());
+    if (!locked)
+        return;
+
+    // Der Mutex ordnet die Schreibzugriffe des letzten Besitzers vor die nächste Vergabe.
+    boost::lock_guard<boost::mutex> lock(locked->mutex);
+    locked->free.push_back(std::move(owned));
+}
+
+FitResultsPool::FitResultsPool() :
+    storage_(std::make_shared<Storage>())
+{
+}
+
+std::shared_ptr<FitResults> FitResultsPool::Acquire()
+{
+    std::unique_ptr<FitResults> results;
+    {
+        boost::lock_guard<boost::mutex> lock(storage_->mutex);
+        if (!storage_->free.empty())
+        {
+            // Das zuletzt zurückgegebene Objekt liegt am ehesten noch im Cache.
+            results = std::move(storage_->free.back());
+            storage_->free.pop_back();
+        }
+        else
+            ++storage_->n_created;
+    }
+
+    if (!results)
+        results.reset(new FitResults());
+
+    Release release;
+    release.storage = storage_;
+    return std::shared_ptr<FitResults>(results.release(), release);
+}
+
+std::size_t FitResultsPool::size() const
+{
+    boost::lock_guard<boost::mutex> lock(storage_->mutex);
+    return storage_->n_created;
+}
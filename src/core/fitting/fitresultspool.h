@@ -0,0 +1,91 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef FITRESULTSPOOL_H
+#define FITRESULTSPOOL_H
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "fitresults.h"
+
+//! Wiederverwendbarer Vorrat an FitResults-Objekten für Monte-Carlo-Läufe.
+/*!
+  Jeder Monte-Carlo-Fit erzeugt ein Ergebnisobjekt, das nach der Verarbeitung sofort wieder
+  verworfen wird. Der Vorrat gibt stattdessen Objekte heraus, die von keinem anderen Besitzer
+  mehr gehalten werden. Da die Größe der Vektoren und Matrizen sowie die Schlüssel der
+  Konzentrations-Maps innerhalb eines Laufs gleich bleiben, werden beim Überschreiben keine
+  Speicherbereiche neu angelegt.
+
+  Die herausgegebenen Zeiger legen ihr Objekt beim Zerstören der letzten Kopie in eine
+  Freiliste zurück, aus der Acquire in konstanter Zeit nimmt. Die Zahl der noch gehaltenen
+  Objekte spielt dafür keine Rolle.
+
+  Herausgegebene Objekte bleiben gültig, solange ein Besitzer sie hält, auch über die
+  Lebensdauer des Vorrats hinaus. Danach freigegebene Objekte werden gelöscht.
+
+  Die Objekte werden nicht zurückgesetzt. Der Nutzer muss alle Felder, die er später liest,
+  selbst überschreiben.
+  */
+class FitResultsPool
+{
+public:
+    FitResultsPool();
+
+    //! Gibt ein freies Ergebnisobjekt zurück und legt bei Bedarf ein neues an.
+    /*!
+      Threadsicher.
+      */
+    std::shared_ptr<FitResults> Acquire();
+
+    //! Gibt die Zahl der bisher angelegten Ergebnisobjekte zurück.
+    std::size_t size() const;
+
+private:
+
+    //! Gemeinsamer Zustand von Vorrat und herausgegebenen Zeigern.
+    struct Storage
+    {
+        Storage();
+
+        //! Freie Ergebnisobjekte; zuletzt zurückgegebene liegen hinten.
+        std::vector<std::unique_ptr<FitResults>> free;
+
+        //! Zahl der bisher angelegten Ergebnisobjekte.
+        std::size_t n_created;
+
+        //! Mutex für den Zugriff auf free und n_created.
+        boost::mutex mutex;
+    };
+
+    //! Deleter der herausgegebenen Zeiger, legt das Objekt in die Freiliste zurück.
+    struct Release
+    {
+        void operator()(FitResults* results) const;
+
+        //! Existiert der Vorrat nicht mehr, wird das Objekt gelöscht.
+        std::weak_ptr<Storage> storage;
+    };
+
+    std::shared_ptr<Storage> storage_;
+};
+
+#endif // FITRESULTSPOOL_H
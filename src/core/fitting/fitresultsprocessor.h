@@ -24,10 +24,22 @@
 #include "core/misc/typedefs.h"
 
 #include "fitresults.h"
+#include "resultsrequest.h"
 
 class FitResultsProcessor
 {
 public:
+    virtual ~FitResultsProcessor() {}
+
+    //! Gibt an, welche Gaskonzentrationen ProcessMonteCarloResult benötigt.
+    /*!
+      Die Monte-Carlo-Fits berechnen nur diese Größen.
+      */
+    virtual ResultsRequest GetMonteCarloResultsRequest() const
+    {
+        return ResultsRequest::All();
+    }
+
     virtual void ProcessResult(
             std::shared_ptr<FitResults> results,
             const std::vector<std::string>& sample_names,
@@ -0,0 +1,558 @@
+// Copyright © 2014 Michael Jung
+//
+// This file is part of Panga.
+//
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef FIXEDSIZELEVENBERGMARQUARDT_H
+#define FIXEDSIZELEVENBERGMARQUARDT_H
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "eigen_lm_includes.h"
+
+//! Levenberg-Marquardt-Minimierer für kleine Probleme ohne Heap-Allokationen.
+/*!
+  Entspricht Eigen::LevenbergMarquardt::minimize (MINPACK lmder), verwendet aber
+  für Jacobi-Matrix, QR-Zerlegung und alle Arbeitsvektoren Eigen-Typen mit zur
+  Compilezeit festgelegter Maximalgröße. Diese liegen vollständig auf dem Stack,
+  die tatsächliche Größe des Problems wird trotzdem erst zur Laufzeit festgelegt.
+
+  Der Funktor muss InputType, ValueType und JacobianType dieser Klasse
+  akzeptieren.
+
+  \tparam MaxValues Maximale Zahl der Residuen.
+  \tparam MaxParams Maximale Zahl der Fitparameter.
+  */
+template<typename FunctorType, int MaxValues, int MaxParams>
+class FixedSizeLevenbergMarquardt
+{
+public:
+    typedef Eigen::DenseIndex Index;
+
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MaxParams, 1> InputType;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MaxValues, 1> ValueType;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0,
+                          MaxValues, MaxParams> JacobianType;
+    typedef Eigen::ColPivHouseholderQR<JacobianType> QRType;
+    typedef Eigen::PermutationMatrix<Eigen::Dynamic, MaxParams> PermutationType;
+
+    //! Entspricht Eigen::LevenbergMarquardt::Parameters.
+    struct Parameters
+    {
+        Parameters() :
+            factor(100.),
+            maxfev(400),
+            ftol(std::sqrt(std::numeric_limits<double>::epsilon())),
+            xtol(std::sqrt(std::numeric_limits<double>::epsilon())),
+            gtol(0.)
+        {
+        }
+        double factor;
+        Index maxfev;
+        double ftol;
+        double xtol;
+        double gtol;
+    };
+
+    explicit FixedSizeLevenbergMarquardt(FunctorType& functor) :
+        nfev(0), njev(0), iter(0), fnorm(0.), gnorm(0.), functor_(functor)
+    {
+    }
+
+    //! Führt die Minimierung ausgehend von \a x durch.
+    /*!
+      \post \a x enthält den besten gefundenen Parametersatz, fjac und
+        permutation die QR-Zerlegung der Jacobi-Matrix der letzten Iteration.
+      */
+    Eigen::LM::Status minimize(InputType& x);
+
+    //! Initialisiert die schrittweise Minimierung (wie in Eigen::LevenbergMarquardt).
+    Eigen::LM::Status minimizeInit(InputType& x);
+
+    //! Führt einen Iterationsschritt durch (wie in Eigen::LevenbergMarquardt).
+    Eigen::LM::Status minimizeOneStep(InputType& x);
+
+    //! Berechnet die Kovarianzmatrix aus der in fjac gespeicherten QR-Zerlegung.
+    /*!
+      Entspricht Eigen::internal::covar. Die Kovarianzmatrix steht danach in
+      der linken oberen n×n-Ecke von fjac.
+      */
+    void covar(double tol);
+
+    Parameters parameters;
+    ValueType fvec;
+    InputType qtf;
+    InputType diag;
+    JacobianType fjac;
+    PermutationType permutation;
+    Index nfev;
+    Index njev;
+    Index iter;
+    double fnorm;
+    double gnorm;
+
+private:
+    FixedSizeLevenbergMarquardt& operator=(const FixedSizeLevenbergMarquardt&);
+
+    //! Entspricht Eigen::internal::lmpar2.
+    static void lmpar(const QRType& qr,
+                      const InputType& diag,
+                      const InputType& qtb,
+                      double delta,
+                      double& par,
+                      InputType& x);
+
+    //! Entspricht Eigen::internal::qrsolv.
+    static void qrsolv(JacobianType& s,
+                       const typename PermutationType::IndicesType& ipvt,
+                       const InputType& diag,
+                       const InputType& qtb,
+                       InputType& x,
+                       InputType& sdiag);
+
+    FunctorType& functor_;
+    Index n_;
+    Index m_;
+    InputType wa1_, wa2_, wa3_;
+    ValueType wa4_;
+    double par_;
+    double delta_;
+    double xnorm_;
+};
+
+template<typename FunctorType, int MaxValues, int MaxParams>
+Eigen::LM::Status
+FixedSizeLevenbergMarquardt<FunctorType, MaxValues, MaxParams>::minimize(
+        InputType& x)
+{
+    Eigen::LM::Status status = minimizeInit(x);
+    if (status == Eigen::LM::ImproperInputParameters)
+        return status;
+    do
+    {
+        status = minimizeOneStep(x);
+    } while (status == Eigen::LM::Running);
+    return status;
+}
+
+template<typename FunctorType, int MaxValues, int MaxParams>
+Eigen::LM::Status
+FixedSizeLevenbergMarquardt<FunctorType, MaxValues, MaxParams>::minimizeInit(
+        InputType& x)
+{
+    n_ = x.size();
+    m_ = functor_.values();
+
+    nfev = 0;
+    njev = 0;
+
+    if (n_ <= 0 || m_ < n_ || n_ > MaxParams || m_ > MaxValues ||
+        parameters.ftol < 0. || parameters.xtol < 0. || parameters.gtol < 0. ||
+        parameters.maxfev <= 0 || parameters.factor <= 0.)
+        return Eigen::LM::ImproperInputParameters;
+
+    wa1_.resize(n_);
+    wa2_.resize(n_);
+    wa3_.resize(n_);
+    wa4_.resize(m_);
+    fvec.resize(m_);
+    fjac.resize(m_, n_);
+    diag.resize(n_);
+    qtf.resize(n_);
+
+    nfev = 1;
+    if (functor_(x, fvec) < 0)
+        return Eigen::LM::UserAsked;
+    fnorm = fvec.stableNorm();
+
+    par_ = 0.;
+    iter = 1;
+
+    return Eigen::LM::NotStarted;
+}
+
+template<typename FunctorType, int MaxValues, int MaxParams>
+Eigen::LM::Status
+FixedSizeLevenbergMarquardt<FunctorType, MaxValues, MaxParams>::minimizeOneStep(
+        InputType& x)
+{
+    assert(x.size() == n_);
+
+    if (functor_.df(x, fjac) < 0)
+        return Eigen::LM::UserAsked;
+    ++njev;
+
+    // QR-Zerlegung der Jacobi-Matrix.
+    for (Index j = 0; j < n_; ++j)
+        wa2_[j] = fjac.col(j).blueNorm();
+    QRType qrfac(fjac);
+    fjac = qrfac.matrixQR();
+    permutation = qrfac.colsPermutation();
+
+    // In der ersten Iteration anhand der Spaltennormen skalieren und die
+    // Schrittweite initialisieren.
+    if (iter == 1)
+    {
+        for (Index j = 0; j < n_; ++j)
+            diag[j] = (wa2_[j] == 0.) ? 1. : wa2_[j];
+
+        xnorm_ = diag.cwiseProduct(x).stableNorm();
+        delta_ = parameters.factor * xnorm_;
+        if (delta_ == 0.)
+            delta_ = parameters.factor;
+    }
+
+    wa4_ = fvec;
+    wa4_.applyOnTheLeft(qrfac.householderQ().adjoint());
+    qtf = wa4_.head(n_);
+
+    // Norm des skalierten Gradienten.
+    gnorm = 0.;
+    if (fnorm != 0.)
+        for (Index j = 0; j < n_; ++j)
+            if (wa2_[permutation.indices()[j]] != 0.)
+                gnorm = (std::max)(gnorm, std::abs(
+                        fjac.col(j).head(j + 1).dot(qtf.head(j + 1) / fnorm) /
+                        wa2_[permutation.indices()[j]]));
+
+    if (gnorm <= parameters.gtol)
+        return Eigen::LM::CosinusTooSmall;
+
+    diag = diag.cwiseMax(wa2_);
+
+    double ratio;
+    do
+    {
+        lmpar(qrfac, diag, qtf, delta_, par_, wa1_);
+
+        wa1_ = -wa1_;
+        wa2_ = x + wa1_;
+        const double pnorm = diag.cwiseProduct(wa1_).stableNorm();
+
+        if (iter == 1)
+            delta_ = (std::min)(delta_, pnorm);
+
+        if (functor_(wa2_, wa4_) < 0)
+            return Eigen::LM::UserAsked;
+        ++nfev;
+        const double fnorm1 = wa4_.stableNorm();
+
+        // Tatsächliche Reduktion.
+        double actred = -1.;
+        if (.1 * fnorm1 < fnorm)
+            actred = 1. - (fnorm1 / fnorm) * (fnorm1 / fnorm);
+
+        // Vorhergesagte Reduktion und Richtungsableitung.
+        wa3_ = fjac.topLeftCorner(n_, n_).template triangularView<Eigen::Upper>() *
+               (permutation.inverse() * wa1_);
+        const double temp1 = std::pow(wa3_.stableNorm() / fnorm, 2);
+        const double temp2 = std::pow(std::sqrt(par_) * pnorm / fnorm, 2);
+        const double prered = temp1 + temp2 / .5;
+        const double dirder = -(temp1 + temp2);
+
+        ratio = 0.;
+        if (prered != 0.)
+            ratio = actred / prered;
+
+        // Schrittweite anpassen.
+        if (ratio <= .25)
+        {
+            double temp = .5;
+            if (actred < 0.)
+                temp = .5 * dirder / (dirder + .5 * actred);
+            if (.1 * fnorm1 >= fnorm || temp < .1)
+                temp = .1;
+            delta_ = temp * (std::min)(delta_, pnorm / .1);
+            par_ /= temp;
+        }
+        else if (!(par_ != 0. && ratio < .75))
+        {
+            delta_ = pnorm / .5;
+            par_ = .5 * par_;
+        }
+
+        if (ratio >= 1e-4)
+        {
+            // Erfolgreiche Iteration.
+            x = wa2_;
+            wa2_ = diag.cwiseProduct(x);
+            fvec = wa4_;
+            xnorm_ = wa2_.stableNorm();
+            fnorm = fnorm1;
+            ++iter;
+        }
+
+        // Konvergenztests.
+        if (std::abs(actred) <= parameters.ftol && prered <= parameters.ftol &&
+            .5 * ratio <= 1. && delta_ <= parameters.xtol * xnorm_)
+            return Eigen::LM::RelativeErrorAndReductionTooSmall;
+        if (std::abs(actred) <= parameters.ftol && prered <= parameters.ftol &&
+            .5 * ratio <= 1.)
+            return Eigen::LM::RelativeReductionTooSmall;
+        if (delta_ <= parameters.xtol * xnorm_)
+            return Eigen::LM::RelativeErrorTooSmall;
+
+        // Tests auf zu strenge Toleranzen.
+        if (nfev >= parameters.maxfev)
+            return Eigen::LM::TooManyFunctionEvaluation;
+        if (std::abs(actred) <= std::numeric_limits<double>::epsilon() &&
+            prered <= std::numeric_limits<double>::epsilon() && .5 * ratio <= 1.)
+            return Eigen::LM::FtolTooSmall;
+        if (delta_ <= std::numeric_limits<double>::epsilon() * xnorm_)
+            return Eigen::LM::XtolTooSmall;
+        if (gnorm <= std::numeric_limits<double>::epsilon())
+            return Eigen::LM::GtolTooSmall;
+
+    } while (ratio < 1e-4);
+
+    return Eigen::LM::Running;
+}
+
+template<typename FunctorType, int MaxValues, int MaxParams>
+void FixedSizeLevenbergMarquardt<FunctorType, MaxValues, MaxParams>::lmpar(
+        const QRType& qr,
+        const InputType& diag,
+        const InputType& qtb,
+        double delta,
+        double& par,
+        InputType& x)
+{
+    const double dwarf = std::numeric_limits<double>::min();
+    const Index n = qr.matrixQR().cols();
+    assert(n == diag.size());
+    assert(n == qtb.size());
+
+    InputType wa1, wa2;
+
+    // Gauss-Newton-Richtung, bei Rangdefekt Least-Squares-Lösung.
+    const Index rank = qr.rank();
+    wa1 = qtb;
+    wa1.tail(n - rank).setZero();
+    qr.matrixQR().topLeftCorner(rank, rank)
+            .template triangularView<Eigen::Upper>()
+            .solveInPlace(wa1.head(rank));
+
+    x = qr.colsPermutation() * wa1;
+
+    Index iter = 0;
+    wa2 = diag.cwiseProduct(x);
+    double dxnorm = wa2.blueNorm();
+    double fp = dxnorm - delta;
+    if (fp <= .1 * delta)
+    {
+        par = 0;
+        return;
+    }
+
+    // Untere Schranke parl, falls die Jacobi-Matrix vollen Rang hat.
+    double parl = 0.;
+    if (rank == n)
+    {
+        wa1 = qr.colsPermutation().inverse() * diag.cwiseProduct(wa2) / dxnorm;
+        qr.matrixQR().topLeftCorner(n, n).transpose()
+                .template triangularView<Eigen::Lower>().solveInPlace(wa1);
+        const double temp = wa1.blueNorm();
+        parl = fp / delta / temp / temp;
+    }
+
+    // Obere Schranke paru.
+    for (Index j = 0; j < n; ++j)
+        wa1[j] = qr.matrixQR().col(j).head(j + 1).dot(qtb.head(j + 1)) /
+                 diag[qr.colsPermutation().indices()(j)];
+
+    const double gnorm = wa1.stableNorm();
+    double paru = gnorm / delta;
+    if (paru == 0.)
+        paru = dwarf / (std::min)(delta, .1);
+
+    par = (std::max)(par, parl);
+    par = (std::min)(par, paru);
+    if (par == 0.)
+        par = gnorm / dxnorm;
+
+    JacobianType s = qr.matrixQR();
+    InputType sdiag(n);
+    while (true)
+    {
+        ++iter;
+
+        if (par == 0.)
+            par = (std::max)(dwarf, .001 * paru);
+        wa1 = std::sqrt(par) * diag;
+
+        qrsolv(s, qr.colsPermutation().indices(), wa1, qtb, x, sdiag);
+
+        wa2 = diag.cwiseProduct(x);
+        dxnorm = wa2.blueNorm();
+        double temp = fp;
+        fp = dxnorm - delta;
+
+        if (std::abs(fp) <= .1 * delta ||
+            (parl == 0. && fp <= temp && temp < 0.) ||
+            iter == 10)
+            break;
+
+        // Newton-Korrektur.
+        wa1 = qr.colsPermutation().inverse() * diag.cwiseProduct(wa2 / dxnorm);
+        for (Index j = 0; j < n; ++j)
+        {
+            wa1[j] /= sdiag[j];
+            temp = wa1[j];
+            for (Index i = j + 1; i < n; ++i)
+                wa1[i] -= s(i, j) * temp;
+        }
+        temp = wa1.blueNorm();
+        const double parc = fp / delta / temp / temp;
+
+        if (fp > 0.)
+            parl = (std::max)(parl, par);
+        if (fp < 0.)
+            paru = (std::min)(paru, par);
+
+        par = (std::max)(parl, par + parc);
+    }
+    if (iter == 0)
+        par = 0.;
+}
+
+template<typename FunctorType, int MaxValues, int MaxParams>
+void FixedSizeLevenbergMarquardt<FunctorType, MaxValues, MaxParams>::qrsolv(
+        JacobianType& s,
+        const typename PermutationType::IndicesType& ipvt,
+        const InputType& diag,
+        const InputType& qtb,
+        InputType& x,
+        InputType& sdiag)
+{
+    const Index n = s.cols();
+    InputType wa(n);
+    Eigen::JacobiRotation<double> givens;
+
+    // R und Q^T*b sichern, Diagonale von R in x zwischenspeichern.
+    x = s.diagonal();
+    wa = qtb;
+
+    s.topLeftCorner(n, n).template triangularView<Eigen::StrictlyLower>() =
+            s.topLeftCorner(n, n).transpose();
+
+    // Diagonalmatrix D mittels Givens-Rotationen eliminieren.
+    for (Index j = 0; j < n; ++j)
+    {
+        const Index l = ipvt[j];
+        if (diag[l] == 0.)
+            break;
+        sdiag.tail(n - j).setZero();
+        sdiag[j] = diag[l];
+
+        double qtbpj = 0.;
+        for (Index k = j; k < n; ++k)
+        {
+            givens.makeGivens(-s(k, k), sdiag[k]);
+
+            s(k, k) = givens.c() * s(k, k) + givens.s() * sdiag[k];
+            double temp = givens.c() * wa[k] + givens.s() * qtbpj;
+            qtbpj = -givens.s() * wa[k] + givens.c() * qtbpj;
+            wa[k] = temp;
+
+            for (Index i = k + 1; i < n; ++i)
+            {
+                temp = givens.c() * s(i, k) + givens.s() * sdiag[i];
+                sdiag[i] = -givens.s() * s(i, k) + givens.c() * sdiag[i];
+                s(i, k) = temp;
+            }
+        }
+    }
+
+    // Dreieckssystem lösen, bei Singularität Least-Squares-Lösung.
+    Index nsing;
+    for (nsing = 0; nsing < n && sdiag[nsing] != 0; ++nsing) {}
+
+    wa.tail(n - nsing).setZero();
+    s.topLeftCorner(nsing, nsing).transpose()
+            .template triangularView<Eigen::Upper>()
+            .solveInPlace(wa.head(nsing));
+
+    sdiag = s.diagonal();
+    s.diagonal() = x;
+
+    for (Index j = 0; j < n; ++j)
+        x[ipvt[j]] = wa[j];
+}
+
+template<typename FunctorType, int MaxValues, int MaxParams>
+void FixedSizeLevenbergMarquardt<FunctorType, MaxValues, MaxParams>::covar(
+        double tol)
+{
+    JacobianType& r = fjac;
+    const typename PermutationType::IndicesType& ipvt = permutation.indices();
+    const Index n = r.cols();
+    const double tolr = tol * std::abs(r(0, 0));
+    InputType wa(n);
+    assert(ipvt.size() == n);
+
+    // Inverse von R im oberen Dreieck von R bilden.
+    Index l = -1;
+    for (Index k = 0; k < n; ++k)
+        if (std::abs(r(k, k)) > tolr)
+        {
+            r(k, k) = 1. / r(k, k);
+            for (Index j = 0; j <= k - 1; ++j)
+            {
+                const double temp = r(k, k) * r(j, k);
+                r(j, k) = 0.;
+                r.col(k).head(j + 1) -= r.col(j).head(j + 1) * temp;
+            }
+            l = k;
+        }
+
+    // Oberes Dreieck von (R^T*R)^-1 bilden.
+    for (Index k = 0; k <= l; ++k)
+    {
+        for (Index j = 0; j <= k - 1; ++j)
+            r.col(j).head(j + 1) += r.col(k).head(j + 1) * r(j, k);
+        r.col(k).head(k + 1) *= r(k, k);
+    }
+
+    // Unteres Dreieck der Kovarianzmatrix bilden und Permutation rückgängig
+    // machen.
+    for (Index j = 0; j < n; ++j)
+    {
+        const Index jj = ipvt[j];
+        const bool sing = j > l;
+        for (Index i = 0; i <= j; ++i)
+        {
+            if (sing)
+                r(i, j) = 0.;
+            const Index ii = ipvt[i];
+            if (ii > jj)
+                r(ii, jj) = r(i, j);
+            if (ii < jj)
+                r(jj, ii) = r(i, j);
+        }
+        wa[jj] = r(j, j);
+    }
+
+    r.topLeftCorner(n, n).template triangularView<Eigen::StrictlyUpper>() =
+            r.topLeftCorner(n, n).transpose();
+    r.diagonal().head(n) = wa;
+}
+
+#endif // FIXEDSIZELEVENBERGMARQUARDT_H
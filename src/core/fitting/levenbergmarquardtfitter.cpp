@@ -21,13 +21,28 @@
 #include <limits>
 #include <stdexcept>
 
+#include "core/misc/gas.h"
+
 #include "eigen_lm_includes.h"
+#include "ensemblefitresults.h"
+#include "fitresultspool.h"
+#include "fixedsizelevenbergmarquardt.h"
 #include "noblefitfunction.h"
+#include "schurlevenbergmarquardt.h"
 
 #include "levenbergmarquardtfitter.h"
 
 namespace
 {
+//! Maximale Zahl an Residuen, bis zu der FixedSizeLevenbergMarquardt verwendet wird.
+/*!
+  Entspricht der Zahl der Gase, also der größten Zahl an Konzentrationen bei Einzelprobenfits.
+  */
+const int MAX_FIXED_SIZE_VALUES = Gas::end_including_HE3;
+
+//! Maximale Zahl an Fitparametern, bis zu der FixedSizeLevenbergMarquardt verwendet wird.
+const int MAX_FIXED_SIZE_PARAMS = Gas::end_including_HE3;
+
 // Generic functor
 template<typename _Scalar, int NX=Eigen::Dynamic, int NY=Eigen::Dynamic>
 struct Functor
@@ -54,20 +69,32 @@ struct Functor
 //  void operator() (const InputType& x, ValueType* v, JacobianType* _j=0) const;
 };
 
+//! Funktor für die Levenberg-Marquardt-Minimierer.
+/*!
+  Mit den Standardwerten für MaxValues und MaxParams werden dynamische Eigen-Typen verwendet,
+  ansonsten Typen mit fester Maximalgröße, die auf dem Stack liegen.
+  */
+template<int MaxValues = Eigen::Dynamic, int MaxParams = Eigen::Dynamic>
 class FitFunctor : public Functor<double>
 {
 public:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MaxParams, 1> InputType;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MaxValues, 1> ValueType;
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0,
+                          MaxValues, MaxParams> JacobianType;
+
     FitFunctor(std::shared_ptr<NobleFitFunction> func,
                int n_inputs,
                int n_values);
-    int operator()(const Eigen::VectorXd& x, Eigen::VectorXd& fvec) const;
-    int df(const Eigen::VectorXd& x, Eigen::MatrixXd& fjac) const;
+    int operator()(const InputType& x, ValueType& fvec) const;
+    int df(const InputType& x, JacobianType& fjac) const;
     
 private:
     std::shared_ptr<NobleFitFunction> func_;
 };
 
-inline FitFunctor::FitFunctor(
+template<int MaxValues, int MaxParams>
+inline FitFunctor<MaxValues, MaxParams>::FitFunctor(
         std::shared_ptr<NobleFitFunction> func,
         int n_inputs,
         int n_values) :
@@ -76,26 +103,128 @@ inline FitFunctor::FitFunctor(
 {
 }
 
-inline int FitFunctor::operator()(
-        const Eigen::VectorXd& x,
-        Eigen::VectorXd& fvec) const
+template<int MaxValues, int MaxParams>
+inline int FitFunctor<MaxValues, MaxParams>::operator()(
+        const InputType& x,
+        ValueType& fvec) const
 {
     func_->SetParameters(x);
     func_->CalcResiduals(fvec);
     return 0;
 }
 
-inline int FitFunctor::df(const Eigen::VectorXd& x, Eigen::MatrixXd& fjac) const
+template<int MaxValues, int MaxParams>
+inline int FitFunctor<MaxValues, MaxParams>::df(
+        const InputType& x,
+        JacobianType& fjac) const
 {
     func_->SetParameters(x);
     func_->CalcJacobian(fjac);
     return 0;
 }
+
+typedef FitFunctor<> DynamicFitFunctor;
+typedef FitFunctor<MAX_FIXED_SIZE_VALUES, MAX_FIXED_SIZE_PARAMS> FixedSizeFitFunctor;
+
+inline void CalcCovariance(Eigen::LevenbergMarquardt<DynamicFitFunctor>& lm)
+{
+    Eigen::covar(lm.fjac, lm.permutation.indices(),
+                 std::numeric_limits<double>::epsilon());
+}
+
+inline void CalcCovariance(
+        FixedSizeLevenbergMarquardt<FixedSizeFitFunctor,
+                                    MAX_FIXED_SIZE_VALUES,
+                                    MAX_FIXED_SIZE_PARAMS>& lm)
+{
+    lm.covar(std::numeric_limits<double>::epsilon());
+}
+
+//! Führt die Minimierung mit dem übergebenen Minimierer aus und speichert die Ergebnisse.
+template<typename FunctorType, typename MinimizerType>
+void Minimize(FunctorType& functor,
+              MinimizerType& lm,
+              const Eigen::VectorXd& initials,
+              const LevenbergMarquardtFitter::AbortCriterion& abort_criterion,
+              FitResults& results)
+{
+    const int n_params = functor.inputs();
+    lm.parameters.maxfev = 10000;
+
+    typename FunctorType::InputType x(initials);
+
+    if (abort_criterion)
+    {
+        // Entspricht lm.minimize(x), prüft aber nach jedem Schritt das Abbruchkriterium.
+        results.exit_flag = lm.minimizeInit(x);
+        if (results.exit_flag != Eigen::LM::ImproperInputParameters)
+        {
+            do
+            {
+                results.exit_flag = lm.minimizeOneStep(x);
+                if (results.exit_flag == Eigen::LM::Running &&
+                    abort_criterion(lm.iter, lm.fnorm * lm.fnorm))
+                    results.exit_flag = Eigen::LM::UserAsked;
+            } while (results.exit_flag == Eigen::LM::Running);
+        }
+    }
+    else
+    {
+        results.exit_flag = lm.minimize(x);
+    }
+
+    if (n_params > 0)
+    {
+        CalcCovariance(lm);
+        results.covariance_matrix = lm.fjac.topLeftCorner(n_params, n_params);
+        results.residuals = lm.fvec;
+    }
+    else
+    {
+        results.covariance_matrix = Eigen::MatrixXd(0, 0);
+        typename FunctorType::ValueType fvec;
+        functor(x, fvec);
+        results.residuals = fvec;
+    }
+
+    results.best_estimate = x;
+    results.n_iterations = lm.iter;
+    results.deviations = results.covariance_matrix.diagonal().cwiseSqrt();
+}
+
+//! Führt einen Ensemblefit mit SchurLevenbergMarquardt aus und speichert die Ergebnisse.
+std::shared_ptr<FitResults> MinimizeEnsemble(
+        std::shared_ptr<NobleFitFunction> func,
+        const Eigen::VectorXd& initials,
+        const LevenbergMarquardtFitter::AbortCriterion& abort_criterion)
+{
+    std::shared_ptr<EnsembleFitResults> results(std::make_shared<EnsembleFitResults>());
+
+    SchurLevenbergMarquardt lm(func, initials.size());
+    lm.maxfev = 10000;
+    lm.abort_criterion = abort_criterion;
+
+    Eigen::VectorXd x(initials);
+    results->exit_flag = lm.minimize(x);
+    lm.CalcCovariances(results->sample_covariances, results->deviations);
+
+    results->sample_parameters.resize(func->NumberOfSamples());
+    for (unsigned i = 0; i < func->NumberOfSamples(); ++i)
+        results->sample_parameters[i] = func->GetFitParametersOfSample(i);
+
+    results->residuals = lm.fvec;
+    results->best_estimate = x;
+    results->n_iterations = lm.iter;
+    return results;
+}
 }
 
 LevenbergMarquardtFitter::LevenbergMarquardtFitter(
         std::shared_ptr<NobleFitFunction> func) :
-    func_(func)
+    func_(func),
+    fixed_size_solver_enabled_(true),
+    schur_solver_enabled_(true),
+    results_request_(ResultsRequest::All())
 {
 }
 
@@ -103,41 +232,40 @@ std::shared_ptr<FitResults> LevenbergMarquardtFitter::fit(
         std::shared_ptr<const FitParameterConfig> pconf
         ) const
 {
-    std::shared_ptr<FitResults> results(std::make_shared<FitResults>());
+    std::shared_ptr<FitResults> results(results_pool_ ?
+                                        results_pool_->Acquire() :
+                                        std::make_shared<FitResults>());
 
     int n_params = pconf->size();
     int n_values = func_->NumberOfConcentrations();
     
     if (n_values >= n_params)
     {
-        FitFunctor functor(func_, n_params, n_values);
-        Eigen::LevenbergMarquardt<FitFunctor> lm(functor);
-        lm.parameters.maxfev = 10000;
-        
-        Eigen::VectorXd x(pconf->initials());
-        
-        results->exit_flag = lm.minimize(x);
-        
-        if (n_params > 0)
+        if (schur_solver_enabled_ &&
+            SchurLevenbergMarquardt::IsApplicable(*func_, n_params))
         {
-            Eigen::covar(lm.fjac, lm.permutation.indices(),
-                         std::numeric_limits<double>::epsilon());
-            results->covariance_matrix = 
-                    lm.fjac.topLeftCorner(n_params, n_params);
-            results->residuals = lm.fvec;
+            results = MinimizeEnsemble(func_, pconf->initials(), abort_criterion_);
+        }
+        else if (fixed_size_solver_enabled_ &&
+            n_values <= MAX_FIXED_SIZE_VALUES &&
+            n_params <= MAX_FIXED_SIZE_PARAMS)
+        {
+            FixedSizeFitFunctor functor(func_, n_params, n_values);
+            FixedSizeLevenbergMarquardt<FixedSizeFitFunctor,
+                                        MAX_FIXED_SIZE_VALUES,
+                                        MAX_FIXED_SIZE_PARAMS> lm(functor);
+            Minimize(functor, lm, pconf->initials(), abort_criterion_, *results);
         }
         else
         {
-            results->covariance_matrix = Eigen::MatrixXd(0, 0);
-            functor(x, results->residuals);
+            DynamicFitFunctor functor(func_, n_params, n_values);
+            Eigen::LevenbergMarquardt<DynamicFitFunctor> lm(functor);
+            Minimize(functor, lm, pconf->initials(), abort_criterion_, *results);
         }
-        
-        results->best_estimate = x;
-        results->deviations = results->covariance_matrix.diagonal().cwiseSqrt(); 
+
         results->chi_square =
                 results->residuals.cwiseProduct(results->residuals).sum();
         results->degrees_of_freedom = n_values - n_params;
-        results->n_iterations = lm.iter;
     }
     else
     {
@@ -152,17 +280,49 @@ std::shared_ptr<FitResults> LevenbergMarquardtFitter::fit(
         results->residuals.setConstant(n_params, nan);
     }
 
-    func_->CompileResults(results);
+    func_->CompileResults(results, results_request_);
     
     return results;
 }
 
 std::shared_ptr<LevenbergMarquardtFitter> LevenbergMarquardtFitter::clone() const
 {
-    return std::make_shared<LevenbergMarquardtFitter>(func_->clone());
+    std::shared_ptr<LevenbergMarquardtFitter> ret(
+            std::make_shared<LevenbergMarquardtFitter>(func_->clone()));
+    ret->fixed_size_solver_enabled_ = fixed_size_solver_enabled_;
+    ret->schur_solver_enabled_ = schur_solver_enabled_;
+    ret->abort_criterion_ = abort_criterion_;
+    ret->results_request_ = results_request_;
+    ret->results_pool_ = results_pool_;
+    return ret;
 }
 
 std::shared_ptr<NobleFitFunction> LevenbergMarquardtFitter::GetFitFunction()
 {
     return func_;
 }
+
+void LevenbergMarquardtFitter::SetFixedSizeSolverEnabled(bool enabled)
+{
+    fixed_size_solver_enabled_ = enabled;
+}
+
+void LevenbergMarquardtFitter::SetSchurSolverEnabled(bool enabled)
+{
+    schur_solver_enabled_ = enabled;
+}
+
+void LevenbergMarquardtFitter::SetAbortCriterion(AbortCriterion criterion)
+{
+    abort_criterion_ = criterion;
+}
+
+void LevenbergMarquardtFitter::SetResultsRequest(const ResultsRequest& request)
+{
+    results_request_ = request;
+}
+
+void LevenbergMarquardtFitter::SetResultsPool(std::shared_ptr<FitResultsPool> pool)
+{
+    results_pool_ = pool;
+}
@@ -21,17 +21,26 @@
 
 #include <Eigen/Dense>
 
+#include <functional>
 #include <memory>
 
 #include "fitparameterconfig.h"
 #include "fitresults.h"
+#include "resultsrequest.h"
 
+class FitResultsPool;
 class NobleFitFunction;
 
 //! Führt einen Levenberg-Marquardt-Least-Squares-Fit durch.
 class LevenbergMarquardtFitter
 {
 public:
+    //! Abbruchkriterium, das nach jeder Iteration mit deren Zahl und dem aktuellen χ² aufgerufen wird.
+    /*!
+      Gibt es true zurück, wird der Fit mit dem Status Eigen::LM::UserAsked beendet.
+      */
+    typedef std::function<bool(int n_iterations, double chi_square)> AbortCriterion;
+
     //! Konstruktor.
     /*!
       \param func Zu verwendende Fitfunktion.
@@ -55,10 +64,56 @@ public:
     //! Gibt die verwendete Fitfunktion zurück.
     std::shared_ptr<NobleFitFunction> GetFitFunction();
 
+    //! Legt fest, ob für kleine Probleme FixedSizeLevenbergMarquardt verwendet werden darf.
+    /*!
+      Standardmäßig aktiviert. Bei bis zu sechs Residuen und Parametern liegen dann Jacobi-Matrix,
+      QR-Zerlegung und Arbeitsvektoren auf dem Stack.
+      */
+    void SetFixedSizeSolverEnabled(bool enabled);
+
+    //! Legt fest, ob Ensemblefits mit SchurLevenbergMarquardt durchgeführt werden dürfen.
+    /*!
+      Standardmäßig aktiviert. Die Ergebnisse sind dann vom Typ EnsembleFitResults und enthalten
+      die Kovarianzen nur blockweise je Probe.
+      */
+    void SetSchurSolverEnabled(bool enabled);
+
+    //! Setzt ein Abbruchkriterium, mit dem laufende Fits vorzeitig beendet werden können.
+    void SetAbortCriterion(AbortCriterion criterion);
+
+    //! Legt fest, welche Gaskonzentrationen nach dem Fit berechnet werden.
+    /*!
+      Standardmäßig alle. Werden nur wenige Ergebnisspalten benötigt (etwa bei Monte-Carlo-Fits),
+      spart dies den Großteil der Nachbearbeitung.
+      */
+    void SetResultsRequest(const ResultsRequest& request);
+
+    //! Legt fest, aus welchem Vorrat die Ergebnisobjekte stammen.
+    /*!
+      Standardmäßig wird für jeden Fit ein neues Objekt angelegt. Ergebnisse von
+      Ensemblefits mit SchurLevenbergMarquardt stammen nie aus dem Vorrat.
+      */
+    void SetResultsPool(std::shared_ptr<FitResultsPool> pool);
+
 private:
     
     //! Zeiger auf die verwendete Fitfunktion.
     std::shared_ptr<NobleFitFunction> func_;
+
+    //! Gibt an, ob für kleine Probleme FixedSizeLevenbergMarquardt verwendet wird.
+    bool fixed_size_solver_enabled_;
+
+    //! Gibt an, ob Ensemblefits mit SchurLevenbergMarquardt durchgeführt werden.
+    bool schur_solver_enabled_;
+
+    //! Abbruchkriterium, leer falls keines gesetzt ist.
+    AbortCriterion abort_criterion_;
+
+    //! Nach dem Fit zu berechnende Gaskonzentrationen.
+    ResultsRequest results_request_;
+
+    //! Vorrat für die Ergebnisobjekte, leer falls keiner gesetzt ist.
+    std::shared_ptr<FitResultsPool> results_pool_;
 };
 
 #endif // LEVENBERGMARQUARDTFITTER_H
@@ -0,0 +1,264 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/chrono.hpp>
+#include <boost/random.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+#include "levenbergmarquardtfitter.h"
+
+#include "multistartfitter.h"
+
+MultiStartSettings::MultiStartSettings() :
+    n_starts(1),
+    n_threads(0),
+    time_budget(0.),
+    prune_iterations(5),
+    prune_factor(10.),
+    distinct_tolerance(1e-3),
+    seed(0)
+{
+}
+
+namespace
+{
+//! Vergleicht zwei Ergebnisse. Abgebrochene Fits kommen nur in Frage, falls kein Fit abgeschlossen wurde.
+bool IsBetter(const FitResults& a, const FitResults& b)
+{
+    const bool a_aborted = a.exit_flag == Eigen::LM::UserAsked;
+    const bool b_aborted = b.exit_flag == Eigen::LM::UserAsked;
+    if (a_aborted != b_aborted)
+        return b_aborted;
+    return a.chi_square < b.chi_square;
+}
+
+bool IsConverged(const FitResults& results)
+{
+    return results.exit_flag >= Eigen::LM::RelativeReductionTooSmall &&
+           results.exit_flag <= Eigen::LM::CosinusTooSmall &&
+           std::isfinite(results.chi_square);
+}
+}
+
+struct MultiStartFitter::SharedState
+{
+    std::shared_ptr<const FitParameterConfig> pconf;
+    std::vector<Eigen::VectorXd> starting_points;
+    std::vector<std::shared_ptr<FitResults>> results;
+    boost::chrono::steady_clock::time_point deadline;
+    bool has_deadline;
+
+    boost::mutex mutex;
+    unsigned next_start;
+    double best_chi_square;
+};
+
+MultiStartFitter::MultiStartFitter(
+        std::shared_ptr<const LevenbergMarquardtFitter> fitter,
+        const MultiStartSettings& settings) :
+    fitter_(fitter),
+    settings_(settings)
+{
+}
+
+MultiStartResults MultiStartFitter::fit(std::shared_ptr<const FitParameterConfig> pconf) const
+{
+    SharedState state;
+    state.pconf = pconf;
+    state.starting_points = CreateStartingPoints(*pconf,
+                                                 std::max(settings_.n_starts, 1u),
+                                                 settings_.seed);
+    state.results.resize(state.starting_points.size());
+    state.has_deadline = settings_.time_budget > 0.;
+    if (state.has_deadline)
+        state.deadline = boost::chrono::steady_clock::now() +
+                boost::chrono::duration_cast<boost::chrono::steady_clock::duration>(
+                    boost::chrono::duration<double>(settings_.time_budget));
+    state.next_start = 0;
+    state.best_chi_square = std::numeric_limits<double>::infinity();
+
+    unsigned n_threads = settings_.n_threads;
+    if (n_threads == 0) n_threads = boost::thread::hardware_concurrency();
+    if (n_threads == 0) n_threads = 1;
+    n_threads = std::min<unsigned>(n_threads, state.starting_points.size());
+
+    boost::thread_group threads;
+    for (unsigned l = 1; l < n_threads; ++l)
+        threads.create_thread(std::bind(&MultiStartFitter::PerformFits,
+                                        this,
+                                        std::ref(state)));
+    PerformFits(state);
+    threads.join_all();
+
+    MultiStartResults multi_start_results;
+    std::vector<std::shared_ptr<FitResults>> finished;
+    for (const auto& results : state.results)
+    {
+        if (!results)
+        {
+            ++multi_start_results.n_skipped;
+            continue;
+        }
+        if (results->exit_flag == Eigen::LM::UserAsked)
+        {
+            ++multi_start_results.n_pruned;
+        }
+        else
+        {
+            ++multi_start_results.n_completed;
+            finished.push_back(results);
+        }
+
+        if (!multi_start_results.best || IsBetter(*results, *multi_start_results.best))
+            multi_start_results.best = results;
+    }
+
+    SelectDistinctMinima(*pconf, finished, multi_start_results);
+
+    return multi_start_results;
+}
+
+std::vector<Eigen::VectorXd> MultiStartFitter::CreateStartingPoints(
+        const FitParameterConfig& pconf,
+        unsigned n_starts,
+        unsigned seed)
+{
+    std::vector<Eigen::VectorXd> points(n_starts, pconf.initials());
+    if (n_starts < 2)
+        return points;
+
+    boost::random::mt19937 generator(seed);
+    boost::random::uniform_01<double> uniform;
+
+    const unsigned n_strata = n_starts - 1;
+    std::vector<unsigned> strata(n_strata);
+    for (unsigned j = 0; j < pconf.size(); ++j)
+    {
+        const double lower = pconf.lower_bounds()[j];
+        const double upper = pconf.upper_bounds()[j];
+        if (!std::isfinite(lower) || !std::isfinite(upper))
+            continue;
+
+        std::iota(strata.begin(), strata.end(), 0u);
+        for (unsigned k = n_strata - 1; k > 0; --k)
+        {
+            boost::random::uniform_int_distribution<unsigned> index(0, k);
+            std::swap(strata[k], strata[index(generator)]);
+        }
+
+        for (unsigned k = 0; k < n_strata; ++k)
+            points[k + 1][j] = lower + (upper - lower) * (strata[k] + uniform(generator)) / n_strata;
+    }
+
+    return points;
+}
+
+void MultiStartFitter::PerformFits(SharedState& state) const
+{
+    std::shared_ptr<LevenbergMarquardtFitter> fitter(fitter_->clone());
+    const int prune_iterations = settings_.prune_iterations;
+    const double prune_factor = settings_.prune_factor;
+    fitter->SetAbortCriterion([&](int n_iterations, double chi_square)
+    {
+        if (state.has_deadline && boost::chrono::steady_clock::now() > state.deadline)
+            return true;
+        if (n_iterations < prune_iterations)
+            return false;
+        boost::lock_guard<boost::mutex> lock(state.mutex);
+        return chi_square > prune_factor * state.best_chi_square;
+    });
+
+    FitParameterConfig pconf(*state.pconf);
+    while (true)
+    {
+        unsigned i;
+        {
+            boost::lock_guard<boost::mutex> lock(state.mutex);
+            i = state.next_start++;
+            if (i >= state.starting_points.size()) return;
+        }
+        // Von den Anfangswerten aus wird immer gefittet, damit es ein Ergebnis gibt.
+        if (i > 0 && state.has_deadline &&
+            boost::chrono::steady_clock::now() > state.deadline)
+            return;
+
+        for (unsigned j = 0; j < pconf.size(); ++j)
+            pconf.ChangeParameterInitial(j, state.starting_points[i][j]);
+
+        std::shared_ptr<FitResults> results(
+                fitter->fit(std::make_shared<FitParameterConfig>(pconf)));
+
+        boost::lock_guard<boost::mutex> lock(state.mutex);
+        state.results[i] = results;
+        if (results->exit_flag != Eigen::LM::UserAsked &&
+            results->chi_square < state.best_chi_square)
+            state.best_chi_square = results->chi_square;
+    }
+}
+
+void MultiStartFitter::SelectDistinctMinima(
+        const FitParameterConfig& pconf,
+        const std::vector<std::shared_ptr<FitResults>>& results,
+        MultiStartResults& multi_start_results) const
+{
+    std::vector<std::shared_ptr<FitResults>> converged;
+    for (const auto& r : results)
+        if (IsConverged(*r))
+            converged.push_back(r);
+
+    std::stable_sort(converged.begin(), converged.end(),
+                     [](const std::shared_ptr<FitResults>& a,
+                        const std::shared_ptr<FitResults>& b)
+    {
+        return a->chi_square < b->chi_square;
+    });
+
+    auto is_same_minimum = [&](const FitResults& a, const FitResults& b)
+    {
+        for (unsigned j = 0; j < pconf.size(); ++j)
+        {
+            const double range = pconf.upper_bounds()[j] - pconf.lower_bounds()[j];
+            const double scale = std::isfinite(range) ?
+                        range :
+                        std::max(std::abs(a.best_estimate[j]), std::abs(b.best_estimate[j]));
+            if (std::abs(a.best_estimate[j] - b.best_estimate[j]) >
+                    settings_.distinct_tolerance * scale)
+                return false;
+        }
+        return true;
+    };
+
+    for (const auto& candidate : converged)
+    {
+        bool is_distinct = true;
+        for (const auto& minimum : multi_start_results.local_minima)
+            if (is_same_minimum(*candidate, *minimum))
+            {
+                is_distinct = false;
+                break;
+            }
+        if (is_distinct)
+            multi_start_results.local_minima.push_back(candidate);
+    }
+}
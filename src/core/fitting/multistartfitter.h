@@ -0,0 +1,135 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef MULTISTARTFITTER_H
+#define MULTISTARTFITTER_H
+
+#include <Eigen/Core>
+
+#include <memory>
+#include <vector>
+
+#include "fitparameterconfig.h"
+#include "fitresults.h"
+
+class LevenbergMarquardtFitter;
+
+//! Einstellungen für MultiStartFitter.
+struct MultiStartSettings
+{
+    MultiStartSettings();
+
+    //! Zahl der Startpunkte. Bei 1 wird nur von den Anfangswerten aus gefittet.
+    unsigned n_starts;
+
+    //! Zahl der Threads, 0 verwendet alle verfügbaren Prozessorkerne.
+    unsigned n_threads;
+
+    //! Verfügbare Rechenzeit in Sekunden, ≤ 0 bedeutet unbegrenzt.
+    double time_budget;
+
+    //! Iteration, ab der Fits mit aussichtslosem χ² abgebrochen werden.
+    int prune_iterations;
+
+    //! \brief Fits werden abgebrochen, wenn ihr χ² das beste bisher gefundene
+    //! um mehr als diesen Faktor übersteigt.
+    double prune_factor;
+
+    //! \brief Relativer Abstand (bezogen auf die Parametergrenzen), ab dem zwei
+    //! Minima als verschieden gelten.
+    double distinct_tolerance;
+
+    //! Startwert des Zufallszahlengenerators für die Wahl der Startpunkte.
+    unsigned seed;
+};
+
+//! Ergebnisse eines MultiStartFitter-Laufs.
+struct MultiStartResults
+{
+    MultiStartResults() : n_completed(0), n_pruned(0), n_skipped(0) {}
+
+    //! Ergebnis mit dem kleinsten χ².
+    std::shared_ptr<FitResults> best;
+
+    //! Voneinander verschiedene konvergierte Minima, aufsteigend nach χ² sortiert.
+    std::vector<std::shared_ptr<FitResults>> local_minima;
+
+    //! Zahl der vollständig durchgeführten Fits.
+    unsigned n_completed;
+
+    //! Zahl der Fits, die wegen aussichtslosem χ² oder Zeitüberschreitung abgebrochen wurden.
+    unsigned n_pruned;
+
+    //! Zahl der Startpunkte, die wegen Zeitüberschreitung nicht mehr begonnen wurden.
+    unsigned n_skipped;
+};
+
+//! Sucht das globale Minimum durch parallele Fits von mehreren Startpunkten aus.
+/*!
+  Modelle wie GR, PD und PR besitzen mehrere lokale Minima. Der erste Startpunkt sind die
+  Anfangswerte aus der FitParameterConfig, die übrigen bilden ein Latin Hypercube innerhalb der
+  Parametergrenzen. Parameter ohne endliche Grenzen behalten ihren Anfangswert. Die Grenzen
+  bestimmen nur die Startpunkte, die Fits selbst bleiben unbeschränkt.
+
+  Sobald ein Fit abgeschlossen ist, werden weitere Fits abgebrochen, deren χ² nach
+  MultiStartSettings::prune_iterations Iterationen noch um mehr als
+  MultiStartSettings::prune_factor über dem besten liegt.
+  */
+class MultiStartFitter
+{
+public:
+    //! Konstruktor.
+    /*!
+      \param fitter Fitter, von dem für jeden Thread eine Kopie erzeugt wird.
+      \param settings Zu verwendende Einstellungen.
+      */
+    MultiStartFitter(std::shared_ptr<const LevenbergMarquardtFitter> fitter,
+                     const MultiStartSettings& settings);
+
+    //! Führt die Fits aus.
+    /*!
+      \param pconf Zu verwendende ParameterConfig mit Anfangswerten und Grenzen.
+      */
+    MultiStartResults fit(std::shared_ptr<const FitParameterConfig> pconf) const;
+
+    //! Erzeugt die Startpunkte.
+    /*!
+      \param pconf ParameterConfig mit Anfangswerten und Grenzen.
+      \param n_starts Zahl der Startpunkte.
+      \param seed Startwert des Zufallszahlengenerators.
+      */
+    static std::vector<Eigen::VectorXd> CreateStartingPoints(const FitParameterConfig& pconf,
+                                                             unsigned n_starts,
+                                                             unsigned seed);
+
+private:
+    struct SharedState;
+
+    //! Arbeitet Startpunkte ab, bis keine mehr übrig sind oder die Zeit abgelaufen ist.
+    void PerformFits(SharedState& state) const;
+
+    //! Sortiert die konvergierten Ergebnisse und entfernt Duplikate desselben Minimums.
+    void SelectDistinctMinima(const FitParameterConfig& pconf,
+                              const std::vector<std::shared_ptr<FitResults>>& results,
+                              MultiStartResults& multi_start_results) const;
+
+    std::shared_ptr<const LevenbergMarquardtFitter> fitter_;
+    MultiStartSettings settings_;
+};
+
+#endif // MULTISTARTFITTER_H
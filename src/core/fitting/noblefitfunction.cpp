@@ -16,10 +16,13 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <stdexcept>
 
+#include "core/misc/rundata.h"
+
 #include "fitresults.h"
 
 #include "noblefitfunction.h"
@@ -29,148 +32,178 @@ NobleFitFunction::NobleFitFunction(
         const NobleParameterMap& parameter_map,
         const std::vector<std::map<GasType, Data> >& concentrations
         ) :
-    models_(concentrations.size()),
     parameter_map_(parameter_map),
-    concentrations_(concentrations),
-    n_concentrations_(NumberOfConcentrations())
+    sample_offsets_(1, 0)
 {
-    for (unsigned i = 0; i < models_.size(); ++i)
-    {
-        models_[i] = model->clone();
-    }
-
-    SetupDerivatives();
+    for (const auto& sample : concentrations)
+        AddSample(sample);
 
-    if (concentrations_.size() != parameter_map_.GetNumberOfSamples())
-        throw std::invalid_argument("The number of samples for which concentrations have been provided "
-                                    "does not match the number of samples for which parameter "
-                                    "mappings have been defined.");
+    Initialize(model);
 }
 
-NobleFitFunction::~NobleFitFunction()
+NobleFitFunction::NobleFitFunction(
+        std::shared_ptr<const CombinedModel> model,
+        const NobleParameterMap& parameter_map,
+        const RunData& concentrations,
+        const std::vector<unsigned>& samples
+        ) :
+    parameter_map_(parameter_map),
+    sample_offsets_(1, 0)
 {
+    for (unsigned sample : samples)
+    {
+        if (sample >= concentrations.EnabledSize())
+            throw std::out_of_range("Sample index out of range.");
+        const unsigned index = concentrations.GetIndexOfEnabledSample(sample);
+        for (GasType gas = Gas::begin; gas != Gas::end_including_HE3; ++gas)
+            if (concentrations.HasGas(index, gas))
+            {
+                gases_.push_back(gas);
+                values_.push_back(concentrations.GetValues(gas)[index]);
+                errors_.push_back(concentrations.GetErrors(gas)[index]);
+            }
+        sample_offsets_.push_back(gases_.size());
+    }
+
+    Initialize(model);
 }
 
-void NobleFitFunction::SetParameters(const Eigen::VectorXd& parameters)
+void NobleFitFunction::Initialize(std::shared_ptr<const CombinedModel> model)
 {
-    parameters_ = parameter_map_.MapParameterValues(parameters);
-
-    assert(parameters_.size() == concentrations_.size());
+    if (NumberOfSamples() != parameter_map_.GetNumberOfSamples())
+        throw std::invalid_argument("The number of samples for which concentrations have been provided "
+                                    "does not match the number of samples for which parameter "
+                                    "mappings have been defined.");
 
+    models_.resize(NumberOfSamples());
     for (unsigned i = 0; i < models_.size(); ++i)
-        models_[i]->SetParameters(parameters_[i]);
+    {
+        models_[i] = model->clone();
+    }
+
+    SetupDerivatives();
 }
 
-void NobleFitFunction::CalcResiduals(Eigen::VectorXd& residuals) const
+void NobleFitFunction::AddSample(const std::map<GasType, Data>& concentrations)
 {
-    residuals.resize(n_concentrations_);
-
-    int i = 0;
-    int k = 0;
-    for (std::vector<std::map<GasType, Data> >::const_iterator it = concentrations_.begin();
-         it != concentrations_.end();
-         ++it, ++i)
+    for (const auto& concentration : concentrations)
     {
-        for (std::map<GasType, Data>::const_iterator jt = it->begin();
-             jt != it->end();
-             ++jt, ++k)
-        {
-            residuals[k] = (jt->second.value - models_[i]->CalculateConcentration(jt->first)) /
-                           jt->second.error;
-        }
+        gases_.push_back(concentration.first);
+        values_.push_back(concentration.second.value);
+        errors_.push_back(concentration.second.error);
     }
+    sample_offsets_.push_back(gases_.size());
 }
 
-void NobleFitFunction::CalcJacobian(Eigen::MatrixXd &jacobian) const
+NobleFitFunction::~NobleFitFunction()
+{
+}
+
+void NobleFitFunction::CalcSampleJacobian(
+        unsigned sample,
+        Eigen::MatrixXd& jacobian) const
 {
-    jacobian.resize(n_concentrations_, parameter_map_.GetNumberOfFitParameters());
+    const unsigned begin = sample_offsets_[sample];
+    jacobian.resize(NumberOfConcentrations(sample),
+                    sample_fit_parameters_[sample].size());
 
-    int i = 0;
-    int k = 0;
-    for (std::vector<std::map<GasType, Data> >::const_iterator it = concentrations_.begin();
-         it != concentrations_.end();
-         ++it, ++i)
+    for (unsigned k = begin; k < sample_offsets_[sample + 1]; ++k)
     {
-        for (std::map<GasType, Data>::const_iterator jt = it->begin();
-             jt != it->end();
-             ++jt, ++k)
-        {
-            jacobian.row(k) = -models_[i]->CalculateDerivatives(jt->first) / jt->second.error;
-        }
+        jacobian.row(k - begin) = -models_[sample]->CalculateDerivatives(gases_[k]) / errors_[k];
     }
 }
 
 void NobleFitFunction::CompileResults(
-    std::shared_ptr<FitResults> results
+    std::shared_ptr<FitResults> results,
+    const ResultsRequest& request
     )
 {
-    results->equilibrium_concentrations.resize(concentrations_.size());
-    results->      model_concentrations.resize(concentrations_.size());
-    results->   measured_concentrations.resize(concentrations_.size());
+    results->equilibrium_concentrations.resize(NumberOfSamples());
+    results->      model_concentrations.resize(NumberOfSamples());
+    results->   measured_concentrations.resize(NumberOfSamples());
     results->residual_gases.resize(results->residuals.size());
 
-    SetParameters(results->best_estimate);
-
-    unsigned residuals_counter = 0;
-    for (unsigned i = 0; i < concentrations_.size(); ++i)
-    {
-        Eigen::MatrixXd equilibrium_jacobian(
-                    static_cast<unsigned>(Gas::end_including_HE3),
-                    parameter_map_.GetNumberOfFitParameters());
-
-        Eigen::MatrixXd model_jacobian(
-                    static_cast<unsigned>(Gas::end_including_HE3),
-                    parameter_map_.GetNumberOfFitParameters());
-
-        unsigned j = 0;
-        for (GasType gas = Gas::begin;
-             gas != Gas::end_including_HE3;
-             ++gas, ++j)
-        {
-            results->equilibrium_concentrations[i][gas].value =
-                    models_[i]->CalculateEquilibriumConcentration(gas);
-
-            results->model_concentrations[i][gas].value =
-                    models_[i]->CalculateConcentration(gas);
-
-            equilibrium_jacobian.row(j) = models_[i]->CalculateEquilibriumDerivatives(gas);
-            model_jacobian.row(j) = models_[i]->CalculateDerivatives(gas);
+    const unsigned calculated = ResultsRequest::EQUILIBRIUM_VALUE |
+                                ResultsRequest::EQUILIBRIUM_ERROR |
+                                ResultsRequest::MODEL_VALUE |
+                                ResultsRequest::MODEL_ERROR;
+    const unsigned errors = ResultsRequest::EQUILIBRIUM_ERROR |
+                            ResultsRequest::MODEL_ERROR;
 
-            if (concentrations_[i].count(gas))
-                results->measured_concentrations[i][gas] = concentrations_[i][gas];
-        }
-
-        Eigen::MatrixXd equilibrium_covariances = equilibrium_jacobian *
-                                            results->covariance_matrix *
-                                            equilibrium_jacobian.transpose();
+    if (request.IsRequested(calculated))
+        SetParameters(results->best_estimate);
 
-        Eigen::MatrixXd model_covariances = model_jacobian *
-                                            results->covariance_matrix *
-                                            model_jacobian.transpose();
+    for (unsigned i = 0; i < NumberOfSamples(); ++i)
+    {
+        // Die Ableitungen nach allen anderen Fitparametern verschwinden, daher genügen die
+        // Kovarianzen der Parameter, von denen diese Probe abhängt.
+        Eigen::MatrixXd covariances;
+        if (request.IsRequested(errors))
+            covariances = results->SelectCovariances(sample_fit_parameters_[i]);
 
-        j = 0;
         for (GasType gas = Gas::begin;
              gas != Gas::end_including_HE3;
-             ++gas, ++j)
+             ++gas)
         {
-            results->equilibrium_concentrations[i][gas].error =
-                    std::sqrt(equilibrium_covariances(j, j));
-
-            results->model_concentrations[i][gas].error =
-                    std::sqrt(model_covariances(j, j));
+            if (request.IsRequested(gas, ResultsRequest::EQUILIBRIUM_VALUE |
+                                         ResultsRequest::EQUILIBRIUM_ERROR))
+            {
+                Data& equilibrium = results->equilibrium_concentrations[i][gas];
+                equilibrium.value = models_[i]->CalculateEquilibriumConcentration(gas);
+                if (request.IsRequested(gas, ResultsRequest::EQUILIBRIUM_ERROR))
+                {
+                    const Eigen::RowVectorXd& derivatives =
+                            models_[i]->CalculateEquilibriumDerivatives(gas);
+                    equilibrium.error =
+                            std::sqrt((derivatives * covariances).dot(derivatives));
+                }
+            }
+
+            // Auch für die Fehler nötig, da CalculateConcentration die
+            // Gleichgewichtskonzentration für CalculateDerivatives zwischenspeichert.
+            if (request.IsRequested(gas, ResultsRequest::MODEL_VALUE |
+                                         ResultsRequest::MODEL_ERROR))
+            {
+                Data& model = results->model_concentrations[i][gas];
+                model.value = models_[i]->CalculateConcentration(gas);
+                if (request.IsRequested(gas, ResultsRequest::MODEL_ERROR))
+                {
+                    const Eigen::RowVectorXd& derivatives =
+                            models_[i]->CalculateDerivatives(gas);
+                    model.error = std::sqrt((derivatives * covariances).dot(derivatives));
+                }
+            }
+
+            if (request.IsRequested(gas, ResultsRequest::MEASURED))
+            {
+                const auto begin = gases_.begin() + sample_offsets_[i];
+                const auto end = gases_.begin() + sample_offsets_[i + 1];
+                const auto it = std::find(begin, end, gas);
+                if (it != end)
+                {
+                    const unsigned k = it - gases_.begin();
+                    results->measured_concentrations[i][gas] = Data(values_[k], errors_[k]);
+                }
+                else
+                    // Wiederverwendete Ergebnisobjekte (FitResultsPool) können noch
+                    // Messwerte einer anderen Probe enthalten.
+                    results->measured_concentrations[i].erase(gas);
+            }
         }
-        for (const auto& concentration : concentrations_[i])
-            results->residual_gases[residuals_counter++] = concentration.first;
     }
+    std::copy(gases_.begin(), gases_.end(), results->residual_gases.begin());
 }
 
 std::shared_ptr<NobleFitFunction> NobleFitFunction::clone() const
 {
     std::shared_ptr<NobleFitFunction> ret(std::make_shared<NobleFitFunction>(*this));
 
-    for (unsigned i = 0; i < concentrations_.size(); ++i)
+    for (unsigned i = 0; i < models_.size(); ++i)
         ret->models_[i] = models_[i]->clone();
 
+    // CombinedModel::clone übernimmt die Einrichtung der Ableitungen nicht.
+    ret->SetupDerivatives();
+
     return ret;
 }
 
@@ -188,22 +221,38 @@ void NobleFitFunction::ResetParameters()
 
 void NobleFitFunction::SetupDerivatives()
 {
+    sample_fit_parameters_.resize(models_.size());
     for (unsigned i = 0; i < models_.size(); ++i)
     {
-        models_[i]->SetupDerivatives(parameter_map_.GetIndicesOfFittedParameters(i));
+        const std::vector<int>& indices = parameter_map_.GetIndicesOfFittedParameters(i);
+        std::vector<int> model_parameters;
+        sample_fit_parameters_[i].clear();
+        for (unsigned j = 0; j < indices.size(); ++j)
+            if (indices[j] >= 0)
+            {
+                model_parameters.push_back(indices[j]);
+                sample_fit_parameters_[i].push_back(j);
+            }
+        models_[i]->SetupDerivatives(model_parameters);
     }
 }
 
 unsigned NobleFitFunction::NumberOfConcentrations() const
 {
-    unsigned n = 0;
+    return gases_.size();
+}
 
-    for (std::vector<std::map<GasType, Data> >::const_iterator it = concentrations_.begin();
-         it != concentrations_.end();
-         ++it)
-    {
-        n += it->size();
-    }
+unsigned NobleFitFunction::NumberOfConcentrations(unsigned sample) const
+{
+    return sample_offsets_[sample + 1] - sample_offsets_[sample];
+}
 
-    return n;
+unsigned NobleFitFunction::NumberOfSamples() const
+{
+    return sample_offsets_.size() - 1;
+}
+
+const std::vector<unsigned>& NobleFitFunction::GetFitParametersOfSample(unsigned sample) const
+{
+    return sample_fit_parameters_[sample];
 }
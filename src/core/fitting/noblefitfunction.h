@@ -19,6 +19,7 @@
 #ifndef NOBLEFITFUNCTION_H
 #define NOBLEFITFUNCTION_H
 
+#include <cassert>
 #include <memory>
 
 #include <map>
@@ -31,6 +32,9 @@
 
 #include "levenbergmarquardtfitter.h"
 #include "nobleparametermap.h"
+#include "resultsrequest.h"
+
+class RunData;
 
 //! Wird zum Fitten eines Edelgas-Modells an gemessene Grundwasserkonzentrationen verwendet.
 /*!
@@ -52,28 +56,59 @@ public:
         const NobleParameterMap& parameter_map,
         const std::vector<std::map<GasType, Data> >& concentrations);
 
+    //! Erzeugt die Fitfunktion aus den Spalten von RunData, ohne Konzentrations-Maps anzulegen.
+    /*!
+     * \param concentrations Messdaten aller Proben.
+     * \param samples Indizes der am Fit beteiligten Proben unter den aktivierten Proben.
+     * \throws std::out_of_range Falls ein Index zu groß ist.
+     */
+    NobleFitFunction(
+        std::shared_ptr<const CombinedModel> model,
+        const NobleParameterMap& parameter_map,
+        const RunData& concentrations,
+        const std::vector<unsigned>& samples);
+
     ~NobleFitFunction();
 
     //! Legt die Parameter für die kommenden Berechnungen fest.
     /*!
       \param parameters Für kommende Berechnungen zu verwendende Parameter.
       */
-    void SetParameters(const Eigen::VectorXd& parameters);
+    template<typename Derived>
+    void SetParameters(const Eigen::MatrixBase<Derived>& parameters);
 
     //! Berechnet die Residuen für die übergebenen Parameter.
     /*!
+      Akzeptiert auch Vektoren mit fester Maximalgröße, wie sie von
+      FixedSizeLevenbergMarquardt verwendet werden.
       \param residuals Muss nach dem Aufruf den Residuen-Vektor beinhalten.
       */
-    void CalcResiduals(Eigen::VectorXd& residuals) const;
+    template<typename VectorType>
+    void CalcResiduals(VectorType& residuals) const;
 
     //! Berechnet die Jacobi-Matrix.
     /*!
       \param jacobi Muss nach dem Aufruf die Jacobi-Matrix beinhalten.
       */
-    void CalcJacobian(Eigen::MatrixXd& jacobian) const;
+    template<typename MatrixType>
+    void CalcJacobian(MatrixType& jacobian) const;
+
+    //! Berechnet den zu einer Probe gehörenden Block der Jacobi-Matrix.
+    /*!
+      Enthält nur die Zeilen der Konzentrationen dieser Probe und nur die Spalten der Fitparameter,
+      von denen die Probe abhängt (siehe GetFitParametersOfSample).
+      \param sample Index der Probe.
+      \param jacobian Muss nach dem Aufruf den Block der Jacobi-Matrix beinhalten.
+      */
+    void CalcSampleJacobian(unsigned sample, Eigen::MatrixXd& jacobian) const;
 
     //! Gibt der Fitfunktion die Gelegenheit eventuelle weitere Ergebnisse zu speichern.
-    void CompileResults(std::shared_ptr<FitResults> results);
+    /*!
+      \param results Ergebnisse des Fits, die ergänzt werden.
+      \param request Legt fest, welche Gaskonzentrationen berechnet werden.
+      */
+    void CompileResults(std::shared_ptr<FitResults> results,
+                        const ResultsRequest& request = ResultsRequest::All());
 
     std::shared_ptr<NobleFitFunction> clone() const;
 
@@ -93,8 +128,31 @@ public:
     //! Bestimmt die Zahl der vorhandenen Gaskonzentrationen.
     unsigned NumberOfConcentrations() const;
 
+    //! Gibt die Zahl der Gaskonzentrationen einer einzelnen Probe zurück.
+    unsigned NumberOfConcentrations(unsigned sample) const;
+
+    //! Gibt die Zahl der am Fit beteiligten Proben zurück.
+    unsigned NumberOfSamples() const;
+
+    //! Gibt die aufsteigend sortierten Indizes der Fitparameter zurück, von denen eine Probe abhängt.
+    const std::vector<unsigned>& GetFitParametersOfSample(unsigned sample) const;
+
+    //! Variiert jeden Messwert um ein Vielfaches seines Fehlers, etwa für Monte-Carlo-Fits.
+    /*!
+      \param random Liefert bei jedem Aufruf den Faktor für den nächsten Messwert. Die Messwerte
+        werden probenweise und innerhalb einer Probe nach Gasen geordnet durchlaufen.
+      */
+    template<typename Generator>
+    void VaryMeasuredValues(Generator& random);
+
 private:
 
+    //! Prüft die Messdaten und legt die Modelle an.
+    void Initialize(std::shared_ptr<const CombinedModel> model);
+
+    //! Hängt die Messwerte einer Probe an.
+    void AddSample(const std::map<GasType, Data>& concentrations);
+
     //! Initialisiert die Ableitungen der Modelle in models_ neu.
     void SetupDerivatives();
 
@@ -104,14 +162,74 @@ private:
     //! Verwendete NobleParameterMap. Zum Beschreiben der Abbildungen von Fit- auf Modellparameter.
     NobleParameterMap parameter_map_;
 
-    //! Gaskonzentrationen der verschiedenen, für den Fit verwendeten Proben.
-    std::vector<std::map<GasType, Data> > concentrations_;
+    //! Gase der Messwerte aller für den Fit verwendeten Proben, probenweise hintereinander.
+    std::vector<GasType> gases_;
+
+    //! Messwerte in der Reihenfolge von gases_.
+    std::vector<double> values_;
+
+    //! Messfehler in der Reihenfolge von gases_.
+    std::vector<double> errors_;
+
+    //! Position des ersten Messwerts jeder Probe in gases_, zuletzt die Gesamtzahl der Messwerte.
+    std::vector<unsigned> sample_offsets_;
 
     //! Modellparameter, die für die Berechnungen verwendet werden.
     std::vector<Eigen::VectorXd> parameters_;
 
-    //! Gesamtzahl aller für den Fit verwendeten Gaskonzentrationen.
-    const int n_concentrations_;
+    //! Indizes der Fitparameter, von denen die jeweilige Probe abhängt.
+    /*!
+      Die Modelle berechnen nur die Ableitungen nach diesen Parametern, in dieser Reihenfolge.
+      */
+    std::vector<std::vector<unsigned> > sample_fit_parameters_;
 };
 
+template<typename Derived>
+void NobleFitFunction::SetParameters(const Eigen::MatrixBase<Derived>& parameters)
+{
+    parameter_map_.MapParameterValues(parameters, parameters_);
+
+    assert(parameters_.size() == models_.size());
+
+    for (unsigned i = 0; i < models_.size(); ++i)
+        models_[i]->SetParameters(parameters_[i]);
+}
+
+template<typename VectorType>
+void NobleFitFunction::CalcResiduals(VectorType& residuals) const
+{
+    residuals.resize(gases_.size());
+
+    for (unsigned i = 0; i < models_.size(); ++i)
+        for (unsigned k = sample_offsets_[i]; k < sample_offsets_[i + 1]; ++k)
+            residuals[k] = (values_[k] - models_[i]->CalculateConcentration(gases_[k])) /
+                           errors_[k];
+}
+
+template<typename MatrixType>
+void NobleFitFunction::CalcJacobian(MatrixType& jacobian) const
+{
+    jacobian.resize(gases_.size(), parameter_map_.GetNumberOfFitParameters());
+
+    for (unsigned i = 0; i < models_.size(); ++i)
+    {
+        const std::vector<unsigned>& fit_parameters = sample_fit_parameters_[i];
+        for (unsigned k = sample_offsets_[i]; k < sample_offsets_[i + 1]; ++k)
+        {
+            const Eigen::RowVectorXd& derivatives =
+                    models_[i]->CalculateDerivatives(gases_[k]);
+            jacobian.row(k).setZero();
+            for (unsigned l = 0; l < fit_parameters.size(); ++l)
+                jacobian(k, fit_parameters[l]) = -derivatives[l] / errors_[k];
+        }
+    }
+}
+
+template<typename Generator>
+void NobleFitFunction::VaryMeasuredValues(Generator& random)
+{
+    for (unsigned k = 0; k < values_.size(); ++k)
+        values_[k] += random() * errors_[k];
+}
+
 #endif // NOBLEFITFUNCTION_H
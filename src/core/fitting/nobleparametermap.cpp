@@ -172,22 +172,8 @@ void NobleParameterMap::ResetParameters()
 
 std::vector<Eigen::VectorXd> NobleParameterMap::MapParameterValues(const Eigen::VectorXd &fit_parameters) const
 {
-    assert(fit_parameters.size() == GetNumberOfFitParameters());
-
-    std::vector<Eigen::VectorXd> parameters(current_map_.size());
-
-    for (unsigned i = 0; i < current_map_.size(); ++i)
-    {
-        parameters[i].resize(current_map_[i].size());
-        for (unsigned j = 0; j < current_map_[i].size(); ++j)
-        {
-            const Parameter& parameter = current_map_[i][j];
-            parameters[i][j] = parameter.fitted ?
-                               fit_parameters(parameter.target_index) :
-                               parameter.value;
-        }
-    }
-
+    std::vector<Eigen::VectorXd> parameters;
+    MapParameterValues(fit_parameters, parameters);
     return parameters;
 }
 
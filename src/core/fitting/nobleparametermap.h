@@ -25,6 +25,7 @@
 
 #include <Eigen/Core>
 
+#include <cassert>
 #include <vector>
 
 #include "core/models/combinedmodelfactory.h"
@@ -79,6 +80,17 @@ public:
       */
     std::vector<Eigen::VectorXd> MapParameterValues(const Eigen::VectorXd& fit_parameters) const;
 
+    //! Bestimmt die Modellparameter für die gegebenen Fitparametern.
+    /*!
+      Verwendet den bereits in \a parameters vorhandenen Speicher wieder, sodass bei wiederholten
+      Aufrufen keine neuen Vektoren angelegt werden müssen.
+      \param fit_parameters Zu verwendende Fitparameter.
+      \param parameters Enthält nach dem Aufruf die Modellparameter.
+      */
+    template<typename Derived>
+    void MapParameterValues(const Eigen::MatrixBase<Derived>& fit_parameters,
+                            std::vector<Eigen::VectorXd>& parameters) const;
+
     //! Gibt die Indizes der Parameter an, die gefittet werden.
     /*!
       \param sample_index Index der Probe.
@@ -144,6 +156,28 @@ public:
     std::string msg_;
 };
 
+template<typename Derived>
+void NobleParameterMap::MapParameterValues(
+        const Eigen::MatrixBase<Derived>& fit_parameters,
+        std::vector<Eigen::VectorXd>& parameters) const
+{
+    assert(fit_parameters.size() == GetNumberOfFitParameters());
+
+    parameters.resize(current_map_.size());
+
+    for (unsigned i = 0; i < current_map_.size(); ++i)
+    {
+        parameters[i].resize(current_map_[i].size());
+        for (unsigned j = 0; j < current_map_[i].size(); ++j)
+        {
+            const Parameter& parameter = current_map_[i][j];
+            parameters[i][j] = parameter.fitted ?
+                               fit_parameters(parameter.target_index) :
+                               parameter.value;
+        }
+    }
+}
+
 BOOST_FUSION_ADAPT_STRUCT
 (
     NobleParameterMap::Parameter,
@@ -0,0 +1,346 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "core/misc/rundata.h"
+
+#include "levenbergmarquardtfitter.h"
+#include "noblefitfunction.h"
+
+#include "profilelikelihoodscanner.h"
+
+ProfileLikelihoodSettings::ProfileLikelihoodSettings() :
+    n_steps(20),
+    range(4.),
+    delta_chi_square(1.),
+    max_delta_chi_square(9.),
+    n_threads(0)
+{
+}
+
+ParameterProfile::ParameterProfile() :
+    parameter_name(),
+    best_estimate(std::numeric_limits<double>::quiet_NaN()),
+    chi_square_min(std::numeric_limits<double>::quiet_NaN()),
+    values(),
+    chi_squares(),
+    lower_bound(std::numeric_limits<double>::quiet_NaN()),
+    upper_bound(std::numeric_limits<double>::quiet_NaN())
+{
+}
+
+namespace
+{
+//! Abtastung eines Parameters in eine Richtung, beginnend beim Bestwert.
+struct HalfScan
+{
+    unsigned problem;
+    unsigned parameter;
+    int direction;
+    std::vector<double> values;
+    std::vector<double> chi_squares;
+};
+
+bool IsUsable(const FitResults& results)
+{
+    return results.exit_flag != Eigen::LM::UserAsked && std::isfinite(results.chi_square);
+}
+
+Eigen::VectorXd RemoveElement(const Eigen::VectorXd& v, unsigned index)
+{
+    Eigen::VectorXd result(v.size() - 1);
+    result.head(index) = v.head(index);
+    result.tail(v.size() - index - 1) = v.tail(v.size() - index - 1);
+    return result;
+}
+
+//! Schrittweite aus der Standardabweichung; ohne brauchbare Abweichung 10 % des Bestwerts.
+double StepSize(double best_estimate, double deviation, const ProfileLikelihoodSettings& settings)
+{
+    double width = deviation * settings.range;
+    if (!std::isfinite(width) || width <= 0.)
+        width = best_estimate != 0. ? 0.1 * std::abs(best_estimate) : 0.1;
+    return width / std::max(settings.n_steps, 1u);
+}
+
+//! Interpoliert den Wert, an dem das χ² level erreicht, zwischen zwei Abtastpunkten.
+double Interpolate(double x1, double chi1, double x2, double chi2, double level)
+{
+    if (chi2 == chi1) return x2;
+    return x1 + (level - chi1) / (chi2 - chi1) * (x2 - x1);
+}
+}
+
+struct ProfileLikelihoodScanner::SharedState
+{
+    std::vector<ProfileLikelihoodProblem> problems;
+    std::vector<std::shared_ptr<FitResults>> best_results;
+    std::vector<HalfScan> half_scans;
+
+    bool best_fits;
+    unsigned n_jobs;
+    unsigned n_threads;
+
+    boost::mutex mutex;
+    unsigned next_job;
+};
+
+ProfileLikelihoodScanner::ProfileLikelihoodScanner(const ProfileLikelihoodSettings& settings) :
+    settings_(settings)
+{
+}
+
+std::vector<std::vector<ParameterProfile>> ProfileLikelihoodScanner::Scan(
+        const std::vector<ProfileLikelihoodProblem>& problems) const
+{
+    SharedState state;
+    state.problems = problems;
+    state.best_results.resize(problems.size());
+
+    state.n_threads = settings_.n_threads;
+    if (state.n_threads == 0) state.n_threads = boost::thread::hardware_concurrency();
+    if (state.n_threads == 0) state.n_threads = 1;
+
+    state.best_fits = true;
+    state.n_jobs = problems.size();
+    RunJobs(state);
+
+    // Je Parameter zwei Richtungen; so bleiben auch bei wenigen Proben alle Kerne beschäftigt.
+    for (unsigned p = 0; p < problems.size(); ++p)
+        for (unsigned k = 0; k < problems[p].pconf->size(); ++k)
+            for (int direction : {-1, 1})
+            {
+                HalfScan scan;
+                scan.problem = p;
+                scan.parameter = k;
+                scan.direction = direction;
+                state.half_scans.push_back(scan);
+            }
+
+    state.best_fits = false;
+    state.n_jobs = state.half_scans.size();
+    RunJobs(state);
+
+    std::vector<std::vector<ParameterProfile>> profiles(problems.size());
+    for (unsigned p = 0; p < problems.size(); ++p)
+    {
+        const FitResults& best = *state.best_results[p];
+        profiles[p].resize(problems[p].pconf->size());
+        for (unsigned k = 0; k < profiles[p].size(); ++k)
+        {
+            ParameterProfile& profile = profiles[p][k];
+            profile.parameter_name = problems[p].pconf->names()[k];
+            if (!IsUsable(best))
+                continue;
+            profile.best_estimate = best.best_estimate(k);
+            profile.values.push_back(profile.best_estimate);
+            profile.chi_squares.push_back(best.chi_square);
+        }
+    }
+
+    for (const HalfScan& scan : state.half_scans)
+    {
+        ParameterProfile& profile = profiles[scan.problem][scan.parameter];
+        if (scan.direction < 0)
+        {
+            profile.values.insert(profile.values.begin(),
+                                  scan.values.rbegin(), scan.values.rend());
+            profile.chi_squares.insert(profile.chi_squares.begin(),
+                                       scan.chi_squares.rbegin(), scan.chi_squares.rend());
+        }
+        else
+        {
+            profile.values.insert(profile.values.end(),
+                                  scan.values.begin(), scan.values.end());
+            profile.chi_squares.insert(profile.chi_squares.end(),
+                                       scan.chi_squares.begin(), scan.chi_squares.end());
+        }
+    }
+
+    for (auto& problem_profiles : profiles)
+        for (auto& profile : problem_profiles)
+            FindBounds(profile, settings_.delta_chi_square);
+
+    return profiles;
+}
+
+std::vector<ProfileLikelihoodProblem> ProfileLikelihoodScanner::CreateProblems(
+        const RunData& concentrations,
+        const std::vector<FitConfiguration>& fit_configurations)
+{
+    std::vector<ProfileLikelihoodProblem> problems;
+    for (const FitConfiguration& config : fit_configurations)
+    {
+        ProfileLikelihoodProblem problem;
+        problem.fitter = std::make_shared<LevenbergMarquardtFitter>(
+                std::make_shared<NobleFitFunction>(
+                    config.model,
+                    *config.GetParameterMap(),
+                    concentrations,
+                    config.sample_numbers));
+        problem.pconf = std::make_shared<FitParameterConfig>(config.fit_parameter_config);
+        problems.push_back(problem);
+    }
+    return problems;
+}
+
+void ProfileLikelihoodScanner::FindBounds(ParameterProfile& profile, double delta_chi_square)
+{
+    profile.lower_bound = std::numeric_limits<double>::quiet_NaN();
+    profile.upper_bound = std::numeric_limits<double>::quiet_NaN();
+
+    auto min = profile.chi_squares.end();
+    for (auto it = profile.chi_squares.begin(); it != profile.chi_squares.end(); ++it)
+        if (std::isfinite(*it) && (min == profile.chi_squares.end() || *it < *min))
+            min = it;
+    if (min == profile.chi_squares.end())
+    {
+        profile.chi_square_min = std::numeric_limits<double>::quiet_NaN();
+        return;
+    }
+
+    // Liegt ein abgetasteter Punkt unter dem Bestwert, war der ursprüngliche Fit nicht im
+    // Minimum; das Intervall bezieht sich dann auf den besseren Punkt.
+    profile.chi_square_min = *min;
+    const double level = *min + delta_chi_square;
+    const unsigned i_min = min - profile.chi_squares.begin();
+
+    unsigned last = i_min;
+    for (unsigned i = i_min + 1; i < profile.chi_squares.size(); ++i)
+    {
+        if (!std::isfinite(profile.chi_squares[i])) continue;
+        if (profile.chi_squares[i] >= level)
+        {
+            profile.upper_bound = Interpolate(profile.values[last], profile.chi_squares[last],
+                                              profile.values[i], profile.chi_squares[i],
+                                              level);
+            break;
+        }
+        last = i;
+    }
+
+    last = i_min;
+    for (unsigned i = i_min; i-- > 0;)
+    {
+        if (!std::isfinite(profile.chi_squares[i])) continue;
+        if (profile.chi_squares[i] >= level)
+        {
+            profile.lower_bound = Interpolate(profile.values[last], profile.chi_squares[last],
+                                              profile.values[i], profile.chi_squares[i],
+                                              level);
+            break;
+        }
+        last = i;
+    }
+}
+
+void ProfileLikelihoodScanner::RunJobs(SharedState& state) const
+{
+    state.next_job = 0;
+    const unsigned n_threads = std::max(1u, std::min(state.n_threads, state.n_jobs));
+
+    boost::thread_group threads;
+    for (unsigned l = 1; l < n_threads; ++l)
+        threads.create_thread(std::bind(&ProfileLikelihoodScanner::PerformJobs,
+                                        this,
+                                        std::ref(state)));
+    PerformJobs(state);
+    threads.join_all();
+}
+
+void ProfileLikelihoodScanner::PerformJobs(SharedState& state) const
+{
+    while (true)
+    {
+        unsigned i;
+        {
+            boost::lock_guard<boost::mutex> lock(state.mutex);
+            if (state.next_job >= state.n_jobs) return;
+            i = state.next_job++;
+        }
+
+        if (state.best_fits)
+            PerformBestFit(state, i);
+        else
+            PerformHalfScan(state, i);
+    }
+}
+
+void ProfileLikelihoodScanner::PerformBestFit(SharedState& state, unsigned problem) const
+{
+    std::shared_ptr<LevenbergMarquardtFitter> fitter = state.problems[problem].fitter->clone();
+    fitter->SetResultsRequest(ResultsRequest());
+    state.best_results[problem] = fitter->fit(state.problems[problem].pconf);
+}
+
+void ProfileLikelihoodScanner::PerformHalfScan(SharedState& state, unsigned job) const
+{
+    HalfScan& scan = state.half_scans[job];
+    const ProfileLikelihoodProblem& problem = state.problems[scan.problem];
+    const FitResults& best = *state.best_results[scan.problem];
+    if (!IsUsable(best))
+        return;
+
+    const unsigned k = scan.parameter;
+    const double best_estimate = best.best_estimate(k);
+    const double lower = problem.pconf->lower_bounds()(k);
+    const double upper = problem.pconf->upper_bounds()(k);
+    const double step = scan.direction *
+            StepSize(best_estimate,
+                     k < best.deviations.size() ? best.deviations(k) : 0.,
+                     settings_);
+
+    std::shared_ptr<LevenbergMarquardtFitter> fitter = problem.fitter->clone();
+    fitter->SetResultsRequest(ResultsRequest());
+    std::shared_ptr<NobleFitFunction> function = fitter->GetFitFunction();
+
+    std::shared_ptr<FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(*problem.pconf));
+    // Bleibt kein Parameter übrig, wertet der Fitter χ² nur am festgehaltenen Wert aus.
+    pconf->RemoveParameter(k);
+    Eigen::VectorXd start_values = RemoveElement(best.best_estimate, k);
+
+    for (unsigned s = 1; s <= settings_.n_steps; ++s)
+    {
+        const double value = best_estimate + s * step;
+        // Werte außerhalb der Parametergrenzen sind physikalisch nicht sinnvoll.
+        if (value < lower || value > upper)
+            break;
+
+        function->FixParameters({std::make_pair(static_cast<int>(k), value)});
+        for (unsigned j = 0; j < pconf->size(); ++j)
+            pconf->ChangeParameterInitial(j, start_values(j));
+
+        std::shared_ptr<FitResults> results = fitter->fit(pconf);
+        scan.values.push_back(value);
+        scan.chi_squares.push_back(results->chi_square);
+
+        if (!IsUsable(*results))
+            continue;
+        // Der nächste Schritt startet beim Minimum des vorherigen.
+        start_values = results->best_estimate;
+        if (results->chi_square - best.chi_square > settings_.max_delta_chi_square)
+            break;
+    }
+}
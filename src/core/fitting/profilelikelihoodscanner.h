@@ -0,0 +1,157 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef PROFILELIKELIHOODSCANNER_H
+#define PROFILELIKELIHOODSCANNER_H
+
+#include <Eigen/Core>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fitconfiguration.h"
+#include "fitparameterconfig.h"
+#include "fitresults.h"
+
+class LevenbergMarquardtFitter;
+class RunData;
+
+//! Einstellungen für ProfileLikelihoodScanner.
+struct ProfileLikelihoodSettings
+{
+    ProfileLikelihoodSettings();
+
+    //! Zahl der Schritte je Richtung.
+    unsigned n_steps;
+
+    //! Abgetasteter Bereich je Richtung in Vielfachen der Standardabweichung aus dem Fit.
+    double range;
+
+    //! χ²-Anstieg, der die Grenzen des Konfidenzintervalls festlegt (1 entspricht 68,3 %).
+    double delta_chi_square;
+
+    //! Eine Richtung wird abgebrochen, sobald der χ²-Anstieg diesen Wert übersteigt.
+    double max_delta_chi_square;
+
+    //! Zahl der Threads, 0 verwendet alle verfügbaren Prozessorkerne.
+    unsigned n_threads;
+};
+
+//! Profil der χ²-Funktion entlang eines gefitteten Parameters.
+struct ParameterProfile
+{
+    ParameterProfile();
+
+    //! Name des Parameters.
+    std::string parameter_name;
+
+    //! Bestwert aus dem ungebundenen Fit.
+    double best_estimate;
+
+    //! Kleinstes gefundenes χ², Bezugspunkt für das Konfidenzintervall.
+    double chi_square_min;
+
+    //! Abgetastete Parameterwerte, aufsteigend sortiert und einschließlich des Bestwerts.
+    std::vector<double> values;
+
+    //! Über die übrigen Parameter minimiertes χ² zu den Werten in values.
+    std::vector<double> chi_squares;
+
+    //! Untere Grenze des Konfidenzintervalls, NaN falls innerhalb des Bereichs nicht erreicht.
+    double lower_bound;
+
+    //! Obere Grenze des Konfidenzintervalls, NaN falls innerhalb des Bereichs nicht erreicht.
+    double upper_bound;
+};
+
+//! Ein einzelner Fit, dessen Parameter profiliert werden.
+struct ProfileLikelihoodProblem
+{
+    //! Fitter, von dem für jeden Abtastpunkt-Strang eine Kopie erzeugt wird.
+    std::shared_ptr<const LevenbergMarquardtFitter> fitter;
+
+    //! Zu verwendende ParameterConfig mit Anfangswerten und Grenzen.
+    std::shared_ptr<const FitParameterConfig> pconf;
+};
+
+//! Berechnet Profile-Likelihood-Konfidenzintervalle für alle gefitteten Parameter.
+/*!
+  Für jeden Parameter wird dieser schrittweise vom Bestwert aus nach unten und oben festgehalten
+  (NobleFitFunction::FixParameters) und über die übrigen Parameter neu minimiert. Jeder Schritt
+  startet beim Ergebnis des vorherigen. Die Grenzen des Intervalls liegen dort, wo das χ² um
+  ProfileLikelihoodSettings::delta_chi_square über dem Minimum liegt; sie werden zwischen den
+  Abtastpunkten linear interpoliert. Anders als die Standardabweichung aus der Kovarianzmatrix
+  dürfen die Intervalle asymmetrisch sein und lassen sich so mit den Monte-Carlo-Intervallen
+  vergleichen.
+
+  Alle Richtungen aller Parameter aller Probleme werden parallel abgearbeitet. Werte außerhalb
+  der Parametergrenzen werden nicht abgetastet. Bei Fits mit nur einem Parameter bleibt nichts
+  zu minimieren; das Profil besteht dann aus den χ²-Werten an den festgehaltenen Werten.
+  */
+class ProfileLikelihoodScanner
+{
+public:
+    //! Konstruktor.
+    /*!
+      \param settings Zu verwendende Einstellungen.
+      */
+    explicit ProfileLikelihoodScanner(const ProfileLikelihoodSettings& settings);
+
+    //! Berechnet die Profile.
+    /*!
+      \param problems Zu profilierende Fits.
+      \return Für jedes Problem ein Profil je gefittetem Parameter.
+      */
+    std::vector<std::vector<ParameterProfile>> Scan(
+            const std::vector<ProfileLikelihoodProblem>& problems) const;
+
+    //! Erzeugt die Probleme aus Fitkonfigurationen, wie sie DefaultFitter verwendet.
+    /*!
+      \param concentrations Messdaten aller Proben.
+      \param fit_configurations Eine Konfiguration je Fit.
+      */
+    static std::vector<ProfileLikelihoodProblem> CreateProblems(
+            const RunData& concentrations,
+            const std::vector<FitConfiguration>& fit_configurations);
+
+    //! Bestimmt die Grenzen des Konfidenzintervalls aus values und chi_squares eines Profils.
+    /*!
+      Nicht endliche χ²-Werte werden übersprungen.
+      */
+    static void FindBounds(ParameterProfile& profile, double delta_chi_square);
+
+private:
+    struct SharedState;
+
+    //! Arbeitet Jobs ab, bis keine mehr übrig sind.
+    void PerformJobs(SharedState& state) const;
+
+    //! Fittet ein Problem ohne festgehaltene Parameter.
+    void PerformBestFit(SharedState& state, unsigned problem) const;
+
+    //! Tastet einen Parameter in eine Richtung ab.
+    void PerformHalfScan(SharedState& state, unsigned job) const;
+
+    //! Führt alle Jobs der aktuellen Phase parallel aus.
+    void RunJobs(SharedState& state) const;
+
+    ProfileLikelihoodSettings settings_;
+};
+
+#endif // PROFILELIKELIHOODSCANNER_H
@@ -0,0 +1,93 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RESULTSREQUEST_H
+#define RESULTSREQUEST_H
+
+#include "core/misc/gas.h"
+
+//! Legt fest, welche abgeleiteten Größen NobleFitFunction::CompileResults berechnet.
+/*!
+  Nicht angeforderte Gaskonzentrationen fehlen in den Maps von FitResults. Residuen, Parameter
+  und Kovarianzen werden immer gespeichert.
+  */
+class ResultsRequest
+{
+public:
+    //! Einzelne Größen, die je Gas angefordert werden können.
+    enum Quantity
+    {
+        EQUILIBRIUM_VALUE = 1 << 0,
+        EQUILIBRIUM_ERROR = 1 << 1,
+        MODEL_VALUE       = 1 << 2,
+        MODEL_ERROR       = 1 << 3,
+        MEASURED          = 1 << 4,
+        EVERYTHING        = (1 << 5) - 1
+    };
+
+    //! Erzeugt eine Anforderung, die keine Gaskonzentrationen enthält.
+    ResultsRequest()
+    {
+        for (unsigned& flags : flags_)
+            flags = 0;
+    }
+
+    //! Erzeugt eine Anforderung aller Gaskonzentrationen samt Fehlern.
+    static ResultsRequest All()
+    {
+        ResultsRequest request;
+        for (GasType gas = Gas::begin; gas != Gas::end_including_HE3; ++gas)
+            request.Request(gas, EVERYTHING);
+        return request;
+    }
+
+    //! Fordert die übergebenen Größen (bitweise verknüpfte Quantity-Werte) für ein Gas an.
+    void Request(GasType gas, unsigned quantities)
+    {
+        flags_[gas] |= quantities;
+    }
+
+    //! Gibt an, ob eine der übergebenen Größen für das Gas angefordert ist.
+    bool IsRequested(GasType gas, unsigned quantities) const
+    {
+        return (flags_[gas] & quantities) != 0;
+    }
+
+    //! Gibt an, ob eine der übergebenen Größen für irgendein Gas angefordert ist.
+    bool IsRequested(unsigned quantities) const
+    {
+        for (unsigned flags : flags_)
+            if (flags & quantities)
+                return true;
+        return false;
+    }
+
+    bool operator==(const ResultsRequest& other) const
+    {
+        for (unsigned i = 0; i < Gas::end_including_HE3; ++i)
+            if (flags_[i] != other.flags_[i])
+                return false;
+        return true;
+    }
+
+private:
+    //! Angeforderte Größen je Gas.
+    unsigned flags_[Gas::end_including_HE3];
+};
+
+#endif // RESULTSREQUEST_H
@@ -0,0 +1,400 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "noblefitfunction.h"
+
+#include "schurlevenbergmarquardt.h"
+
+namespace
+{
+//! Anfangswert des Dämpfungsparameters.
+const double INITIAL_LAMBDA = 1e-3;
+
+//! Faktor, um den der Dämpfungsparameter nach jedem Schritt verändert wird.
+const double LAMBDA_FACTOR = 10.;
+
+//! Größter Dämpfungsparameter, ab dem die Minimierung abgebrochen wird.
+const double MAX_LAMBDA = 1e16;
+
+//! Zählt, auf wie viele Proben jeder Fitparameter wirkt.
+std::vector<unsigned> CountSamplesPerParameter(const NobleFitFunction& func,
+                                               unsigned n_params)
+{
+    std::vector<unsigned> counts(n_params, 0);
+    for (unsigned i = 0; i < func.NumberOfSamples(); ++i)
+        for (unsigned parameter : func.GetFitParametersOfSample(i))
+            if (parameter < n_params)
+                ++counts[parameter];
+    return counts;
+}
+}
+
+SchurLevenbergMarquardt::SchurLevenbergMarquardt(
+        std::shared_ptr<NobleFitFunction> func,
+        unsigned n_params) :
+    iter(0),
+    nfev(0),
+    maxfev(400),
+    ftol(std::sqrt(std::numeric_limits<double>::epsilon())),
+    xtol(std::sqrt(std::numeric_limits<double>::epsilon())),
+    func_(func),
+    n_params_(n_params)
+{
+    assert(IsApplicable(*func, n_params));
+
+    const unsigned n_samples = func_->NumberOfSamples();
+    const std::vector<unsigned> counts = CountSamplesPerParameter(*func_, n_params);
+
+    std::vector<int> shared_position(n_params, -1);
+    for (unsigned j = 0; j < n_params; ++j)
+        if (counts[j] > 1)
+        {
+            shared_position[j] = shared_.size();
+            shared_.push_back(j);
+        }
+
+    individual_.resize(n_samples);
+    columns_.resize(n_samples);
+    offsets_.resize(n_samples);
+    a_.resize(n_samples);
+    b_.resize(n_samples);
+    gradient_individual_.resize(n_samples);
+
+    unsigned offset = 0;
+    for (unsigned i = 0; i < n_samples; ++i)
+    {
+        offsets_[i] = offset;
+        offset += func_->NumberOfConcentrations(i);
+        for (unsigned parameter : func_->GetFitParametersOfSample(i))
+        {
+            if (shared_position[parameter] >= 0)
+            {
+                columns_[i].push_back(-1 - shared_position[parameter]);
+            }
+            else
+            {
+                columns_[i].push_back(individual_[i].size());
+                individual_[i].push_back(parameter);
+            }
+        }
+    }
+}
+
+bool SchurLevenbergMarquardt::IsApplicable(const NobleFitFunction& func, unsigned n_params)
+{
+    if (func.NumberOfSamples() < 2 || n_params == 0)
+        return false;
+
+    const std::vector<unsigned> counts = CountSamplesPerParameter(func, n_params);
+    if (std::find(counts.begin(), counts.end(), 0u) != counts.end())
+        return false;
+
+    // Ohne gemeinsame oder ohne probeneigene Parameter hat das System keine Blockstruktur.
+    if (std::find_if(counts.begin(), counts.end(),
+                     [](unsigned count) { return count > 1; }) == counts.end() ||
+        std::find(counts.begin(), counts.end(), 1u) == counts.end())
+        return false;
+
+    for (unsigned i = 0; i < func.NumberOfSamples(); ++i)
+        for (unsigned parameter : func.GetFitParametersOfSample(i))
+            if (parameter >= n_params)
+                return false;
+
+    return true;
+}
+
+Eigen::LM::Status SchurLevenbergMarquardt::minimize(Eigen::VectorXd& x)
+{
+    assert(x.size() == n_params_);
+
+    iter = 0;
+    nfev = 1;
+    diag_.setZero(n_params_);
+    BuildNormalEquations(x);
+    double fnorm = fvec.norm();
+
+    double lambda = INITIAL_LAMBDA;
+    Eigen::VectorXd step;
+    Eigen::VectorXd trial_x;
+    Eigen::VectorXd trial_fvec;
+    while (true)
+    {
+        ++iter;
+        if (fnorm == 0.)
+            return Eigen::LM::RelativeReductionTooSmall;
+
+        while (true)
+        {
+            if (nfev >= maxfev)
+                return Eigen::LM::TooManyFunctionEvaluation;
+
+            if (!SolveStep(lambda, step))
+            {
+                lambda *= LAMBDA_FACTOR;
+                if (lambda > MAX_LAMBDA)
+                    return Eigen::LM::XtolTooSmall;
+                continue;
+            }
+
+            trial_x = x_ + step;
+            func_->SetParameters(trial_x);
+            func_->CalcResiduals(trial_fvec);
+            ++nfev;
+            const double trial_fnorm = trial_fvec.norm();
+
+            const double xnorm = diag_.cwiseProduct(x_).norm();
+            const double pnorm = diag_.cwiseProduct(step).norm();
+            const bool small_step = pnorm <= xtol * xnorm;
+
+            if (trial_fnorm < fnorm)
+            {
+                const double ratio = trial_fnorm / fnorm;
+                const bool small_reduction = 1. - ratio * ratio <= ftol;
+
+                BuildNormalEquations(trial_x);
+                fnorm = trial_fnorm;
+                x = x_;
+                lambda = std::max(lambda / LAMBDA_FACTOR,
+                                  std::numeric_limits<double>::epsilon());
+
+                if (small_reduction && small_step)
+                    return Eigen::LM::RelativeErrorAndReductionTooSmall;
+                if (small_reduction)
+                    return Eigen::LM::RelativeReductionTooSmall;
+                if (small_step)
+                    return Eigen::LM::RelativeErrorTooSmall;
+                if (abort_criterion && abort_criterion(iter, fnorm * fnorm))
+                    return Eigen::LM::UserAsked;
+                break;
+            }
+
+            if (small_step)
+            {
+                func_->SetParameters(x_);
+                return Eigen::LM::RelativeErrorTooSmall;
+            }
+
+            lambda *= LAMBDA_FACTOR;
+            if (lambda > MAX_LAMBDA)
+            {
+                func_->SetParameters(x_);
+                return Eigen::LM::XtolTooSmall;
+            }
+        }
+    }
+}
+
+void SchurLevenbergMarquardt::CalcCovariances(
+        std::vector<Eigen::MatrixXd>& sample_covariances,
+        Eigen::VectorXd& deviations)
+{
+    BuildNormalEquations(x_);
+
+    const unsigned n_samples = func_->NumberOfSamples();
+    const unsigned n_shared = shared_.size();
+
+    std::vector<Eigen::MatrixXd> a_inverse(n_samples);
+    std::vector<Eigen::MatrixXd> a_inverse_b(n_samples);
+    Eigen::MatrixXd schur_complement = c_;
+    for (unsigned i = 0; i < n_samples; ++i)
+    {
+        a_inverse[i] = PseudoInverse(a_[i]);
+        a_inverse_b[i] = a_inverse[i] * b_[i];
+        schur_complement.noalias() -= b_[i].transpose() * a_inverse_b[i];
+    }
+    const Eigen::MatrixXd shared_covariances = PseudoInverse(schur_complement);
+
+    deviations.resize(n_params_);
+    for (unsigned k = 0; k < n_shared; ++k)
+        deviations(shared_[k]) = std::sqrt(shared_covariances(k, k));
+
+    sample_covariances.resize(n_samples);
+    for (unsigned i = 0; i < n_samples; ++i)
+    {
+        const Eigen::MatrixXd mixed = -a_inverse_b[i] * shared_covariances;
+        const Eigen::MatrixXd individual =
+                a_inverse[i] - mixed * a_inverse_b[i].transpose();
+
+        for (unsigned k = 0; k < individual_[i].size(); ++k)
+            deviations(individual_[i][k]) = std::sqrt(individual(k, k));
+
+        const std::vector<int>& columns = columns_[i];
+        Eigen::MatrixXd& covariances = sample_covariances[i];
+        covariances.resize(columns.size(), columns.size());
+        for (unsigned k = 0; k < columns.size(); ++k)
+            for (unsigned l = 0; l < columns.size(); ++l)
+            {
+                if (columns[k] >= 0 && columns[l] >= 0)
+                    covariances(k, l) = individual(columns[k], columns[l]);
+                else if (columns[k] >= 0)
+                    covariances(k, l) = mixed(columns[k], -1 - columns[l]);
+                else if (columns[l] >= 0)
+                    covariances(k, l) = mixed(columns[l], -1 - columns[k]);
+                else
+                    covariances(k, l) = shared_covariances(-1 - columns[k], -1 - columns[l]);
+            }
+    }
+}
+
+void SchurLevenbergMarquardt::BuildNormalEquations(const Eigen::VectorXd& x)
+{
+    x_ = x;
+    func_->SetParameters(x_);
+    func_->CalcResiduals(fvec);
+
+    const unsigned n_shared = shared_.size();
+    c_.setZero(n_shared, n_shared);
+    gradient_shared_.setZero(n_shared);
+
+    Eigen::MatrixXd jacobian_individual;
+    Eigen::MatrixXd jacobian_shared;
+    for (unsigned i = 0; i < func_->NumberOfSamples(); ++i)
+    {
+        func_->CalcSampleJacobian(i, sample_jacobian_);
+        const unsigned n_rows = sample_jacobian_.rows();
+        const std::vector<int>& columns = columns_[i];
+
+        jacobian_individual.resize(n_rows, individual_[i].size());
+        jacobian_shared.setZero(n_rows, n_shared);
+        for (unsigned k = 0; k < columns.size(); ++k)
+        {
+            if (columns[k] >= 0)
+                jacobian_individual.col(columns[k]) = sample_jacobian_.col(k);
+            else
+                jacobian_shared.col(-1 - columns[k]) = sample_jacobian_.col(k);
+        }
+
+        const auto residuals = fvec.segment(offsets_[i], n_rows);
+        a_[i].noalias() = jacobian_individual.transpose() * jacobian_individual;
+        b_[i].noalias() = jacobian_individual.transpose() * jacobian_shared;
+        c_.noalias() += jacobian_shared.transpose() * jacobian_shared;
+        gradient_individual_[i].noalias() = jacobian_individual.transpose() * residuals;
+        gradient_shared_.noalias() += jacobian_shared.transpose() * residuals;
+
+        for (unsigned k = 0; k < individual_[i].size(); ++k)
+        {
+            double& d = diag_(individual_[i][k]);
+            d = std::max(d, std::sqrt(a_[i](k, k)));
+        }
+    }
+
+    for (unsigned k = 0; k < n_shared; ++k)
+    {
+        double& d = diag_(shared_[k]);
+        d = std::max(d, std::sqrt(c_(k, k)));
+    }
+
+    // Wie in MINPACK werden Parameter, von denen die Residuen (noch) nicht abhängen, nicht skaliert.
+    for (unsigned j = 0; j < n_params_; ++j)
+        if (diag_(j) == 0.)
+            diag_(j) = 1.;
+}
+
+bool SchurLevenbergMarquardt::SolveStep(double lambda, Eigen::VectorXd& step) const
+{
+    const unsigned n_samples = func_->NumberOfSamples();
+    const unsigned n_shared = shared_.size();
+
+    std::vector<Eigen::LDLT<Eigen::MatrixXd>> a_decompositions(n_samples);
+    std::vector<Eigen::MatrixXd> a_inverse_b(n_samples);
+    std::vector<Eigen::VectorXd> a_inverse_gradient(n_samples);
+
+    Eigen::MatrixXd schur_complement = c_;
+    Eigen::VectorXd rhs = -gradient_shared_;
+    for (unsigned k = 0; k < n_shared; ++k)
+        schur_complement(k, k) += lambda * diag_(shared_[k]) * diag_(shared_[k]);
+
+    for (unsigned i = 0; i < n_samples; ++i)
+    {
+        // Eigen::LDLT kann keine leeren Matrizen zerlegen.
+        if (individual_[i].empty())
+        {
+            a_inverse_b[i].setZero(0, n_shared);
+            a_inverse_gradient[i].resize(0);
+            continue;
+        }
+
+        Eigen::MatrixXd a = a_[i];
+        for (unsigned k = 0; k < individual_[i].size(); ++k)
+            a(k, k) += lambda * diag_(individual_[i][k]) * diag_(individual_[i][k]);
+
+        a_decompositions[i].compute(a);
+        if (a_decompositions[i].info() != Eigen::Success ||
+            !a_decompositions[i].isPositive())
+            return false;
+
+        a_inverse_b[i] = a_decompositions[i].solve(b_[i]);
+        a_inverse_gradient[i] = a_decompositions[i].solve(gradient_individual_[i]);
+        schur_complement.noalias() -= b_[i].transpose() * a_inverse_b[i];
+        rhs.noalias() += b_[i].transpose() * a_inverse_gradient[i];
+    }
+
+    Eigen::VectorXd shared_step(n_shared);
+    if (n_shared)
+    {
+        Eigen::LDLT<Eigen::MatrixXd> schur_decomposition(schur_complement);
+        if (schur_decomposition.info() != Eigen::Success ||
+            !schur_decomposition.isPositive())
+            return false;
+        shared_step = schur_decomposition.solve(rhs);
+    }
+
+    step.resize(n_params_);
+    for (unsigned k = 0; k < n_shared; ++k)
+        step(shared_[k]) = shared_step(k);
+
+    for (unsigned i = 0; i < n_samples; ++i)
+    {
+        const Eigen::VectorXd individual_step =
+                -(a_inverse_gradient[i] + a_inverse_b[i] * shared_step);
+        for (unsigned k = 0; k < individual_[i].size(); ++k)
+            step(individual_[i][k]) = individual_step(k);
+    }
+
+    for (int j = 0; j < step.size(); ++j)
+        if (!std::isfinite(step(j)))
+            return false;
+
+    return true;
+}
+
+Eigen::MatrixXd SchurLevenbergMarquardt::PseudoInverse(const Eigen::MatrixXd& matrix)
+{
+    if (matrix.size() == 0)
+        return matrix;
+
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(matrix);
+    const Eigen::VectorXd& eigenvalues = solver.eigenvalues();
+    const double tolerance = std::numeric_limits<double>::epsilon() * matrix.rows() *
+                             eigenvalues.cwiseAbs().maxCoeff();
+
+    Eigen::VectorXd inverse_eigenvalues(eigenvalues.size());
+    for (int k = 0; k < eigenvalues.size(); ++k)
+        inverse_eigenvalues(k) = eigenvalues(k) > tolerance ? 1. / eigenvalues(k) : 0.;
+
+    return solver.eigenvectors() * inverse_eigenvalues.asDiagonal() *
+           solver.eigenvectors().transpose();
+}
@@ -0,0 +1,162 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SCHURLEVENBERGMARQUARDT_H
+#define SCHURLEVENBERGMARQUARDT_H
+
+#include <Eigen/Core>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "eigen_lm_includes.h"
+
+class NobleFitFunction;
+
+//! Levenberg-Marquardt-Minimierer für Ensemblefits, der die Blockstruktur der Jacobi-Matrix nutzt.
+/*!
+  Bei Ensemblefits hängen die Residuen einer Probe nur von den gemeinsamen Parametern und den
+  eigenen Parametern der Probe ab. Die Normalgleichungen haben daher die Form
+
+      | A_1        B_1 |
+      |     ...    ... |
+      |         A_n B_n |
+      | B_1^T ... B_n^T C |
+
+  mit kleinen Blöcken A_i für die eigenen Parameter der Proben. Die Schritte werden über das
+  Schur-Komplement S = C - Σ B_i^T A_i^-1 B_i berechnet, sodass der Aufwand linear mit der Zahl
+  der Proben wächst statt kubisch wie bei der QR-Zerlegung der vollständigen Jacobi-Matrix.
+
+  Die Abbruchkriterien entsprechen denen von Eigen::LevenbergMarquardt.
+  */
+class SchurLevenbergMarquardt
+{
+public:
+    //! Konstruktor.
+    /*!
+      \param func Zu verwendende Fitfunktion.
+      \param n_params Zahl der Fitparameter.
+      */
+    SchurLevenbergMarquardt(std::shared_ptr<NobleFitFunction> func, unsigned n_params);
+
+    //! Prüft, ob der Fit eine Blockstruktur hat, die der Minimierer nutzen kann.
+    /*!
+      Dies ist der Fall, wenn mehrere Proben gefittet werden, jeder Fitparameter auf mindestens
+      eine Probe wirkt und es sowohl gemeinsame als auch probeneigene Parameter gibt.
+      */
+    static bool IsApplicable(const NobleFitFunction& func, unsigned n_params);
+
+    //! Führt die Minimierung aus.
+    /*!
+      \param x Enthält die Startwerte und nach dem Aufruf den besten gefundenen Parametersatz.
+      \return Grund des Abbruchs.
+      */
+    Eigen::LM::Status minimize(Eigen::VectorXd& x);
+
+    //! Berechnet die Kovarianzen am zuletzt von minimize gefundenen Parametersatz.
+    /*!
+      \param sample_covariances Enthält nach dem Aufruf für jede Probe die Kovarianz-Matrix der
+      Parameter, von denen sie abhängt (in der Reihenfolge von
+      NobleFitFunction::GetFitParametersOfSample).
+      \param deviations Enthält nach dem Aufruf die Standardabweichungen aller Parameter.
+      */
+    void CalcCovariances(std::vector<Eigen::MatrixXd>& sample_covariances,
+                         Eigen::VectorXd& deviations);
+
+    //! Residuen am besten gefundenen Parametersatz.
+    Eigen::VectorXd fvec;
+
+    //! Zahl der Iterationen.
+    int iter;
+
+    //! Zahl der Funktionsauswertungen.
+    int nfev;
+
+    //! Maximale Zahl der Funktionsauswertungen.
+    int maxfev;
+
+    //! Abbruchkriterium für die relative Verringerung der Residuenquadratsumme.
+    double ftol;
+
+    //! Abbruchkriterium für die relative Änderung der Parameter.
+    double xtol;
+
+    //! Optionales Abbruchkriterium, das nach jeder Iteration mit deren Zahl und χ² aufgerufen wird.
+    std::function<bool(int, double)> abort_criterion;
+
+private:
+    //! Berechnet die Normalgleichungen in Blockform und den Gradienten am Punkt x.
+    void BuildNormalEquations(const Eigen::VectorXd& x);
+
+    //! Berechnet den Schritt für den Dämpfungsparameter lambda.
+    /*!
+      \return false, falls das gedämpfte Gleichungssystem nicht lösbar war.
+      */
+    bool SolveStep(double lambda, Eigen::VectorXd& step) const;
+
+    //! Berechnet die (Pseudo-)Inverse einer symmetrischen, positiv semidefiniten Matrix.
+    static Eigen::MatrixXd PseudoInverse(const Eigen::MatrixXd& matrix);
+
+    //! Zeiger auf die verwendete Fitfunktion.
+    std::shared_ptr<NobleFitFunction> func_;
+
+    //! Zahl der Fitparameter.
+    const unsigned n_params_;
+
+    //! Indizes der Parameter, die auf mehrere Proben wirken.
+    std::vector<unsigned> shared_;
+
+    //! Indizes der Parameter, die nur auf die jeweilige Probe wirken.
+    std::vector<std::vector<unsigned>> individual_;
+
+    //! Für jede Probe und jede Spalte ihrer Jacobi-Matrix die Position in shared_ bzw. individual_.
+    /*!
+      Nichtnegative Werte bezeichnen eigene Parameter, negative Werte -1 - Position in shared_.
+      */
+    std::vector<std::vector<int>> columns_;
+
+    //! Position der ersten Residue der jeweiligen Probe in fvec.
+    std::vector<unsigned> offsets_;
+
+    //! Blöcke A_i = J_i^T J_i der eigenen Parameter.
+    std::vector<Eigen::MatrixXd> a_;
+
+    //! Blöcke B_i = J_i^T J_s der Kopplung an die gemeinsamen Parameter.
+    std::vector<Eigen::MatrixXd> b_;
+
+    //! Block C = J_s^T J_s der gemeinsamen Parameter.
+    Eigen::MatrixXd c_;
+
+    //! Gradienten J_i^T f der eigenen Parameter.
+    std::vector<Eigen::VectorXd> gradient_individual_;
+
+    //! Gradient J_s^T f der gemeinsamen Parameter.
+    Eigen::VectorXd gradient_shared_;
+
+    //! Skalierung der Parameter für die Dämpfung (wie diag in MINPACK).
+    Eigen::VectorXd diag_;
+
+    //! Zuletzt verwendeter Parametersatz.
+    Eigen::VectorXd x_;
+
+    //! Arbeitsspeicher für die Jacobi-Matrix einer Probe.
+    Eigen::MatrixXd sample_jacobian_;
+};
+
+#endif // SCHURLEVENBERGMARQUARDT_H
@@ -0,0 +1,158 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <bitset>
+#include <stdexcept>
+
+#include "rankselectbitvector.h"
+
+namespace
+{
+unsigned PopCount(std::uint64_t word)
+{
+    return std::bitset<64>(word).count();
+}
+
+//! Gibt die Position des k-ten gesetzten Bits in einem Wort zurück.
+unsigned SelectInWord(std::uint64_t word, unsigned k)
+{
+    for (unsigned i = 0; i < k; ++i)
+        word &= word - 1;
+    unsigned position = 0;
+    while (!(word & 1))
+    {
+        word >>= 1;
+        ++position;
+    }
+    return position;
+}
+}
+
+RankSelectBitVector::RankSelectBitVector() :
+    words_(),
+    size_(0),
+    ranks_(1, 0),
+    select_samples_()
+{
+}
+
+RankSelectBitVector::RankSelectBitVector(std::size_t size, bool value) :
+    words_((size + WORD_SIZE - 1) / WORD_SIZE),
+    size_(size),
+    ranks_(),
+    select_samples_()
+{
+    Fill(value);
+}
+
+std::size_t RankSelectBitVector::size() const
+{
+    return size_;
+}
+
+bool RankSelectBitVector::operator[](std::size_t i) const
+{
+    return (words_[i / WORD_SIZE] >> (i % WORD_SIZE)) & 1;
+}
+
+void RankSelectBitVector::Set(std::size_t i, bool value)
+{
+    if (i >= size_)
+        throw std::out_of_range("Index out of range.");
+    if ((*this)[i] == value)
+        return;
+    const std::uint64_t bit = std::uint64_t(1) << (i % WORD_SIZE);
+    if (value)
+        words_[i / WORD_SIZE] |= bit;
+    else
+        words_[i / WORD_SIZE] &= ~bit;
+    UpdateDirectories(i / WORD_SIZE);
+}
+
+void RankSelectBitVector::Fill(bool value)
+{
+    std::fill(words_.begin(), words_.end(), value ? ~std::uint64_t(0) : 0);
+    // Unbenutzte Bits des letzten Worts bleiben immer gelöscht.
+    if (value && size_ % WORD_SIZE)
+        words_.back() = (std::uint64_t(1) << (size_ % WORD_SIZE)) - 1;
+    UpdateDirectories(0);
+}
+
+void RankSelectBitVector::push_back(bool value)
+{
+    if (size_ % WORD_SIZE == 0)
+        words_.push_back(0);
+    if (value)
+        words_.back() |= std::uint64_t(1) << (size_ % WORD_SIZE);
+    ++size_;
+    UpdateDirectories(words_.size() - 1);
+}
+
+void RankSelectBitVector::clear()
+{
+    words_.clear();
+    size_ = 0;
+    UpdateDirectories(0);
+}
+
+std::size_t RankSelectBitVector::Count() const
+{
+    return ranks_.back();
+}
+
+std::size_t RankSelectBitVector::Rank(std::size_t i) const
+{
+    if (i >= size_)
+        return Count();
+    return ranks_[i / WORD_SIZE] +
+           PopCount(words_[i / WORD_SIZE] &
+                    ((std::uint64_t(1) << (i % WORD_SIZE)) - 1));
+}
+
+std::size_t RankSelectBitVector::Select(std::size_t k) const
+{
+    if (k >= Count())
+        throw std::out_of_range("Index out of range.");
+
+    // Das Wort liegt zwischen den Wörtern der benachbarten Stichproben.
+    const std::size_t j = k / WORD_SIZE;
+    const auto first = ranks_.begin() + select_samples_[j];
+    const auto last = j + 1 < select_samples_.size() ?
+                      ranks_.begin() + select_samples_[j + 1] + 1 :
+                      ranks_.end() - 1;
+    const std::size_t word = std::upper_bound(first, last, k) - ranks_.begin() - 1;
+    return word * WORD_SIZE + SelectInWord(words_[word], k - ranks_[word]);
+}
+
+void RankSelectBitVector::UpdateDirectories(std::size_t first_word)
+{
+    ranks_.resize(words_.size() + 1);
+    if (first_word == 0)
+        ranks_[0] = 0;
+    for (std::size_t w = first_word; w < words_.size(); ++w)
+        ranks_[w + 1] = ranks_[w] + PopCount(words_[w]);
+
+    // Stichproben in Wörtern vor first_word bleiben gültig.
+    select_samples_.resize(
+            std::min(select_samples_.size(),
+                     (ranks_[first_word] + WORD_SIZE - 1) / WORD_SIZE));
+    for (std::size_t w = first_word; w < words_.size(); ++w)
+        while (select_samples_.size() * WORD_SIZE < ranks_[w + 1])
+            select_samples_.push_back(w);
+}
@@ -0,0 +1,82 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RANKSELECTBITVECTOR_H
+#define RANKSELECTBITVECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! Bitvektor mit schnellen Rang- und Auswahlabfragen.
+/*!
+ * Rank(i) zählt die gesetzten Bits vor Position i, Select(k) gibt die Position des
+ * k-ten gesetzten Bits zurück. Dazu werden die kumulierten Bitzahlen je 64-Bit-Wort
+ * sowie das Wort jedes 64. gesetzten Bits gespeichert. Rank ist damit O(1), Select
+ * für nicht zu dünn besetzte Vektoren ebenfalls.
+ *
+ * Die Verzeichnisse werden bei jeder Änderung sofort nachgeführt (O(n/64)), damit
+ * Abfragen ohne Synchronisation aus mehreren Threads möglich sind.
+ */
+class RankSelectBitVector
+{
+public:
+    RankSelectBitVector();
+    explicit RankSelectBitVector(std::size_t size, bool value = false);
+
+    std::size_t size() const;
+    bool operator[](std::size_t i) const;
+
+    //! Setzt das Bit an Position i.
+    void Set(std::size_t i, bool value);
+
+    //! Setzt alle Bits.
+    void Fill(bool value);
+
+    void push_back(bool value);
+    void clear();
+
+    //! Gibt die Zahl der gesetzten Bits zurück.
+    std::size_t Count() const;
+
+    //! Gibt die Zahl der gesetzten Bits vor Position i zurück.
+    std::size_t Rank(std::size_t i) const;
+
+    //! Gibt die Position des k-ten gesetzten Bits zurück (beginnend bei 0).
+    /*!
+     * \throws std::out_of_range Falls weniger als k + 1 Bits gesetzt sind.
+     */
+    std::size_t Select(std::size_t k) const;
+
+private:
+    static const unsigned WORD_SIZE = 64;
+
+    //! Baut die Verzeichnisse ab dem Wort first_word neu auf.
+    void UpdateDirectories(std::size_t first_word);
+
+    std::vector<std::uint64_t> words_;
+    std::size_t size_;
+
+    //! Zahl der gesetzten Bits vor jedem Wort; das letzte Element ist die Gesamtzahl.
+    std::vector<std::size_t> ranks_;
+
+    //! Wort, in dem das (j * WORD_SIZE)-te gesetzte Bit liegt.
+    std::vector<std::size_t> select_samples_;
+};
+
+#endif // RANKSELECTBITVECTOR_H
@@ -21,143 +21,246 @@
 #include <stdexcept>
 
 #include "rundata.h"
-#include "templates.h"
 
-const SampleConcentrations&
-RunData::ReturnConcentrations::operator()(const RunData::Tuple& in) const
+RunData::ReturnConcentrations::ReturnConcentrations() :
+    run_data_(nullptr)
 {
-    return in.concentrations;
 }
 
-bool RunData::ReturnEnabled::operator()(const RunData::Tuple& in) const
+RunData::ReturnConcentrations::ReturnConcentrations(const RunData* run_data) :
+    run_data_(run_data)
 {
-    return in.enabled;
 }
 
-RunData::RunData() : data_() {}
+SampleConcentrations
+RunData::ReturnConcentrations::operator()(size_t enabled_index) const
+{
+    return run_data_->GetSampleConcentrations(
+            run_data_->GetIndexOfEnabledSample(enabled_index));
+}
+
+RunData::RunData() :
+    names_(),
+    gas_masks_(),
+    values_(),
+    errors_(),
+    enabled_()
+{
+}
 
 RunData::RunData(const RunData& other) :
     QObject(),
-    data_(other.data_)
+    names_(other.names_),
+    gas_masks_(other.gas_masks_),
+    values_(other.values_),
+    errors_(other.errors_),
+    enabled_(other.enabled_)
 {
 }
 
 RunData& RunData::operator=(const RunData& other)
 {
     if (&other != this)
-        data_ = other.data_;
+    {
+        names_ = other.names_;
+        gas_masks_ = other.gas_masks_;
+        values_ = other.values_;
+        errors_ = other.errors_;
+        enabled_ = other.enabled_;
+    }
     return *this;
 }
 
 void RunData::Add(Sample&& sample)
 {
-    data_.emplace_back(std::move(sample.first), std::move(sample.second));
+    unsigned char gas_mask = 0;
+    for (const auto& concentration : sample.second)
+        if (concentration.first >= Gas::end_including_HE3)
+            throw std::invalid_argument("Invalid gas type.");
+
+    for (unsigned gas = 0; gas < Gas::end_including_HE3; ++gas)
+    {
+        auto it = sample.second.find(static_cast<GasType>(gas));
+        if (it != sample.second.end())
+        {
+            gas_mask |= 1 << gas;
+            values_[gas].push_back(it->second.value);
+            errors_[gas].push_back(it->second.error);
+        }
+        else
+        {
+            values_[gas].push_back(0.);
+            errors_[gas].push_back(0.);
+        }
+    }
+    names_.push_back(std::move(sample.first));
+    gas_masks_.push_back(gas_mask);
+    enabled_.push_back(true);
+    sample.second.clear();
+}
+
+void RunData::reserve(size_t n)
+{
+    names_.reserve(n);
+    gas_masks_.reserve(n);
+    for (unsigned gas = 0; gas < Gas::end_including_HE3; ++gas)
+    {
+        values_[gas].reserve(n);
+        errors_[gas].reserve(n);
+    }
 }
 
 size_t RunData::EnabledSize() const
 {
-    return std::count_if(data_.cbegin(), data_.cend(),
-                         [](const Tuple& t)
-                         {
-                             return t.enabled;
-                         });
+    return enabled_.Count();
 }
 
 size_t RunData::TotalSize() const
 {
-    return data_.size();
+    return names_.size();
 }
 
 RunData::const_concentrations_iterator RunData::concentrations_begin() const
 {
     return boost::make_transform_iterator(
-            boost::make_filter_iterator(ReturnEnabled(),
-                                        data_.cbegin(),
-                                        data_.cend()),
-            ReturnConcentrations());
+            boost::counting_iterator<size_t>(0),
+            ReturnConcentrations(this));
 }
 
 RunData::const_concentrations_iterator RunData::concentrations_end() const
 {
     return boost::make_transform_iterator(
-            boost::make_filter_iterator(ReturnEnabled(),
-                                        data_.cend(),
-                                        data_.cend()),
-            ReturnConcentrations());
+            boost::counting_iterator<size_t>(EnabledSize()),
+            ReturnConcentrations(this));
 }
 
 std::vector<std::string> RunData::GetEnabledSampleNames() const
 {
     std::vector<std::string> names;
+    names.reserve(EnabledSize());
     
-    for (auto it = data_.begin(); it != data_.end(); ++it)
-        if (it->enabled)
-            names.push_back(it->name);
+    for (unsigned i = 0; i < names_.size(); ++i)
+        if (enabled_[i])
+            names.push_back(names_[i]);
     
     return names;
 }
 
 std::vector< std::string > RunData::GetAllSampleNames() const
 {
-    std::vector<std::string> names;
-    
-    for (auto it = data_.begin(); it != data_.end(); ++it)
-        names.push_back(it->name);
-    
-    return names;
+    return names_;
 }
 
 const std::string& RunData::GetSampleName(unsigned index) const
 {
-    return data_.at(index).name;
+    return names_.at(index);
+}
+
+SampleConcentrations RunData::GetSampleConcentrations(unsigned index) const
+{
+    CheckIndex(index);
+    SampleConcentrations concentrations;
+    for (unsigned gas = 0; gas < Gas::end_including_HE3; ++gas)
+        if (gas_masks_[index] & (1 << gas))
+            concentrations.emplace_hint(
+                    concentrations.end(),
+                    static_cast<GasType>(gas),
+                    Data(values_[gas][index], errors_[gas][index]));
+    return concentrations;
 }
 
-const SampleConcentrations& RunData::GetSampleConcentrations(
-        unsigned index) const
+bool RunData::HasGas(unsigned index, GasType gas) const
 {
-    return data_.at(index).concentrations;
+    CheckIndex(index);
+    return gas < Gas::end_including_HE3 && (gas_masks_[index] & (1 << gas));
+}
+
+const double* RunData::GetValues(GasType gas) const
+{
+    return values_.at(gas).data();
+}
+
+const double* RunData::GetErrors(GasType gas) const
+{
+    return errors_.at(gas).data();
+}
+
+unsigned RunData::GetIndexOfEnabledSample(unsigned enabled_index) const
+{
+    return enabled_.Select(enabled_index);
 }
 
 void RunData::RemoveGas(GasType gas)
 {
-    for (auto& sample : data_)
-        sample.concentrations.erase(gas);
+    if (gas >= Gas::end_including_HE3)
+        return;
+    for (auto& gas_mask : gas_masks_)
+        gas_mask &= ~(1 << gas);
 }
 
 void RunData::DisableSample(unsigned int index)
 {
-    bool changed = data_.at(index).enabled;
-    data_.at(index).enabled = false;
+    CheckIndex(index);
+    bool changed = enabled_[index];
+    enabled_.Set(index, false);
     if (changed)
         emit SampleDisabled(index);
 }
 
 void RunData::EnableSample(unsigned int index)
 {
-    bool changed = !data_.at(index).enabled;
-    data_.at(index).enabled = true;
+    CheckIndex(index);
+    bool changed = !enabled_[index];
+    enabled_.Set(index, true);
     if (changed)
         emit SampleEnabled(index);
 }
 
 bool RunData::IsEnabled(unsigned index) const
 {
-    return data_.at(index).enabled;
+    CheckIndex(index);
+    return enabled_[index];
 }
 
 void RunData::EnableAllSamples()
 {
-    for (unsigned i = 0; i < data_.size(); ++i)
-        EnableSample(i);
+    SetAllSamplesEnabled(true);
 }
 
 void RunData::DisableAllSamples()
 {
-    for (unsigned i = 0; i < data_.size(); ++i)
-        DisableSample(i);
+    SetAllSamplesEnabled(false);
 }
 
 void RunData::clear()
 {
-    data_.clear();
+    names_.clear();
+    gas_masks_.clear();
+    for (unsigned gas = 0; gas < Gas::end_including_HE3; ++gas)
+    {
+        values_[gas].clear();
+        errors_[gas].clear();
+    }
+    enabled_.clear();
+}
+
+void RunData::CheckIndex(unsigned index) const
+{
+    if (index >= names_.size())
+        throw std::out_of_range("Sample index out of range.");
+}
+
+void RunData::SetAllSamplesEnabled(bool enabled)
+{
+    // Den Bitvektor nur einmal ändern, die Signale aber wie bisher je Probe senden.
+    std::vector<unsigned> changed;
+    for (unsigned i = 0; i < names_.size(); ++i)
+        if (enabled_[i] != enabled)
+            changed.push_back(i);
+    enabled_.Fill(enabled);
+    for (unsigned i : changed)
+        if (enabled)
+            emit SampleEnabled(i);
+        else
+            emit SampleDisabled(i);
 }
@@ -22,10 +22,12 @@
 #include <QObject>
 
 #define BOOST_RESULT_OF_USE_DECLTYPE
-#include <boost/iterator/filter_iterator.hpp>
+#include <boost/iterator/counting_iterator.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 #include <boost/serialization/access.hpp>
+#include <boost/serialization/split_member.hpp>
 
+#include <array>
 #include <map>
 #include <memory>
 #include <string>
@@ -34,19 +36,24 @@
 
 #include "data.h"
 #include "gas.h"
+#include "rankselectbitvector.h"
 #include "typedefs.h"
 
 //! Speichert einen Satz von Proben.
 /*!
- * Probennamen werden zusammen mit Gaskonzentrationen gespeichert.
+ * Probennamen werden zusammen mit Gaskonzentrationen gespeichert. Die Konzentrationen
+ * liegen spaltenweise vor: je Gas ein Feld der Werte und eines der Fehler über alle
+ * Proben, dazu je Probe eine Maske der gemessenen Gase. Die aktivierten Proben werden
+ * in einem Bitvektor mit Rang- und Auswahlabfragen geführt, sodass sich Indizes aller
+ * und aktivierter Proben schnell ineinander umrechnen lassen.
  */
 class RunData : public QObject
 {
     Q_OBJECT
     
     class ReturnConcentrations;
-    class ReturnEnabled;
     
+    //! Format einer Probe in gespeicherten Dateien.
     struct Tuple
     {
         Tuple() : enabled(true) {}
@@ -69,8 +76,6 @@ class RunData : public QObject
     };
     
     typedef std::vector<Tuple> VectorType;
-    typedef boost::filter_iterator<ReturnEnabled, VectorType::const_iterator>
-            FilterIterator;
     
 public:
     
@@ -85,15 +90,20 @@ public:
      */
     void Add(Sample&& sample);
     
+    //! Reserviert Speicher für n Proben.
+    void reserve(size_t n);
+    
     size_t EnabledSize() const;
     size_t TotalSize() const;
     
-    typedef boost::transform_iterator<ReturnConcentrations, FilterIterator>
+    typedef boost::transform_iterator<ReturnConcentrations,
+                                      boost::counting_iterator<size_t>>
             const_concentrations_iterator;
     
     //! Gibt einen Iterator der über alle Konzentrations-Maps iteriert zurück.
     /*!
-     * Dabei werden deaktivierte Proben jedoch übersprungen.
+     * Dabei werden deaktivierte Proben jedoch übersprungen. Die Maps werden beim
+     * Dereferenzieren erzeugt.
      */
     const_concentrations_iterator concentrations_begin() const;
     
@@ -116,7 +126,26 @@ public:
     /*!
      * \warning Übergeht deaktivierte Proben \b nicht.
      */
-    const SampleConcentrations& GetSampleConcentrations(unsigned index) const;
+    SampleConcentrations GetSampleConcentrations(unsigned index) const;
+    
+    //! Gibt an, ob für eine Probe eine Konzentration des Gases vorliegt.
+    bool HasGas(unsigned index, GasType gas) const;
+    
+    //! Gibt die Messwerte eines Gases für alle Proben zurück, ohne sie zu kopieren.
+    /*!
+     * Das Feld hat TotalSize() Elemente. Werte von Proben, für die das Gas nicht
+     * vorliegt (siehe HasGas()), sind undefiniert.
+     */
+    const double* GetValues(GasType gas) const;
+    
+    //! Gibt die Messfehler eines Gases für alle Proben zurück (siehe GetValues()).
+    const double* GetErrors(GasType gas) const;
+    
+    //! Gibt den Index einer aktivierten Probe unter allen Proben zurück.
+    /*!
+     * \param enabled_index Index unter den aktivierten Proben.
+     */
+    unsigned GetIndexOfEnabledSample(unsigned enabled_index) const;
     
     //! Entfernt ein Gas aus allen Proben.
     void RemoveGas(GasType gas);
@@ -136,25 +165,40 @@ signals:
     void SampleDisabled(unsigned index);
         
 private:
-    //! Funktor, der die Konzentrationen zurückgibt.
-    class ReturnConcentrations :
-    public std::unary_function<const Tuple&, const SampleConcentrations&>
+    //! Funktor, der zum Index einer aktivierten Probe deren Konzentrationen zurückgibt.
+    class ReturnConcentrations
     {
     public:
-        const SampleConcentrations& operator()(const Tuple& in) const;
+        typedef SampleConcentrations result_type;
+        
+        ReturnConcentrations();
+        explicit ReturnConcentrations(const RunData* run_data);
+        SampleConcentrations operator()(size_t enabled_index) const;
+        
+    private:
+        const RunData* run_data_;
     };
     
-    //! Funktor, der zurückgibt, ob die Probe aktiviert oder deaktiviert ist.
-    class ReturnEnabled : public std::unary_function<const Tuple&, bool>
-    {
-    public:
-        bool operator()(const Tuple& in) const;
-    };
+    void CheckIndex(unsigned index) const;
+    void SetAllSamplesEnabled(bool enabled);
+    
+    std::vector<std::string> names_;
+    
+    //! Bit g ist gesetzt, falls für die Probe eine Konzentration des Gases g vorliegt.
+    std::vector<unsigned char> gas_masks_;
+    
+    //! Messwerte je Gas (äußeres Feld) und Probe.
+    std::array<std::vector<double>, Gas::end_including_HE3> values_;
+    
+    //! Messfehler je Gas (äußeres Feld) und Probe.
+    std::array<std::vector<double>, Gas::end_including_HE3> errors_;
     
-    VectorType data_;
+    RankSelectBitVector enabled_;
     
     friend class boost::serialization::access;
-    template<class Archive> void serialize(Archive& ar, const unsigned);
+    template<class Archive> void save(Archive& ar, const unsigned) const;
+    template<class Archive> void load(Archive& ar, const unsigned);
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
 template<class Archive>
@@ -167,9 +211,32 @@ void RunData::Tuple::serialize(Archive& ar, const unsigned version)
         
 
 template<class Archive>
-void RunData::serialize(Archive& ar, const unsigned)
+void RunData::save(Archive& ar, const unsigned) const
 {
-    ar & data_;
+    // Das Dateiformat ist unverändert eine Liste von Proben.
+    VectorType data;
+    data.reserve(TotalSize());
+    for (unsigned i = 0; i < TotalSize(); ++i)
+    {
+        data.emplace_back(std::string(names_[i]), GetSampleConcentrations(i));
+        data.back().enabled = enabled_[i];
+    }
+    ar << data;
+}
+
+template<class Archive>
+void RunData::load(Archive& ar, const unsigned)
+{
+    VectorType data;
+    ar >> data;
+    clear();
+    reserve(data.size());
+    for (auto& tuple : data)
+    {
+        const bool enabled = tuple.enabled;
+        Add(std::make_pair(std::move(tuple.name), std::move(tuple.concentrations)));
+        enabled_.Set(enabled_.size() - 1, enabled);
+    }
 }
         
 #endif //RUNDATA_H
\ No newline at end of file
@@ -0,0 +1,97 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+//! Misst den Durchsatz von Monte-Carlo-Fits eines Einzelprobenfits.
+/*!
+  Vergleicht FixedSizeLevenbergMarquardt mit Eigen::LevenbergMarquardt. Wird nicht als Test
+  registriert, sondern manuell aufgerufen:
+
+      benchmark_montecarlo [Zahl der Monte-Carlo-Fits]
+  */
+
+#include <boost/chrono.hpp>
+#include <boost/random.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "core/fitting/levenbergmarquardtfitter.h"
+#include "core/fitting/noblefitfunction.h"
+
+#include "cefitsetup.h"
+
+namespace
+{
+double RunMonteCarloFits(const CeFitSetup& setup,
+                         unsigned long n_monte_carlos,
+                         bool fixed_size_solver_enabled)
+{
+    boost::random::mt19937 generator(42);
+    boost::random::normal_distribution<> normal;
+
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+    const NobleParameterMap parameter_map(setup.GetParameterMap());
+
+    double chi_square_sum = 0.;
+    boost::chrono::steady_clock::time_point start =
+            boost::chrono::steady_clock::now();
+
+    for (unsigned long i = 0; i < n_monte_carlos; ++i)
+    {
+        std::vector<SampleConcentrations> varied_concentrations(
+                setup.concentrations);
+        for (auto& sample : varied_concentrations)
+            for (auto& concentration : sample)
+                concentration.second.value +=
+                        normal(generator) * concentration.second.error;
+
+        LevenbergMarquardtFitter fitter(std::make_shared<NobleFitFunction>(
+                setup.model, parameter_map, varied_concentrations));
+        fitter.SetFixedSizeSolverEnabled(fixed_size_solver_enabled);
+        chi_square_sum += fitter.fit(pconf)->chi_square;
+    }
+
+    boost::chrono::duration<double> seconds =
+            boost::chrono::steady_clock::now() - start;
+
+    std::cout << (fixed_size_solver_enabled ? "fixed size" : "dynamic   ")
+              << ": " << n_monte_carlos / seconds.count() << " fits/s"
+              << " (mean chi2 " << chi_square_sum / n_monte_carlos << ")"
+              << std::endl;
+
+    return seconds.count();
+}
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long n_monte_carlos = argc > 1 ? std::strtoul(argv[1], 0, 10) : 20000UL;
+    if (n_monte_carlos == 0)
+        n_monte_carlos = 1;
+
+    CeFitSetup setup;
+
+    double dynamic = RunMonteCarloFits(setup, n_monte_carlos, false);
+    double fixed_size = RunMonteCarloFits(setup, n_monte_carlos, true);
+
+    std::cout << "speedup: " << dynamic / fixed_size << std::endl;
+
+    return 0;
+}
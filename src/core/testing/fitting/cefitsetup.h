@@ -0,0 +1,178 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CEFITSETUP_H
+#define CEFITSETUP_H
+
+#include <Eigen/Core>
+
+#include <boost/lexical_cast.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/fitting/fitparameterconfig.h"
+#include "core/fitting/modelparameterconfig.h"
+#include "core/fitting/nobleparametermap.h"
+#include "core/misc/typedefs.h"
+#include "core/models/cemodelfactory.h"
+#include "core/models/combinedmodelfactory.h"
+#include "core/models/weissmethodfactory.h"
+
+//! Einzelprobenfit des CE-Modells (A, F, T gefittet) an synthetische Konzentrationen.
+struct CeFitSetup
+{
+    CeFitSetup(double A = 0.01, double F = 0.3, double T = 10.) :
+        factory(new CeModelFactory(), new WeissMethodFactory()),
+        model(factory.CreateModel()),
+        fit_parameter_config(),
+        model_parameter_configs(1),
+        concentrations(1)
+    {
+        fit_parameter_config.AddParameter(FitParameter("A", 0.005));
+        fit_parameter_config.AddParameter(FitParameter("F", 0.5));
+        fit_parameter_config.AddParameter(FitParameter("T", 5.));
+
+        model_parameter_configs[0].push_back(ModelParameterConfig("A", "A"));
+        model_parameter_configs[0].push_back(ModelParameterConfig("F", "F"));
+        model_parameter_configs[0].push_back(ModelParameterConfig("T", "T"));
+        model_parameter_configs[0].push_back(ModelParameterConfig("S", 0.));
+        model_parameter_configs[0].push_back(ModelParameterConfig("p", 1.));
+
+        std::map<std::string, double> values;
+        values["A"] = A;
+        values["F"] = F;
+        values["T"] = T;
+        values["S"] = 0.;
+        values["p"] = 1.;
+        std::vector<std::string> names(model->GetParameterNamesInOrder());
+        Eigen::VectorXd parameters(names.size());
+        for (unsigned i = 0; i < names.size(); ++i)
+            parameters[i] = values[names[i]];
+        model->SetParameters(parameters);
+
+        for (GasType gas = Gas::begin; gas != Gas::end; ++gas)
+        {
+            const double c = model->CalculateConcentration(gas);
+            concentrations[0][gas] = Data(c, 0.01 * c);
+        }
+    }
+
+    NobleParameterMap GetParameterMap() const
+    {
+        return NobleParameterMap(model, fit_parameter_config, model_parameter_configs);
+    }
+
+    CombinedModelFactory factory;
+    std::shared_ptr<CombinedModel> model;
+    FitParameterConfig fit_parameter_config;
+    std::vector<ModelParameterConfigs> model_parameter_configs;
+    std::vector<SampleConcentrations> concentrations;
+};
+
+//! Ensemblefit des CE-Modells mit gemeinsamen A und F und einem eigenen T je Probe.
+struct CeEnsembleFitSetup
+{
+    //! Welche Parameter die Proben gemeinsam haben.
+    enum Sharing
+    {
+        //! A und F gemeinsam, T je Probe.
+        SHARE_A_AND_F,
+        //! A, F und T gemeinsam.
+        SHARE_ALL,
+        //! Jede Probe hat eigene Parameter.
+        SHARE_NONE
+    };
+
+    CeEnsembleFitSetup(unsigned n_samples, double A = 0.01, double F = 0.3,
+                       Sharing sharing = SHARE_A_AND_F) :
+        factory(new CeModelFactory(), new WeissMethodFactory()),
+        model(factory.CreateModel()),
+        fit_parameter_config(),
+        model_parameter_configs(n_samples),
+        concentrations(n_samples)
+    {
+        if (sharing != SHARE_NONE)
+        {
+            fit_parameter_config.AddParameter(FitParameter("A", 0.005));
+            fit_parameter_config.AddParameter(FitParameter("F", 0.5));
+        }
+        if (sharing == SHARE_ALL)
+            fit_parameter_config.AddParameter(FitParameter("T", 5.));
+
+        std::vector<std::string> names(model->GetParameterNamesInOrder());
+        for (unsigned i = 0; i < n_samples; ++i)
+        {
+            const std::string suffix = boost::lexical_cast<std::string>(i);
+            std::string A_name = "A";
+            std::string F_name = "F";
+            std::string T_name = "T";
+            if (sharing == SHARE_NONE)
+            {
+                A_name += suffix;
+                F_name += suffix;
+                fit_parameter_config.AddParameter(FitParameter(A_name, 0.005));
+                fit_parameter_config.AddParameter(FitParameter(F_name, 0.5));
+            }
+            if (sharing != SHARE_ALL)
+            {
+                T_name += suffix;
+                fit_parameter_config.AddParameter(FitParameter(T_name, 5.));
+            }
+
+            model_parameter_configs[i].push_back(ModelParameterConfig("A", A_name));
+            model_parameter_configs[i].push_back(ModelParameterConfig("F", F_name));
+            model_parameter_configs[i].push_back(ModelParameterConfig("T", T_name));
+            model_parameter_configs[i].push_back(ModelParameterConfig("S", 0.));
+            model_parameter_configs[i].push_back(ModelParameterConfig("p", 1.));
+
+            std::map<std::string, double> values;
+            values["A"] = A;
+            values["F"] = F;
+            values["T"] = 4. + 2. * (i % 8);
+            values["S"] = 0.;
+            values["p"] = 1.;
+            Eigen::VectorXd parameters(names.size());
+            for (unsigned j = 0; j < names.size(); ++j)
+                parameters[j] = values[names[j]];
+            model->SetParameters(parameters);
+
+            for (GasType gas = Gas::begin; gas != Gas::end; ++gas)
+            {
+                const double c = model->CalculateConcentration(gas);
+                concentrations[i][gas] = Data(c * (1. + 0.002 * ((i + gas) % 3 - 1.)),
+                                              0.01 * c);
+            }
+        }
+    }
+
+    NobleParameterMap GetParameterMap() const
+    {
+        return NobleParameterMap(model, fit_parameter_config, model_parameter_configs);
+    }
+
+    CombinedModelFactory factory;
+    std::shared_ptr<CombinedModel> model;
+    FitParameterConfig fit_parameter_config;
+    std::vector<ModelParameterConfigs> model_parameter_configs;
+    std::vector<SampleConcentrations> concentrations;
+};
+
+#endif // CEFITSETUP_H
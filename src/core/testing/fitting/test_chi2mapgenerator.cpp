@@ -0,0 +1,250 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cmath>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "core/fitting/chi2mapgenerator.h"
+#include "core/fitting/levenbergmarquardtfitter.h"
+#include "core/fitting/noblefitfunction.h"
+#include "core/misc/rundata.h"
+
+#include "cefitsetup.h"
+
+namespace
+{
+Chi2Map CreateMap(double (*f)(double, double))
+{
+    Chi2Map map;
+    map.index = 0;
+    // 41 Punkte im Abstand 0.1 von -2 bis 2, die obere Grenze wird nicht abgetastet.
+    map.x_min = map.y_min = -2.;
+    map.x_max = map.y_max = 2.1;
+    map.chi2_values.resize(41, 41);
+    for (int i = 0; i < 41; ++i)
+        for (int j = 0; j < 41; ++j)
+            map.chi2_values(i, j) = f(map.GetX(i), map.GetY(j));
+    return map;
+}
+
+double Paraboloid(double x, double y)
+{
+    return x * x + y * y;
+}
+
+double Plane(double x, double)
+{
+    return x;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(Chi2MapGenerator_tests)
+
+BOOST_AUTO_TEST_CASE(FindContours_Paraboloid_ClosedCircles)
+{
+    std::vector<ContourLine> lines =
+            Chi2MapGenerator::FindContours(CreateMap(Paraboloid), {1., 2.25, 100.});
+
+    BOOST_REQUIRE_EQUAL(lines.size(), 2);
+    BOOST_CHECK_EQUAL(lines[0].delta_chi_square, 1.);
+    BOOST_CHECK_EQUAL(lines[1].delta_chi_square, 2.25);
+    for (const ContourLine& line : lines)
+    {
+        BOOST_REQUIRE(line.points.size() > 10);
+        BOOST_CHECK(line.points.front() == line.points.back());
+        const double radius = std::sqrt(line.delta_chi_square);
+        for (const auto& point : line.points)
+            BOOST_CHECK_SMALL(std::hypot(point.first, point.second) - radius, 0.01);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FindContours_Plane_OpenLine)
+{
+    Chi2Map map = CreateMap(Plane);
+    map.chi2_values(30, 20) = std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<ContourLine> lines = Chi2MapGenerator::FindContours(map, {1.});
+
+    // Die Linie bei x = -1 berührt die NaN-Zelle nicht.
+    BOOST_REQUIRE_EQUAL(lines.size(), 1);
+    BOOST_CHECK_EQUAL(lines[0].points.size(), 41);
+    for (const auto& point : lines[0].points)
+        BOOST_CHECK_CLOSE(point.first, -1., 1e-10);
+    BOOST_CHECK_CLOSE(std::abs(lines[0].points.front().second), 2., 1e-10);
+    BOOST_CHECK_CLOSE(std::abs(lines[0].points.back().second), 2., 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(GridPoint_CellLeftEdges)
+{
+    BOOST_CHECK_EQUAL(Chi2Map::GridPoint(1., 3., 4, 0), 1.);
+    BOOST_CHECK_EQUAL(Chi2Map::GridPoint(1., 3., 4, 1), 1.5);
+    BOOST_CHECK_EQUAL(Chi2Map::GridPoint(1., 3., 4, 3), 2.5);
+    BOOST_CHECK_EQUAL(Chi2Map::GridPoint(1., 3., 4, 4), 3.);
+
+    Chi2Map map;
+    map.x_min = 0.;
+    map.x_max = 1.;
+    map.y_min = -1.;
+    map.y_max = 1.;
+    map.chi2_values.resize(10, 4);
+    BOOST_CHECK_EQUAL(map.GetX(9), 0.9);
+    BOOST_CHECK_EQUAL(map.GetY(3), 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(Generate_AllSamples_MinimumAtTrueValues)
+{
+    CeFitSetup setup_a(0.012, 0.4, 12.);
+    CeFitSetup setup_b(0.008, 0.3, 12.);
+    RunData data;
+    data.Add(std::make_pair(std::string("a"), setup_a.concentrations[0]));
+    data.Add(std::make_pair(std::string("b"), setup_b.concentrations[0]));
+
+    std::vector<FitConfiguration> configurations(2);
+    for (unsigned s = 0; s < 2; ++s)
+    {
+        configurations[s].model = setup_a.model;
+        configurations[s].fit_parameter_config = setup_a.fit_parameter_config;
+        configurations[s].model_parameter_configs = setup_a.model_parameter_configs;
+        configurations[s].sample_numbers = {s};
+    }
+
+    Chi2MapSettings settings;
+    settings.x_parameter = 0;
+    settings.y_parameter = 1;
+    settings.width = 9;
+    settings.height = 7;
+    settings.n_threads = 3;
+    settings.max_maps_in_memory = 1;
+
+    std::vector<Chi2Map> maps(2);
+    std::set<unsigned> processed;
+    for (unsigned s = 0; s < 2; ++s)
+    {
+        const double A = s == 0 ? 0.012 : 0.008;
+        const double F = s == 0 ? 0.4 : 0.3;
+        // Die wahren Werte liegen auf den Gitterpunkten (4, 3).
+        settings.x_min = A - 4 * 0.0005;
+        settings.x_max = A + 5 * 0.0005;
+        settings.y_min = F - 3 * 0.05;
+        settings.y_max = F + 4 * 0.05;
+        Chi2MapGenerator generator(settings);
+        generator.Generate(data, configurations, [&](const Chi2Map& map)
+                           {
+                               if (map.index == s)
+                                   maps[s] = map;
+                               processed.insert(map.index);
+                           });
+    }
+    BOOST_CHECK_EQUAL(processed.size(), 2);
+
+    for (unsigned s = 0; s < 2; ++s)
+    {
+        const Chi2Map& map = maps[s];
+        BOOST_CHECK_EQUAL(map.sample_name, s == 0 ? "a" : "b");
+        BOOST_REQUIRE_EQUAL(map.chi2_values.rows(), 9);
+        BOOST_REQUIRE_EQUAL(map.chi2_values.cols(), 7);
+
+        int i_min, j_min;
+        map.chi2_values.minCoeff(&i_min, &j_min);
+        BOOST_CHECK_EQUAL(i_min, 4);
+        BOOST_CHECK_EQUAL(j_min, 3);
+        BOOST_CHECK_SMALL(map.chi2_values(4, 3), 1e-6);
+    }
+
+    // Stichprobe gegen einen einzelnen Fit mit festgehaltenen Achsenparametern.
+    const Chi2Map& map = maps[1];
+    std::shared_ptr<NobleFitFunction> function(std::make_shared<NobleFitFunction>(
+            setup_b.model, setup_b.GetParameterMap(), setup_b.concentrations));
+    function->FixParameters({std::make_pair(0, map.GetX(1)), std::make_pair(1, map.GetY(5))});
+    std::shared_ptr<FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup_b.fit_parameter_config));
+    pconf->RemoveParameter(1);
+    pconf->RemoveParameter(0);
+    LevenbergMarquardtFitter fitter(function);
+    BOOST_CHECK_CLOSE(fitter.fit(pconf)->chi_square, map.chi2_values(1, 5), 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(Generate_ProcessorThrows_RethrownAfterAllThreadsEnded)
+{
+    CeFitSetup setup;
+    RunData data;
+    std::vector<FitConfiguration> configurations(8);
+    for (unsigned s = 0; s < configurations.size(); ++s)
+    {
+        data.Add(std::make_pair(std::to_string(s), setup.concentrations[0]));
+        configurations[s].model = setup.model;
+        configurations[s].fit_parameter_config = setup.fit_parameter_config;
+        configurations[s].model_parameter_configs = setup.model_parameter_configs;
+        configurations[s].sample_numbers = {s};
+    }
+
+    Chi2MapSettings settings;
+    settings.x_min = 0.01;
+    settings.x_max = 0.014;
+    settings.y_min = 0.3;
+    settings.y_max = 0.5;
+    settings.width = 4;
+    settings.height = 4;
+    settings.n_threads = 4;
+    Chi2MapGenerator generator(settings);
+
+    // Die Karten werden auch in den zusätzlichen Threads übergeben.
+    boost::mutex mutex;
+    unsigned n_calls = 0;
+    BOOST_CHECK_THROW(generator.Generate(data, configurations, [&](const Chi2Map&)
+                      {
+                          boost::lock_guard<boost::mutex> lock(mutex);
+                          ++n_calls;
+                          throw std::runtime_error("Map processor failed");
+                      }),
+                      std::runtime_error);
+    // Nach dem Fehler werden keine weiteren Spalten vergeben.
+    BOOST_CHECK(n_calls >= 1);
+    BOOST_CHECK(n_calls <= settings.n_threads);
+}
+
+BOOST_AUTO_TEST_CASE(Generate_InvalidAxes_Throws)
+{
+    CeFitSetup setup;
+    FitConfiguration config;
+    config.model = setup.model;
+    config.fit_parameter_config = setup.fit_parameter_config;
+    config.model_parameter_configs = setup.model_parameter_configs;
+    config.sample_numbers = {0};
+
+    Chi2MapSettings settings;
+    settings.x_parameter = 0;
+    settings.y_parameter = 3;
+    Chi2MapGenerator generator(settings);
+    BOOST_CHECK_THROW(generator.Generate(RunData(), {config}, [](const Chi2Map&) {}),
+                      std::invalid_argument);
+
+    settings.width = 1;
+    BOOST_CHECK_THROW((Chi2MapGenerator(settings)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
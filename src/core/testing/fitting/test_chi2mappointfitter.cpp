@@ -0,0 +1,99 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "core/fitting/chi2mapgenerator.h"
+#include "core/fitting/chi2mappointfitter.h"
+#include "core/misc/rundata.h"
+
+#include "cefitsetup.h"
+
+namespace
+{
+struct Chi2MapPointFitterFixture
+{
+    Chi2MapPointFitterFixture() :
+        setup(0.012, 0.4, 12.)
+    {
+        data.Add(std::make_pair(std::string("a"), setup.concentrations[0]));
+        config.model = setup.model;
+        config.fit_parameter_config = setup.fit_parameter_config;
+        config.model_parameter_configs = setup.model_parameter_configs;
+        config.sample_numbers = {0};
+    }
+
+    CeFitSetup setup;
+    RunData data;
+    FitConfiguration config;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Chi2MapPointFitter_tests, Chi2MapPointFitterFixture)
+
+BOOST_AUTO_TEST_CASE(Fit_GridPoint_SameAsFitAtItsCoordinates)
+{
+    Chi2MapPointFitter fitter(config, data, 0, 1);
+    fitter.SetGrid(0.010, 0.014, 8, 0.3, 0.5, 4);
+    BOOST_CHECK_EQUAL(fitter.GetX(3), Chi2Map::GridPoint(0.010, 0.014, 8, 3));
+    BOOST_CHECK_EQUAL(fitter.GetY(2), Chi2Map::GridPoint(0.3, 0.5, 4, 2));
+    BOOST_CHECK_EQUAL(fitter.GetParameterConfig().size(), 1);
+
+    const double on_grid = fitter.Fit(3, 2, Eigen::VectorXd())->chi_square;
+    const double at_coordinates =
+            fitter.FitAt(fitter.GetX(3), fitter.GetY(2), Eigen::VectorXd())->chi_square;
+    BOOST_CHECK_CLOSE(on_grid, at_coordinates, 1e-10);
+
+    // Die wahren Werte liegen auf dem Gitterpunkt (4, 2).
+    BOOST_CHECK_SMALL(fitter.Fit(4, 2, Eigen::VectorXd())->chi_square, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(Constructor_FixedParameters_NotFitted)
+{
+    // Der Achsenparameter unter den festgehaltenen wird ignoriert.
+    Chi2MapPointFitter fitter(config, data, 0, 1,
+                              {std::make_pair(1, 1.), std::make_pair(2, 12.)});
+    BOOST_CHECK_EQUAL(fitter.GetParameterConfig().size(), 0);
+
+    BOOST_CHECK_SMALL(fitter.FitAt(0.012, 0.4, Eigen::VectorXd())->chi_square, 1e-6);
+    BOOST_CHECK(fitter.FitAt(0.012, 0.3, Eigen::VectorXd())->chi_square > 1.);
+}
+
+BOOST_AUTO_TEST_CASE(CopyConstructor_OwnFitter_SameResults)
+{
+    Chi2MapPointFitter fitter(config, data, 1, 2);
+    fitter.SetResultsRequest(ResultsRequest());
+    Chi2MapPointFitter copy(fitter);
+
+    std::shared_ptr<FitResults> copy_results = copy.FitAt(0.35, 14., Eigen::VectorXd());
+    std::shared_ptr<FitResults> results = fitter.FitAt(0.35, 14., Eigen::VectorXd());
+    BOOST_CHECK_EQUAL(copy_results->chi_square, results->chi_square);
+    BOOST_CHECK(copy_results->best_estimate == results->best_estimate);
+    BOOST_CHECK(copy_results->model_concentrations.empty() ||
+                copy_results->model_concentrations[0].empty());
+
+    // Startwerte falscher Länge werden durch die der Fitkonfiguration ersetzt.
+    BOOST_CHECK_EQUAL(copy.FitAt(0.35, 14., Eigen::Vector3d(1., 2., 3.))->chi_square,
+                      results->chi_square);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <memory>
+
+#include "core/fitting/defaultfitter.h"
+
+#include "cefitsetup.h"
+
+namespace
+{
+//! Speichert die Ergebnisse der normalen Fits.
+class StoringResultsProcessor : public FitResultsProcessor
+{
+public:
+    void ProcessResult(std::shared_ptr<FitResults> results,
+                       const std::vector<std::string>&,
+                       const std::vector<std::string>&,
+                       const std::vector<SampleConcentrations>&)
+    {
+        results_.push_back(results);
+    }
+
+    void ProcessMonteCarloResult(std::shared_ptr<FitResults>,
+                                 const std::vector<std::string>&,
+                                 const std::vector<std::string>&,
+                                 const std::vector<SampleConcentrations>&)
+    {
+    }
+
+    std::vector<std::shared_ptr<FitResults>> results_;
+};
+
+//! Fittet eine Probe von einem Startpunkt aus, von dem aus LM ein Nebenminimum findet.
+std::shared_ptr<FitResults> FitFromDistantStartingPoint(unsigned n_starts,
+                                                        double time_budget = 0.)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    RunData concentrations;
+    concentrations.Add(std::make_pair("X", setup.concentrations[0]));
+
+    FitConfiguration config;
+    config.model = setup.model;
+    config.fit_parameter_config.AddParameter(FitParameter("A", 1.  , 0.  , 0.05));
+    config.fit_parameter_config.AddParameter(FitParameter("F", 5.  , 0.05, 1.  ));
+    config.fit_parameter_config.AddParameter(FitParameter("T", 100., 0.  , 30. ));
+    config.model_parameter_configs = setup.model_parameter_configs;
+    config.n_monte_carlos = 0;
+    config.sample_numbers.push_back(0);
+    config.multi_start_settings.n_starts = n_starts;
+    config.multi_start_settings.time_budget = time_budget;
+
+    std::shared_ptr<StoringResultsProcessor> processor(
+            std::make_shared<StoringResultsProcessor>());
+    DefaultFitter fitter(processor);
+    fitter.SetConcentrations(concentrations);
+    fitter.SetFitConfigurations({config});
+    fitter.Fit();
+
+    BOOST_REQUIRE_EQUAL(processor->results_.size(), 1);
+    return processor->results_.front();
+}
+}
+
+BOOST_AUTO_TEST_SUITE(DefaultFitter_tests)
+
+BOOST_AUTO_TEST_CASE(Fit_OneStartingPoint_FindLocalMinimum)
+{
+    std::shared_ptr<FitResults> results = FitFromDistantStartingPoint(1);
+    BOOST_CHECK(results->chi_square > 1.);
+    BOOST_CHECK(results->local_minima.empty());
+    BOOST_CHECK_EQUAL(results->n_starts_completed, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Fit_SeveralStartingPoints_FindGlobalMinimum)
+{
+    std::shared_ptr<FitResults> results = FitFromDistantStartingPoint(16);
+    BOOST_CHECK_SMALL(results->chi_square, 1e-10);
+    BOOST_REQUIRE_EQUAL(results->best_estimate.size(), 3);
+    BOOST_CHECK_CLOSE(results->best_estimate[0], 0.012, 1e-4);
+    BOOST_CHECK_CLOSE(results->best_estimate[1], 0.4  , 1e-4);
+    BOOST_CHECK_CLOSE(results->best_estimate[2], 12.  , 1e-4);
+
+    // Das Nebenminimum der Anfangswerte wird mit dem Ergebnis weitergegeben.
+    BOOST_REQUIRE(results->local_minima.size() >= 2);
+    BOOST_CHECK_EQUAL(results->local_minima.front().chi_square, results->chi_square);
+    BOOST_CHECK(results->local_minima.front().best_estimate == results->best_estimate);
+    BOOST_CHECK(results->local_minima.back().chi_square > 1.);
+    BOOST_CHECK_EQUAL(results->n_starts_completed +
+                      results->n_starts_pruned +
+                      results->n_starts_skipped, 16);
+}
+
+BOOST_AUTO_TEST_CASE(Fit_TimeBudgetExceeded_FitFromInitialValuesOnly)
+{
+    std::shared_ptr<FitResults> results = FitFromDistantStartingPoint(16, 1e-12);
+    // Der Fit von den Anfangswerten aus wird begonnen, aber bei Zeitüberschreitung abgebrochen.
+    BOOST_CHECK(std::isfinite(results->chi_square));
+    BOOST_CHECK_EQUAL(results->n_starts_completed + results->n_starts_pruned, 1);
+    BOOST_CHECK_EQUAL(results->n_starts_skipped, 15);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,6 +19,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -107,4 +108,27 @@ BOOST_AUTO_TEST_CASE(ChangeParameterInitialByName)
                       std::invalid_argument);
 }
 
+BOOST_AUTO_TEST_CASE(ChangeParameterBounds)
+{
+    config.AddParameter(FitParameter("ABC", 1));
+    config.AddParameter(FitParameter("FGH", 5, 0, 10));
+    config.AddParameter(FitParameter("XYZ", 2));
+
+    BOOST_CHECK_EQUAL(config.lower_bounds()[0], -std::numeric_limits<double>::infinity());
+    BOOST_CHECK_EQUAL(config.upper_bounds()[0], std::numeric_limits<double>::infinity());
+    BOOST_CHECK_CLOSE(config.lower_bounds()[1], 0, 1e-10);
+    BOOST_CHECK_CLOSE(config.upper_bounds()[1], 10, 1e-10);
+
+    config.ChangeParameterBounds("XYZ", -1., 3.);
+    config.RemoveParameter(0);
+
+    BOOST_REQUIRE_EQUAL(config.lower_bounds().size(), 2);
+    BOOST_REQUIRE_EQUAL(config.upper_bounds().size(), 2);
+    BOOST_CHECK_CLOSE(config.lower_bounds()[1], -1, 1e-10);
+    BOOST_CHECK_CLOSE(config.upper_bounds()[1], 3, 1e-10);
+
+    BOOST_CHECK_THROW(config.ChangeParameterBounds(0, 2., 1.), std::invalid_argument);
+    BOOST_CHECK_THROW(config.ChangeParameterBounds("BUH", 0., 1.), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
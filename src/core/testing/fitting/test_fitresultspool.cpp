@@ -0,0 +1,102 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/chrono.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "core/fitting/fitresultspool.h"
+
+namespace
+{
+
+//! Gibt die Dauer von n Vergaben zurück, deren Objekte jeweils sofort wieder frei werden.
+boost::chrono::duration<double> TimeAcquireAndRelease(FitResultsPool& pool, unsigned n)
+{
+    const boost::chrono::steady_clock::time_point start =
+            boost::chrono::steady_clock::now();
+    for (unsigned i = 0; i < n; ++i)
+        pool.Acquire()->chi_square = i;
+    return boost::chrono::steady_clock::now() - start;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(FitResultsPool_tests)
+
+BOOST_AUTO_TEST_CASE(ReleasedObjectIsReusedFirst)
+{
+    FitResultsPool pool;
+    std::shared_ptr<FitResults> first = pool.Acquire();
+    std::shared_ptr<FitResults> second = pool.Acquire();
+    std::shared_ptr<FitResults> copy = first;
+    const FitResults* first_address = first.get();
+    BOOST_CHECK_EQUAL(pool.size(), 2);
+
+    // Solange eine Kopie besteht, ist das Objekt nicht frei.
+    first.reset();
+    std::shared_ptr<FitResults> third = pool.Acquire();
+    BOOST_CHECK(third.get() != first_address);
+    BOOST_CHECK_EQUAL(pool.size(), 3);
+
+    copy.reset();
+    std::shared_ptr<FitResults> fourth = pool.Acquire();
+    BOOST_CHECK_EQUAL(fourth.get(), first_address);
+    BOOST_CHECK_EQUAL(pool.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(ObjectsOutliveThePool)
+{
+    std::shared_ptr<FitResults> results;
+    {
+        FitResultsPool pool;
+        results = pool.Acquire();
+    }
+    results->chi_square = 1.;
+    results.reset();
+}
+
+BOOST_AUTO_TEST_CASE(AcquireIndependentOfOutstandingObjects)
+{
+    const unsigned n_outstanding = 40000;
+    const unsigned n_acquires = 10000;
+
+    FitResultsPool empty_pool;
+    TimeAcquireAndRelease(empty_pool, n_acquires);
+    const boost::chrono::duration<double> without_outstanding =
+            TimeAcquireAndRelease(empty_pool, n_acquires);
+    BOOST_CHECK_EQUAL(empty_pool.size(), 1);
+
+    // Wie bei einem Verbraucher, der den Monte-Carlo-Fits hinterherhinkt.
+    FitResultsPool pool;
+    std::vector<std::shared_ptr<FitResults>> outstanding;
+    for (unsigned i = 0; i < n_outstanding; ++i)
+        outstanding.push_back(pool.Acquire());
+    TimeAcquireAndRelease(pool, n_acquires);
+    const boost::chrono::duration<double> with_outstanding =
+            TimeAcquireAndRelease(pool, n_acquires);
+    BOOST_CHECK_EQUAL(pool.size(), n_outstanding + 1);
+
+    // Eine lineare Suche über die gehaltenen Objekte bräuchte hier ein Vielfaches.
+    BOOST_CHECK_LT(with_outstanding.count(),
+                   5 * without_outstanding.count() + 0.01);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
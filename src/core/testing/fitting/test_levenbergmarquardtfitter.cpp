@@ -0,0 +1,278 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <memory>
+
+#include "core/fitting/ensemblefitresults.h"
+#include "core/fitting/fitresultspool.h"
+#include "core/fitting/levenbergmarquardtfitter.h"
+#include "core/fitting/noblefitfunction.h"
+#include "core/fitting/schurlevenbergmarquardt.h"
+#include "core/misc/rundata.h"
+
+#include "cefitsetup.h"
+
+BOOST_AUTO_TEST_SUITE(LevenbergMarquardtFitter_tests)
+
+BOOST_AUTO_TEST_CASE(FixedSizeSolverMatchesDynamicSolver)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    LevenbergMarquardtFitter fixed_size_fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    LevenbergMarquardtFitter dynamic_fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    dynamic_fitter.SetFixedSizeSolverEnabled(false);
+
+    std::shared_ptr<FitResults> fixed_size = fixed_size_fitter.fit(pconf);
+    std::shared_ptr<FitResults> dynamic = dynamic_fitter.fit(pconf);
+
+    BOOST_CHECK_EQUAL(fixed_size->exit_flag, dynamic->exit_flag);
+    BOOST_CHECK_EQUAL(fixed_size->n_iterations, dynamic->n_iterations);
+    BOOST_REQUIRE_EQUAL(fixed_size->best_estimate.size(), 3);
+    BOOST_CHECK_CLOSE(fixed_size->best_estimate[0], 0.012, 1e-4);
+    BOOST_CHECK_CLOSE(fixed_size->best_estimate[1], 0.4  , 1e-4);
+    BOOST_CHECK_CLOSE(fixed_size->best_estimate[2], 12.  , 1e-4);
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        BOOST_CHECK_CLOSE(fixed_size->best_estimate[i],
+                          dynamic->best_estimate[i], 1e-8);
+        for (unsigned j = 0; j < 3; ++j)
+            BOOST_CHECK_CLOSE(fixed_size->covariance_matrix(i, j),
+                              dynamic->covariance_matrix(i, j), 1e-6);
+    }
+    BOOST_CHECK_SMALL(fixed_size->chi_square, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(ResultsRequestLimitsCompiledResults)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    LevenbergMarquardtFitter full_fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    LevenbergMarquardtFitter partial_fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    ResultsRequest request;
+    request.Request(Gas::NE, ResultsRequest::EQUILIBRIUM_ERROR);
+    request.Request(Gas::XE, ResultsRequest::MODEL_VALUE | ResultsRequest::MEASURED);
+    request.Request(Gas::AR, ResultsRequest::MODEL_ERROR);
+    partial_fitter.SetResultsRequest(request);
+
+    std::shared_ptr<FitResults> full = full_fitter.fit(pconf);
+    std::shared_ptr<FitResults> partial = partial_fitter.fit(pconf);
+
+    BOOST_REQUIRE_EQUAL(partial->equilibrium_concentrations.size(), 1);
+    BOOST_CHECK_EQUAL(partial->equilibrium_concentrations[0].size(), 1);
+    BOOST_CHECK_EQUAL(partial->model_concentrations[0].size(), 2);
+    BOOST_CHECK_EQUAL(partial->measured_concentrations[0].size(), 1);
+    BOOST_CHECK_EQUAL(partial->residual_gases.size(), full->residual_gases.size());
+
+    BOOST_CHECK_CLOSE(partial->equilibrium_concentrations[0].at(Gas::NE).error,
+                      full->equilibrium_concentrations[0].at(Gas::NE).error, 1e-10);
+    BOOST_CHECK_CLOSE(partial->model_concentrations[0].at(Gas::XE).value,
+                      full->model_concentrations[0].at(Gas::XE).value, 1e-10);
+    BOOST_CHECK_CLOSE(partial->model_concentrations[0].at(Gas::AR).error,
+                      full->model_concentrations[0].at(Gas::AR).error, 1e-10);
+    BOOST_CHECK_CLOSE(partial->measured_concentrations[0].at(Gas::XE).value,
+                      full->measured_concentrations[0].at(Gas::XE).value, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(PooledResultsAreReused)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    LevenbergMarquardtFitter fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    std::shared_ptr<FitResults> expected = fitter.fit(pconf);
+
+    std::shared_ptr<FitResultsPool> pool(std::make_shared<FitResultsPool>());
+    fitter.SetResultsPool(pool);
+
+    std::shared_ptr<FitResults> first = fitter.fit(pconf);
+    const FitResults* first_address = first.get();
+    std::shared_ptr<FitResults> second = fitter.fit(pconf);
+    BOOST_CHECK(second.get() != first_address);
+    BOOST_CHECK_EQUAL(pool->size(), 2);
+
+    first.reset();
+    second.reset();
+    std::shared_ptr<FitResults> third = fitter.fit(pconf);
+    BOOST_CHECK_EQUAL(pool->size(), 2);
+
+    BOOST_CHECK_EQUAL(third->chi_square, expected->chi_square);
+    BOOST_CHECK(third->best_estimate == expected->best_estimate);
+    BOOST_CHECK(third->covariance_matrix == expected->covariance_matrix);
+    BOOST_CHECK(third->residual_gases == expected->residual_gases);
+    BOOST_CHECK(third->measured_concentrations[0].size() ==
+                expected->measured_concentrations[0].size());
+    BOOST_CHECK_EQUAL(third->model_concentrations[0].at(Gas::XE).error,
+                      expected->model_concentrations[0].at(Gas::XE).error);
+}
+
+BOOST_AUTO_TEST_CASE(SchurSolverMatchesDenseSolver)
+{
+    const unsigned n_samples = 4;
+    CeEnsembleFitSetup setup(n_samples);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    LevenbergMarquardtFitter schur_fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    std::shared_ptr<NobleFitFunction> dense_function(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    LevenbergMarquardtFitter dense_fitter(dense_function);
+    dense_fitter.SetSchurSolverEnabled(false);
+
+    std::shared_ptr<FitResults> schur = schur_fitter.fit(pconf);
+    std::shared_ptr<FitResults> dense = dense_fitter.fit(pconf);
+
+    BOOST_REQUIRE(std::dynamic_pointer_cast<EnsembleFitResults>(schur));
+    BOOST_REQUIRE_EQUAL(schur->best_estimate.size(), n_samples + 2);
+    BOOST_CHECK_EQUAL(schur->GetExitFlagAsString(), "Converged");
+    BOOST_CHECK_EQUAL(dense->GetExitFlagAsString(), "Converged");
+    BOOST_CHECK_CLOSE(schur->chi_square, dense->chi_square, 1e-4);
+    for (unsigned i = 0; i < n_samples + 2; ++i)
+    {
+        BOOST_CHECK_CLOSE(schur->best_estimate[i], dense->best_estimate[i], 1e-4);
+        BOOST_CHECK_CLOSE(schur->deviations[i], dense->deviations[i], 1e-2);
+    }
+
+    for (unsigned i = 0; i < n_samples; ++i)
+    {
+        const std::vector<unsigned>& indices = dense_function->GetFitParametersOfSample(i);
+        BOOST_REQUIRE_EQUAL(indices.size(), 3);
+        const Eigen::MatrixXd schur_covariances = schur->SelectCovariances(indices);
+        const Eigen::MatrixXd dense_covariances = dense->SelectCovariances(indices);
+        for (unsigned j = 0; j < 3; ++j)
+            for (unsigned k = 0; k < 3; ++k)
+                BOOST_CHECK_CLOSE(schur_covariances(j, k), dense_covariances(j, k), 1e-2);
+
+        for (GasType gas = Gas::begin; gas != Gas::end; ++gas)
+            BOOST_CHECK_CLOSE(schur->model_concentrations[i][gas].error,
+                              dense->model_concentrations[i][gas].error, 1e-2);
+    }
+}
+
+namespace
+{
+//! Fittet mit und ohne Schur-Löser und vergleicht die Ergebnisse.
+void CheckSchurEnabledFitMatchesDenseFit(const CeEnsembleFitSetup& setup)
+{
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+    std::shared_ptr<NobleFitFunction> function(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    BOOST_CHECK(!SchurLevenbergMarquardt::IsApplicable(*function, pconf->size()));
+
+    LevenbergMarquardtFitter schur_enabled_fitter(function);
+    LevenbergMarquardtFitter dense_fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    dense_fitter.SetSchurSolverEnabled(false);
+
+    std::shared_ptr<FitResults> schur_enabled = schur_enabled_fitter.fit(pconf);
+    std::shared_ptr<FitResults> dense = dense_fitter.fit(pconf);
+
+    BOOST_CHECK_EQUAL(schur_enabled->GetExitFlagAsString(), "Converged");
+    BOOST_CHECK_CLOSE(schur_enabled->chi_square, dense->chi_square, 1e-8);
+    BOOST_REQUIRE_EQUAL(schur_enabled->best_estimate.size(), pconf->size());
+    for (unsigned i = 0; i < pconf->size(); ++i)
+        BOOST_CHECK_CLOSE(schur_enabled->best_estimate[i], dense->best_estimate[i], 1e-8);
+}
+}
+
+BOOST_AUTO_TEST_CASE(SchurSolverNotUsedIfAllParametersAreShared)
+{
+    CheckSchurEnabledFitMatchesDenseFit(
+            CeEnsembleFitSetup(3, 0.01, 0.3, CeEnsembleFitSetup::SHARE_ALL));
+}
+
+BOOST_AUTO_TEST_CASE(SchurSolverNotUsedIfNoParameterIsShared)
+{
+    CheckSchurEnabledFitMatchesDenseFit(
+            CeEnsembleFitSetup(3, 0.01, 0.3, CeEnsembleFitSetup::SHARE_NONE));
+}
+
+BOOST_AUTO_TEST_CASE(FitFunctionFromRunDataMatchesFitFunctionFromMaps)
+{
+    CeEnsembleFitSetup setup(3);
+    setup.concentrations[1].erase(Gas::KR);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    RunData data;
+    SampleConcentrations disabled(setup.concentrations[2]);
+    data.Add(std::make_pair(std::string("disabled"), disabled));
+    data.DisableSample(0);
+    for (unsigned i = 0; i < setup.concentrations.size(); ++i)
+    {
+        SampleConcentrations concentrations(setup.concentrations[i]);
+        data.Add(std::make_pair(std::string("sample"), concentrations));
+    }
+
+    std::shared_ptr<NobleFitFunction> from_run_data(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), data, std::vector<unsigned>{0, 1, 2}));
+    BOOST_CHECK_EQUAL(from_run_data->NumberOfSamples(), 3);
+    BOOST_CHECK_EQUAL(from_run_data->NumberOfConcentrations(1), Gas::end - 1);
+    BOOST_CHECK_EQUAL(from_run_data->NumberOfConcentrations(), 3 * Gas::end - 1);
+
+    LevenbergMarquardtFitter run_data_fitter(from_run_data);
+    LevenbergMarquardtFitter map_fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    std::shared_ptr<FitResults> run_data_results = run_data_fitter.fit(pconf);
+    std::shared_ptr<FitResults> map_results = map_fitter.fit(pconf);
+
+    BOOST_CHECK_EQUAL(run_data_results->chi_square, map_results->chi_square);
+    BOOST_CHECK(run_data_results->best_estimate == map_results->best_estimate);
+    BOOST_CHECK(run_data_results->residuals == map_results->residuals);
+    BOOST_CHECK(run_data_results->residual_gases == map_results->residual_gases);
+    BOOST_REQUIRE_EQUAL(run_data_results->measured_concentrations.size(), 3);
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        BOOST_CHECK_EQUAL(run_data_results->measured_concentrations[i].size(),
+                          setup.concentrations[i].size());
+        for (const auto& concentration : setup.concentrations[i])
+        {
+            const Data& measured =
+                    run_data_results->measured_concentrations[i].at(concentration.first);
+            BOOST_CHECK_EQUAL(measured.value, concentration.second.value);
+            BOOST_CHECK_EQUAL(measured.error, concentration.second.error);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FitFunctionFromRunData_SampleIndexTooHigh_Throws)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    RunData data;
+    data.Add(std::make_pair(std::string("a"), setup.concentrations[0]));
+
+    BOOST_CHECK_THROW(NobleFitFunction(setup.model, setup.GetParameterMap(), data,
+                                       std::vector<unsigned>{1}),
+                      std::out_of_range);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "core/fitting/levenbergmarquardtfitter.h"
+#include "core/fitting/multistartfitter.h"
+#include "core/fitting/noblefitfunction.h"
+
+#include "cefitsetup.h"
+
+BOOST_AUTO_TEST_SUITE(MultiStartFitter_tests)
+
+BOOST_AUTO_TEST_CASE(CreateStartingPoints)
+{
+    FitParameterConfig config;
+    config.AddParameter(FitParameter("A", 0.5, 0., 1.));
+    config.AddParameter(FitParameter("B", 7.));
+    config.AddParameter(FitParameter("C", 3., -10., 10.));
+
+    const unsigned n_starts = 9;
+    std::vector<Eigen::VectorXd> points =
+            MultiStartFitter::CreateStartingPoints(config, n_starts, 42);
+
+    BOOST_REQUIRE_EQUAL(points.size(), n_starts);
+    BOOST_CHECK(points[0] == config.initials());
+
+    std::vector<unsigned> strata_A;
+    std::vector<unsigned> strata_C;
+    for (unsigned k = 1; k < n_starts; ++k)
+    {
+        BOOST_CHECK_EQUAL(points[k][1], 7.);
+        BOOST_CHECK(points[k][0] >= 0. && points[k][0] <= 1.);
+        BOOST_CHECK(points[k][2] >= -10. && points[k][2] <= 10.);
+        strata_A.push_back(static_cast<unsigned>(points[k][0] * (n_starts - 1)));
+        strata_C.push_back(static_cast<unsigned>((points[k][2] + 10.) / 20. * (n_starts - 1)));
+    }
+
+    // Latin Hypercube: jedes Intervall wird in jeder Dimension genau einmal getroffen.
+    std::sort(strata_A.begin(), strata_A.end());
+    std::sort(strata_C.begin(), strata_C.end());
+    for (unsigned k = 0; k < n_starts - 1; ++k)
+    {
+        BOOST_CHECK_EQUAL(strata_A[k], k);
+        BOOST_CHECK_EQUAL(strata_C[k], k);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FindsGlobalMinimum)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    setup.fit_parameter_config.ChangeParameterBounds("A", 0., 0.05);
+    setup.fit_parameter_config.ChangeParameterBounds("F", 0., 1.);
+    setup.fit_parameter_config.ChangeParameterBounds("T", 0., 30.);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    MultiStartSettings settings;
+    settings.n_starts = 16;
+    settings.n_threads = 4;
+    MultiStartFitter fitter(std::make_shared<LevenbergMarquardtFitter>(
+            std::make_shared<NobleFitFunction>(
+                setup.model, setup.GetParameterMap(), setup.concentrations)),
+                            settings);
+
+    MultiStartResults results = fitter.fit(pconf);
+
+    BOOST_REQUIRE(results.best);
+    BOOST_CHECK_EQUAL(results.n_completed + results.n_pruned + results.n_skipped, 16);
+    BOOST_CHECK_EQUAL(results.n_skipped, 0);
+    BOOST_CHECK_SMALL(results.best->chi_square, 1e-10);
+    BOOST_CHECK_CLOSE(results.best->best_estimate[0], 0.012, 1e-4);
+    BOOST_CHECK_CLOSE(results.best->best_estimate[1], 0.4  , 1e-4);
+    BOOST_CHECK_CLOSE(results.best->best_estimate[2], 12.  , 1e-4);
+
+    BOOST_REQUIRE(!results.local_minima.empty());
+    BOOST_CHECK_SMALL(results.local_minima.front()->chi_square, 1e-10);
+    for (unsigned i = 1; i < results.local_minima.size(); ++i)
+        BOOST_CHECK(results.local_minima[i - 1]->chi_square <=
+                    results.local_minima[i]->chi_square);
+}
+
+BOOST_AUTO_TEST_CASE(TimeBudget)
+{
+    CeFitSetup setup;
+    setup.fit_parameter_config.ChangeParameterBounds("T", 0., 30.);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    MultiStartSettings settings;
+    settings.n_starts = 1000;
+    settings.n_threads = 1;
+    settings.time_budget = 1e-9;
+    MultiStartFitter fitter(std::make_shared<LevenbergMarquardtFitter>(
+            std::make_shared<NobleFitFunction>(
+                setup.model, setup.GetParameterMap(), setup.concentrations)),
+                            settings);
+
+    MultiStartResults results = fitter.fit(pconf);
+
+    BOOST_CHECK_EQUAL(results.n_completed + results.n_pruned + results.n_skipped, 1000);
+    BOOST_CHECK(results.n_skipped > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
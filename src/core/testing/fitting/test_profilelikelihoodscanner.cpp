@@ -0,0 +1,164 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "core/fitting/levenbergmarquardtfitter.h"
+#include "core/fitting/noblefitfunction.h"
+#include "core/fitting/profilelikelihoodscanner.h"
+
+#include "cefitsetup.h"
+
+BOOST_AUTO_TEST_SUITE(ProfileLikelihoodScanner_tests)
+
+BOOST_AUTO_TEST_CASE(FindBounds)
+{
+    ParameterProfile profile;
+    profile.values = {-2., -1., 0., 1., 2., 3.};
+    profile.chi_squares = {4., 1., 0., 0.5, std::numeric_limits<double>::quiet_NaN(), 1.5};
+
+    ProfileLikelihoodScanner::FindBounds(profile, 1.);
+
+    BOOST_CHECK_EQUAL(profile.chi_square_min, 0.);
+    BOOST_CHECK_CLOSE(profile.lower_bound, -1., 1e-10);
+    // Der NaN-Punkt wird übersprungen, interpoliert wird zwischen 1 und 3.
+    BOOST_CHECK_CLOSE(profile.upper_bound, 2., 1e-10);
+
+    profile.chi_squares = {4., 1., 0., 0.1, 0.2, 0.3};
+    ProfileLikelihoodScanner::FindBounds(profile, 1.);
+    BOOST_CHECK(std::isnan(profile.upper_bound));
+}
+
+BOOST_AUTO_TEST_CASE(AgreesWithCovariance)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    ProfileLikelihoodProblem problem;
+    problem.fitter = std::make_shared<LevenbergMarquardtFitter>(
+            std::make_shared<NobleFitFunction>(
+                setup.model, setup.GetParameterMap(), setup.concentrations));
+    problem.pconf = pconf;
+
+    std::shared_ptr<FitResults> best = problem.fitter->fit(pconf);
+
+    ProfileLikelihoodSettings settings;
+    settings.n_steps = 10;
+    settings.range = 2.;
+    settings.n_threads = 4;
+    ProfileLikelihoodScanner scanner(settings);
+
+    std::vector<std::vector<ParameterProfile>> profiles =
+            scanner.Scan(std::vector<ProfileLikelihoodProblem>(2, problem));
+
+    BOOST_REQUIRE_EQUAL(profiles.size(), 2);
+    for (const auto& problem_profiles : profiles)
+    {
+        BOOST_REQUIRE_EQUAL(problem_profiles.size(), 3);
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            const ParameterProfile& profile = problem_profiles[k];
+            BOOST_CHECK_EQUAL(profile.parameter_name, pconf->names()[k]);
+            BOOST_CHECK_EQUAL(profile.values.size(), 2 * settings.n_steps + 1);
+            BOOST_CHECK_CLOSE(profile.best_estimate, best->best_estimate[k], 1e-6);
+            BOOST_CHECK_SMALL(profile.chi_square_min, 1e-10);
+
+            // Die Intervalle dürfen asymmetrisch sein (F ist es deutlich), ihre halbe Breite
+            // entspricht bei kleinen Fehlern aber der Standardabweichung.
+            BOOST_CHECK(profile.lower_bound < profile.best_estimate);
+            BOOST_CHECK(profile.upper_bound > profile.best_estimate);
+            BOOST_CHECK_CLOSE(0.5 * (profile.upper_bound - profile.lower_bound),
+                              best->deviations[k], 10.);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(StopsAtParameterBounds)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    setup.fit_parameter_config.ChangeParameterBounds("F", 0.4, 1.);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    ProfileLikelihoodProblem problem;
+    problem.fitter = std::make_shared<LevenbergMarquardtFitter>(
+            std::make_shared<NobleFitFunction>(
+                setup.model, setup.GetParameterMap(), setup.concentrations));
+    problem.pconf = pconf;
+
+    ProfileLikelihoodSettings settings;
+    settings.n_steps = 5;
+    ProfileLikelihoodScanner scanner(settings);
+
+    std::vector<std::vector<ParameterProfile>> profiles =
+            scanner.Scan(std::vector<ProfileLikelihoodProblem>(1, problem));
+
+    const ParameterProfile& profile = profiles[0][1];
+    BOOST_REQUIRE(!profile.values.empty());
+    BOOST_CHECK(profile.values.front() >= 0.4 - 1e-8);
+    BOOST_CHECK(std::isnan(profile.lower_bound) ||
+                profile.lower_bound >= profile.values.front());
+    BOOST_CHECK(std::isfinite(profile.upper_bound));
+}
+
+BOOST_AUTO_TEST_CASE(SingleParameter_EvaluatesChiSquareAtFixedValues)
+{
+    CeFitSetup setup(0.012, 0.4, 12.);
+    setup.fit_parameter_config = FitParameterConfig();
+    setup.fit_parameter_config.AddParameter(FitParameter("T", 5.));
+    setup.model_parameter_configs[0][0] = ModelParameterConfig("A", 0.012);
+    setup.model_parameter_configs[0][1] = ModelParameterConfig("F", 0.4);
+    std::shared_ptr<const FitParameterConfig> pconf(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    ProfileLikelihoodProblem problem;
+    problem.fitter = std::make_shared<LevenbergMarquardtFitter>(
+            std::make_shared<NobleFitFunction>(
+                setup.model, setup.GetParameterMap(), setup.concentrations));
+    problem.pconf = pconf;
+
+    std::shared_ptr<FitResults> best = problem.fitter->fit(pconf);
+
+    ProfileLikelihoodSettings settings;
+    settings.n_steps = 10;
+    settings.range = 2.;
+    ProfileLikelihoodScanner scanner(settings);
+
+    std::vector<std::vector<ParameterProfile>> profiles =
+            scanner.Scan(std::vector<ProfileLikelihoodProblem>(1, problem));
+
+    BOOST_REQUIRE_EQUAL(profiles.size(), 1);
+    BOOST_REQUIRE_EQUAL(profiles[0].size(), 1);
+    const ParameterProfile& profile = profiles[0][0];
+    BOOST_CHECK_EQUAL(profile.values.size(), 2 * settings.n_steps + 1);
+    for (double chi_square : profile.chi_squares)
+        BOOST_CHECK(std::isfinite(chi_square));
+    BOOST_CHECK(profile.lower_bound < profile.best_estimate);
+    BOOST_CHECK(profile.upper_bound > profile.best_estimate);
+    BOOST_CHECK_CLOSE(0.5 * (profile.upper_bound - profile.lower_bound),
+                      best->deviations[0], 10.);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "core/misc/rankselectbitvector.h"
+
+BOOST_AUTO_TEST_SUITE(RankSelectBitVector_tests)
+
+BOOST_AUTO_TEST_CASE(RankAndSelect_PatternOverSeveralWords_MatchLinearScan)
+{
+    const unsigned n = 1000;
+    RankSelectBitVector bits;
+    std::vector<bool> expected;
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const bool value = (i % 3 == 0) || (i > 300 && i < 500);
+        bits.push_back(value);
+        expected.push_back(value);
+    }
+    for (unsigned i = 700; i < 900; ++i)
+    {
+        bits.Set(i, false);
+        expected[i] = false;
+    }
+
+    std::vector<unsigned> positions;
+    for (unsigned i = 0; i < n; ++i)
+    {
+        BOOST_REQUIRE_EQUAL(bits[i], expected[i]);
+        BOOST_REQUIRE_EQUAL(bits.Rank(i), positions.size());
+        if (expected[i])
+            positions.push_back(i);
+    }
+    BOOST_CHECK_EQUAL(bits.Count(), positions.size());
+    for (unsigned k = 0; k < positions.size(); ++k)
+        BOOST_REQUIRE_EQUAL(bits.Select(k), positions[k]);
+    BOOST_CHECK_THROW(bits.Select(positions.size()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(Fill_SizeNotMultipleOfWordSize_CountsOnlyUsedBits)
+{
+    RankSelectBitVector bits(70, true);
+    BOOST_CHECK_EQUAL(bits.Count(), 70u);
+    BOOST_CHECK_EQUAL(bits.Select(69), 69u);
+
+    bits.Fill(false);
+    BOOST_CHECK_EQUAL(bits.Count(), 0u);
+    bits.Set(65, true);
+    BOOST_CHECK_EQUAL(bits.Select(0), 65u);
+    BOOST_CHECK_EQUAL(bits.Rank(66), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
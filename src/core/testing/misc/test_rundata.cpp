@@ -71,4 +71,27 @@ BOOST_AUTO_TEST_CASE(ConcentrationsIterators_DisableSomeSamplesAndReenableOne_It
     BOOST_CHECK(++it == rundata.concentrations_end());
 }
 
+BOOST_AUTO_TEST_CASE(GetIndexOfEnabledSample_DisableSomeSamples_SkipsDisabledOnes)
+{
+    rundata.DisableSample(0);
+    rundata.DisableSample(2);
+    BOOST_CHECK_EQUAL(rundata.EnabledSize(), 2u);
+    BOOST_CHECK_EQUAL(rundata.GetIndexOfEnabledSample(0), 1u);
+    BOOST_CHECK_EQUAL(rundata.GetIndexOfEnabledSample(1), 3u);
+    BOOST_CHECK_THROW(rundata.GetIndexOfEnabledSample(2), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(Columns_SampleWithoutGas_ReportsMissingGas)
+{
+    rundata.Add(std::make_pair("E", SampleConcentrations({{Gas::NE, Data(4, 0.4)}})));
+    BOOST_CHECK(!rundata.HasGas(4, Gas::HE));
+    BOOST_CHECK(rundata.HasGas(4, Gas::NE));
+    BOOST_CHECK_CLOSE(rundata.GetValues(Gas::NE)[4], 4, 1e-10);
+    BOOST_CHECK_CLOSE(rundata.GetErrors(Gas::NE)[4], 0.4, 1e-10);
+    BOOST_CHECK_CLOSE(rundata.GetValues(Gas::HE)[3], 3, 1e-10);
+
+    rundata.RemoveGas(Gas::NE);
+    BOOST_CHECK(rundata.GetSampleConcentrations(4).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -18,6 +18,7 @@
 
 #include <QDoubleValidator>
 #include <QFormLayout>
+#include <QLabel>
 #include <QStyledItemDelegate>
 
 #include <algorithm>
@@ -42,6 +43,7 @@ Chi2Explorer::Chi2Explorer(ContourPlotData* fitter,
     plot_data_(fitter),
     editor_factory_(new DoubleEditorFactory()),
     validator_(new QDoubleValidator(this)),
+    details_label_(new QLabel(this)),
     parameter_config_model_(nullptr),
     slider_map_()
 {
@@ -54,6 +56,7 @@ Chi2Explorer::Chi2Explorer(ContourPlotData* fitter,
     MainWindow::theMainWindow->AddWindowToOpenWindowsVector(this);
     ui->setupUi(this);
     statusBar()->showMessage("");
+    statusBar()->addPermanentWidget(details_label_);
     ui->plot->SetRasterData(plot_data_);
     dynamic_cast<QStyledItemDelegate*>(
             ui->parameter_config_tableview->itemDelegate())->
@@ -73,8 +76,14 @@ Chi2Explorer::Chi2Explorer(ContourPlotData* fitter,
     connect(ui->update_plot_button, SIGNAL(pressed()), this, SLOT(RunFit()));
     connect(ui->autoupdate_plot_checkbox, SIGNAL(toggled(bool)),
             plot_data_, SLOT(SetAutoUpdatePlot(bool)));
+    connect(ui->adaptive_refinement_checkbox, SIGNAL(toggled(bool)),
+            plot_data_, SLOT(SetAdaptiveRefinement(bool)));
+    connect(ui->bilinear_interpolation_checkbox, SIGNAL(toggled(bool)),
+            plot_data_, SLOT(SetBilinearInterpolation(bool)));
     connect(ui->plot, SIGNAL(CursorPositionChanged(bool,QPointF)),
             this, SLOT(UpdateStatusBar(bool,QPointF)));
+    connect(ui->plot, SIGNAL(PointSelected(QPointF)),
+            this, SLOT(ShowDetailsForPoint(QPointF)));
     connect(ui->chi2_scale_autoupdate_checkbox, SIGNAL(toggled(bool)),
             plot_data_, SLOT(SetAutoUpdateChi2Interval(bool)));
     connect(ui->chi2_scale_minimum_lineedit, SIGNAL(textChanged(QString)),
@@ -161,6 +170,12 @@ void Chi2Explorer::UpdateStatusBar(bool cursor_over_plot,
     statusBar()->showMessage(message);
 }
 
+void Chi2Explorer::ShowDetailsForPoint(QPointF coordinates)
+{
+    details_label_->setText(plot_data_->GetDetailsForPoint(coordinates.x(),
+                                                           coordinates.y()));
+}
+
 void Chi2Explorer::UpdateChi2Interval()
 {
     const double min = ui->chi2_scale_minimum_lineedit->text().toDouble();
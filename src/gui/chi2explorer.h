@@ -31,6 +31,7 @@ class Chi2ParameterConfigModel;
 class ContourPlotData;
 class DoubleEditorFactory;
 class QDoubleValidator;
+class QLabel;
 
 class Chi2Explorer : public QMainWindow
 {
@@ -46,6 +47,8 @@ private slots:
     void RunFit();
     void UpdateStatusBar(bool cursor_over_plot,
                          QPointF cursor_coordinates);
+    //! Zeigt das vollständige, neu berechnete Ergebnis des Punkts an.
+    void ShowDetailsForPoint(QPointF coordinates);
     void UpdateChi2Interval();
     void UpdateChi2IntervalLineEdits();
     void UpdateParameterSliders();
@@ -61,6 +64,9 @@ private:
     ContourPlotData* plot_data_;
     DoubleEditorFactory* editor_factory_;
     QDoubleValidator* validator_;
+    //! \brief Ergebnis des zuletzt ausgewählten Punkts. Bleibt anders als die
+    //! Meldungen der Statusleiste beim Bewegen der Maus stehen.
+    QLabel* details_label_;
     Chi2ParameterConfigModel* parameter_config_model_;
     std::map<int, Chi2ParameterSlider*> slider_map_;
 };
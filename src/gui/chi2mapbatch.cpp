@@ -0,0 +1,297 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "core/fitting/chi2mapgenerator.h"
+
+#include "fitsetup.h"
+#include "parametersetupmodel.h"
+#include "resultsfilereader.h"
+
+#include "chi2mapbatch.h"
+
+namespace
+{
+const char BATCH_OPTION[] = "chi2-maps";
+
+bool ParseRange(const QString& text, double& min, double& max)
+{
+    const QStringList parts = text.split(':');
+    if (parts.size() != 2)
+        return false;
+    bool min_ok, max_ok;
+    min = parts[0].toDouble(&min_ok);
+    max = parts[1].toDouble(&max_ok);
+    return min_ok && max_ok && min < max;
+}
+
+bool ParseRaster(const QString& text, int& width, int& height)
+{
+    const QStringList parts = text.split('x');
+    if (parts.size() != 2)
+        return false;
+    bool width_ok, height_ok;
+    width = parts[0].toInt(&width_ok);
+    height = parts[1].toInt(&height_ok);
+    return width_ok && height_ok && width >= 2 && height >= 2;
+}
+
+bool ParseLevels(const QString& text, std::vector<double>& levels)
+{
+    levels.clear();
+    for (const QString& part : text.split(',', QString::SkipEmptyParts))
+    {
+        bool ok;
+        levels.push_back(part.toDouble(&ok));
+        if (!ok || levels.back() <= 0.)
+            return false;
+    }
+    return true;
+}
+
+//! Probennamen dürfen beliebige Zeichen enthalten, Dateinamen nicht.
+QString CreateBaseName(const Chi2Map& map)
+{
+    QString name = QString::fromStdString(map.sample_name);
+    for (QChar& c : name)
+        if (!c.isLetterOrNumber() && c != '-' && c != '.')
+            c = '_';
+    return QString("%1_%2").arg(map.index + 1, 3, 10, QChar('0')).arg(name);
+}
+
+bool WriteMap(const Chi2Map& map, const QString& filename)
+{
+    std::ofstream ofs(filename.toStdString());
+    ofs << std::setprecision(std::numeric_limits<double>::digits10);
+    ofs << "# " << map.sample_name << "\n# x y chi2\n";
+    for (int i = 0; i < map.chi2_values.rows(); ++i)
+    {
+        for (int j = 0; j < map.chi2_values.cols(); ++j)
+            ofs << map.GetX(i) << ' ' << map.GetY(j) << ' '
+                << map.chi2_values(i, j) << '\n';
+        ofs << '\n';
+    }
+    return bool(ofs);
+}
+
+bool WriteContours(const Chi2Map& map,
+                   const std::vector<double>& levels,
+                   const QString& filename)
+{
+    const std::vector<ContourLine> lines = Chi2MapGenerator::FindContours(map, levels);
+
+    std::ofstream ofs(filename.toStdString());
+    ofs << std::setprecision(std::numeric_limits<double>::digits10);
+    ofs << "# " << map.sample_name << "\n# x y\n";
+    for (double level : levels)
+    {
+        ofs << "\n\n# delta_chi2 = " << level << '\n';
+        for (const ContourLine& line : lines)
+        {
+            if (line.delta_chi_square != level)
+                continue;
+            for (const auto& point : line.points)
+                ofs << point.first << ' ' << point.second << '\n';
+            ofs << '\n';
+        }
+    }
+    return bool(ofs);
+}
+}
+
+bool Chi2MapBatch::IsRequested(int argc, char* argv[])
+{
+    const std::string option = std::string("--") + BATCH_OPTION;
+    for (int i = 1; i < argc; ++i)
+        if (argv[i] == option || std::strncmp(argv[i], (option + "=").c_str(),
+                                              option.size() + 1) == 0)
+            return true;
+    return false;
+}
+
+int Chi2MapBatch::Run(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+            "Writes the chi-square maps of all samples in a results file.");
+    const QCommandLineOption help_option = parser.addHelpOption();
+    const QCommandLineOption file_option(
+            BATCH_OPTION, "Results file to read.", "file");
+    const QCommandLineOption x_parameter_option(
+            "x-parameter", "Parameter on the x axis.", "name");
+    const QCommandLineOption y_parameter_option(
+            "y-parameter", "Parameter on the y axis.", "name");
+    const QCommandLineOption x_range_option(
+            "x-range", "Range of the x axis, max itself is not sampled.", "min:max");
+    const QCommandLineOption y_range_option(
+            "y-range", "Range of the y axis, max itself is not sampled.", "min:max");
+    const QCommandLineOption raster_option(
+            "raster", "Number of points per axis.", "WxH", "64x64");
+    const QCommandLineOption levels_option(
+            "levels", "Contour levels as delta chi-square above the minimum.",
+            "list", "2.30,6.18,11.8");
+    const QCommandLineOption output_option(
+            "output", "Output directory.", "directory", ".");
+    const QCommandLineOption threads_option(
+            "threads", "Number of threads, 0 uses all cores.", "n", "0");
+    for (const QCommandLineOption& option : {file_option,
+                                             x_parameter_option,
+                                             y_parameter_option,
+                                             x_range_option,
+                                             y_range_option,
+                                             raster_option,
+                                             levels_option,
+                                             output_option,
+                                             threads_option})
+        parser.addOption(option);
+
+    if (!parser.parse(arguments))
+    {
+        std::cerr << parser.errorText().toStdString() << std::endl;
+        return 1;
+    }
+    if (parser.isSet(help_option))
+    {
+        std::cout << parser.helpText().toStdString();
+        return 0;
+    }
+    for (const QCommandLineOption& option : {x_parameter_option,
+                                             y_parameter_option,
+                                             x_range_option,
+                                             y_range_option})
+        if (!parser.isSet(option))
+        {
+            std::cerr << "Missing option --"
+                      << option.names().front().toStdString() << std::endl;
+            return 1;
+        }
+
+    Chi2MapSettings settings;
+    std::vector<double> levels;
+    bool threads_ok;
+    settings.n_threads = parser.value(threads_option).toUInt(&threads_ok);
+    if (!ParseRange(parser.value(x_range_option), settings.x_min, settings.x_max) ||
+        !ParseRange(parser.value(y_range_option), settings.y_min, settings.y_max) ||
+        !ParseRaster(parser.value(raster_option), settings.width, settings.height) ||
+        !ParseLevels(parser.value(levels_option), levels) ||
+        !threads_ok)
+    {
+        std::cerr << "Invalid range, raster, levels or number of threads." << std::endl;
+        return 1;
+    }
+
+    ResultsFileReader reader;
+    if (!reader.Read(parser.value(file_option)))
+    {
+        std::cerr << "Error opening file:"
+                  << reader.GetErrorMessage().toStdString() << std::endl;
+        return 1;
+    }
+    std::unique_ptr<FitSetup> fit_setup(reader.TakeFitSetup());
+    if (!fit_setup || !fit_setup->HasModel())
+    {
+        std::cerr << "The results file contains no fit setup." << std::endl;
+        return 1;
+    }
+
+    RunData concentrations(fit_setup->PrepareGasConcentrations());
+    std::vector<FitConfiguration> configurations;
+    try
+    {
+        configurations = fit_setup->PrepareFitConfigurations();
+    }
+    catch (ParameterSetupModel::ParameterNotInHeaderError err)
+    {
+        std::cerr << "Parameter " << err.parameter_name.toStdString()
+                  << " is setup to have individual values but could not be "
+                     "found in the table." << std::endl;
+        return 1;
+    }
+    if (configurations.empty())
+    {
+        std::cerr << "Error: sample list is empty" << std::endl;
+        return 1;
+    }
+
+    const std::vector<std::string> names =
+            configurations[0].fit_parameter_config.names();
+    auto find_parameter = [&](const QCommandLineOption& option) -> int
+    {
+        const std::string name = parser.value(option).toStdString();
+        for (unsigned i = 0; i < names.size(); ++i)
+            if (names[i] == name)
+                return i;
+        std::cerr << "Parameter " << name << " is not fitted. Fitted parameters:";
+        for (const auto& fitted : names)
+            std::cerr << ' ' << fitted;
+        std::cerr << std::endl;
+        return -1;
+    };
+    settings.x_parameter = find_parameter(x_parameter_option);
+    settings.y_parameter = find_parameter(y_parameter_option);
+    if (settings.x_parameter < 0 || settings.y_parameter < 0)
+        return 1;
+
+    const QDir output(parser.value(output_option));
+    if (!output.exists() && !output.mkpath("."))
+    {
+        std::cerr << "Could not create " << output.path().toStdString() << std::endl;
+        return 1;
+    }
+
+    bool write_error = false;
+    try
+    {
+        Chi2MapGenerator generator(settings);
+        generator.Generate(
+                concentrations,
+                configurations,
+                [&](const Chi2Map& map)
+                {
+                    const QString base_name = output.filePath(CreateBaseName(map));
+                    if (!WriteMap(map, base_name + ".chi2.dat") ||
+                        !WriteContours(map, levels, base_name + ".contours.dat"))
+                    {
+                        std::cerr << "Error writing " << base_name.toStdString()
+                                  << std::endl;
+                        write_error = true;
+                        return;
+                    }
+                    std::cout << "Wrote " << base_name.toStdString() << std::endl;
+                });
+    }
+    catch (std::invalid_argument& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return write_error ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CHI2MAPBATCH_H
+#define CHI2MAPBATCH_H
+
+#include <QStringList>
+
+//! Schreibt die χ²-Karten aller Proben einer Ergebnisdatei ohne Benutzeroberfläche.
+/*!
+ * Aufruf etwa
+ *
+ *     panga --chi2-maps results.panga --x-parameter A --y-parameter F
+ *           --x-range 0.005:0.02 --y-range 0.2:0.6 --raster 128x128
+ *           --levels 2.30,6.18,11.8 --output maps
+ *
+ * Je Probe entstehen im Ausgabeverzeichnis zwei Textdateien, benannt nach
+ * laufender Nummer und Probenname:
+ * - NNN_name.chi2.dat mit Zeilen "x y χ²", nach jedem x-Wert eine Leerzeile.
+ * - NNN_name.contours.dat mit den Höhenlinien als Zeilen "x y". Linien
+ *   sind durch eine, Höhen durch zwei Leerzeilen getrennt.
+ *
+ * Beide lassen sich direkt mit gnuplot darstellen. Die Karten werden mit
+ * Chi2MapGenerator berechnet.
+ */
+class Chi2MapBatch
+{
+public:
+    //! Gibt an, ob die Kommandozeile den Batch-Modus verlangt.
+    static bool IsRequested(int argc, char* argv[]);
+
+    //! Wertet die Kommandozeile aus, berechnet und schreibt die Karten.
+    /*!
+     * Fehler werden auf der Standardfehlerausgabe gemeldet.
+     * \return Rückgabewert des Programms.
+     */
+    static int Run(const QStringList& arguments);
+};
+
+#endif // CHI2MAPBATCH_H
@@ -0,0 +1,162 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "chi2mapcache.h"
+
+namespace
+{
+//! Für den Vergleich der Rastergrößen verschiedener Ansichten.
+const double RELATIVE_TOLERANCE = 1e-9;
+}
+
+bool Chi2MapCache::Key::operator==(const Key& other) const
+{
+    return sample == other.sample &&
+           x_parameter == other.x_parameter &&
+           y_parameter == other.y_parameter &&
+           fixed_parameters == other.fixed_parameters;
+}
+
+Chi2MapCache::Chi2MapCache(unsigned max_layers) :
+    max_layers_(max_layers),
+    layers_(),
+    mutex_()
+{
+}
+
+void Chi2MapCache::Store(const Key& key, const Layer& layer)
+{
+    if (!layer.results.AnyResults())
+        return;
+
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    layers_.remove_if([&](const std::pair<Key, Layer>& stored)
+                      {
+                          return stored.first == key &&
+                                 stored.second.rect == layer.rect &&
+                                 stored.second.raster == layer.raster;
+                      });
+    layers_.push_front(std::make_pair(key, layer));
+    while (layers_.size() > max_layers_)
+        layers_.pop_back();
+}
+
+unsigned Chi2MapCache::Lookup(const Key& key,
+                              const QRectF& rect,
+                              const QSize& raster,
+                              Eigen::MatrixXd& chi2_values,
+                              ResultsGrid& results,
+                              Eigen::MatrixXd& preview,
+                              ResultsGrid& preview_results)
+{
+    const int width = raster.width();
+    const int height = raster.height();
+    const double cell_width = rect.width() / width;
+    const double cell_height = rect.height() / height;
+
+    preview.setConstant(width, height, std::numeric_limits<double>::quiet_NaN());
+    preview_results.Reset(width, height, results.n_parameters());
+
+    boost::lock_guard<boost::mutex> lock(mutex_);
+
+    typedef std::list<std::pair<Key, Layer>>::iterator Iterator;
+    std::vector<Iterator> candidates;
+    for (Iterator it = layers_.begin(); it != layers_.end(); ++it)
+        if (it->first == key)
+            candidates.push_back(it);
+
+    // Feinste Ansichten zuerst, sodass die Vorschau möglichst genau ist.
+    auto cell_area = [](const Layer& cached)
+                     {
+                         return cached.rect.width() * cached.rect.height() /
+                                (cached.raster.width() * cached.raster.height());
+                     };
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&](Iterator a, Iterator b)
+                     {
+                         return cell_area(a->second) < cell_area(b->second);
+                     });
+
+    std::vector<bool> used(candidates.size(), false);
+    unsigned n_covered = 0;
+    for (int i = 0; i < width; ++i)
+        for (int j = 0; j < height; ++j)
+        {
+            const double x = rect.left() + i * cell_width;
+            const double y = rect.top() + j * cell_height;
+            for (unsigned c = 0; c < candidates.size(); ++c)
+            {
+                const Layer& cached = candidates[c]->second;
+                const double cached_width =
+                        cached.rect.width() / cached.raster.width();
+                const double cached_height =
+                        cached.rect.height() / cached.raster.height();
+                const long k = std::lround((x - cached.rect.left()) / cached_width);
+                const long l = std::lround((y - cached.rect.top()) / cached_height);
+                if (k < 0 || k >= cached.raster.width() ||
+                    l < 0 || l >= cached.raster.height())
+                    continue;
+
+                if (!cached.results.HasResults(k, l))
+                    continue;
+
+                const double dx =
+                        std::abs(cached.rect.left() + k * cached_width - x);
+                const double dy =
+                        std::abs(cached.rect.top() + l * cached_height - y);
+                const bool sufficient_resolution =
+                        cached_width <= cell_width * (1. + RELATIVE_TOLERANCE) &&
+                        cached_height <= cell_height * (1. + RELATIVE_TOLERANCE);
+
+                if (sufficient_resolution &&
+                    dx <= cell_width / 2. && dy <= cell_height / 2.)
+                {
+                    chi2_values(i, j) = cached.chi2_values(k, l);
+                    results.CopyResults(i, j, cached.results, k, l);
+                    ++n_covered;
+                    used[c] = true;
+                    break;
+                }
+
+                if (!preview_results.HasResults(i, j) &&
+                    dx <= cached_width && dy <= cached_height)
+                {
+                    preview(i, j) = cached.chi2_values(k, l);
+                    preview_results.CopyResults(i, j, cached.results, k, l);
+                    used[c] = true;
+                }
+            }
+        }
+
+    // Verwendete Ansichten gelten als zuletzt benutzt.
+    for (unsigned c = candidates.size(); c-- > 0; )
+        if (used[c])
+            layers_.splice(layers_.begin(), layers_, candidates[c]);
+
+    return n_covered;
+}
+
+void Chi2MapCache::Clear()
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    layers_.clear();
+}
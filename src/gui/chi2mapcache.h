@@ -0,0 +1,124 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CHI2MAPCACHE_H
+#define CHI2MAPCACHE_H
+
+#include <QRectF>
+#include <QSize>
+
+#include <Eigen/Core>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "contourresultsgrid.h"
+
+//! Zwischenspeicher für bereits berechnete χ²-Karten des Konturplots.
+/*!
+ * Speichert die Ergebnisse früherer Ansichten (Ausschnitt und Raster) je
+ * Probe, Achsenparametern und Werten der festgehaltenen Parameter. Beim
+ * Verschieben, Zoomen oder Ändern der Größe des Plots müssen dann nur die
+ * Punkte neu gefittet werden, für die noch kein Ergebnis in ausreichender
+ * Auflösung vorliegt.
+ */
+class Chi2MapCache
+{
+public:
+    typedef ContourResultsGrid ResultsGrid;
+
+    //! Legt fest, zu welcher Rechnung eine χ²-Karte gehört.
+    struct Key
+    {
+        int sample;
+        int x_parameter;
+        int y_parameter;
+        //! Festgehaltene Parameter außer den Achsenparametern, sortiert.
+        std::vector<std::pair<int, double>> fixed_parameters;
+
+        bool operator==(const Key& other) const;
+    };
+
+    //! Ergebnisse einer Ansicht.
+    /*!
+     * Der Punkt (i, j) liegt bei rect.left() + i * rect.width() / raster.width()
+     * bzw. rect.top() + j * rect.height() / raster.height(). Für nicht
+     * berechnete Punkte liefert results.HasResults falsch.
+     */
+    struct Layer
+    {
+        QRectF rect;
+        QSize raster;
+        Eigen::MatrixXd chi2_values;
+        ResultsGrid results;
+    };
+
+    //! Konstruktor.
+    /*!
+     * \param max_layers Zahl der Ansichten, die höchstens gespeichert werden.
+     *   Die am längsten nicht verwendeten werden zuerst verworfen.
+     */
+    explicit Chi2MapCache(unsigned max_layers = 32);
+
+    //! Speichert die Ergebnisse einer Ansicht.
+    /*!
+     * Ansichten ohne berechnete Punkte werden ignoriert.
+     */
+    void Store(const Key& key, const Layer& layer);
+
+    //! Übernimmt gespeicherte Ergebnisse für eine neue Ansicht.
+    /*!
+     * Ein Punkt gilt als abgedeckt, wenn eine gespeicherte Ansicht mit
+     * mindestens gleicher Auflösung einen berechneten Punkt innerhalb einer
+     * halben Rasterzelle enthält. Für alle anderen Punkte wird, soweit
+     * vorhanden, der nächstgelegene Punkt gröberer Ansichten als Vorschau
+     * eingetragen.
+     * \param chi2_values, results Die abgedeckten Punkte werden hier
+     *   eingetragen, die übrigen bleiben unverändert. Die Größen müssen
+     *   bereits zum Raster passen.
+     * \param preview Muss nach dem Aufruf die Vorschau enthalten (NaN, wo
+     *   keine vorliegt). Wird an die Größe des Rasters angepasst.
+     * \param preview_results Ergebnisse zu den Vorschauwerten. Wird an die
+     *   Größe des Rasters und die Parameterzahl von \a results angepasst.
+     * \return Zahl der abgedeckten Punkte.
+     */
+    unsigned Lookup(const Key& key,
+                    const QRectF& rect,
+                    const QSize& raster,
+                    Eigen::MatrixXd& chi2_values,
+                    ResultsGrid& results,
+                    Eigen::MatrixXd& preview,
+                    ResultsGrid& preview_results);
+
+    //! Verwirft alle gespeicherten Ergebnisse.
+    void Clear();
+
+private:
+    const unsigned max_layers_;
+
+    //! Zuletzt verwendete Ansichten zuerst.
+    std::list<std::pair<Key, Layer>> layers_;
+
+    mutable boost::mutex mutex_;
+};
+
+#endif // CHI2MAPCACHE_H
@@ -20,13 +20,14 @@
 #include <QClipboard>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QTextStream>
+#include <QStringList>
 
 #include <algorithm>
 #include <iostream>
 #include <iterator>
 
 #include "commons.h"
+#include "samplesparser.h"
 
 #include "concentrationsmodel.h"
 
@@ -66,21 +67,26 @@ void ConcentrationsModel::LoadSamplesFromFile()
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly))
         return;
-    
-    QString contents(file.readAll());
-    QRegExp rx("\\r(?!\\n)");
-    contents.replace(rx, "\n");
-    QTextStream stream(&contents);
-    LoadSamplesIntoModel(stream);
+
+    // Große Dateien werden nicht kopiert, sondern direkt aus dem Mapping gelesen.
+    if (const uchar* data = file.map(0, file.size()))
+    {
+        const char* begin = reinterpret_cast<const char*>(data);
+        LoadSamplesIntoModel(begin, begin + file.size());
+    }
+    else
+    {
+        QByteArray contents(file.readAll());
+        LoadSamplesIntoModel(contents.constData(),
+                             contents.constData() + contents.size());
+    }
 }
 
 void ConcentrationsModel::LoadSamplesFromClipboard()
 {
-    QString clipboard_text = QApplication::clipboard()->text();
-    QRegExp rx("\\r(?!\\n)");
-    clipboard_text.replace(rx, "\n");
-    QTextStream stream(&clipboard_text);
-    LoadSamplesIntoModel(stream);
+    QByteArray clipboard_text = QApplication::clipboard()->text().toUtf8();
+    LoadSamplesIntoModel(clipboard_text.constData(),
+                         clipboard_text.constData() + clipboard_text.size());
 }
 
 void ConcentrationsModel::EmitSampleState()
@@ -96,36 +102,40 @@ void ConcentrationsModel::EmitSampleState()
     emit SampleStateChanged(check_state);
 }
 
-std::vector<Sample> ConcentrationsModel::ReadSamplesFromStream(
-        QTextStream& stream) const
+void ConcentrationsModel::LoadSamplesIntoModel(const char* begin, const char* end)
 {
-    std::vector<Sample> samples;
-    while (!stream.atEnd())
+    SamplesParser parser;
     {
-        try
-        {
-            auto line = stream.readLine();
-            if (line.isEmpty() || line.at(0) == '#')
-                continue;
-            samples.emplace_back(CreateSampleFromLine(line));
-        }
-        catch (std::invalid_argument)
-        {
-            continue;
-        }
+        GlobalWaitCursor wait_cursor;
+        parser.Parse(begin, end);
     }
-    return samples;
-}
-
-void ConcentrationsModel::LoadSamplesIntoModel(QTextStream& stream)
-{
-    std::vector<Sample> samples(ReadSamplesFromStream(stream));
+    std::vector<Sample>& samples = parser.GetSamples();
+    const auto& malformed_lines = parser.GetMalformedLines();
     if (samples.empty())
     {
-        QMessageBox::warning(nullptr, APPLICATION_NAME,
-                             "Error: Invalid input format.");
+        QString message("Error: Invalid input format.");
+        if (!malformed_lines.empty())
+            message += "\n" + QString::fromStdString(malformed_lines.front().message);
+        QMessageBox::warning(nullptr, APPLICATION_NAME, message);
         return;
     }
+    if (!malformed_lines.empty())
+    {
+        const unsigned MAX_LISTED_LINES = 10;
+        QStringList line_numbers;
+        for (unsigned i = 0;
+             i < malformed_lines.size() && i < MAX_LISTED_LINES;
+             ++i)
+            line_numbers << QString::number(malformed_lines[i].line_number);
+        if (malformed_lines.size() > MAX_LISTED_LINES)
+            line_numbers << "...";
+        QMessageBox::warning(
+                nullptr, APPLICATION_NAME,
+                QString("Warning: %1 malformed line(s) skipped (lines %2).\n")
+                    .arg(malformed_lines.size())
+                    .arg(line_numbers.join(", ")) +
+                QString::fromStdString(malformed_lines.front().message));
+    }
     if (ContainsDuplicateSampleNames(samples)) 
     {
         QMessageBox::critical(nullptr, APPLICATION_NAME,
@@ -137,6 +147,7 @@ void ConcentrationsModel::LoadSamplesIntoModel(QTextStream& stream)
     
     beginResetModel();
     run_data_.clear();
+    run_data_.reserve(samples.size());
     for(auto& sample : samples)
         run_data_.Add(std::move(sample));
     endResetModel();
@@ -148,36 +159,6 @@ void ConcentrationsModel::LoadSamplesIntoModel(QTextStream& stream)
     emit SampleStateChanged(Qt::Checked);
 }
 
-Sample ConcentrationsModel::CreateSampleFromLine(const QString& line) const
-{
-    QStringList strings;
-    if (!((strings = line.split(',' )).size() == 11 ||
-          (strings = line.split('\t')).size() == 11))
-        throw std::invalid_argument("A line must consist of the sample name "
-                                    "and the following concentrations, all "
-                                    "separated by commas or tabs: He, He err, "
-                                    "Ne, Ne err, Ar, Ar err, Kr, Kr err, Xe, "
-                                    "Xe err.");
-    
-    std::string sample_name = strings.takeFirst().toStdString();
-    SampleConcentrations concentrations;
-    
-    for (unsigned i = 0; i < 5; ++i)
-    {
-        bool value_ok = true;
-        bool error_ok = true;
-        double value = strings.takeFirst().toDouble(&value_ok);
-        double error = strings.takeFirst().toDouble(&error_ok);
-        
-        if (!value_ok || !error_ok)
-            continue;
-        
-        concentrations[static_cast<GasType>(i)] = Data(value, error);
-    }
-    
-    return std::make_pair(sample_name, concentrations);
-}
-
 bool ConcentrationsModel::ContainsDuplicateSampleNames(
         const std::vector<Sample>& samples) const
 {
@@ -209,14 +190,11 @@ QVariant ConcentrationsModel::data(const QModelIndex& index, int role) const
     {
         int col = index.column();
         if (!col--) return QVariant();
-        const SampleConcentrations& sample =
-                run_data_.GetSampleConcentrations(index.row());
-        
         GasType gas = static_cast<GasType>(col / 2);
         
-        auto it = sample.find(gas);
-        if (it != sample.end())
-            return col % 2 ? it->second.error : it->second.value;
+        if (run_data_.HasGas(index.row(), gas))
+            return col % 2 ? run_data_.GetErrors(gas)[index.row()]
+                           : run_data_.GetValues(gas)[index.row()];
     }
     if (role == Qt::CheckStateRole && !index.column())
     {
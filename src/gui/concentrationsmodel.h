@@ -26,8 +26,6 @@
 
 #include "core/misc/rundata.h"
 
-class QTextStream;
-
 class ConcentrationsModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -66,9 +64,7 @@ signals:
     
 private:
     void ConnectSignalsAndSlots();
-    std::vector<Sample> ReadSamplesFromStream(QTextStream& stream) const;
-    void LoadSamplesIntoModel(QTextStream& stream);
-    Sample CreateSampleFromLine(const QString& line) const;
+    void LoadSamplesIntoModel(const char* begin, const char* end);
     bool ContainsDuplicateSampleNames(const std::vector<Sample>& samples) const;
     
 private slots:
@@ -22,10 +22,12 @@
 #include <qwt_plot_picker.h>
 #include <qwt_plot_zoomer.h>
 #include <qwt_scale_engine.h>
+#include <qwt_scale_map.h>
 #include <qwt_scale_widget.h>
 
 #include <cassert>
 #include <cmath>
+#include <vector>
 
 #include "colormap.h"
 #include "contourplot.h"
@@ -53,12 +55,71 @@ protected:
     }
 };
 
+class Chi2Spectrogram : public QwtPlotSpectrogram
+{
+public:
+    explicit Chi2Spectrogram(const QString& title) :
+            QwtPlotSpectrogram(title),
+            chi2_data_(nullptr)
+    {
+    }
+
+    void SetChi2Data(ContourPlotData* data)
+    {
+        chi2_data_ = data;
+        setData(data);
+    }
+
+protected:
+    //! Füllt das ganze Bild auf einmal statt Qwt für jedes Pixel value() aufrufen zu lassen.
+    QImage renderImage(const QwtScaleMap& xMap,
+                       const QwtScaleMap& yMap,
+                       const QRectF& area,
+                       const QSize& imageSize) const
+    {
+        const QwtColorMap* color_map = colorMap();
+        if (!chi2_data_ || !color_map || color_map->format() != QwtColorMap::RGB)
+            return QwtPlotSpectrogram::renderImage(xMap, yMap, area, imageSize);
+
+        const QwtInterval interval = chi2_data_->interval(Qt::ZAxis);
+        if (imageSize.isEmpty() || !interval.isValid())
+            return QImage();
+
+        std::vector<double> xs(imageSize.width());
+        std::vector<double> ys(imageSize.height());
+        for (int x = 0; x < imageSize.width(); ++x)
+            xs[x] = xMap.invTransform(x);
+        for (int y = 0; y < imageSize.height(); ++y)
+            ys[y] = yMap.invTransform(y);
+
+        // initRaster legt fest, welcher Plot bis discardRaster verwendet wird.
+        std::vector<double> values(xs.size() * ys.size());
+        chi2_data_->initRaster(area, imageSize);
+        chi2_data_->FillRaster(xs, ys, values.data());
+        chi2_data_->discardRaster();
+
+        QImage image(imageSize, QImage::Format_ARGB32);
+        const double* value = values.data();
+        for (int y = 0; y < imageSize.height(); ++y)
+        {
+            QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for (int x = 0; x < imageSize.width(); ++x)
+                *line++ = color_map->rgb(interval, *value++);
+        }
+        return image;
+    }
+
+private:
+    ContourPlotData* chi2_data_;
+};
+
 ContourPlot::ContourPlot(QWidget* parent) :
     QwtPlot(parent),
-    spectrogram_(new QwtPlotSpectrogram("χ²")),
+    spectrogram_(new Chi2Spectrogram("χ²")),
     colorbar_(nullptr),
     zoomer_(nullptr),
-    picker_(nullptr)
+    picker_(nullptr),
+    point_picker_(nullptr)
 {
     spectrogram_->setDisplayMode(QwtPlotSpectrogram::ContourMode, false);
     spectrogram_->setDisplayMode(QwtPlotSpectrogram::ImageMode  , true );
@@ -88,6 +149,12 @@ ContourPlot::ContourPlot(QWidget* parent) :
     picker_->setRubberBand(QwtPicker::CrossRubberBand);
     picker_->setRubberBandPen(QColor(Qt::darkGray));
 
+    // Umschalt+Linksklick, damit der Zoomer den Klick nicht auch erhält.
+    point_picker_ = new QwtPlotPicker(canvas());
+    point_picker_->setStateMachine(new QwtPickerClickPointMachine());
+    point_picker_->setMousePattern(QwtEventPattern::MouseSelect1,
+                                   Qt::LeftButton, Qt::ShiftModifier);
+
     axisScaleEngine(QwtPlot::xBottom)->setAttribute(QwtScaleEngine::Floating);
     axisScaleEngine(QwtPlot::yLeft  )->setAttribute(QwtScaleEngine::Floating);
     axisScaleEngine(QwtPlot::yRight )->setAttribute(QwtScaleEngine::Floating);
@@ -96,6 +163,8 @@ ContourPlot::ContourPlot(QWidget* parent) :
             this, SLOT(EmitCursorPosition(QPointF)));
     connect(picker_, SIGNAL(activated(bool)),
             this, SLOT(EmitCursorNotOverPlot(bool)));
+    connect(point_picker_, SIGNAL(selected(QPointF)),
+            this, SIGNAL(PointSelected(QPointF)));
 
     replot();
 }
@@ -106,7 +175,7 @@ ContourPlot::~ContourPlot()
 
 void ContourPlot::SetRasterData(ContourPlotData* data)
 {
-    spectrogram_->setData(data);
+    spectrogram_->SetChi2Data(data);
     connect(data, SIGNAL(ReplotNeeded()), this, SLOT(replot()));
     connect(data, SIGNAL(ZIntervalChanged()), this, SLOT(replot()));
     connect(data, SIGNAL(ZIntervalChanged()), this, SLOT(UpdateColorBar()));
@@ -22,6 +22,7 @@
 #include <qwt_plot.h>
 #include <qwt_plot_spectrogram.h>
 
+class Chi2Spectrogram;
 class ContourPlotData;
 class ContourPlotZoomer;
 class QwtPlotPicker;
@@ -43,6 +44,8 @@ public slots:
     
 signals:
     void CursorPositionChanged(bool over_plot, QPointF position);
+    //! Ein Punkt wurde mit Umschalt+Linksklick ausgewählt.
+    void PointSelected(QPointF position);
     
 private slots:
     void UpdateColorBar();
@@ -50,10 +53,11 @@ private slots:
     void EmitCursorPosition(const QPointF& position);
     
 private:
-    QwtPlotSpectrogram* spectrogram_;
+    Chi2Spectrogram* spectrogram_;
     QwtScaleWidget* colorbar_;
     ContourPlotZoomer* zoomer_;
     QwtPlotPicker* picker_;
+    QwtPlotPicker* point_picker_;
 };
 
 #endif // CONTOURPLOT_H
@@ -22,6 +22,7 @@
 #include <cassert>
 #include <cmath>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <utility>
@@ -32,19 +33,77 @@
 
 #include "contourplotdata.h"
 
+namespace
+{
+//! Lage einer Koordinate im Raster eines Plots.
+struct RasterPosition
+{
+    //! Gibt an, ob die Koordinate innerhalb der berechneten Fläche liegt.
+    bool valid;
+    //! Index der Zelle, in der die Koordinate liegt.
+    int nearest;
+    //! Benachbarte Punkte und Gewicht des zweiten für die Interpolation.
+    int first;
+    int second;
+    double weight;
+};
+
+RasterPosition GetRasterPosition(double coordinate,
+                                 double begin,
+                                 double length,
+                                 int n_points,
+                                 bool bilinear)
+{
+    RasterPosition position;
+    const double u = (coordinate - begin) / length * n_points;
+    position.valid = u >= 0. && u <= n_points;
+    position.nearest = std::min(static_cast<int>(u), n_points - 1);
+    position.first = position.second = position.nearest;
+    position.weight = 0.;
+    if (!position.valid || !bilinear)
+        return position;
+
+    // Die Werte gelten für die Mitte ihrer Zellen.
+    const double center = u - 0.5;
+    const int first = static_cast<int>(std::floor(center));
+    position.first = std::max(0, std::min(first, n_points - 1));
+    position.second = std::max(0, std::min(first + 1, n_points - 1));
+    if (position.first != position.second)
+        position.weight = center - first;
+    return position;
+}
+
+double GetValue(const Eigen::MatrixXd& chi2_values,
+                const RasterPosition& x,
+                const RasterPosition& y)
+{
+    if (!x.valid || !y.valid)
+        return std::numeric_limits<double>::quiet_NaN();
+    if (x.weight == 0. && y.weight == 0.)
+        return chi2_values(x.nearest, y.nearest);
+
+    const double v00 = chi2_values(x.first , y.first );
+    const double v10 = chi2_values(x.second, y.first );
+    const double v01 = chi2_values(x.first , y.second);
+    const double v11 = chi2_values(x.second, y.second);
+    // Fehlt ein Nachbar, wird nicht interpoliert.
+    if (!std::isfinite(v00) || !std::isfinite(v10) ||
+        !std::isfinite(v01) || !std::isfinite(v11))
+        return chi2_values(x.nearest, y.nearest);
+    return (1. - y.weight) * ((1. - x.weight) * v00 + x.weight * v10) +
+                  y.weight * ((1. - x.weight) * v01 + x.weight * v11);
+}
+}
+
 ContourPlotData::ContourPlotData() :
     QObject(),
     QwtRasterData(),
     fitter_(this),
     plot_rect_(0., 0., 10., 10.),
     plot_raster_(32, 32),
-    pointers_mutex_(),
-    pointers_valid_(false),
-    data_rect_(nullptr),
-    data_raster_(nullptr),
-    chi2_values_(nullptr),
-    results_(nullptr),
-    fitted_parameter_names_(nullptr),
+    plot_(),
+    render_plot_(),
+    bilinear_interpolation_(false),
     auto_update_chi2_interval_(true),
     current_chi2_interval_(),
     chi2_data_interval_(),
@@ -58,13 +117,13 @@ ContourPlotData::ContourPlotData() :
     setInterval(Qt::ZAxis, QwtInterval(1, 2));
     
     connect(&fitter_, SIGNAL(NewDataAvailable(double, double)),
-            this, SLOT(UpdateResultsPointers()));
+            this, SLOT(UpdatePlot()));
     connect(&fitter_, SIGNAL(NewDataAvailable(double, double)),
             this, SLOT(UpdateDataInterval(double, double)));
     connect(&fitter_, SIGNAL(NewDataAvailable(double,double)),
             this, SLOT(EmitReplotNeeded()));
     connect(&fitter_, SIGNAL(ResultsInvalidated()),
-            this, SLOT(InvalidatePointers()), Qt::DirectConnection);
+            this, SLOT(InvalidatePlot()), Qt::DirectConnection);
 }
 
 ContourPlotData::~ContourPlotData()
@@ -102,32 +161,78 @@ void ContourPlotData::SetFitConfigurations(
 
 QString ContourPlotData::GetInfoForPoint(double x, double y) const
 {
-    boost::lock_guard<boost::mutex> lock(pointers_mutex_);
-    if (!pointers_valid_ || !data_rect_->contains(x, y))
+    std::shared_ptr<const ContourPlotFitter::Plot> plot(std::atomic_load(&plot_));
+    if (!plot || !plot->rect.contains(x, y))
+        return QString();
+    std::pair<int, int> indices = GetIndicesForCoordinates(*plot, x, y);
+    if (!plot->results.HasResults(indices.first, indices.second))
         return QString();
-    std::pair<int, int> indices = GetIndicesForCoordinates(x, y);
-    std::shared_ptr<const FitResults> results(results_->at(indices.first)
-                                                       .at(indices.second));
+    const Eigen::Map<const Eigen::VectorXd> best_estimate(
+            plot->results.GetBestEstimate(indices.first, indices.second));
     
-    assert(fitted_parameter_names_->size() ==
-            unsigned(results->best_estimate.size()));
+    const std::vector<QString>& names = plot->parameter_names;
+    assert(names.size() == unsigned(best_estimate.size()));
     
     QString string;
-    for (unsigned i = 0; i < fitted_parameter_names_->size(); ++i)
-        string += (*fitted_parameter_names_)[i] + "="
-                + QString::number(results->best_estimate[i]) + ", ";
+    for (unsigned i = 0; i < names.size(); ++i)
+        string += names[i] + "="
+                + QString::number(best_estimate[i]) + ", ";
     if (string.size() > 0)
         string.remove(string.size() - 3, 2);
     return string;
 }
 
+QString ContourPlotData::GetDetailsForPoint(double x, double y) const
+{
+    std::shared_ptr<const ContourPlotFitter::Plot> plot(std::atomic_load(&plot_));
+    if (!plot || !plot->rect.contains(x, y))
+        return QString();
+    std::pair<int, int> indices = GetIndicesForCoordinates(*plot, x, y);
+    Eigen::VectorXd start_values;
+    if (plot->results.HasResults(indices.first, indices.second))
+        start_values = plot->results.GetBestEstimate(indices.first, indices.second);
+
+    std::shared_ptr<FitResults> results(
+            ContourPlotFitter::ComputeResults(*plot, x, y, start_values));
+    if (!results)
+        return QString();
+
+    const std::vector<QString>& names = plot->parameter_names;
+    assert(names.size() == unsigned(results->best_estimate.size()));
+
+    QString string = "χ²=" + QString::number(results->chi_square) + " ("
+            + QString::number(results->n_iterations) + " iterations), ";
+    const bool has_deviations =
+            results->deviations.size() == results->best_estimate.size();
+    for (unsigned i = 0; i < names.size(); ++i)
+    {
+        string += names[i] + "=" + QString::number(results->best_estimate[i]);
+        if (has_deviations)
+            string += "±" + QString::number(results->deviations[i]);
+        string += ", ";
+    }
+    string.remove(string.size() - 2, 2);
+    return string;
+}
+
 double ContourPlotData::value(double x, double y) const
 {
-    boost::lock_guard<boost::mutex> lock(pointers_mutex_);
-    if (!pointers_valid_ || !data_rect_->contains(x, y))
+    // Zwischen initRaster und discardRaster ohne Zugriff auf den
+    // Referenzzähler, da Qwt diese Funktion für jedes Pixel aufruft.
+    std::shared_ptr<const ContourPlotFitter::Plot> plot;
+    const ContourPlotFitter::Plot* p = render_plot_.get();
+    if (!p)
+    {
+        plot = std::atomic_load(&plot_);
+        p = plot.get();
+    }
+    if (!p)
         return std::numeric_limits<double>::quiet_NaN();
-    std::pair<int, int> indices = GetIndicesForCoordinates(x, y);
-    return (*chi2_values_)(indices.first, indices.second);
+    return GetValue(p->chi2_values,
+                    GetRasterPosition(x, p->rect.left(), p->rect.width(),
+                                      p->raster.width(), bilinear_interpolation_),
+                    GetRasterPosition(y, p->rect.top(), p->rect.height(),
+                                      p->raster.height(), bilinear_interpolation_));
 }
 
 void ContourPlotData::initRaster(const QRectF& rect, const QSize& raster)
@@ -139,10 +244,54 @@ void ContourPlotData::initRaster(const QRectF& rect, const QSize& raster)
         UpdatePlotIfAutoUpdateEnabled();
         auto_update_with_next_init_raster_ = false;
     }
+    render_plot_ = std::atomic_load(&plot_);
 }
 
 void ContourPlotData::discardRaster()
 {
+    render_plot_.reset();
+}
+
+void ContourPlotData::FillRaster(const std::vector<double>& xs,
+                                 const std::vector<double>& ys,
+                                 double* values) const
+{
+    std::shared_ptr<const ContourPlotFitter::Plot> plot(GetPlot());
+    if (!plot)
+    {
+        std::fill(values, values + xs.size() * ys.size(),
+                  std::numeric_limits<double>::quiet_NaN());
+        return;
+    }
+    FillRaster(*plot, bilinear_interpolation_, xs, ys, values);
+}
+
+void ContourPlotData::FillRaster(const ContourPlotFitter::Plot& plot,
+                                 bool bilinear,
+                                 const std::vector<double>& xs,
+                                 const std::vector<double>& ys,
+                                 double* values)
+{
+    // Die Lage im Raster hängt je Spalte nur von x und je Zeile nur von y ab.
+    std::vector<RasterPosition> columns;
+    columns.reserve(xs.size());
+    for (double x : xs)
+        columns.push_back(GetRasterPosition(x,
+                                            plot.rect.left(),
+                                            plot.rect.width(),
+                                            plot.raster.width(),
+                                            bilinear));
+
+    for (double y : ys)
+    {
+        const RasterPosition row = GetRasterPosition(y,
+                                                     plot.rect.top(),
+                                                     plot.rect.height(),
+                                                     plot.raster.height(),
+                                                     bilinear);
+        for (const RasterPosition& column : columns)
+            *values++ = GetValue(plot.chi2_values, column, row);
+    }
 }
 
 bool ContourPlotData::AutoUpdateChi2Interval() const
@@ -180,6 +329,18 @@ void ContourPlotData::SetAutoUpdatePlot(bool enabled)
     UpdatePlotIfAutoUpdateEnabled();
 }
 
+void ContourPlotData::SetAdaptiveRefinement(bool enabled)
+{
+    fitter_.SetAdaptiveRefinement(enabled);
+    UpdatePlotIfAutoUpdateEnabled();
+}
+
+void ContourPlotData::SetBilinearInterpolation(bool enabled)
+{
+    bilinear_interpolation_ = enabled;
+    emit ReplotNeeded();
+}
+
 void ContourPlotData::SetAutoUpdateChi2Interval(bool enabled)
 {
     auto_update_chi2_interval_ = enabled;
@@ -210,23 +371,9 @@ void ContourPlotData::UpdatePlotIfAutoUpdateEnabled()
     if (auto_update_) Fit();
 }
 
-void ContourPlotData::UpdateResultsPointers()
+void ContourPlotData::UpdatePlot()
 {
-    boost::lock_guard<boost::mutex> lock(pointers_mutex_);
-    fitter_.GetResultsPointers(data_rect_,
-                               data_raster_,
-                               chi2_values_,
-                               results_,
-                               fitted_parameter_names_);
-
-    if (!data_rect_   ||
-        !data_raster_ ||
-        !chi2_values_ ||
-        !results_     ||
-        !fitted_parameter_names_)
-        pointers_valid_ = false;
-    else
-        pointers_valid_ = true;
+    std::atomic_store(&plot_, fitter_.GetPlot());
 }
 
 void ContourPlotData::UpdateDataInterval(
@@ -246,25 +393,24 @@ void ContourPlotData::UpdatePlotChi2IntervalIfAutoUpdateEnabled()
     }
 }
 
-void ContourPlotData::InvalidatePointers()
+void ContourPlotData::InvalidatePlot()
 {
-    boost::lock_guard<boost::mutex> lock(pointers_mutex_);
-    pointers_valid_ = false;
+    std::atomic_store(&plot_, std::shared_ptr<const ContourPlotFitter::Plot>());
 }
 
-std::pair<int, int> ContourPlotData::GetIndicesForCoordinates(double x,
-                                                              double y) const
+std::shared_ptr<const ContourPlotFitter::Plot> ContourPlotData::GetPlot() const
 {
-    int i = (x - data_rect_->left()) /
-            data_rect_->width () * data_raster_->width ();
-    int j = (y - data_rect_->top ()) /
-            data_rect_->height() * data_raster_->height();
-
-    if (i >= data_raster_->width())
-        i = data_raster_->width() - 1;
+    if (render_plot_)
+        return render_plot_;
+    return std::atomic_load(&plot_);
+}
 
-    if (j >= data_raster_->height())
-        j = data_raster_->height() - 1;
-    
-    return std::make_pair(i, j);
+std::pair<int, int> ContourPlotData::GetIndicesForCoordinates(
+        const ContourPlotFitter::Plot& plot, double x, double y)
+{
+    return std::make_pair(
+            GetRasterPosition(x, plot.rect.left(), plot.rect.width(),
+                              plot.raster.width(), false).nearest,
+            GetRasterPosition(y, plot.rect.top(), plot.rect.height(),
+                              plot.raster.height(), false).nearest);
 }
@@ -23,6 +23,9 @@
 
 #include <boost/thread.hpp>
 
+#include <memory>
+#include <vector>
+
 #include "core/fitting/fitconfiguration.h"
 #include "core/fitting/fitresults.h"
 #include "core/misc/rundata.h"
@@ -47,12 +50,41 @@ public:
             const std::vector<FitConfiguration>& fit_configurations);
     
     QString GetInfoForPoint(double x, double y) const;
+
+    //! Fittet den Punkt erneut und beschreibt das vollständige Ergebnis.
+    /*!
+     * Startwerte sind die beste Schätzung der Zelle, in der der Punkt
+     * liegt. Anders als GetInfoForPoint enthält der Text auch χ², die Zahl
+     * der Iterationen und die Fehler der Parameter.
+     * \return Leer, falls für den Punkt kein Plot vorliegt.
+     */
+    QString GetDetailsForPoint(double x, double y) const;
     
     // QwtRasterData-Methoden
     virtual double value(double x, double y) const;
     
     void initRaster(const QRectF& rect, const QSize& raster);
     void discardRaster();
+
+    //! Berechnet die Werte eines ganzen Bildes auf einmal.
+    /*!
+     * Der Plot wird nur einmal geholt, je Pixel fallen weder Sperren noch
+     * virtuelle Aufrufe an.
+     * \param xs x-Koordinaten der Spalten.
+     * \param ys y-Koordinaten der Zeilen.
+     * \param values Ziel mit xs.size() * ys.size() Einträgen, zeilenweise.
+     *   NaN außerhalb der berechneten Fläche.
+     */
+    void FillRaster(const std::vector<double>& xs,
+                    const std::vector<double>& ys,
+                    double* values) const;
+
+    //! Wie FillRaster, aber für einen gegebenen Plot.
+    static void FillRaster(const ContourPlotFitter::Plot& plot,
+                           bool bilinear,
+                           const std::vector<double>& xs,
+                           const std::vector<double>& ys,
+                           double* values);
     bool AutoUpdateChi2Interval() const;
     
 public slots:
@@ -62,6 +94,10 @@ public slots:
     void SetFixedParameters(
             std::vector<std::pair<int, double>> fixed_parameters);
     void SetAutoUpdatePlot(bool enabled);
+    void SetAdaptiveRefinement(bool enabled);
+    //! \brief Legt fest, ob zwischen den berechneten Punkten bilinear
+    //! interpoliert wird. Standardmäßig deaktiviert.
+    void SetBilinearInterpolation(bool enabled);
     void SetAutoUpdateChi2Interval(bool enabled);
     
     //! Setzt eigenes Intervall, aber nur wenn Auto-Update deaktiviert ist.
@@ -77,27 +113,34 @@ signals:
 private slots:
     void EmitReplotNeeded();
     void UpdatePlotIfAutoUpdateEnabled();
-    void UpdateResultsPointers();
+    void UpdatePlot();
     void UpdateDataInterval(double chi2_min, double chi2_max);
     void UpdatePlotChi2IntervalIfAutoUpdateEnabled();
-    void InvalidatePointers();
+    void InvalidatePlot();
 
 private:
     void InterruptFitAndWait();
+
+    //! Gibt den anzuzeigenden Plot zurück, leer falls keiner vorliegt.
+    /*!
+     * Zwischen initRaster und discardRaster stets derselbe, damit ein Bild
+     * nicht aus zwei Stufen zusammengesetzt wird.
+     */
+    std::shared_ptr<const ContourPlotFitter::Plot> GetPlot() const;
     
-    std::pair<int, int> GetIndicesForCoordinates(double x, double y) const;
+    static std::pair<int, int> GetIndicesForCoordinates(
+            const ContourPlotFitter::Plot& plot, double x, double y);
     ContourPlotFitter fitter_;
     
     QRectF plot_rect_;
     QSize plot_raster_;
     
-    mutable boost::mutex pointers_mutex_;
-    bool pointers_valid_;
-    const QRectF* data_rect_;
-    const QSize* data_raster_;
-    const Eigen::MatrixXd* chi2_values_;
-    const std::vector<std::vector<std::shared_ptr<const FitResults>>>* results_;
-    const std::vector<QString>* fitted_parameter_names_;
+    //! \brief Zuletzt veröffentlichter Plot. Wird nur über std::atomic_load
+    //! und std::atomic_store gelesen und ersetzt.
+    std::shared_ptr<const ContourPlotFitter::Plot> plot_;
+    //! Während des Zeichnens festgehaltener Plot.
+    std::shared_ptr<const ContourPlotFitter::Plot> render_plot_;
+    bool bilinear_interpolation_;
     
     bool auto_update_chi2_interval_;
     QwtInterval current_chi2_interval_;
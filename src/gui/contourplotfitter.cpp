@@ -20,12 +20,13 @@
 #include <cmath>
 #include <utility>
 
-#include "core/fitting/noblefitfunction.h"
 #include "core/misc/defines.h"
 
 #include "contourplotdata.h"
 
 const int ContourPlotFitter::BLOCKSIZE_REDUCTION_FACTOR = 2;
+const int ContourPlotFitter::ADAPTIVE_INITIAL_CELLS = 8;
+const unsigned ContourPlotFitter::MAX_TILE_SIZE = 64;
 
 ContourPlotFitter::ContourPlotFitter(ContourPlotData* data) :
     QThread(),
@@ -34,21 +35,40 @@ ContourPlotFitter::ContourPlotFitter(ContourPlotData* data) :
     fit_configurations_(),
     results_(),
     chi2_values_(32, 32),
+    start_values_(),
+    cache_(),
+    preview_values_(),
+    preview_results_(),
+    preview_available_(false),
+    adaptive_refinement_(false),
+    contour_levels_({2.30, 6.18, 11.8}),
+    refinement_threshold_(1.),
+    adaptive_cells_(),
+    adaptive_blocksize_(1),
+    adaptive_chi2_min_(std::numeric_limits<double>::quiet_NaN()),
+    leaf_values_(),
+    leaf_results_(),
     sample_number_(-1),
     x_parameter_(-1),
     y_parameter_(-1),
     n_parameters_(0),
-    new_jobs_(),
-    completed_jobs_(),
-    plot_stack_(),
+    tile_points_(),
+    tiles_(),
+    n_tiles_(0),
+    next_tile_(0),
+    completed_tiles_(),
+    point_available_(),
+    plot_(),
+    point_fitter_(),
     plot_stack_infos_(),
     fitted_parameter_names_(),
     all_jobs_prepared_(false),
     new_jobs_mutex_(),
-    completed_jobs_mutex_(),
-    plot_stack_mutex_(),
+    completed_tiles_mutex_(),
+    plot_mutex_(),
+    start_values_mutex_(),
     new_job_condition_(),
-    new_future_condition_(),
+    tile_completed_condition_(),
     interrupted_(false)
 {
 }
@@ -64,11 +84,8 @@ void ContourPlotFitter::PrepareForFit()
 
 void ContourPlotFitter::SetConcentrations(const RunData& concentrations)
 {
-    concentrations_.clear();
-    for (auto it = concentrations.concentrations_begin();
-         it != concentrations.concentrations_end();
-         ++it)
-        concentrations_.push_back({*it});
+    concentrations_ = concentrations;
+    cache_.Clear();
 }
 
 void ContourPlotFitter::SetFitConfigurations(
@@ -78,6 +95,7 @@ void ContourPlotFitter::SetFitConfigurations(
     
     assert(!fit_configurations_.empty());
     n_parameters_ = fit_configurations_[0].fit_parameter_config.size();
+    cache_.Clear();
 }
 
 void ContourPlotFitter::SetSampleNumber(int sample)
@@ -131,6 +149,21 @@ bool ContourPlotFitter::SetFixedParameters(
     return false;
 }
 
+void ContourPlotFitter::SetAdaptiveRefinement(bool enabled)
+{
+    adaptive_refinement_ = enabled;
+}
+
+void ContourPlotFitter::SetContourLevels(const std::vector<double>& delta_chi2_levels)
+{
+    contour_levels_ = delta_chi2_levels;
+}
+
+void ContourPlotFitter::SetRefinementThreshold(double delta_chi2)
+{
+    refinement_threshold_ = delta_chi2;
+}
+
 void ContourPlotFitter::SetFitArea(const QRectF& rect, const QSize& raster)
 {
     new_rect_ = rect;
@@ -148,21 +181,29 @@ void ContourPlotFitter::run()
         
     PrepareVariables();
     
-    FitConfiguration config(fit_configurations_.at(sample_number_));
+    const FitConfiguration& config = fit_configurations_.at(sample_number_);
     assert(config.sample_numbers.size() == 1);
-    const std::vector<SampleConcentrations>& concentrations(
-            concentrations_.at(sample_number_));
-    std::shared_ptr<NobleFitFunction> function(
-            std::make_shared<NobleFitFunction>(
-                config.model,
-                *config.GetParameterMap(),
-                concentrations));
-
-    RemoveFixedParametersFromFit(config);
-    DetermineFittedParameterNames(config);
-    std::vector<std::pair<int, double>> parameters = PrepareParametersVector();
-        
-    LevenbergMarquardtFitter fitter(function);
+    Chi2MapPointFitter fitter(config,
+                              concentrations_,
+                              x_parameter_,
+                              y_parameter_,
+                              fixed_parameters_);
+    fitter.SetGrid(data_rect_.left(), data_rect_.right(), data_raster_.width(),
+                   data_rect_.top(), data_rect_.bottom(), data_raster_.height());
+
+    DetermineFittedParameterNames(fitter.GetParameterConfig());
+    results_.Reset(data_raster_.width(),
+                   data_raster_.height(),
+                   fitter.GetParameterConfig().size());
+
+    std::shared_ptr<Chi2MapPointFitter> detail_fitter(
+            std::make_shared<Chi2MapPointFitter>(fitter));
+    point_fitter_ = detail_fitter;
+    // Angezeigt werden nur χ² und die Parameter, Gaskonzentrationen werden nicht benötigt.
+    fitter.SetResultsRequest(ResultsRequest());
+
+    const Chi2MapCache::Key cache_key = CreateCacheKey();
+    QwtInterval chi2_interval = LoadCachedResults(cache_key);
    
     unsigned n_cpus = boost::thread::hardware_concurrency();
     if (n_cpus == 0) n_cpus = 1;
@@ -171,42 +212,50 @@ void ContourPlotFitter::run()
         worker_threads.create_thread(
                 std::bind(&ContourPlotFitter::DoFittingJobs,
                           this,
-                          parameters,
-                          std::cref(fitter),
-                          std::cref(config)));
-    CreateJobs();
+                          std::cref(fitter)));
+    if (adaptive_refinement_)
+    {
+        CreateAdaptiveJobs();
+        // Alle Punkte stammen aus dem Zwischenspeicher.
+        if (plot_stack_infos_.empty())
+            PublishPlot(1, chi2_interval);
+    }
+    else
+    {
+        CreateJobs();
+    }
     
-    if (!ProcessResults())
+    if (!ProcessResults(chi2_interval))
         worker_threads.interrupt_all();
     worker_threads.join_all();
-    
+
+    // Auch unvollständige Ansichten speichern, die berechneten Punkte
+    // müssen dann beim nächsten Mal nicht erneut gefittet werden.
+    Chi2MapCache::Layer layer;
+    layer.rect = data_rect_;
+    layer.raster = data_raster_;
+    layer.chi2_values = chi2_values_;
+    layer.results = results_;
+    cache_.Store(cache_key, layer);
 }
 
-void ContourPlotFitter::GetResultsPointers(
-        const QRectF*& rect,
-        const QSize*& raster,
-        const Eigen::MatrixXd*& chi2_values,
-        const std::vector<std::vector<std::shared_ptr<const FitResults>>>*&
-            results,
-        const std::vector<QString>*& parameter_names)
+std::shared_ptr<const ContourPlotFitter::Plot> ContourPlotFitter::GetPlot()
 {
-    boost::lock_guard<boost::mutex> lock(plot_stack_mutex_);
-    if (plot_stack_.empty())
-    {
-        rect = nullptr;
-        raster = nullptr;
-        chi2_values = nullptr;
-        results = nullptr;
-        parameter_names = nullptr;
-    }
-    else
-    {
-        rect = &plot_stack_.back().rect;
-        raster = &plot_stack_.back().raster;
-        chi2_values = &plot_stack_.back().chi2_values;
-        results = &plot_stack_.back().results;
-        parameter_names = &fitted_parameter_names_;
-    }
+    boost::lock_guard<boost::mutex> lock(plot_mutex_);
+    return plot_;
+}
+
+std::shared_ptr<FitResults> ContourPlotFitter::ComputeResults(
+        const Plot& plot,
+        double x,
+        double y,
+        const Eigen::VectorXd& start_values)
+{
+    if (!plot.point_fitter)
+        return std::shared_ptr<FitResults>();
+
+    Chi2MapPointFitter fitter(*plot.point_fitter);
+    return fitter.FitAt(x, y, start_values);
 }
 
 void ContourPlotFitter::InterruptFitAndInvalidateResults()
@@ -218,15 +267,16 @@ void ContourPlotFitter::InterruptFitAndInvalidateResults()
 void ContourPlotFitter::PrepareVariables()
 {
     all_jobs_prepared_ = false;
-    new_jobs_.clear();
-    completed_jobs_.clear();
+    n_tiles_ = 0;
+    next_tile_ = 0;
+    completed_tiles_.clear();
     plot_stack_infos_.clear();
     {
-        boost::lock_guard<boost::mutex> lock(plot_stack_mutex_);
-        if (!plot_stack_.empty())
+        boost::lock_guard<boost::mutex> lock(plot_mutex_);
+        if (plot_)
         {
             emit ResultsInvalidated();
-            plot_stack_.clear();
+            plot_.reset();
         }
     }
     
@@ -235,10 +285,71 @@ void ContourPlotFitter::PrepareVariables()
     
     chi2_values_.resize(data_raster_.width(), data_raster_.height());
     chi2_values_.fill(std::numeric_limits<double>::quiet_NaN());
-    results_.clear();
-    results_.resize(data_raster_.width());
-    for (auto& r : results_)
-        r.resize(data_raster_.height());
+    start_values_.clear();
+    start_values_.resize(data_raster_.width() * data_raster_.height());
+    tile_points_.resize(data_raster_.width() * data_raster_.height());
+    tiles_.resize(data_raster_.width() * data_raster_.height());
+    point_available_.assign(data_raster_.width() * data_raster_.height(), false);
+}
+
+Chi2MapCache::Key ContourPlotFitter::CreateCacheKey() const
+{
+    Chi2MapCache::Key key;
+    key.sample = sample_number_;
+    key.x_parameter = x_parameter_;
+    key.y_parameter = y_parameter_;
+    std::copy_if(fixed_parameters_.cbegin(),
+                 fixed_parameters_.cend(),
+                 std::back_inserter(key.fixed_parameters),
+                 [&](const std::pair<int, double>& p)
+                 {
+                     return p.first != x_parameter_ &&
+                            p.first != y_parameter_;
+                 });
+    std::sort(key.fixed_parameters.begin(), key.fixed_parameters.end());
+    return key;
+}
+
+QwtInterval ContourPlotFitter::LoadCachedResults(const Chi2MapCache::Key& key)
+{
+    const unsigned n_cached = cache_.Lookup(key,
+                                            data_rect_,
+                                            data_raster_,
+                                            chi2_values_,
+                                            results_,
+                                            preview_values_,
+                                            preview_results_);
+
+    QwtInterval chi2_interval;
+    preview_available_ = n_cached > 0;
+    for (int i = 0; i < data_raster_.width(); ++i)
+        for (int j = 0; j < data_raster_.height(); ++j)
+        {
+            const bool has_results = results_.HasResults(i, j);
+            if (preview_results_.HasResults(i, j))
+                preview_available_ = true;
+            if (has_results)
+                point_available_[i * data_raster_.height() + j] = true;
+            if (has_results &&
+                Chi2MapPointFitter::IsConverged(results_.GetExitFlag(i, j),
+                                                chi2_values_(i, j)))
+                start_values_[i * data_raster_.height() + j] =
+                        results_.GetBestEstimate(i, j);
+
+            const double chi2 = has_results ? chi2_values_(i, j) :
+                                              preview_values_(i, j);
+            if (!std::isfinite(chi2))
+                continue;
+            if (!chi2_interval.isValid())
+                chi2_interval.setInterval(chi2, chi2);
+            else
+                chi2_interval |= chi2;
+        }
+
+    if (preview_available_)
+        PublishPlot(1, chi2_interval);
+
+    return chi2_interval;
 }
 
 void ContourPlotFitter::CreateJobs()
@@ -249,189 +360,363 @@ void ContourPlotFitter::CreateJobs()
     int blocksize = std::pow(BLOCKSIZE_REDUCTION_FACTOR,
                              std::ceil(std::log(smaller_border) /
                                        std::log(BLOCKSIZE_REDUCTION_FACTOR)));
-    // Am Anfang sehr groß gewählt, sodass im ersten Schritt auch wirklich
-    // keine Punkte übersprungen werden.
-    int old_blocksize = blocksize * 10000;
-    int n_fits = 0;
+    // Jeder Punkt darf nur einer Kachel angehören. Der letzte Durchgang
+    // enthält alle Punkte, auch die der gröberen.
+    std::vector<char> queued(width * height, false);
     std::vector<JobParameters> working_vector_;
     working_vector_.reserve(width * height);
     while (blocksize > 0)
     {
         working_vector_.clear();
         const int beginning = blocksize == 1 ? 0 : std::ceil(blocksize / 2.);
-        const int old_beginning = std::ceil(old_blocksize / 2.);
         for (int i = beginning; i < width; i += blocksize)
             for (int j = beginning; j < height; j += blocksize)
-                // Nur hinzufügen wenn nicht schon bei der nächsthöheren
-                // Blocksize geschehen.
-                if ((i - old_beginning % old_blocksize) ||
-                    (j - old_beginning % old_blocksize))
+                // Nur hinzufügen wenn nicht schon bei einer höheren
+                // Blocksize geschehen oder aus dem Zwischenspeicher übernommen.
+                if (!queued[i * height + j] && !results_.HasResults(i, j))
                 {
-                    working_vector_.push_back(JobParameters(i, j));
-                    ++n_fits;
+                    queued[i * height + j] = true;
+                    working_vector_.push_back(JobParameters(i, j, blocksize));
                 }
-        if (n_fits)        
-            plot_stack_infos_.push_back(PlotStackInfo(n_fits, blocksize));
-        old_blocksize = blocksize;
+        AddJobs(working_vector_, blocksize);
         blocksize /= BLOCKSIZE_REDUCTION_FACTOR;
-        
+    }
+    
+    {
+        boost::lock_guard<boost::mutex> lock(new_jobs_mutex_);
+        all_jobs_prepared_ = true;
+    }
+    new_job_condition_.notify_all();
+}
+
+void ContourPlotFitter::AddJobs(const std::vector<JobParameters>& jobs,
+                                int blocksize)
+{
+    if (jobs.empty())
+        return;
+
+    // Kleine Kacheln halten bei den groben Durchgängen alle Kerne
+    // beschäftigt, große sparen bei den feinen die Synchronisation.
+    unsigned n_cpus = boost::thread::hardware_concurrency();
+    if (n_cpus == 0) n_cpus = 1;
+    const unsigned tile_size = std::max(
+            1u, std::min<unsigned>(MAX_TILE_SIZE, jobs.size() / (4 * n_cpus)));
+    const int level = plot_stack_infos_.size();
+    const unsigned n_new_tiles = (jobs.size() + tile_size - 1) / tile_size;
+    plot_stack_infos_.push_back(PlotStackInfo(n_new_tiles, blocksize));
+
+    {
+        boost::lock_guard<boost::mutex> lock(new_jobs_mutex_);
+        // Die Arbeiter-Threads lesen nur freigegebene Kacheln, die übrigen
+        // Einträge dürfen daher ohne Weiteres beschrieben werden.
+        const unsigned n_tiles = n_tiles_.load(std::memory_order_relaxed);
+        const unsigned first_point = n_tiles == 0 ? 0 : tiles_[n_tiles - 1].end;
+        assert(first_point + jobs.size() <= tile_points_.size());
+        std::copy(jobs.begin(), jobs.end(), tile_points_.begin() + first_point);
+        for (unsigned t = 0; t < n_new_tiles; ++t)
         {
-            boost::lock_guard<boost::mutex> lock(new_jobs_mutex_);
-            std::move(working_vector_.begin(),
-                      working_vector_.end(),
-                      std::back_inserter(new_jobs_));
+            Tile& tile = tiles_[n_tiles + t];
+            tile.level = level;
+            tile.begin = first_point + t * tile_size;
+            tile.end = std::min<unsigned>(tile.begin + tile_size,
+                                          first_point + jobs.size());
         }
-        new_job_condition_.notify_all();
+        n_tiles_.store(n_tiles + n_new_tiles, std::memory_order_release);
     }
-    
-    all_jobs_prepared_ = true;
-}
-
-void ContourPlotFitter::RemoveFixedParametersFromFit(FitConfiguration& config) const
-{
-    std::vector<int> parameters_to_remove;
-    parameters_to_remove.push_back(x_parameter_);
-    parameters_to_remove.push_back(y_parameter_);
-    for (auto it = fixed_parameters_.cbegin();
-         it != fixed_parameters_.cend();
-         ++it)
-         parameters_to_remove.push_back(it->first);
-    std::sort(parameters_to_remove.begin(),
-              parameters_to_remove.end(),
-              std::greater<int>());
-    parameters_to_remove.erase(std::unique(parameters_to_remove.begin(),
-                                           parameters_to_remove.end()),
-                               parameters_to_remove.end());
-    std::for_each(parameters_to_remove.begin(),
-                  parameters_to_remove.end(),
-                  std::bind(&FitParameterConfig::RemoveParameter,
-                            &config.fit_parameter_config,
-                            std::placeholders::_1));
-}
-
-void ContourPlotFitter::DetermineFittedParameterNames(FitConfiguration& config)
-{
-    boost::lock_guard<boost::mutex> lock(plot_stack_mutex_);
-    if (!fitted_parameter_names_.empty())
+    new_job_condition_.notify_all();
+}
+
+void ContourPlotFitter::CreateAdaptiveJobs()
+{
+    const int width = data_raster_.width();
+    const int height = data_raster_.height();
+    const int smaller_border = std::min(width, height);
+
+    int blocksize = 1;
+    while (smaller_border / (blocksize * BLOCKSIZE_REDUCTION_FACTOR) >=
+           ADAPTIVE_INITIAL_CELLS)
+        blocksize *= BLOCKSIZE_REDUCTION_FACTOR;
+
+    adaptive_blocksize_ = blocksize;
+    adaptive_chi2_min_ = std::numeric_limits<double>::quiet_NaN();
+    adaptive_cells_.clear();
+    for (int x = 0; x < width; x += blocksize)
+        for (int y = 0; y < height; y += blocksize)
+            adaptive_cells_.push_back(std::make_pair(x, y));
+
+    leaf_values_.setConstant(width, height,
+                             std::numeric_limits<double>::quiet_NaN());
+    leaf_results_.Reset(width, height, results_.n_parameters());
+
+    StartAdaptiveLevel();
+}
+
+void ContourPlotFitter::StartAdaptiveLevel()
+{
+    while (!adaptive_cells_.empty())
     {
-        emit ResultsInvalidated();
-        fitted_parameter_names_.clear();
+        std::vector<std::pair<int, int>> points;
+        for (const auto& cell : adaptive_cells_)
+        {
+            const std::pair<int, int> point = GetSamplePoint(cell);
+            if (!results_.HasResults(point.first, point.second))
+                points.push_back(point);
+        }
+        // Am Rand fallen die Punkte mehrerer Zellen zusammen. Jeder Punkt
+        // darf aber nur von einem Arbeiter-Thread beschrieben werden.
+        std::sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+
+        if (!points.empty())
+        {
+            std::vector<JobParameters> jobs;
+            for (const auto& point : points)
+                jobs.push_back(JobParameters(point.first,
+                                             point.second,
+                                             adaptive_blocksize_));
+            AddJobs(jobs, adaptive_blocksize_);
+            return;
+        }
+
+        // Alle Punkte dieses Durchgangs liegen bereits vor.
+        FinishAdaptiveLevel();
     }
-    for (const auto& name : config.fit_parameter_config.names())
-        fitted_parameter_names_.push_back(QString::fromStdString(name));
+
+    {
+        boost::lock_guard<boost::mutex> lock(new_jobs_mutex_);
+        all_jobs_prepared_ = true;
+    }
+    new_job_condition_.notify_all();
 }
 
-std::vector<std::pair<int, double>>
-ContourPlotFitter::PrepareParametersVector() const
+void ContourPlotFitter::FinishAdaptiveLevel()
 {
-    std::vector<std::pair<int, double>> parameters;
-    parameters.push_back(std::make_pair(x_parameter_, 0.));
-    parameters.push_back(std::make_pair(y_parameter_, 0.));
-    std::copy_if(fixed_parameters_.cbegin(),
-                 fixed_parameters_.cend(),
-                 std::back_inserter(parameters),
-                 [&](const std::pair<int, double>& p)
-                 {
-                     return p.first != x_parameter_ &&
-                            p.first != y_parameter_;
-                 });
-    return parameters;
+    const int width = data_raster_.width();
+    const int height = data_raster_.height();
+    const int blocksize = adaptive_blocksize_;
+
+    for (const auto& cell : adaptive_cells_)
+    {
+        const std::pair<int, int> point = GetSamplePoint(cell);
+        assert(results_.HasResults(point.first, point.second));
+        const double chi2 = chi2_values_(point.first, point.second);
+        if (std::isfinite(chi2) &&
+            !(adaptive_chi2_min_ <= chi2))
+            adaptive_chi2_min_ = chi2;
+
+        for (int x = cell.first; x < std::min(cell.first + blocksize, width); ++x)
+            for (int y = cell.second; y < std::min(cell.second + blocksize, height); ++y)
+            {
+                leaf_values_(x, y) = chi2;
+                leaf_results_.CopyResults(x, y, results_, point.first, point.second);
+            }
+    }
+
+    std::vector<std::pair<int, int>> refined_cells;
+    if (blocksize > 1)
+    {
+        const int child_blocksize = blocksize / BLOCKSIZE_REDUCTION_FACTOR;
+        for (const auto& cell : adaptive_cells_)
+        {
+            if (!NeedsRefinement(cell))
+                continue;
+            for (int x = cell.first;
+                 x < std::min(cell.first + blocksize, width);
+                 x += child_blocksize)
+                for (int y = cell.second;
+                     y < std::min(cell.second + blocksize, height);
+                     y += child_blocksize)
+                    refined_cells.push_back(std::make_pair(x, y));
+        }
+        adaptive_blocksize_ = child_blocksize;
+    }
+    adaptive_cells_.swap(refined_cells);
+}
+
+bool ContourPlotFitter::NeedsRefinement(const std::pair<int, int>& cell) const
+{
+    const int width = data_raster_.width();
+    const int height = data_raster_.height();
+    const int blocksize = adaptive_blocksize_;
+    const std::pair<int, int> point = GetSamplePoint(cell);
+    const double chi2 = chi2_values_(point.first, point.second);
+
+    // Die Zelle mit dem bisher kleinsten χ² enthält das Minimum.
+    if (chi2 == adaptive_chi2_min_)
+        return true;
+
+    const std::pair<int, int> neighbours[] = {
+        std::make_pair(cell.first - 1, point.second),
+        std::make_pair(cell.first + blocksize, point.second),
+        std::make_pair(point.first, cell.second - 1),
+        std::make_pair(point.first, cell.second + blocksize)
+    };
+    // Steile Flanken weit außerhalb der Konturen müssen nicht aufgelöst werden.
+    const double max_level = contour_levels_.empty() ? 0. :
+            *std::max_element(contour_levels_.begin(), contour_levels_.end());
+    const double region_of_interest = adaptive_chi2_min_ + 2. * max_level;
+
+    for (const auto& neighbour : neighbours)
+    {
+        if (neighbour.first < 0 || neighbour.first >= width ||
+            neighbour.second < 0 || neighbour.second >= height ||
+            !leaf_results_.HasResults(neighbour.first, neighbour.second))
+            continue;
+
+        const double neighbour_chi2 =
+                leaf_values_(neighbour.first, neighbour.second);
+        if (std::isfinite(chi2) != std::isfinite(neighbour_chi2))
+            return true;
+        if (!std::isfinite(chi2))
+            continue;
+
+        for (double level : contour_levels_)
+        {
+            const double contour = adaptive_chi2_min_ + level;
+            if ((chi2 < contour) != (neighbour_chi2 < contour))
+                return true;
+        }
+
+        if (std::abs(chi2 - neighbour_chi2) > refinement_threshold_ &&
+            std::min(chi2, neighbour_chi2) <= region_of_interest)
+            return true;
+    }
+    return false;
 }
 
-bool ContourPlotFitter::ResultsLeft() const
+std::pair<int, int> ContourPlotFitter::GetSamplePoint(
+        const std::pair<int, int>& cell) const
 {
-    return !completed_jobs_.empty() ||
-           !new_jobs_.empty() ||
-           !all_jobs_prepared_;
+    const int offset = adaptive_blocksize_ == 1 ?
+            0 : std::ceil(adaptive_blocksize_ / 2.);
+    return std::make_pair(std::min(cell.first + offset, data_raster_.width() - 1),
+                          std::min(cell.second + offset, data_raster_.height() - 1));
 }
 
-ContourPlotFitter::JobPromise ContourPlotFitter::GetNewJob()
+void ContourPlotFitter::DetermineFittedParameterNames(
+        const FitParameterConfig& parameter_config)
 {
-    JobParameters params;
+    boost::lock_guard<boost::mutex> lock(plot_mutex_);
+    if (!fitted_parameter_names_.empty())
     {
-        boost::unique_lock<boost::mutex> lock(new_jobs_mutex_);
-        if (new_jobs_.empty() && all_jobs_prepared_) throw NoJobsLeft();
-        
-        while (new_jobs_.empty())
-            new_job_condition_.wait(lock);
-        
-        params = new_jobs_.front();
-        new_jobs_.pop_front();
+        emit ResultsInvalidated();
+        fitted_parameter_names_.clear();
     }
-    
-    boost::promise<std::shared_ptr<FitResults>> promise;
-    boost::unique_future<std::shared_ptr<FitResults>> future(
-            promise.get_future());
-    
-    JobFuture job_future;
-    job_future.params = params;
-    job_future.future = std::move(future);
+    for (const auto& name : parameter_config.names())
+        fitted_parameter_names_.push_back(QString::fromStdString(name));
+}
+
+bool ContourPlotFitter::FindStartValues(const JobParameters& params,
+                                        Eigen::VectorXd& start_values)
+{
+    const int width = data_raster_.width();
+    const int height = data_raster_.height();
+    // Die Punkte des vorherigen, gröberen Durchgangs liegen höchstens zwei
+    // Blockgrößen entfernt.
+    const int max_distance = 2 * std::max(params.blocksize, 1);
+
+    auto find = [&](int i, int j) -> bool
+                {
+                    if (i < 0 || i >= width || j < 0 || j >= height)
+                        return false;
+                    const Eigen::VectorXd& values = start_values_[i * height + j];
+                    if (!values.size())
+                        return false;
+                    start_values = values;
+                    return true;
+                };
+
+    boost::lock_guard<boost::mutex> lock(start_values_mutex_);
+    // Ringe mit wachsendem Abstand (Maximumsnorm) um den Punkt absuchen.
+    for (int distance = 1; distance <= max_distance; ++distance)
     {
-        boost::lock_guard<boost::mutex> lock(completed_jobs_mutex_);
-        completed_jobs_.push_back(std::move(job_future));
+        for (int k = -distance; k <= distance; ++k)
+        {
+            if (find(params.i + k, params.j - distance) ||
+                find(params.i + k, params.j + distance))
+                return true;
+        }
+        for (int k = -distance + 1; k < distance; ++k)
+        {
+            if (find(params.i - distance, params.j + k) ||
+                find(params.i + distance, params.j + k))
+                return true;
+        }
     }
-    
-    new_future_condition_.notify_one();
-            
-    JobPromise job_promise;
-    job_promise.params = params;
-    job_promise.promise = std::move(promise);
-    return job_promise;
+    return false;
 }
 
-ContourPlotFitter::JobResults ContourPlotFitter::GetNextResults()
+void ContourPlotFitter::StoreStartValues(const JobParameters& params,
+                                         const FitResults& results)
 {
-    JobFuture future;
+    if (!Chi2MapPointFitter::IsConverged(results.exit_flag, results.chi_square))
+        return;
+
+    boost::lock_guard<boost::mutex> lock(start_values_mutex_);
+    start_values_[params.i * data_raster_.height() + params.j] =
+            results.best_estimate;
+}
+
+unsigned ContourPlotFitter::ClaimTile()
+{
+    unsigned tile = next_tile_.load();
+    while (true)
     {
-        boost::unique_lock<boost::mutex> lock(completed_jobs_mutex_);
-        
-        if (!ResultsLeft())
-            throw NoResultsLeft();
-        
-        while(completed_jobs_.empty())
-            new_future_condition_.wait(lock);
-        
-        future = std::move(completed_jobs_.front());
-        completed_jobs_.pop_front();
+        while (tile < n_tiles_.load(std::memory_order_acquire))
+            if (next_tile_.compare_exchange_weak(tile, tile + 1))
+                return tile;
+
+        boost::unique_lock<boost::mutex> lock(new_jobs_mutex_);
+        while ((tile = next_tile_.load()) >= n_tiles_.load())
+        {
+            // Im adaptiven Modus steht erst nach dem Warten fest, ob noch
+            // Aufträge folgen.
+            if (all_jobs_prepared_) throw NoJobsLeft();
+            new_job_condition_.wait(lock);
+        }
     }
-    
-    JobResults results;
-    results.params = future.params;
-    results.results = future.future.get();
-    return results;
 }
 
 noble_align_function void ContourPlotFitter::DoFittingJobs(
-        std::vector<std::pair<int, double>> parameters,
-        const LevenbergMarquardtFitter& fitter,
-        const FitConfiguration& config)
-{
-    std::shared_ptr<LevenbergMarquardtFitter> local_fitter(fitter.clone());
-    std::shared_ptr<NobleFitFunction> function(
-            std::dynamic_pointer_cast<NobleFitFunction>(
-                    local_fitter->GetFitFunction()));
+        const Chi2MapPointFitter& fitter)
+{
+    Chi2MapPointFitter local_fitter(fitter);
+    Eigen::VectorXd start_values;
     
     try
     {
         while (true)
         {
-            ContourPlotFitter::JobPromise job_promise = GetNewJob();
-            const JobParameters& params = job_promise.params;
-            
-            parameters[0].second = data_rect_.left() +
-                    params.i * data_rect_.width()  / data_raster_.width();
-            parameters[1].second = data_rect_.top() +
-                    params.j * data_rect_.height() / data_raster_.height();
-
-            function->FixParameters(parameters);
-
-            std::shared_ptr<FitResults> results =
-                    local_fitter->fit(std::make_shared<FitParameterConfig>(
-                        config.fit_parameter_config));
-                       
-            job_promise.promise.set_value(results);
-            
-            boost::this_thread::interruption_point();
+            const unsigned tile_index = ClaimTile();
+            const Tile& tile = tiles_[tile_index];
+
+            for (unsigned p = tile.begin; p < tile.end; ++p)
+            {
+                const JobParameters& params = tile_points_[p];
+
+                // Die Punkte werden von grob nach fein berechnet. Ein bereits
+                // konvergierter Nachbar liefert meist deutlich bessere Startwerte
+                // als die der Fitkonfiguration.
+                if (!FindStartValues(params, start_values))
+                    start_values.resize(0);
+
+                std::shared_ptr<FitResults> results =
+                        local_fitter.Fit(params.i, params.j, start_values);
+                StoreStartValues(params, *results);
+
+                // Jeder Punkt gehört genau einer Kachel, der GUI-Thread liest
+                // ihn erst nach der Meldung der fertigen Kachel.
+                chi2_values_(params.i, params.j) = results->chi_square;
+                results_.SetResults(params.i, params.j, *results);
+
+                boost::this_thread::interruption_point();
+            }
+
+            {
+                boost::lock_guard<boost::mutex> lock(completed_tiles_mutex_);
+                completed_tiles_.push_back(tile_index);
+            }
+            tile_completed_condition_.notify_one();
         }
     }
     catch (NoJobsLeft)
@@ -439,51 +724,66 @@ noble_align_function void ContourPlotFitter::DoFittingJobs(
     }
 }
 
-bool ContourPlotFitter::ProcessResults()
+bool ContourPlotFitter::ProcessResults(QwtInterval chi2_interval)
 {
-    QwtInterval chi2_interval;
-    
-    auto it = plot_stack_infos_.cbegin();
-    int n_fits = 0;
-    try
+    const int height = data_raster_.height();
+    // Index statt Iterator, da im adaptiven Modus während der Verarbeitung
+    // weitere Durchgänge angehängt werden.
+    std::size_t level = 0;
+    std::vector<unsigned> finished_tiles;
+    while (!all_jobs_prepared_ || level < plot_stack_infos_.size())
     {
-        while (true)
+        if (interrupted_)
+            return false;
+
+        finished_tiles.clear();
         {
-            if (interrupted_)
-                return false;
-            JobResults next_results(GetNextResults());
-            const JobParameters& params = next_results.params;
-            std::shared_ptr<FitResults> results = next_results.results;
-            
-            chi2_values_(params.i, params.j) = results->chi_square;
-            results_.at(params.i).at(params.j) = results;
-            
-            ++n_fits;
-            if (std::isfinite(results->chi_square))
+            boost::unique_lock<boost::mutex> lock(completed_tiles_mutex_);
+            // Mit Zeitlimit, damit eine Unterbrechung auch während langer
+            // Fits bemerkt wird.
+            if (completed_tiles_.empty())
+                tile_completed_condition_.wait_for(
+                        lock, boost::chrono::milliseconds(100));
+            finished_tiles.swap(completed_tiles_);
+        }
+
+        // Die Kacheln werden in der Reihenfolge ihrer Fertigstellung
+        // verarbeitet, ein langsamer Fit hält nur seinen eigenen Durchgang auf.
+        for (unsigned tile_index : finished_tiles)
+        {
+            const Tile& tile = tiles_[tile_index];
+            for (unsigned p = tile.begin; p < tile.end; ++p)
             {
+                const JobParameters& params = tile_points_[p];
+                point_available_[params.i * height + params.j] = true;
+                const double chi2 = chi2_values_(params.i, params.j);
+                if (!std::isfinite(chi2))
+                    continue;
                 if (!chi2_interval.isValid())
-                    chi2_interval.setInterval(results->chi_square,
-                                              results->chi_square);
+                    chi2_interval.setInterval(chi2, chi2);
                 else
-                    chi2_interval |= results->chi_square;
+                    chi2_interval |= chi2;
             }
-            
-            assert(it != plot_stack_infos_.cend());
-            if (n_fits == it->n_fits)
+            --plot_stack_infos_[tile.level].n_tiles;
+        }
+
+        // Ein Durchgang wird angezeigt, sobald er und alle gröberen
+        // vollständig sind.
+        while (level < plot_stack_infos_.size() &&
+               plot_stack_infos_[level].n_tiles == 0)
+        {
+            const int blocksize = plot_stack_infos_[level].blocksize;
+            if (adaptive_refinement_)
             {
-                UpdatePlotStack(it->blocksize);
-                if (chi2_interval.isValid())
-                    emit NewDataAvailable(chi2_interval.minValue(),
-                                          chi2_interval.maxValue());
-                else
-                    emit NewDataAvailable(0., 0.);
-                ++it;
+                // Die Arbeiter-Threads sollen möglichst schnell wieder
+                // Aufträge erhalten, daher vor dem Aktualisieren des Plots.
+                FinishAdaptiveLevel();
+                StartAdaptiveLevel();
             }
+            PublishPlot(blocksize, chi2_interval);
+            ++level;
         }
     }
-    catch (NoResultsLeft)
-    {
-    }
     
     return true;
 }
@@ -495,9 +795,21 @@ void ContourPlotFitter::UpdatePlotStack(int blocksize)
     const int x_size = width / blocksize;
     const int y_size = height / blocksize;
     const int initial_index = blocksize == 1 ? 0 : std::ceil(blocksize / 2.);
+
+    if (adaptive_refinement_)
+    {
+        UpdateAdaptivePlotStack();
+        return;
+    }
+
+    if (preview_available_)
+    {
+        UpdatePlotStackWithPreview(blocksize);
+        return;
+    }
+
     Eigen::MatrixXd matrix(x_size, y_size);
-    std::vector<std::vector<std::shared_ptr<const FitResults>>> results(
-        x_size, std::vector<std::shared_ptr<const FitResults>>(y_size));
+    ContourResultsGrid results(x_size, y_size, results_.n_parameters());
     
     for (int x = 0; x < x_size; ++x)
         for (int y = 0; y < y_size; ++y)
@@ -505,7 +817,7 @@ void ContourPlotFitter::UpdatePlotStack(int blocksize)
             const int i = initial_index + x * blocksize;
             const int j = initial_index + y * blocksize;
             matrix(x, y) = chi2_values_(i, j);
-            results.at(x).at(y) = results_.at(i).at(j);
+            results.CopyResults(x, y, results_, i, j);
         }
 
     const double rect_width = x_size * blocksize * data_rect_.width()  / width;
@@ -513,12 +825,113 @@ void ContourPlotFitter::UpdatePlotStack(int blocksize)
     QSize raster(x_size, y_size);
     QRectF rect(data_rect_.left(), data_rect_.top(), rect_width, rect_height);
     
-    {
-        boost::lock_guard<boost::mutex> lock(plot_stack_mutex_);
-        plot_stack_.emplace_back();
-        plot_stack_.back().rect = rect;
-        plot_stack_.back().raster = raster;
-        plot_stack_.back().chi2_values = std::move(matrix);
-        plot_stack_.back().results = std::move(results);
-    }
+    std::shared_ptr<Plot> plot(std::make_shared<Plot>());
+    plot->rect = rect;
+    plot->raster = raster;
+    plot->chi2_values = std::move(matrix);
+    plot->results = std::move(results);
+    SetPlot(plot);
+}
+
+void ContourPlotFitter::UpdatePlotStackWithPreview(int blocksize)
+{
+    const int width = data_raster_.width();
+    const int height = data_raster_.height();
+    const int x_size = width / blocksize;
+    const int y_size = height / blocksize;
+    const int initial_index = blocksize == 1 ? 0 : std::ceil(blocksize / 2.);
+    Eigen::MatrixXd matrix(width, height);
+    ContourResultsGrid results(width, height, results_.n_parameters());
+
+    // Berechnete Punkte haben Vorrang vor der Vorschau, diese vor dem Wert
+    // des Blocks, in dem der Punkt liegt.
+    for (int i = 0; i < width; ++i)
+        for (int j = 0; j < height; ++j)
+        {
+            const int block_i = initial_index + i / blocksize * blocksize;
+            const int block_j = initial_index + j / blocksize * blocksize;
+            // Punkte späterer Durchgänge werden eventuell gerade beschrieben.
+            if (point_available_[i * height + j])
+            {
+                matrix(i, j) = chi2_values_(i, j);
+                results.CopyResults(i, j, results_, i, j);
+            }
+            else if (preview_results_.HasResults(i, j))
+            {
+                matrix(i, j) = preview_values_(i, j);
+                results.CopyResults(i, j, preview_results_, i, j);
+            }
+            else if (i / blocksize < x_size && j / blocksize < y_size &&
+                     point_available_[block_i * height + block_j])
+            {
+                matrix(i, j) = chi2_values_(block_i, block_j);
+                results.CopyResults(i, j, results_, block_i, block_j);
+            }
+            else
+            {
+                matrix(i, j) = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+
+    std::shared_ptr<Plot> plot(std::make_shared<Plot>());
+    plot->rect = data_rect_;
+    plot->raster = data_raster_;
+    plot->chi2_values = std::move(matrix);
+    plot->results = std::move(results);
+    SetPlot(plot);
+}
+
+void ContourPlotFitter::UpdateAdaptivePlotStack()
+{
+    const int width = data_raster_.width();
+    const int height = data_raster_.height();
+    Eigen::MatrixXd matrix(width, height);
+    ContourResultsGrid results(width, height, results_.n_parameters());
+
+    // Jeder Punkt erhält den Wert der feinsten berechneten Zelle, in der er
+    // liegt, und nur solange keine vorliegt die Vorschau.
+    for (int i = 0; i < width; ++i)
+        for (int j = 0; j < height; ++j)
+        {
+            if (leaf_results_.HasResults(i, j))
+            {
+                matrix(i, j) = leaf_values_(i, j);
+                results.CopyResults(i, j, leaf_results_, i, j);
+            }
+            else if (preview_available_ && preview_results_.HasResults(i, j))
+            {
+                matrix(i, j) = preview_values_(i, j);
+                results.CopyResults(i, j, preview_results_, i, j);
+            }
+            else
+            {
+                matrix(i, j) = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+
+    std::shared_ptr<Plot> plot(std::make_shared<Plot>());
+    plot->rect = data_rect_;
+    plot->raster = data_raster_;
+    plot->chi2_values = std::move(matrix);
+    plot->results = std::move(results);
+    SetPlot(plot);
+}
+
+void ContourPlotFitter::SetPlot(std::shared_ptr<Plot> plot)
+{
+    plot->parameter_names = fitted_parameter_names_;
+    plot->point_fitter = point_fitter_;
+    boost::lock_guard<boost::mutex> lock(plot_mutex_);
+    plot_ = plot;
+}
+
+void ContourPlotFitter::PublishPlot(int blocksize,
+                                    const QwtInterval& chi2_interval)
+{
+    UpdatePlotStack(blocksize);
+    if (chi2_interval.isValid())
+        emit NewDataAvailable(chi2_interval.minValue(),
+                              chi2_interval.maxValue());
+    else
+        emit NewDataAvailable(0., 0.);
 }
@@ -23,15 +23,20 @@
 #include <QSize>
 #include <QThread>
 
+#include <qwt_interval.h>
+
 #include <boost/thread.hpp>
 
-#include <deque>
+#include <atomic>
 
+#include "core/fitting/chi2mappointfitter.h"
 #include "core/fitting/fitconfiguration.h"
 #include "core/fitting/fitresults.h"
-#include "core/fitting/levenbergmarquardtfitter.h"
 #include "core/misc/rundata.h"
 
+#include "chi2mapcache.h"
+#include "contourresultsgrid.h"
+
 class ContourPlotData;
 
 class ContourPlotFitter : public QThread
@@ -39,6 +44,41 @@ class ContourPlotFitter : public QThread
     Q_OBJECT
     
 public:
+    //! Unveränderliche Momentaufnahme des angezeigten Plots.
+    /*!
+     * Jede neue Stufe wird als eigenes Objekt veröffentlicht. Wer einen
+     * Zeiger darauf hält, kann ohne Sperren lesen, während der Fitter
+     * bereits die nächste Stufe erzeugt.
+     */
+    struct Plot
+    {
+        QRectF rect;
+        QSize raster;
+        Eigen::MatrixXd chi2_values;
+        //! Status und beste Schätzung je Punkt, siehe ComputeResults.
+        ContourResultsGrid results;
+        std::vector<QString> parameter_names;
+        //! Fitter, der für einzelne Punkte alle Ergebnisgrößen berechnet.
+        std::shared_ptr<const Chi2MapPointFitter> point_fitter;
+    };
+
+    //! Fittet einen Punkt eines Plots erneut.
+    /*!
+     * Für die Karte werden je Punkt nur Status und beste Schätzung
+     * gespeichert. Alle übrigen Ergebnisse (Fehler, Kovarianzen,
+     * Konzentrationen) werden hiermit bei Bedarf nachgerechnet. Darf aus
+     * jedem Thread aufgerufen werden.
+     * \param x, y Werte der Achsenparameter.
+     * \param start_values Startwerte der gefitteten Parameter, leer für die
+     *   der Fitkonfiguration.
+     * \return Ergebnisse des Fits, leer falls \a plot keinen Fitter enthält.
+     */
+    static std::shared_ptr<FitResults> ComputeResults(
+            const Plot& plot,
+            double x,
+            double y,
+            const Eigen::VectorXd& start_values);
+
     ContourPlotFitter(ContourPlotData* data);
     virtual ~ContourPlotFitter();
     
@@ -53,14 +93,35 @@ public:
     bool SetFixedParameters(
             const std::vector<std::pair<int, double>>& fixed_parameters);
     void SetFitArea(const QRectF& rect, const QSize& raster);
+
+    //! Legt fest, ob das Raster adaptiv statt gleichmäßig verfeinert wird.
+    /*!
+     * Im adaptiven Modus wird ein Quadtree über das Raster aufgebaut. Eine
+     * Zelle wird nur dann in vier Teilzellen zerlegt, wenn sie das bisher
+     * kleinste χ² enthält, χ² zwischen ihr und einer Nachbarzelle eine der
+     * Konturen (siehe SetContourLevels) kreuzt oder sich stärker als um den
+     * Schwellwert (siehe SetRefinementThreshold) ändert. Die übrigen Punkte
+     * erhalten den Wert der feinsten berechneten Zelle, in der sie liegen.
+     * Standardmäßig deaktiviert. Wirkt ab dem nächsten Start.
+     */
+    void SetAdaptiveRefinement(bool enabled);
+
+    //! Setzt die Konturen als Δχ² über dem Minimum.
+    /*!
+     * Standardmäßig 2.30, 6.18 und 11.8 (1σ, 2σ und 3σ bei zwei Parametern).
+     */
+    void SetContourLevels(const std::vector<double>& delta_chi2_levels);
+
+    //! \brief Setzt die Änderung von χ² zwischen benachbarten Zellen, ab der
+    //! im adaptiven Modus verfeinert wird.
+    /*!
+     * Gilt nur, solange eine der beiden Zellen höchstens doppelt so weit
+     * über dem Minimum liegt wie die höchste Kontur. Standardmäßig 1.
+     */
+    void SetRefinementThreshold(double delta_chi2);
     
-    void GetResultsPointers(
-            const QRectF*& rect,
-            const QSize*& raster,
-            const Eigen::MatrixXd*& chi2_values,
-            const std::vector<std::vector<std::shared_ptr<const FitResults>>>*&
-                results,
-            const std::vector<QString>*& parameter_names);
+    //! Gibt den zuletzt veröffentlichten Plot zurück, leer falls keiner vorliegt.
+    std::shared_ptr<const Plot> GetPlot();
                             
     void InterruptFitAndInvalidateResults();
                             
@@ -73,76 +134,129 @@ protected:
     
 private:    
     class NoJobsLeft {};
-    class NoResultsLeft {};
     
     struct JobParameters
     {
-        JobParameters() : i(-1), j(-1) {}
-        JobParameters(int i, int j) : i(i), j(j) {}
+        JobParameters() : i(-1), j(-1), blocksize(0) {}
+        JobParameters(int i, int j, int blocksize) :
+                i(i), j(j), blocksize(blocksize) {}
         int i;
         int j;
+        //! Blockgröße des Durchgangs, in dem der Punkt berechnet wird.
+        int blocksize;
     };
     
-    struct JobPromise
-    {
-        JobParameters params;
-        boost::promise<std::shared_ptr<FitResults>> promise;
-    };
-    
-    struct JobResults
-    {
-        JobParameters params;
-        std::shared_ptr<FitResults> results;
-    };
-    
-    struct JobFuture
-    {
-        JobParameters params;
-        boost::unique_future<std::shared_ptr<FitResults>> future;
-    };
-    
-    struct Plot
+    //! Zusammenhängender Block von Aufträgen eines Durchgangs.
+    /*!
+     * Die Punkte liegen in tile_points_[begin, end). Die Arbeiter-Threads
+     * schreiben ihre Ergebnisse direkt nach chi2_values_ und results_ und
+     * melden erst die fertige Kachel.
+     */
+    struct Tile
     {
-        QRectF rect;
-        QSize raster;
-        Eigen::MatrixXd chi2_values;
-        std::vector<std::vector<std::shared_ptr<const FitResults>>> results;
+        int level;
+        unsigned begin;
+        unsigned end;
     };
     
     struct PlotStackInfo
     {
-        PlotStackInfo(int n_fits, int blocksize) :
-                n_fits(n_fits), blocksize(blocksize) {}
-        int n_fits;
+        PlotStackInfo(int n_tiles, int blocksize) :
+                n_tiles(n_tiles), blocksize(blocksize) {}
+        //! Zahl der noch nicht abgeschlossenen Kacheln des Durchgangs.
+        int n_tiles;
         int blocksize;
         QSize size;
     };
     
     void PrepareVariables();
+    Chi2MapCache::Key CreateCacheKey() const;
+    //! Übernimmt bereits berechnete Punkte aus dem Zwischenspeicher.
+    /*!
+     * Liegen Ergebnisse oder eine Vorschau vor, werden diese sofort
+     * angezeigt.
+     * \return Wertebereich der übernommenen χ²-Werte.
+     */
+    QwtInterval LoadCachedResults(const Chi2MapCache::Key& key);
     void CreateJobs();
-    void RemoveFixedParametersFromFit(FitConfiguration& config) const;
-    void DetermineFittedParameterNames(FitConfiguration& config);
-    std::vector<std::pair<int, double>> PrepareParametersVector() const;
-    bool ResultsLeft() const;
-    JobPromise GetNewJob();
-    JobResults GetNextResults();
-    void DoFittingJobs(std::vector<std::pair<int, double>> parameters,
-                       const LevenbergMarquardtFitter& fitter,
-                       const FitConfiguration& config);
+    //! \brief Teilt die Aufträge eines Durchgangs in Kacheln auf und gibt
+    //! sie für die Arbeiter-Threads frei.
+    void AddJobs(const std::vector<JobParameters>& jobs, int blocksize);
+    //! Erzeugt die Aufträge des ersten Durchgangs im adaptiven Modus.
+    void CreateAdaptiveJobs();
+    //! \brief Erzeugt die Aufträge für adaptive_cells_. Liegen bereits alle
+    //! Punkte vor, wird direkt weiter verfeinert.
+    void StartAdaptiveLevel();
+    //! \brief Überträgt die Ergebnisse des abgeschlossenen Durchgangs auf
+    //! alle Punkte der Zellen und bestimmt die Zellen des nächsten.
+    void FinishAdaptiveLevel();
+    bool NeedsRefinement(const std::pair<int, int>& cell) const;
+    //! Gibt den Punkt zurück, an dem eine Zelle des laufenden Durchgangs gefittet wird.
+    std::pair<int, int> GetSamplePoint(const std::pair<int, int>& cell) const;
+    void DetermineFittedParameterNames(const FitParameterConfig& parameter_config);
+    //! Sucht den nächstgelegenen bereits konvergierten Nachbarpunkt.
+    /*!
+     * \return Wahr, falls ein Nachbar gefunden wurde. \a start_values enthält
+     *   dann dessen beste Schätzung.
+     */
+    bool FindStartValues(const JobParameters& params,
+                         Eigen::VectorXd& start_values);
+    void StoreStartValues(const JobParameters& params,
+                          const FitResults& results);
+    //! Reserviert die nächste freigegebene Kachel.
+    /*!
+     * Wartet nur, falls alle freigegebenen Kacheln vergeben sind.
+     * \return Index der Kachel in tiles_.
+     */
+    unsigned ClaimTile();
+    void DoFittingJobs(const Chi2MapPointFitter& fitter);
     /*!
      * \return Wahr wenn alle Fits abgearbeitet wurden.
      *   Falsch falls unterbrochen.
      */
-    bool ProcessResults();
+    bool ProcessResults(QwtInterval chi2_interval);
     void UpdatePlotStack(int blocksize);
+    //! \brief Wie UpdatePlotStack, aber im vollen Raster und ergänzt um die
+    //! Vorschau aus dem Zwischenspeicher.
+    void UpdatePlotStackWithPreview(int blocksize);
+    void UpdateAdaptivePlotStack();
+    void PublishPlot(int blocksize, const QwtInterval& chi2_interval);
+    //! Ersetzt den veröffentlichten Plot.
+    void SetPlot(std::shared_ptr<Plot> plot);
     
     ContourPlotData* data_;
     
-    std::vector<std::vector<SampleConcentrations>> concentrations_;
+    RunData concentrations_;
     std::vector<FitConfiguration> fit_configurations_;
         
-    std::vector<std::vector<std::shared_ptr<const FitResults>>> results_;
+    ContourResultsGrid results_;
     Eigen::MatrixXd chi2_values_;
+    //! \brief Beste Schätzungen der konvergierten Punkte, leer für noch nicht
+    //! berechnete. Dienen benachbarten Punkten als Startwerte.
+    std::vector<Eigen::VectorXd> start_values_;
+
+    //! Ergebnisse früherer Ansichten.
+    Chi2MapCache cache_;
+    //! \brief Vorschauwerte aus gröberen früheren Ansichten für die noch
+    //! nicht berechneten Punkte, NaN wo keine vorliegen.
+    Eigen::MatrixXd preview_values_;
+    Chi2MapCache::ResultsGrid preview_results_;
+    //! \brief Gibt an, ob Ergebnisse aus dem Zwischenspeicher übernommen
+    //! wurden. Der Plot wird dann stets im vollen Raster aufgebaut.
+    bool preview_available_;
+
+    bool adaptive_refinement_;
+    std::vector<double> contour_levels_;
+    double refinement_threshold_;
+    //! Linke obere Ecken der Zellen des laufenden adaptiven Durchgangs.
+    std::vector<std::pair<int, int>> adaptive_cells_;
+    int adaptive_blocksize_;
+    //! Bisher kleinstes χ² im adaptiven Modus, NaN solange keines vorliegt.
+    double adaptive_chi2_min_;
+    //! \brief Wert und Ergebnis der feinsten berechneten Zelle für jeden
+    //! Punkt des Rasters im adaptiven Modus.
+    Eigen::MatrixXd leaf_values_;
+    Chi2MapCache::ResultsGrid leaf_results_;
 
     int sample_number_;
     int x_parameter_;
@@ -155,22 +269,44 @@ private:
     QRectF data_rect_;
     QSize data_raster_;
     
-    std::deque<ContourPlotFitter::JobParameters> new_jobs_;
-    std::deque<ContourPlotFitter::JobFuture> completed_jobs_;
+    //! \brief Punkte aller Kacheln. Jeder Punkt wird höchstens einmal
+    //! gefittet, daher genügt die Größe des Rasters.
+    std::vector<JobParameters> tile_points_;
+    std::vector<Tile> tiles_;
+    //! Zahl der freigegebenen Kacheln.
+    std::atomic<unsigned> n_tiles_;
+    //! Index der nächsten zu vergebenden Kachel.
+    std::atomic<unsigned> next_tile_;
+    //! Abgeschlossene, noch nicht verarbeitete Kacheln.
+    std::vector<unsigned> completed_tiles_;
+    //! \brief Gibt für jeden Punkt (Index i * Höhe + j) an, ob sein Ergebnis
+    //! vom GUI-Thread gelesen werden darf.
+    std::vector<char> point_available_;
     
-    std::vector<Plot> plot_stack_;
+    std::shared_ptr<const Plot> plot_;
+    //! Wird jedem veröffentlichten Plot der laufenden Rechnung mitgegeben.
+    std::shared_ptr<const Chi2MapPointFitter> point_fitter_;
     std::vector<PlotStackInfo> plot_stack_infos_;
     std::vector<QString> fitted_parameter_names_;
     
     bool all_jobs_prepared_;
     boost::mutex new_jobs_mutex_;
-    boost::mutex completed_jobs_mutex_;
-    boost::mutex plot_stack_mutex_;
+    boost::mutex completed_tiles_mutex_;
+    boost::mutex plot_mutex_;
+    boost::mutex start_values_mutex_;
     boost::condition_variable new_job_condition_;
-    boost::condition_variable new_future_condition_;
+    boost::condition_variable tile_completed_condition_;
     bool interrupted_;
     
     static const int BLOCKSIZE_REDUCTION_FACTOR;
+    //! Höchstzahl an Punkten je Kachel.
+    static const unsigned MAX_TILE_SIZE;
+    //! \brief Mindestzahl an Zellen entlang der kürzeren Seite im ersten
+    //! adaptiven Durchgang.
+    static const int ADAPTIVE_INITIAL_CELLS;
+
+    //! Prüft in den Tests die Auftragsverteilung ohne Arbeiter-Threads.
+    friend struct ContourPlotFitterTestAccess;
 };
 
 #endif // CONTOURPLOTFITTER_H
@@ -0,0 +1,116 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <cassert>
+
+#include "contourresultsgrid.h"
+
+ContourResultsGrid::ContourResultsGrid() :
+    width_(0),
+    height_(0),
+    n_parameters_(0),
+    exit_flags_(),
+    best_estimates_()
+{
+}
+
+ContourResultsGrid::ContourResultsGrid(int width, int height, int n_parameters) :
+    ContourResultsGrid()
+{
+    Reset(width, height, n_parameters);
+}
+
+void ContourResultsGrid::Reset(int width, int height, int n_parameters)
+{
+    width_ = width;
+    height_ = height;
+    n_parameters_ = n_parameters;
+    exit_flags_.assign(std::size_t(width) * height, Eigen::LM::NotStarted);
+    best_estimates_.assign(std::size_t(width) * height * n_parameters, 0.);
+}
+
+int ContourResultsGrid::width() const
+{
+    return width_;
+}
+
+int ContourResultsGrid::height() const
+{
+    return height_;
+}
+
+int ContourResultsGrid::n_parameters() const
+{
+    return n_parameters_;
+}
+
+bool ContourResultsGrid::HasResults(int i, int j) const
+{
+    return exit_flags_[Index(i, j)] != Eigen::LM::NotStarted;
+}
+
+bool ContourResultsGrid::AnyResults() const
+{
+    return std::any_of(exit_flags_.cbegin(),
+                       exit_flags_.cend(),
+                       [](signed char flag)
+                       {
+                           return flag != Eigen::LM::NotStarted;
+                       });
+}
+
+Eigen::LM::Status ContourResultsGrid::GetExitFlag(int i, int j) const
+{
+    return static_cast<Eigen::LM::Status>(exit_flags_[Index(i, j)]);
+}
+
+Eigen::Map<const Eigen::VectorXd> ContourResultsGrid::GetBestEstimate(int i, int j) const
+{
+    return Eigen::Map<const Eigen::VectorXd>(
+            best_estimates_.data() + Index(i, j) * n_parameters_, n_parameters_);
+}
+
+void ContourResultsGrid::SetResults(int i, int j, const FitResults& results)
+{
+    assert(results.best_estimate.size() == n_parameters_);
+    const std::size_t index = Index(i, j);
+    exit_flags_[index] = static_cast<signed char>(results.exit_flag);
+    std::copy(results.best_estimate.data(),
+              results.best_estimate.data() + n_parameters_,
+              best_estimates_.begin() + index * n_parameters_);
+}
+
+void ContourResultsGrid::CopyResults(int i, int j,
+                                     const ContourResultsGrid& source,
+                                     int k, int l)
+{
+    assert(source.n_parameters_ == n_parameters_);
+    const std::size_t index = Index(i, j);
+    const std::size_t source_index = source.Index(k, l);
+    exit_flags_[index] = source.exit_flags_[source_index];
+    std::copy(source.best_estimates_.begin() + source_index * n_parameters_,
+              source.best_estimates_.begin() + (source_index + 1) * n_parameters_,
+              best_estimates_.begin() + index * n_parameters_);
+}
+
+std::size_t ContourResultsGrid::Index(int i, int j) const
+{
+    assert(i >= 0 && i < width_ && j >= 0 && j < height_);
+    return std::size_t(i) * height_ + j;
+}
@@ -0,0 +1,85 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CONTOURRESULTSGRID_H
+#define CONTOURRESULTSGRID_H
+
+#include <Eigen/Core>
+
+#include <vector>
+
+#include "core/fitting/fitresults.h"
+
+//! Kompakte Ablage der Fitergebnisse eines Rasters.
+/*!
+ * Je Punkt werden nur Status und beste Schätzung in zusammenhängenden
+ * Feldern gespeichert, χ² liegt in der zugehörigen Matrix. Die
+ * vollständigen FitResults lassen sich bei Bedarf für einzelne Punkte
+ * nachrechnen (siehe ContourPlotFitter::ComputeResults).
+ *
+ * Verschiedene Punkte dürfen gleichzeitig von verschiedenen Threads
+ * beschrieben werden.
+ */
+class ContourResultsGrid
+{
+public:
+    //! Erzeugt ein leeres Raster.
+    ContourResultsGrid();
+
+    //! Erzeugt ein Raster ohne Ergebnisse.
+    /*!
+     * \param n_parameters Zahl der gefitteten Parameter je Punkt.
+     */
+    ContourResultsGrid(int width, int height, int n_parameters);
+
+    //! Verwirft alle Ergebnisse und passt die Größe an.
+    void Reset(int width, int height, int n_parameters);
+
+    int width() const;
+    int height() const;
+    int n_parameters() const;
+
+    //! Gibt an, ob für den Punkt ein Ergebnis vorliegt.
+    bool HasResults(int i, int j) const;
+
+    //! Gibt an, ob für mindestens einen Punkt ein Ergebnis vorliegt.
+    bool AnyResults() const;
+
+    //! Status des Fits, Eigen::LM::NotStarted falls kein Ergebnis vorliegt.
+    Eigen::LM::Status GetExitFlag(int i, int j) const;
+
+    //! Beste Schätzung der gefitteten Parameter.
+    Eigen::Map<const Eigen::VectorXd> GetBestEstimate(int i, int j) const;
+
+    //! Übernimmt Status und beste Schätzung eines Fits.
+    void SetResults(int i, int j, const FitResults& results);
+
+    //! Übernimmt das Ergebnis des Punkts (k, l) eines anderen Rasters.
+    void CopyResults(int i, int j, const ContourResultsGrid& source, int k, int l);
+
+private:
+    std::size_t Index(int i, int j) const;
+
+    int width_;
+    int height_;
+    int n_parameters_;
+    std::vector<signed char> exit_flags_;
+    std::vector<double> best_estimates_;
+};
+
+#endif // CONTOURRESULTSGRID_H
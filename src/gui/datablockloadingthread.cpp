@@ -0,0 +1,82 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <exception>
+
+#include "datavector.h"
+
+#include "datablockloadingthread.h"
+
+DataBlockLoadingThread::DataBlockLoadingThread(
+        std::vector<boost::shared_ptr<DataBlock>> blocks,
+        QObject* parent) :
+    QThread(parent),
+    blocks_(std::move(blocks)),
+    canceled_(false),
+    success_(false),
+    error_message_()
+{
+}
+
+void DataBlockLoadingThread::run()
+{
+    try
+    {
+        for (const auto& block : blocks_)
+        {
+            if (canceled_)
+                return;
+            block->GetValues();
+        }
+    }
+    catch (std::exception& e)
+    {
+        error_message_ = QString("Error: ") + e.what();
+        return;
+    }
+    catch (...)
+    {
+        error_message_ = "Error: unknown error";
+        return;
+    }
+    success_ = true;
+}
+
+void DataBlockLoadingThread::Cancel()
+{
+    canceled_ = true;
+}
+
+bool DataBlockLoadingThread::SuccessfullyCompleted() const
+{
+    return success_;
+}
+
+const QString& DataBlockLoadingThread::GetErrorMessage() const
+{
+    return error_message_;
+}
+
+bool DataBlockLoadingThread::AllLoaded(
+        const std::vector<boost::shared_ptr<DataBlock>>& blocks)
+{
+    for (const auto& block : blocks)
+        if (!block->IsLoaded())
+            return false;
+    return true;
+}
@@ -0,0 +1,65 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef DATABLOCKLOADINGTHREAD_H
+#define DATABLOCKLOADINGTHREAD_H
+
+#include <QString>
+#include <QThread>
+
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <vector>
+
+class DataBlock;
+
+//! Lädt noch nicht geladene Speicherblöcke im Hintergrund.
+/*!
+ * Wird beim Öffnen von Ergebnisdateien verwendet, damit das Fenster schon angezeigt
+ * werden kann, während die Monte-Carlo-Daten noch gelesen werden.
+ */
+class DataBlockLoadingThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    DataBlockLoadingThread(std::vector<boost::shared_ptr<DataBlock>> blocks,
+                           QObject* parent = nullptr);
+    virtual void run();
+
+    //! Bricht das Laden nach dem aktuellen Block ab.
+    void Cancel();
+
+    bool SuccessfullyCompleted() const;
+
+    //! Gibt die Fehlermeldung zurück, falls das Laden fehlgeschlagen ist.
+    const QString& GetErrorMessage() const;
+
+    //! Gibt an, ob alle Blöcke bereits geladen sind.
+    static bool AllLoaded(
+            const std::vector<boost::shared_ptr<DataBlock>>& blocks);
+
+private:
+    std::vector<boost::shared_ptr<DataBlock>> blocks_;
+    std::atomic<bool> canceled_;
+    bool success_;
+    QString error_message_;
+};
+
+#endif // DATABLOCKLOADINGTHREAD_H
@@ -18,80 +18,348 @@
 
 #include <boost/make_shared.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
 #include "mask.h"
 
 #include "datavector.h"
 
+namespace
+{
+//! Zahl der Elemente, die vor dem Kombinieren gemeinsam zusammengefasst werden.
+/*!
+  Ein Block passt in den L1-Cache, sodass der zweite Durchlauf für die Abweichungen
+  vom Blockmittelwert nicht erneut aus dem Speicher lesen muss.
+  */
+const std::size_t BLOCK_SIZE = 256;
+
+//! Für den jeweiligen Thread aktiver DataBlockStore.
+thread_local DataBlockStore* active_store = nullptr;
+
+//! Bestimmt die Kenngrößen eines zusammenhängenden, nicht leeren Bereichs.
+DataStatistics SummarizeBlock(const double* begin, const double* end)
+{
+    assert(end > begin);
+    DataStatistics block;
+    block.n = end - begin;
+    double sum = 0.;
+    double min = *begin;
+    double max = *begin;
+    for (const double* x = begin; x != end; ++x)
+    {
+        sum += *x;
+        min = *x < min ? *x : min;
+        max = *x > max ? *x : max;
+    }
+    block.mean = sum / block.n;
+    block.min = min;
+    block.max = max;
+
+    double sum_of_squares = 0.;
+    for (const double* x = begin; x != end; ++x)
+        sum_of_squares += (*x - block.mean) * (*x - block.mean);
+    block.sum_of_squares = sum_of_squares;
+    return block;
+}
+
+//! Kombiniert die Kenngrößen eines Blocks mit den bisherigen nach Chan et al.
+void Accumulate(DataStatistics& statistics, const DataStatistics& block)
+{
+    if (statistics.n == 0)
+    {
+        statistics = block;
+        return;
+    }
+    const unsigned long n = statistics.n + block.n;
+    const double delta = block.mean - statistics.mean;
+    statistics.mean += delta * block.n / n;
+    statistics.sum_of_squares += block.sum_of_squares +
+            delta * delta * (double(statistics.n) * block.n / n);
+    statistics.min = std::min(statistics.min, block.min);
+    statistics.max = std::max(statistics.max, block.max);
+    statistics.n = n;
+}
+}
+
+DataBlock::DataBlock(boost::shared_ptr<std::vector<double>> values) :
+    values_(values),
+    loader_(),
+    loaded_(true),
+    mutex_()
+{
+}
+
+DataBlock::DataBlock(Loader loader) :
+    values_(),
+    loader_(loader),
+    loaded_(false),
+    mutex_()
+{
+}
+
+const boost::shared_ptr<std::vector<double>>& DataBlock::GetValues() const
+{
+    if (!loaded_.load(std::memory_order_acquire))
+        Load();
+    return values_;
+}
+
+bool DataBlock::IsLoaded() const
+{
+    return loaded_.load(std::memory_order_acquire);
+}
+
+void DataBlock::Load() const
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if (loaded_.load(std::memory_order_relaxed))
+        return;
+    values_ = boost::make_shared<std::vector<double>>(loader_());
+    loader_ = Loader();
+    loaded_.store(true, std::memory_order_release);
+}
+
+DataBlockStore* DataBlockStore::GetActive()
+{
+    return active_store;
+}
+
+DataBlockStore::Activation::Activation(DataBlockStore& store) :
+    previous_(active_store)
+{
+    active_store = &store;
+}
+
+DataBlockStore::Activation::~Activation()
+{
+    active_store = previous_;
+}
+
 DataVector::DataVector() :
-    vector_(boost::make_shared<std::vector<double>>())
+    DataVector(boost::make_shared<std::vector<double>>())
 {
 }
 
 DataVector::DataVector(std::initializer_list<double> l) :
-    vector_(boost::make_shared<std::vector<double>>(l))
+    DataVector(boost::make_shared<std::vector<double>>(l))
 {
 }
 
 DataVector::DataVector(boost::shared_ptr<std::vector<double>> v) :
-    vector_(v)
+    DataVector(v, 0, v->size())
 {
 }
 
 DataVector::DataVector(const std::vector<double>& data) :
-    vector_(boost::make_shared<std::vector<double>>(data))
+    DataVector(boost::make_shared<std::vector<double>>(data))
+{
+}
+
+DataVector::DataVector(boost::shared_ptr<std::vector<double>> block,
+                       std::size_t offset,
+                       std::size_t size) :
+    DataVector(boost::make_shared<DataBlock>(block), offset, size)
 {
 }
 
+DataVector::DataVector(boost::shared_ptr<DataBlock> block,
+                       std::size_t offset,
+                       std::size_t size) :
+    block_(block),
+    offset_(offset),
+    size_(size)
+{
+    assert(!block_->IsLoaded() || offset_ + size_ <= block_->GetValues()->size());
+}
+
 DataVector::~DataVector()
 {
 }
 
+std::size_t DataVector::size() const
+{
+    return size_;
+}
+
+const double* DataVector::data() const
+{
+    return block_->GetValues()->data() + offset_;
+}
+
+const double* DataVector::begin() const
+{
+    return data();
+}
+
+const double* DataVector::end() const
+{
+    return data() + size_;
+}
+
+double DataVector::operator[](std::size_t i) const
+{
+    assert(i < size_);
+    return data()[i];
+}
+
+const boost::shared_ptr<DataBlock>& DataVector::GetBlock() const
+{
+    return block_;
+}
+
 double DataVector::CalcMean(const Mask& mask) const
 {
-    double sum = 0.;
-    unsigned n = 0;
-    MaskForEach(*vector_, mask,
-            [&](const double& x)
+    return CalcStatistics(mask).mean;
+}
+
+double DataVector::CalcStdDev(const Mask& mask) const
+{
+    return CalcStatistics(mask).StdDev();
+}
+
+double DataVector::CalcCorrelation(const DataVector& other,
+                                   const Mask& mask) const
+{
+    return CalcStatistics(other, mask).Correlation();
+}
+
+DataStatistics DataVector::CalcStatistics(const Mask& mask) const
+{
+    DataStatistics statistics;
+    const double* data = this->data();
+    MaskForEachRange(size(), mask,
+            [&](std::size_t begin, std::size_t end)
             {
-                sum += x;
-                ++n;
+                for (; begin < end; begin += BLOCK_SIZE)
+                {
+                    const std::size_t block_end = std::min(begin + BLOCK_SIZE, end);
+                    Accumulate(statistics,
+                               SummarizeBlock(data + begin, data + block_end));
+                }
             });
-    return sum / n;
+    return statistics;
 }
 
-double DataVector::CalcStdDev(const Mask& mask) const
+DataCoStatistics DataVector::CalcStatistics(const DataVector& other,
+                                            const Mask& mask) const
 {
-    double sum = 0.0;
-    unsigned n = 0;
-    double mean = CalcMean(mask);
-    MaskForEach(*vector_, mask,
-            [&](const double& x)
+    assert(size() == other.size());
+    DataCoStatistics statistics;
+    const double* x = data();
+    const double* y = other.data();
+    MaskForEachRange(size(), mask,
+            [&](std::size_t begin, std::size_t end)
             {
-                sum += std::pow(mean - x, 2);
-                ++n;
+                for (; begin < end; begin += BLOCK_SIZE)
+                {
+                    const std::size_t block_end = std::min(begin + BLOCK_SIZE, end);
+                    DataCoStatistics block;
+                    block.x = SummarizeBlock(x + begin, x + block_end);
+                    block.y = SummarizeBlock(y + begin, y + block_end);
+                    block.sum_of_products = 0.;
+                    for (std::size_t i = begin; i < block_end; ++i)
+                        block.sum_of_products +=
+                                (x[i] - block.x.mean) * (y[i] - block.y.mean);
+
+                    const double dx = block.x.mean - statistics.x.mean;
+                    const double dy = block.y.mean - statistics.y.mean;
+                    const unsigned long n = statistics.x.n;
+                    const unsigned long m = block.x.n;
+                    if (n == 0)
+                        statistics.sum_of_products = block.sum_of_products;
+                    else
+                        statistics.sum_of_products += block.sum_of_products +
+                                dx * dy * (double(n) * m / (n + m));
+                    Accumulate(statistics.x, block.x);
+                    Accumulate(statistics.y, block.y);
+                }
             });
+    return statistics;
+}
+
+DataStatistics::DataStatistics() :
+    n(0),
+    mean(std::numeric_limits<double>::quiet_NaN()),
+    sum_of_squares(0.),
+    min(std::numeric_limits<double>::quiet_NaN()),
+    max(std::numeric_limits<double>::quiet_NaN())
+{
+}
 
+double DataStatistics::Variance() const
+{
     if (n == 0)
         return std::numeric_limits<double>::quiet_NaN();
-    return std::sqrt(sum / (n - 1));
+    return sum_of_squares / (n - 1.);
 }
 
-double DataVector::CalcCorrelation(const DataVector& other,
-                                   const Mask& mask) const
+double DataStatistics::StdDev() const
 {
-    double sum = 0.;
-    unsigned n = 0;
-    double x_mean = CalcMean(mask);
-    double y_mean = other.CalcMean(mask);
-    MaskForEach(*vector_, *other.vector_, mask,
-            [&](const double& x, const double& y)
-            {
-                sum += (x - x_mean) * (y - y_mean);
-                ++n;
-            });
+    return std::sqrt(Variance());
+}
 
+void DataStatistics::Add(double x)
+{
     if (n == 0)
+    {
+        *this = DataStatistics();
+        mean = min = max = x;
+        n = 1;
+        return;
+    }
+    ++n;
+    const double delta = x - mean;
+    mean += delta / n;
+    sum_of_squares += delta * (x - mean);
+    min = std::min(min, x);
+    max = std::max(max, x);
+}
+
+bool DataStatistics::Remove(double x)
+{
+    assert(n > 0);
+    if (std::isnan(x) || !(x > min && x < max))
+        return false;
+    --n;
+    const double old_mean = mean;
+    mean -= (x - mean) / n;
+    sum_of_squares -= (x - mean) * (x - old_mean);
+    return true;
+}
+
+DataCoStatistics::DataCoStatistics() :
+    sum_of_products(0.)
+{
+}
+
+double DataCoStatistics::Covariance() const
+{
+    if (x.n == 0)
         return std::numeric_limits<double>::quiet_NaN();
-    return (sum / (n - 1)) / (CalcStdDev(mask) * other.CalcStdDev(mask));
+    return sum_of_products / (x.n - 1.);
 }
 
+double DataCoStatistics::Correlation() const
+{
+    return Covariance() / (x.StdDev() * y.StdDev());
+}
+
+void DataCoStatistics::Add(double x_value, double y_value)
+{
+    const double x_delta = x.n ? x_value - x.mean : 0.;
+    x.Add(x_value);
+    y.Add(y_value);
+    sum_of_products += x_delta * (y_value - y.mean);
+}
+
+bool DataCoStatistics::Remove(double x_value, double y_value)
+{
+    const double y_mean = y.mean;
+    if (!x.Remove(x_value) || !y.Remove(y_value))
+        return false;
+    sum_of_products -= (x_value - x.mean) * (y_value - y_mean);
+    return true;
+}
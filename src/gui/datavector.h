@@ -19,13 +19,183 @@
 #ifndef DATAVECTOR_H
 #define DATAVECTOR_H
 
+#include <boost/make_shared.hpp>
 #include <boost/serialization/serialization.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/version.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <initializer_list>
 #include <vector>
 
 class Mask;
+
+//! Kenngrößen einer maskierten Datenreihe.
+struct DataStatistics
+{
+    DataStatistics();
+
+    //! Gibt die Stichprobenvarianz zurück (NaN bei weniger als zwei Elementen).
+    double Variance() const;
+
+    //! Gibt die Standardabweichung der Stichprobe zurück.
+    double StdDev() const;
+
+    //! Nimmt einen Wert hinzu (Welford).
+    void Add(double x);
+
+    //! Entfernt einen zuvor hinzugenommenen Wert.
+    /*!
+      \return false, falls das nicht exakt möglich ist (der Wert war Minimum, Maximum oder NaN).
+      Die Kenngrößen müssen dann neu berechnet werden.
+      */
+    bool Remove(double x);
+
+    //! Anzahl der nicht maskierten Elemente.
+    unsigned long n;
+
+    //! Mittelwert (NaN falls n == 0).
+    double mean;
+
+    //! Summe der quadrierten Abweichungen vom Mittelwert.
+    double sum_of_squares;
+
+    //! Kleinster Wert (NaN falls n == 0).
+    double min;
+
+    //! Größter Wert (NaN falls n == 0).
+    double max;
+
+private:
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive& ar, const unsigned version)
+    {
+        ar & n
+           & mean
+           & sum_of_squares
+           & min
+           & max;
+    }
+};
+
+//! Gemeinsame Kenngrößen zweier maskierter Datenreihen.
+struct DataCoStatistics
+{
+    DataCoStatistics();
+
+    //! Gibt die Kovarianz der Stichprobe zurück.
+    double Covariance() const;
+
+    //! Gibt den Korrelationskoeffizienten nach Pearson zurück.
+    double Correlation() const;
+
+    //! Nimmt ein Wertepaar hinzu.
+    void Add(double x_value, double y_value);
+
+    //! Entfernt ein zuvor hinzugenommenes Wertepaar.
+    /*!
+      \return false, falls die Kenngrößen neu berechnet werden müssen (siehe DataStatistics::Remove()).
+      */
+    bool Remove(double x_value, double y_value);
+
+    DataStatistics x;
+    DataStatistics y;
+
+    //! Summe der Produkte der Abweichungen von den Mittelwerten.
+    double sum_of_products;
+
+private:
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive& ar, const unsigned version)
+    {
+        ar & x
+           & y
+           & sum_of_products;
+    }
+};
+
+//! Speicherblock, den sich mehrere Datenreihen teilen.
+/*!
+  Der Inhalt kann auch erst beim ersten Zugriff geladen werden, etwa aus einer
+  Ergebnisdatei. Der Zugriff ist threadsicher.
+  */
+class DataBlock
+{
+public:
+    //! Liefert den Inhalt eines noch nicht geladenen Blocks.
+    typedef std::function<std::vector<double>()> Loader;
+
+    explicit DataBlock(boost::shared_ptr<std::vector<double>> values);
+    explicit DataBlock(Loader loader);
+
+    //! Gibt die Werte zurück und lädt sie beim ersten Aufruf, falls nötig.
+    const boost::shared_ptr<std::vector<double>>& GetValues() const;
+
+    bool IsLoaded() const;
+
+private:
+    DataBlock(const DataBlock&) = delete;
+    DataBlock& operator=(const DataBlock&) = delete;
+
+    void Load() const;
+
+    mutable boost::shared_ptr<std::vector<double>> values_;
+    mutable Loader loader_;
+    mutable std::atomic<bool> loaded_;
+    mutable boost::mutex mutex_;
+};
+
+//! Lagert die Werte von Datenreihen beim Speichern und Laden aus.
+/*!
+  Solange für den aktuellen Thread ein DataBlockStore aktiv ist, schreiben und lesen
+  Datenreihen statt ihrer Werte nur die Nummer ihres Speicherblocks. Ein Dateiformat
+  kann die Blöcke so getrennt ablegen und erst bei Bedarf laden.
+  */
+class DataBlockStore
+{
+public:
+    virtual ~DataBlockStore() {}
+
+    //! Gibt die Nummer eines zu speichernden Blocks zurück.
+    /*!
+      Derselbe Block erhält bei jedem Aufruf dieselbe Nummer.
+      */
+    virtual unsigned Add(const boost::shared_ptr<std::vector<double>>& values) = 0;
+
+    //! Gibt den Block zurück, der beim Speichern die Nummer id erhalten hat.
+    virtual boost::shared_ptr<DataBlock> Get(unsigned id) = 0;
+
+    //! Gibt den für den aktuellen Thread aktiven DataBlockStore zurück oder nullptr.
+    static DataBlockStore* GetActive();
+
+    //! Aktiviert einen DataBlockStore für den aktuellen Thread, solange das Objekt existiert.
+    class Activation
+    {
+    public:
+        explicit Activation(DataBlockStore& store);
+        ~Activation();
+
+    private:
+        Activation(const Activation&) = delete;
+        Activation& operator=(const Activation&) = delete;
+
+        DataBlockStore* previous_;
+    };
+};
+
+//! Unveränderliche Datenreihe.
+/*!
+  Die Werte liegen in einem gemeinsam genutzten Speicherblock, von dem die Datenreihe einen
+  zusammenhängenden Ausschnitt darstellt. So können etwa alle Spalten einer Probe in einem
+  Block liegen.
+  */
 class DataVector
 {
 
@@ -34,22 +204,97 @@ public:
     DataVector(std::initializer_list<double> l);
     DataVector(boost::shared_ptr<std::vector<double>> v);
     DataVector(const std::vector<double>& data);
+
+    //! Erzeugt eine Datenreihe als Ausschnitt eines Speicherblocks.
+    /*!
+      \param block Speicherblock, dessen Größe sich danach nicht mehr ändern darf.
+      \param offset Index des ersten Elements im Block.
+      \param size Zahl der Elemente.
+      */
+    DataVector(boost::shared_ptr<std::vector<double>> block,
+               std::size_t offset,
+               std::size_t size);
+
+    //! Erzeugt eine Datenreihe als Ausschnitt eines unter Umständen noch nicht geladenen Blocks.
+    DataVector(boost::shared_ptr<DataBlock> block,
+               std::size_t offset,
+               std::size_t size);
     virtual ~DataVector();
 
+    std::size_t size() const;
+    const double* data() const;
+    const double* begin() const;
+    const double* end() const;
+    double operator[](std::size_t i) const;
+
+    //! Gibt den Speicherblock zurück, von dem die Datenreihe ein Ausschnitt ist.
+    const boost::shared_ptr<DataBlock>& GetBlock() const;
+
     double CalcMean(const Mask& mask) const;
     double CalcStdDev(const Mask& mask) const;
     double CalcCorrelation(const DataVector& other, const Mask& mask) const;
 
-    boost::shared_ptr<std::vector<double>> vector_;
+    //! Bestimmt Mittelwert, Varianz, Minimum und Maximum in einem Durchlauf.
+    /*!
+      Die Daten werden blockweise zusammengefasst und die Blöcke nach Chan et al. kombiniert.
+      Das ist numerisch stabil, ohne wie der Welford-Algorithmus jedes Element einzeln in
+      den Mittelwert einzurechnen.
+      */
+    DataStatistics CalcStatistics(const Mask& mask) const;
+
+    //! Bestimmt die Kenngrößen beider Datenreihen und deren Kovarianz in einem Durchlauf.
+    DataCoStatistics CalcStatistics(const DataVector& other, const Mask& mask) const;
 
 private:
+    boost::shared_ptr<DataBlock> block_;
+    std::size_t offset_;
+    std::size_t size_;
 
     friend class boost::serialization::access;
     template<class Archive>
-    void serialize(Archive& ar, const unsigned version)
+    void save(Archive& ar, const unsigned version) const
+    {
+        const boost::shared_ptr<std::vector<double>>& values = block_->GetValues();
+        if (DataBlockStore* store = DataBlockStore::GetActive())
+        {
+            unsigned id = store->Add(values);
+            ar << id;
+        }
+        else
+            ar << values;
+        ar << offset_
+           << size_;
+    }
+
+    template<class Archive>
+    void load(Archive& ar, const unsigned version)
     {
-        ar & vector_;
+        if (DataBlockStore* store = DataBlockStore::GetActive())
+        {
+            unsigned id;
+            ar >> id;
+            block_ = store->Get(id);
+        }
+        else
+        {
+            boost::shared_ptr<std::vector<double>> values;
+            ar >> values;
+            block_ = boost::make_shared<DataBlock>(values);
+        }
+        if (version >= 1)
+            ar >> offset_
+               >> size_;
+        else
+        {
+            // Bis Version 0 gehörte jeder Datenreihe ein eigener Vektor.
+            offset_ = 0;
+            size_ = block_->GetValues()->size();
+        }
     }
+
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
+BOOST_CLASS_VERSION(DataVector, 1)
+
 #endif // DATAVECTOR_H
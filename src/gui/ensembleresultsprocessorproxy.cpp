@@ -30,7 +30,8 @@ EnsembleResultsProcessorProxy::EnsembleResultsProcessorProxy(
         const std::vector<std::string>& parameter_names,
         std::shared_ptr<FitResultsProcessor> processor) :
     parameter_names_(parameter_names),
-    processor_(processor)
+    processor_(processor),
+    monte_carlo_results_pool_()
 {
     if (!processor)
         throw std::invalid_argument(
@@ -62,7 +63,13 @@ void EnsembleResultsProcessorProxy::ProcessMonteCarloResult(
                       fit_parameter_names,
                       concentrations,
                       std::bind(&FitResultsProcessor::ProcessMonteCarloResult,
-                                processor_, _1, _2, _3, _4));
+                                processor_, _1, _2, _3, _4),
+                      &monte_carlo_results_pool_);
+}
+
+ResultsRequest EnsembleResultsProcessorProxy::GetMonteCarloResultsRequest() const
+{
+    return processor_->GetMonteCarloResultsRequest();
 }
 
 template<typename F>
@@ -71,7 +78,8 @@ void EnsembleResultsProcessorProxy::ConvertAndProcess(
             const std::vector<std::string>& sample_names,
             const std::vector<std::string>& fit_parameter_names,
             const std::vector<SampleConcentrations>& concentrations,
-            F function)
+            F function,
+            FitResultsPool* pool)
 {
     unsigned n_samples = sample_names.size();
     unsigned n_parameters = parameter_names_.size();
@@ -88,23 +96,27 @@ void EnsembleResultsProcessorProxy::ConvertAndProcess(
                                           i,
                                           fit_parameter_names);
         std::shared_ptr<FitResults> individual_results(
-                std::make_shared<FitResults>());
+                pool ? pool->Acquire() : std::make_shared<FitResults>());
         individual_results->chi_square = results->chi_square;
         individual_results->best_estimate =
                 SelectBestEstimates(results->best_estimate, parameter_indices);
         individual_results->deviations =
                 SelectBestEstimates(results->deviations, parameter_indices);
-        individual_results->covariance_matrix =  SelectCovariances(
-                results->covariance_matrix, parameter_indices);
+        individual_results->covariance_matrix =
+                results->SelectCovariances(parameter_indices);
         individual_results->n_iterations = results->n_iterations;
         individual_results->degrees_of_freedom = results->degrees_of_freedom;
         individual_results->exit_flag = results->exit_flag;
-        individual_results->model_concentrations =
-                {results->model_concentrations.at(i)};
-        individual_results->equilibrium_concentrations =
-                {results->equilibrium_concentrations.at(i)};
-        individual_results->measured_concentrations =
-                {results->measured_concentrations.at(i)};
+        // Zuweisung statt Neuanlegen, damit die Knoten wiederverwendeter Maps erhalten bleiben.
+        individual_results->model_concentrations.resize(1);
+        individual_results->model_concentrations[0] =
+                results->model_concentrations.at(i);
+        individual_results->equilibrium_concentrations.resize(1);
+        individual_results->equilibrium_concentrations[0] =
+                results->equilibrium_concentrations.at(i);
+        individual_results->measured_concentrations.resize(1);
+        individual_results->measured_concentrations[0] =
+                results->measured_concentrations.at(i);
         
         const unsigned n_residuals = concentrations.at(i).size();
         individual_results->residuals.resize(n_residuals);
@@ -169,16 +181,3 @@ Eigen::VectorXd EnsembleResultsProcessorProxy::SelectBestEstimates(
         selection(i) = all_estimates(parameter_indices[i]);
     return selection;
 }
-
-Eigen::MatrixXd EnsembleResultsProcessorProxy::SelectCovariances(
-        const Eigen::MatrixXd& all_covariances,
-        const std::vector<unsigned>& parameter_indices) const
-{
-    unsigned selection_size = parameter_indices.size();
-    Eigen::MatrixXd selection(selection_size, selection_size);
-    for (unsigned i = 0; i < selection_size; ++i)
-        for (unsigned j = 0; j < selection_size; ++j)
-            selection(i, j) = all_covariances(parameter_indices[i],
-                                              parameter_indices[j]);
-    return selection;
-}
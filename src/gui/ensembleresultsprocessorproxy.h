@@ -23,6 +23,7 @@
 
 #include <memory>
 
+#include "core/fitting/fitresultspool.h"
 #include "core/fitting/fitresultsprocessor.h"
 
 class EnsembleResultsProcessorProxy : public FitResultsProcessor
@@ -42,15 +43,22 @@ public:
             const std::vector<std::string>& sample_names,
             const std::vector<std::string>& fit_parameter_names,
             const std::vector<SampleConcentrations>& concentrations);
+    virtual ResultsRequest GetMonteCarloResultsRequest() const;
     
 private:
+    //! Zerlegt die Ergebnisse des Ensemblefits in die Ergebnisse der einzelnen Proben.
+    /*!
+      \param pool Vorrat für die Ergebnisse der einzelnen Proben. Darf nur angegeben werden,
+      wenn function die Ergebnisse nicht über den Aufruf hinaus behält.
+      */
     template<typename F>
     void ConvertAndProcess(
             std::shared_ptr<FitResults> results,
             const std::vector<std::string>& sample_names,
             const std::vector<std::string>& fit_parameter_names,
             const std::vector<SampleConcentrations>& concentrations,
-            F function);
+            F function,
+            FitResultsPool* pool = nullptr);
     
     //! \brief Bestimmt die Indices der Fitparameter die für die Probe
     //! sample_number relevant sind.
@@ -62,12 +70,12 @@ private:
     Eigen::VectorXd SelectBestEstimates(
             const Eigen::VectorXd& all_estimates,
             const std::vector<unsigned>& parameter_indices) const;
-    Eigen::MatrixXd SelectCovariances(
-            const Eigen::MatrixXd& all_covariances,
-            const std::vector<unsigned>& parameter_indices) const;
             
     std::vector<std::string> parameter_names_;
     std::shared_ptr<FitResultsProcessor> processor_;
+
+    //! Vorrat für die Ergebnisse der einzelnen Proben der Monte-Carlo-Fits.
+    FitResultsPool monte_carlo_results_pool_;
 };
 
 #endif // ENSEMBLERESULTSPROCESSORPROXY_H
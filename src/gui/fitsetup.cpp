@@ -55,6 +55,9 @@ FitSetup::FitSetup(QWidget* parent) :
                    {Gas::KR, true},
                    {Gas::XE, true}}),
     n_monte_carlos_(0U),
+    monte_carlo_column_types_(),
+    n_starts_(1U),
+    time_budget_(0.),
     name_(DEFAULT_NAME)
 {
     {
@@ -87,6 +90,9 @@ FitSetup::FitSetup(const FitSetup& other) :
     individually_configured_parameters_(
             other.individually_configured_parameters_),
     n_monte_carlos_(other.n_monte_carlos_),
+    monte_carlo_column_types_(other.monte_carlo_column_types_),
+    n_starts_(other.n_starts_),
+    time_budget_(other.time_budget_),
     name_(other.name_),
     combined_model_(other.combined_model_->clone())
 {
@@ -110,6 +116,9 @@ FitSetup& FitSetup::operator=(const FitSetup& other)
         individually_configured_parameters_ =
                 other.individually_configured_parameters_;
         n_monte_carlos_ = other.n_monte_carlos_;
+        monte_carlo_column_types_ = other.monte_carlo_column_types_;
+        n_starts_ = other.n_starts_;
+        time_budget_ = other.time_budget_;
         name_ = other.name_;
         combined_model_ = other.combined_model_->clone();
         
@@ -254,6 +263,37 @@ void FitSetup::SetNumberOfMonteCarlos(int n)
     n_monte_carlos_ = n;
 }
 
+unsigned FitSetup::GetNumberOfStarts() const
+{
+    return n_starts_;
+}
+
+void FitSetup::SetNumberOfStarts(int n)
+{
+    n_starts_ = std::max(n, 1);
+}
+
+double FitSetup::GetTimeBudget() const
+{
+    return time_budget_;
+}
+
+void FitSetup::SetTimeBudget(double seconds)
+{
+    time_budget_ = std::max(seconds, 0.);
+}
+
+const QList<ExtendedColumnType>& FitSetup::GetMonteCarloColumnTypes() const
+{
+    return monte_carlo_column_types_;
+}
+
+void FitSetup::SetMonteCarloColumnTypes(
+        const QList<ExtendedColumnType>& column_types)
+{
+    monte_carlo_column_types_ = column_types;
+}
+
 void FitSetup::SetName(QString name)
 {
     name_ = name;
@@ -473,7 +513,8 @@ std::shared_ptr<GuiResultsProcessor> FitSetup::SetupResultsProcessor()
             concentrations_->GetEnabledSampleNames(),
             parameters,
             gases_in_use,
-            n_monte_carlos_);
+            n_monte_carlos_,
+            monte_carlo_column_types_);
 }
 
 std::vector<FitConfiguration> FitSetup::PrepareFitConfigurations() const
@@ -525,7 +566,7 @@ FitConfiguration FitSetup::PrepareFitConfigurationCommons() const
         if (parameter_fit_states_.at(parameter))
         {
             config.fit_parameter_config.AddParameter(
-                    FitParameter(parameter, value));
+                    CreateFitParameter(parameter, parameter, value));
             model_parameters.push_back(ModelParameterConfig(parameter,
                                                             parameter));
         }
@@ -534,10 +575,25 @@ FitConfiguration FitSetup::PrepareFitConfigurationCommons() const
     }
     config.model_parameter_configs = {model_parameters};
     config.n_monte_carlos = n_monte_carlos_;
+    config.multi_start_settings.n_starts = n_starts_;
+    config.multi_start_settings.time_budget = time_budget_;
     
     return config;
 }
 
+FitParameter FitSetup::CreateFitParameter(const std::string& model_parameter,
+                                          const std::string& name,
+                                          double value) const
+{
+    for (const auto& parameter : combined_model_->GetParametersInOrder())
+        if (parameter.name == model_parameter)
+            return FitParameter(name,
+                                value,
+                                parameter.lowest_normal_value,
+                                parameter.highest_normal_value);
+    return FitParameter(name, value);
+}
+
 FitConfiguration FitSetup::PrepareEnsembleFitConfiguration()
 {
     std::vector<std::string> ensemble_fitted;
@@ -550,13 +606,15 @@ FitConfiguration FitSetup::PrepareEnsembleFitConfiguration()
     config.model = combined_model_;
     if (!n_samples) return config;
     config.n_monte_carlos = n_monte_carlos_;
+    config.multi_start_settings.n_starts = n_starts_;
+    config.multi_start_settings.time_budget = time_budget_;
     config.model_parameter_configs.resize(n_samples);
     
     for (const auto& parameter : ensemble_fitted)
     {
         double value = parameter_values_.at(parameter);
         config.fit_parameter_config.AddParameter(
-                FitParameter(parameter, value));
+                CreateFitParameter(parameter, parameter, value));
     }
     
     for (unsigned i = 0; i < n_samples; ++i)
@@ -576,9 +634,10 @@ FitConfiguration FitSetup::PrepareEnsembleFitConfiguration()
                            individually_fitted.end(),
                            parameter))
                 config.fit_parameter_config.AddParameter(
-                        FitParameter(parameter +
-                                         boost::lexical_cast<std::string>(i),
-                                     value));
+                        CreateFitParameter(parameter,
+                                           parameter +
+                                               boost::lexical_cast<std::string>(i),
+                                           value));
                 
             if (parameter_fit_states_.at(parameter))
             {
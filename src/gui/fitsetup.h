@@ -21,6 +21,7 @@
 
 #include <QString>
 
+#include <boost/serialization/list.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/split_member.hpp>
 
@@ -54,6 +55,20 @@ public:
     
     unsigned GetNumberOfMonteCarlos() const;
     
+    //! Zahl der Startpunkte je Fit (siehe MultiStartFitter).
+    unsigned GetNumberOfStarts() const;
+    
+    //! Rechenzeit in Sekunden für die Startpunkte eines Fits, 0 für unbegrenzt.
+    double GetTimeBudget() const;
+    
+    //! Für jeden Monte-Carlo-Fit zu speichernde Spalten, leer für alle.
+    /*!
+     * Nur für die hier enthaltenen Spalten werden die Gaskonzentrationen der
+     * Monte-Carlo-Fits berechnet (siehe MonteCarloResultsModel).
+     */
+    const QList<ExtendedColumnType>& GetMonteCarloColumnTypes() const;
+    void SetMonteCarloColumnTypes(const QList<ExtendedColumnType>& column_types);
+    
     const std::map<GasType, bool>& GetGasesInUse() const;
     void SetGasInUse(GasType gas, bool use);
     
@@ -81,6 +96,14 @@ public:
     QString GetName() const;
     bool AreConstraintsApplied() const;
     
+    //! Konzentrationen der aktivierten Proben, ohne die nicht verwendeten Gase.
+    RunData PrepareGasConcentrations() const;
+    //! Je aktivierter Probe eine Fitkonfiguration für DefaultFitter.
+    /*!
+     * \throws ParameterSetupModel::ParameterNotInHeaderError
+     */
+    std::vector<FitConfiguration> PrepareFitConfigurations() const;
+    
 public slots:
     void Fit();
     void EnsembleFit();
@@ -88,6 +111,8 @@ public slots:
     void LoadSamplesFromFile();
     void LoadSamplesFromClipboard();
     void SetNumberOfMonteCarlos(int n);
+    void SetNumberOfStarts(int n);
+    void SetTimeBudget(double seconds);
     void SetName(QString name);
     void SetApplyConstraints(bool apply);
     
@@ -100,10 +125,13 @@ private:
     void ResetModel();
     
     template<class A> void DoForEachUnusedGas(A a) const;
-    RunData PrepareGasConcentrations() const;
     std::shared_ptr<GuiResultsProcessor> SetupResultsProcessor();
-    std::vector<FitConfiguration> PrepareFitConfigurations() const;
     FitConfiguration PrepareFitConfigurationCommons() const;
+    //! \brief Erzeugt einen Fitparameter, dessen Startpunkte für Multistart-Fits
+    //! aus dem normalen Wertebereich des Modellparameters gewählt werden.
+    FitParameter CreateFitParameter(const std::string& model_parameter,
+                                    const std::string& name,
+                                    double value) const;
     FitConfiguration PrepareEnsembleFitConfiguration();
     void DetermineEnsembleAndIndividuallyFittedParameters(
             std::vector<std::string>& ensemble_fitted,
@@ -137,6 +165,12 @@ private:
 
     unsigned n_monte_carlos_;
     
+    QList<ExtendedColumnType> monte_carlo_column_types_;
+    
+    unsigned n_starts_;
+    
+    double time_budget_;
+    
     QString name_;
 
     std::shared_ptr<CombinedModel> combined_model_;
@@ -174,6 +208,12 @@ void FitSetup::save(Archive& ar, const unsigned version) const
        << individually_configured_parameters_
        << n_monte_carlos_
        << name_;
+    
+    std::list<ExtendedColumnType> monte_carlo_column_types =
+            monte_carlo_column_types_.toStdList();
+    ar << monte_carlo_column_types
+       << n_starts_
+       << time_budget_;
 }
 
 template<class Archive>
@@ -207,12 +247,32 @@ void FitSetup::load(Archive& ar, const unsigned version)
     else
         name_ = DEFAULT_NAME;
     
+    if (version >= 3)
+    {
+        std::list<ExtendedColumnType> monte_carlo_column_types;
+        ar >> monte_carlo_column_types;
+        monte_carlo_column_types_ =
+                QList<ExtendedColumnType>::fromStdList(monte_carlo_column_types);
+    }
+    else
+        monte_carlo_column_types_.clear();
+    
+    if (version >= 4)
+        ar >> n_starts_;
+    else
+        n_starts_ = 1;
+    
+    if (version >= 5)
+        ar >> time_budget_;
+    else
+        time_budget_ = 0.;
+    
     concentrations_ = concentrations_model_->GetRunData();
     concentrations_model_->setParent(this);
     parameter_setup_model_->setParent(this);
     ConnectSignalsAndSlots();
 }
 
-BOOST_CLASS_VERSION(FitSetup, 2)
+BOOST_CLASS_VERSION(FitSetup, 5)
 
 #endif // FITSETUP_H
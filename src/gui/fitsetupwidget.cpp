@@ -16,9 +16,13 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDoubleValidator>
 #include <QGridLayout>
+#include <QLabel>
 #include <QLineEdit>
+#include <QListWidget>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QScrollBar>
@@ -26,6 +30,7 @@
 #include <QAction>
 
 #include <algorithm>
+#include <set>
 
 #include "core/models/modelmanager.h"
 #include "core/models/ceqmethodmanager.h"
@@ -33,8 +38,10 @@
 #include "commons.h"
 #include "concentrationsheaderview.h"
 #include "fitsetup.h"
+#include "montecarloresultsmodel.h"
 #include "montecarlosummaryproxymodel.h"
 #include "parametercheckbox.h"
+#include "standardfitresultsmodel.h"
 
 #include "fitsetupwidget.h"
 #include "ui_fitsetupwidget.h"
@@ -110,6 +117,9 @@ void FitSetupWidget::SetFitSetup(FitSetup* fit_setup)
     UpdateParameters();
     UpdateConstrainedFitCheckbox();
     ui->n_monte_carlos_spin_box->setValue(fit_setup_->GetNumberOfMonteCarlos());
+    UpdateMonteCarloColumnsButton();
+    ui->n_starts_spin_box->setValue(fit_setup_->GetNumberOfStarts());
+    ui->time_budget_spin_box->setValue(fit_setup_->GetTimeBudget());
 
     connect(fit_setup_->GetConcentrationsModel(), SIGNAL(modelReset()),
             ui->concentrations_view, SLOT(resizeColumnsToContents()));
@@ -123,8 +133,15 @@ void FitSetupWidget::SetFitSetup(FitSetup* fit_setup)
             this, SLOT(UpdateConstrainedFitCheckbox()));
     connect(ui->n_monte_carlos_spin_box, SIGNAL(valueChanged(int)),
             fit_setup_, SLOT(SetNumberOfMonteCarlos(int)));
+    connect(ui->n_starts_spin_box, SIGNAL(valueChanged(int)),
+            fit_setup_, SLOT(SetNumberOfStarts(int)));
+    connect(ui->time_budget_spin_box, SIGNAL(valueChanged(double)),
+            fit_setup_, SLOT(SetTimeBudget(double)));
     connect(ui->constrained_fit_checkbox, SIGNAL(toggled(bool)),
             fit_setup_, SLOT(SetApplyConstraints(bool)));
+    disconnect(ui->monte_carlo_columns_button, 0, 0, 0);
+    connect(ui->monte_carlo_columns_button, SIGNAL(clicked()),
+            this, SLOT(SelectMonteCarloColumns()));
 
     //ui->name_lineedit kann hier schon verbunden sein mit this->EmitNameChanged
     //da es immer erst nach fit_setup_->SetName ausgeführt werden soll, wird es
@@ -158,6 +175,9 @@ void FitSetupWidget::MakeImmutable()
 
     ui->constrained_fit_checkbox->setEnabled(false);
     ui->n_monte_carlos_spin_box->setEnabled(false);
+    ui->monte_carlo_columns_button->setEnabled(false);
+    ui->n_starts_spin_box->setEnabled(false);
+    ui->time_budget_spin_box->setEnabled(false);
 
     ConcentrationsHeaderView* concentrations_header =
             qobject_cast<ConcentrationsHeaderView*>(
@@ -300,6 +320,75 @@ void FitSetupWidget::ChangeParameterIndividuallyConfigured()
                                                    checkbox->isChecked());
 }
 
+void FitSetupWidget::SelectMonteCarloColumns()
+{
+    std::set<GasType> gases_in_use;
+    for (const auto& gas : fit_setup_->GetGasesInUse())
+        if (gas.second) gases_in_use.insert(gas.first);
+    // Wird nur für die Spaltennamen benötigt.
+    StandardFitResultsModel names_model({}, {}, gases_in_use);
+
+    const QList<ExtendedColumnType>& selected = fit_setup_->GetMonteCarloColumnTypes();
+    QList<ExtendedColumnType> column_types;
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Monte Carlo columns");
+    QListWidget* list_widget = new QListWidget(&dialog);
+    for (const auto& column_type : names_model.GetDoubleColumnTypes())
+    {
+        if (MonteCarloResultsModel::IsAlwaysStored(column_type))
+            continue;
+        column_types.push_back(column_type);
+        QListWidgetItem* item = new QListWidgetItem(
+                names_model.GetColumnName(column_type), list_widget);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(selected.isEmpty() || selected.contains(column_type) ?
+                            Qt::Checked : Qt::Unchecked);
+    }
+    QDialogButtonBox* button_box = new QDialogButtonBox(
+            QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, &dialog);
+    connect(button_box, SIGNAL(accepted()), &dialog, SLOT(accept()));
+    connect(button_box, SIGNAL(rejected()), &dialog, SLOT(reject()));
+    QVBoxLayout* layout = new QVBoxLayout(&dialog);
+    layout->addWidget(new QLabel("Columns stored for each Monte Carlo fit "
+                                 "(parameters are always stored):", &dialog));
+    layout->addWidget(list_widget);
+    layout->addWidget(button_box);
+
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    QList<ExtendedColumnType> checked;
+    for (int i = 0; i < column_types.size(); ++i)
+        if (list_widget->item(i)->checkState() == Qt::Checked)
+            checked.push_back(column_types[i]);
+
+    if (checked.size() == column_types.size())
+        checked.clear();
+    else if (checked.isEmpty())
+        // Eine leere Liste steht für alle Spalten. Die Parameterschätzungen
+        // werden ohnehin immer gespeichert.
+        checked.push_back({ColumnType::PARAMETER_ESTIMATE, 0});
+
+    fit_setup_->SetMonteCarloColumnTypes(checked);
+    UpdateMonteCarloColumnsButton();
+}
+
+void FitSetupWidget::UpdateMonteCarloColumnsButton()
+{
+    const QList<ExtendedColumnType>& selected = fit_setup_->GetMonteCarloColumnTypes();
+    const int n_selected = std::count_if(
+            selected.begin(),
+            selected.end(),
+            [](const ExtendedColumnType& c)
+            {
+                return !MonteCarloResultsModel::IsAlwaysStored(c);
+            });
+    ui->monte_carlo_columns_button->setText(
+            selected.isEmpty() ? QString("All") :
+                                 QString("%1 selected").arg(n_selected));
+}
+
 void FitSetupWidget::EmitNameChanged(QString name)
 {
     emit NameChanged(name);
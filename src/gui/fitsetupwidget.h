@@ -74,12 +74,15 @@ private:
     void ClearLayout(QLayout* layout);
     void InitializeParameterInitialsAndValues();
     void UpdateGasesInUse();
+    void UpdateMonteCarloColumnsButton();
 
 private slots:
     void ChangeGasInUse();
     void ChangeParameterValue();
     void ChangeParameterIndividuallyConfigured();
     void EmitNameChanged(QString name);
+    //! Lässt den Benutzer die für Monte-Carlo-Fits zu speichernden Spalten wählen.
+    void SelectMonteCarloColumns();
     void SetActiveModel();
     void UpdateParameters();
     void UpdateInitialsAndValues();
@@ -21,6 +21,7 @@
 #include <boost/make_shared.hpp>
 
 #include <algorithm>
+#include <typeinfo>
 
 #include "commons.h"
 #include "montecarloresultsmodel.h"
@@ -32,7 +33,8 @@ GuiResultsProcessor::GuiResultsProcessor(
         const std::vector<std::string>& sample_names,
         const std::vector<ModelParameter>& parameters,
         const std::set<GasType>& gases_in_use,
-        unsigned n_monte_carlos) :
+        unsigned n_monte_carlos,
+        const QList<ExtendedColumnType>& monte_carlo_column_types) :
     results_model_(nullptr),
     monte_carlo_results_model_(nullptr),
     samples_processed_(0U),
@@ -51,7 +53,9 @@ GuiResultsProcessor::GuiResultsProcessor(
             q_sample_names,
             parameters,
             gases_in_use,
-            n_monte_carlos);
+            n_monte_carlos,
+            0,
+            monte_carlo_column_types);
 }
 
 GuiResultsProcessor::~GuiResultsProcessor()
@@ -68,7 +72,14 @@ void GuiResultsProcessor::ProcessResult(
         const std::vector<std::string>& parameter_names,
         const std::vector<SampleConcentrations>& concentrations)
 {
-    results_model_->ProcessResult(boost::make_shared<FitResults>(*results),
+    // Das Modell speichert boost::shared_ptr. Ist results kein abgeleiteter Typ, wird das
+    // Objekt geteilt, statt es zu kopieren; der Deleter hält den std::shared_ptr am Leben.
+    boost::shared_ptr<FitResults> stored_results(
+            typeid(*results) == typeid(FitResults) ?
+                boost::shared_ptr<FitResults>(results.get(),
+                                              [results](FitResults*) {}) :
+                boost::make_shared<FitResults>(*results));
+    results_model_->ProcessResult(stored_results,
                                   sample_names,
                                   parameter_names, concentrations);
 }
@@ -80,13 +91,18 @@ void GuiResultsProcessor::ProcessMonteCarloResult(
         const std::vector<SampleConcentrations>& concentrations)
 {
     monte_carlo_results_model_->ProcessMonteCarloResult(
-            results, sample_names, parameter_names, concentrations);
+            *results, sample_names, parameter_names, concentrations);
 
     QCoreApplication::processEvents();
     if (was_interrupted_) throw InterruptedByUser();
     emit MonteCarloResultProcessed(++samples_processed_);
 }
 
+ResultsRequest GuiResultsProcessor::GetMonteCarloResultsRequest() const
+{
+    return monte_carlo_results_model_->GetResultsRequest();
+}
+
 QAbstractTableModel* GuiResultsProcessor::GetResultsModel() const
 {
     return results_model_;
@@ -28,6 +28,8 @@
 #include "core/fitting/fitresultsprocessor.h"
 #include "core/models/modelparameter.h"
 
+#include "resultsmodel.h"
+
 class MonteCarloResultsModel;
 class StandardFitResultsModel;
 class QAbstractTableModel;
@@ -42,11 +44,15 @@ public:
     /*!
      * Der Parameter parent wird nur an die erzeugten Modelle weitergeleitet.
      * Diese Klasse hier muss immer selbständig gelöscht werden.
+     * \param monte_carlo_column_types Für Monte-Carlo-Fits zu speichernde
+     * Spalten, leer für alle (siehe MonteCarloResultsModel).
      */ 
     GuiResultsProcessor(const std::vector<std::string>& sample_names,
                         const std::vector<ModelParameter>& parameters,
                         const std::set<GasType>& gases_in_use,
-                        unsigned n_monte_carlos);
+                        unsigned n_monte_carlos,
+                        const QList<ExtendedColumnType>& monte_carlo_column_types =
+                            QList<ExtendedColumnType>());
     virtual ~GuiResultsProcessor();
     
     void ProcessResult(
@@ -60,6 +66,8 @@ public:
             const std::vector<std::string>& sample_names,
             const std::vector<std::string>& parameter_names,
             const std::vector<SampleConcentrations>& concentrations);
+
+    ResultsRequest GetMonteCarloResultsRequest() const;
     
     QAbstractTableModel* GetResultsModel() const;
     QAbstractTableModel* GetMonteCarloResultsModel() const;
@@ -0,0 +1,225 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+#include "core/misc/defines.h"
+
+#include "datavector.h"
+#include "mask.h"
+
+#include "histogrambuilder2d.h"
+
+namespace
+{
+// 2 x 15 Bit, damit OUTSIDE keiner gültigen Zelle entspricht.
+const unsigned RESOLUTION_BITS = 15;
+const std::uint32_t RESOLUTION = 1u << RESOLUTION_BITS;
+const std::uint32_t OUTSIDE = ~std::uint32_t(0);
+
+//! Unterhalb dieser Zahl von Punkten je Thread lohnt sich kein weiterer Thread.
+const std::size_t MIN_POINTS_PER_CHUNK = 1 << 16;
+
+//! Bildet einen Wert im Ausschnitt [min, max] auf eine Zelle des feinen Rasters ab.
+inline std::uint32_t QuantizeValue(double value, double min, double scale)
+{
+    std::uint32_t cell = static_cast<std::uint32_t>((value - min) * scale);
+    return std::min(cell, RESOLUTION - 1);
+}
+
+//! Führt func(first, last, chunk) für alle Teilbereiche aus, ab dem zweiten in eigenen Threads.
+template<class Function>
+void ForEachChunk(unsigned n_chunks,
+                  std::function<std::size_t(unsigned)> chunk_begin,
+                  Function func)
+{
+    boost::thread_group threads;
+    try
+    {
+        for (unsigned chunk = 1; chunk < n_chunks; ++chunk)
+            threads.create_thread(std::bind(func,
+                                            chunk_begin(chunk),
+                                            chunk_begin(chunk + 1),
+                                            chunk));
+        func(chunk_begin(0), chunk_begin(1), 0);
+    }
+    catch (...)
+    {
+        threads.join_all();
+        throw;
+    }
+    threads.join_all();
+}
+}
+
+HistogramBuilder2D::HistogramBuilder2D(
+        boost::shared_ptr<const DataVector> x_data,
+        boost::shared_ptr<const DataVector> y_data) :
+    x_data_(x_data),
+    y_data_(y_data),
+    n_threads_(0),
+    window_valid_(false),
+    min_x_(0.),
+    max_x_(0.),
+    min_y_(0.),
+    max_y_(0.)
+{
+    assert(x_data_->size() == y_data_->size());
+}
+
+void HistogramBuilder2D::SetWindow(double min_x, double max_x,
+                                   double min_y, double max_y)
+{
+    if (window_valid_ &&
+        min_x == min_x_ && max_x == max_x_ &&
+        min_y == min_y_ && max_y == max_y_)
+        return;
+
+    min_x_ = min_x;
+    max_x_ = max_x;
+    min_y_ = min_y;
+    max_y_ = max_y;
+    cells_.resize(x_data_->size());
+
+    const unsigned n_chunks = NumberOfChunks();
+    ForEachChunk(n_chunks,
+                 [&](unsigned chunk) { return ChunkBegin(chunk, n_chunks); },
+                 [&](std::size_t first, std::size_t last, unsigned)
+                 {
+                     Quantize(first, last);
+                 });
+    window_valid_ = true;
+}
+
+void HistogramBuilder2D::SetNumberOfThreads(unsigned n_threads)
+{
+    n_threads_ = n_threads;
+}
+
+std::vector<unsigned> HistogramBuilder2D::Build(unsigned bins,
+                                                const Mask& mask) const
+{
+    assert(window_valid_);
+    assert(bins > 0 && bins <= RESOLUTION);
+
+    const unsigned n_chunks = NumberOfChunks();
+    std::vector<std::vector<unsigned>> partial_counts(n_chunks);
+    ForEachChunk(n_chunks,
+                 [&](unsigned chunk) { return ChunkBegin(chunk, n_chunks); },
+                 [&](std::size_t first, std::size_t last, unsigned chunk)
+                 {
+                     Count(first, last, bins, mask, partial_counts[chunk]);
+                 });
+
+    std::vector<unsigned> counts(std::move(partial_counts[0]));
+    for (unsigned chunk = 1; chunk < n_chunks; ++chunk)
+        for (std::size_t i = 0; i < counts.size(); ++i)
+            counts[i] += partial_counts[chunk][i];
+    return counts;
+}
+
+noble_align_function void HistogramBuilder2D::Quantize(std::size_t first,
+                                                       std::size_t last)
+{
+    const DataVector& x = *x_data_;
+    const DataVector& y = *y_data_;
+    const double scale_x = max_x_ > min_x_ ? RESOLUTION / (max_x_ - min_x_) : 0.;
+    const double scale_y = max_y_ > min_y_ ? RESOLUTION / (max_y_ - min_y_) : 0.;
+    for (std::size_t i = first; i < last; ++i)
+    {
+        // Negiert formuliert, damit auch NaNs außerhalb liegen.
+        if (!(x[i] >= min_x_ && x[i] <= max_x_ && y[i] >= min_y_ && y[i] <= max_y_))
+        {
+            cells_[i] = OUTSIDE;
+            continue;
+        }
+        cells_[i] = QuantizeValue(x[i], min_x_, scale_x) << RESOLUTION_BITS |
+                    QuantizeValue(y[i], min_y_, scale_y);
+    }
+}
+
+noble_align_function void HistogramBuilder2D::Count(
+        std::size_t first,
+        std::size_t last,
+        unsigned bins,
+        const Mask& mask,
+        std::vector<unsigned>& counts) const
+{
+    counts.assign(std::size_t(bins) * bins, 0);
+    MaskForEachRange(first, last, mask,
+            [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    const std::uint32_t cell = cells_[i];
+                    if (cell != OUTSIDE)
+                        ++counts[FindBin(cell, bins)];
+                }
+            });
+}
+
+void HistogramBuilder2D::UpdateCounts(const std::vector<unsigned long>& toggled,
+                                      const Mask& mask,
+                                      unsigned bins,
+                                      std::vector<unsigned>& counts) const
+{
+    assert(window_valid_);
+    assert(counts.size() == std::size_t(bins) * bins);
+    for (unsigned long i : toggled)
+    {
+        const std::uint32_t cell = cells_[i];
+        if (cell == OUTSIDE)
+            continue;
+        if (mask.IsEnabled(i))
+            ++counts[FindBin(cell, bins)];
+        else
+            --counts[FindBin(cell, bins)];
+    }
+}
+
+inline std::size_t HistogramBuilder2D::FindBin(std::uint32_t cell, unsigned bins)
+{
+    const std::uint64_t index_x =
+            (std::uint64_t(cell >> RESOLUTION_BITS) * bins) >> RESOLUTION_BITS;
+    const std::uint64_t index_y =
+            (std::uint64_t(cell & (RESOLUTION - 1)) * bins) >> RESOLUTION_BITS;
+    return index_x + bins * index_y;
+}
+
+unsigned HistogramBuilder2D::NumberOfChunks() const
+{
+    unsigned n_threads = n_threads_;
+    if (n_threads == 0)
+        n_threads = std::max(1u, boost::thread::hardware_concurrency());
+    const std::size_t size = cells_.size();
+    const std::size_t n_useful = std::max<std::size_t>(1, size / MIN_POINTS_PER_CHUNK);
+    return static_cast<unsigned>(std::min<std::size_t>(n_threads, n_useful));
+}
+
+std::size_t HistogramBuilder2D::ChunkBegin(unsigned chunk, unsigned n_chunks) const
+{
+    // Auf ganze Wörter der gepackten Maske ausgerichtet.
+    const std::size_t size = cells_.size();
+    if (chunk >= n_chunks)
+        return size;
+    return std::min(size, (size * chunk / n_chunks) & ~std::size_t(63));
+}
@@ -0,0 +1,110 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HISTOGRAMBUILDER2D_H
+#define HISTOGRAMBUILDER2D_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class DataVector;
+class Mask;
+
+//! Zählt die Punkte zweier Datenreihen parallel in die Bins eines 2D-Histogramms.
+/*!
+  Beim Setzen eines neuen Ausschnitts werden alle Punkte einmal auf ein feines Raster von
+  2^15 x 2^15 Zellen quantisiert. Das Zählen für eine beliebige Binzahl besteht danach nur
+  noch aus Ganzzahloperationen. Die Bingrenzen sind dadurch auf 2^-15 der Ausschnittsbreite
+  genau, bei Binzahlen, die Zweierpotenzen sind, exakt. Jeder Thread zählt einen Teil der Punkte in ein eigenes
+  Histogramm, die am Ende addiert werden.
+  */
+class HistogramBuilder2D
+{
+public:
+    //! Konstruktor.
+    /*!
+      \param x_data Daten der x-Achse.
+      \param y_data Daten der y-Achse, gleich lang wie x_data.
+      */
+    HistogramBuilder2D(boost::shared_ptr<const DataVector> x_data,
+                       boost::shared_ptr<const DataVector> y_data);
+
+    //! Legt den Ausschnitt fest und quantisiert alle Punkte, falls er sich geändert hat.
+    void SetWindow(double min_x, double max_x, double min_y, double max_y);
+
+    //! Legt die Zahl der Threads fest (0: so viele wie Prozessorkerne).
+    void SetNumberOfThreads(unsigned n_threads);
+
+    //! Zählt die nicht maskierten Punkte im Ausschnitt je Bin.
+    /*!
+      Punkte auf dem oberen Rand des Ausschnitts werden dem letzten Bin zugeordnet.
+      \param bins Zahl der Bins je Achse (höchstens 2^15).
+      \param mask Zu verwendende Maske.
+      \return bins * bins Zählerstände, Index index_x + bins * index_y.
+      */
+    std::vector<unsigned> Build(unsigned bins, const Mask& mask) const;
+
+    //! Passt mit Build() erzeugte Zählerstände an eine Maskenänderung an.
+    /*!
+      \param toggled Indizes der umgeschalteten Punkte.
+      \param mask Geänderte Maske.
+      \param bins Zahl der Bins je Achse, wie beim Aufruf von Build().
+      \param counts Zu aktualisierende Zählerstände.
+      */
+    void UpdateCounts(const std::vector<unsigned long>& toggled,
+                      const Mask& mask,
+                      unsigned bins,
+                      std::vector<unsigned>& counts) const;
+
+private:
+    //! Quantisiert die Punkte in [first, last).
+    void Quantize(std::size_t first, std::size_t last);
+
+    //! Zählt die nicht maskierten Punkte in [first, last) in counts.
+    void Count(std::size_t first,
+               std::size_t last,
+               unsigned bins,
+               const Mask& mask,
+               std::vector<unsigned>& counts) const;
+
+    //! Gibt den Index des Bins zurück, in dem die quantisierte Zelle liegt.
+    static std::size_t FindBin(std::uint32_t cell, unsigned bins);
+
+    //! Gibt die Zahl der Teilbereiche zurück, in die die Punkte aufgeteilt werden.
+    unsigned NumberOfChunks() const;
+
+    //! Gibt den Anfang des Teilbereichs chunk von n_chunks zurück.
+    std::size_t ChunkBegin(unsigned chunk, unsigned n_chunks) const;
+
+    boost::shared_ptr<const DataVector> x_data_;
+    boost::shared_ptr<const DataVector> y_data_;
+    unsigned n_threads_;
+
+    bool window_valid_;
+    double min_x_;
+    double max_x_;
+    double min_y_;
+    double max_y_;
+
+    //! Quantisierte Punkte, (x << 15) | y, oder OUTSIDE für Punkte außerhalb des Ausschnitts.
+    std::vector<std::uint32_t> cells_;
+};
+
+#endif // HISTOGRAMBUILDER2D_H
@@ -29,11 +29,13 @@ HistogramDataBase::HistogramDataBase(
     bin_number_(0),
     default_bin_number_(n_bins_default),
     cache_invalid(true),
+    statistics_invalid_(true),
+    n_incremental_changes_(0),
     mask_(mask),
     selection_inverted_(false)
 {
     connect(mask_.get(), SIGNAL(MaskChanged()),
-            this, SLOT(InvalidateCachedHistogram()));
+            this, SLOT(HandleMaskChange()));
     connect(&default_bin_number_, SIGNAL(BinNumberChanged()),
             this, SLOT(InvalidateCachedHistogram()));
     connect(&default_bin_number_, SIGNAL(BinNumberChanged()),
@@ -136,6 +138,41 @@ void HistogramDataBase::InvalidateCachedHistogram()
     emit HistogramChanged();
 }
 
+void HistogramDataBase::HandleMaskChange()
+{
+    const std::vector<unsigned long>& toggled = mask_->GetToggledElements();
+
+    // Kleine Änderungen werden eingearbeitet, große sind durch eine Neuberechnung schneller.
+    // Damit sich Rundungsfehler der Kenngrößen nicht beliebig aufsummieren, wird spätestens
+    // nach size umgeschalteten Elementen ebenfalls neu berechnet.
+    const bool incremental =
+            toggled.size() * 4 < size &&
+            n_incremental_changes_ + toggled.size() < size &&
+            UpdateForMaskChange(toggled);
+
+    if (incremental)
+    {
+        n_incremental_changes_ += toggled.size();
+        emit HistogramChanged();
+    }
+    else
+    {
+        n_incremental_changes_ = 0;
+        statistics_invalid_ = true;
+        InvalidateCachedHistogram();
+    }
+}
+
+bool HistogramDataBase::UpdateForMaskChange(const std::vector<unsigned long>&)
+{
+    return false;
+}
+
+void HistogramDataBase::InvalidateCachedStatistics()
+{
+    statistics_invalid_ = true;
+}
+
 void HistogramDataBase::MakeCacheValid() const
 {
     cache_invalid = false;
@@ -146,6 +183,16 @@ bool HistogramDataBase::IsCacheInvalid() const
     return cache_invalid;
 }
 
+void HistogramDataBase::MakeStatisticsValid() const
+{
+    statistics_invalid_ = false;
+}
+
+bool HistogramDataBase::AreStatisticsInvalid() const
+{
+    return statistics_invalid_;
+}
+
 const unsigned int& HistogramDataBase::GetPlotSpecificBinNumber() const
 {
     return bin_number_;
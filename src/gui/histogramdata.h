@@ -98,18 +98,36 @@ protected:
     void EndEditMask();
     void MakeCacheValid() const;
     bool IsCacheInvalid() const;
+    //! Passt Histogramm und Kenngrößen an eine Maskenänderung an.
+    /*!
+      Wird nur aufgerufen, wenn sich eine schrittweise Aktualisierung lohnt.
+      \param toggled Indizes der umgeschalteten Elemente.
+      \return false, falls stattdessen alles neu berechnet werden soll.
+      */
+    virtual bool UpdateForMaskChange(const std::vector<unsigned long>& toggled);
+    //! Markiert die zwischengespeicherten Kenngrößen (Mittelwert usw.) als gültig.
+    void MakeStatisticsValid() const;
+    //! Gibt zurück, ob die Kenngrößen seit der letzten Maskenänderung neu berechnet wurden.
+    bool AreStatisticsInvalid() const;
     void UseDefaultBinNumber(bool use_default_bin_number);
     const unsigned& GetPlotSpecificBinNumber() const;
     void SetPlotSpecificBinNumber(unsigned bin_number);
 
 protected slots:
     void InvalidateCachedHistogram();
+    void InvalidateCachedStatistics();
+
+private slots:
+    void HandleMaskChange();
 
 private:
     bool use_plotspecific_bin_number_;
     unsigned bin_number_;
     const SharedBinNumber& default_bin_number_;
     mutable bool cache_invalid;
+    mutable bool statistics_invalid_;
+    //! Zahl der seit der letzten vollständigen Neuberechnung schrittweise umgeschalteten Elemente.
+    unsigned long n_incremental_changes_;
     SharedMask mask_;
     bool selection_inverted_;
 
@@ -16,10 +16,25 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <utility>
 
 #include "histogramdata1d.h"
 
+namespace
+{
+//! Gibt das Bin eines Werts im Bereich [min, min + bins * width] zurück.
+inline unsigned FindBin(double x, double min, double width, unsigned bins)
+{
+    if (!(width > 0))
+        return 0;
+    const unsigned bin = static_cast<unsigned>((x - min) / width);
+    return bin < bins ? bin : bins - 1;
+}
+}
+
 HistogramData1D::HistogramData1D(
             unsigned long size,
             const SharedBinNumber& n_bins_default,
@@ -28,23 +43,42 @@ HistogramData1D::HistogramData1D(
         HistogramDataBase(size, n_bins_default, mask),
         data_(data),
         original_result_(std::numeric_limits<double>::quiet_NaN()),
-        histogramplot_cache_(nullptr)
+        histogramplot_cache_(nullptr),
+        sorted_values_invalid_(true)
 {
-    DetermineOutmostZoomIfZoomStackIsEmpty();
+    connect(&GetMask(), SIGNAL(MaskChanged()),
+            this, SLOT(InvalidateSortedValues()));
+}
+
+const DataStatistics& HistogramData1D::CalcStatistics() const
+{
+    if (AreStatisticsInvalid())
+    {
+        statistics_ = data_->CalcStatistics(GetMask());
+        MakeStatisticsValid();
+    }
+    return statistics_;
+}
+
+void HistogramData1D::SetStatistics(const DataStatistics& statistics)
+{
+    statistics_ = statistics;
+    MakeStatisticsValid();
 }
 
 double HistogramData1D::CalcMean() const
 {
-    return data_->CalcMean(GetMask());
+    return CalcStatistics().mean;
 }
 
 double HistogramData1D::CalcStdDev() const
 {
-    return data_->CalcStdDev(GetMask());
+    return CalcStatistics().StdDev();
 }
 
 QwtIntervalSeriesData* HistogramData1D::GetHistogramData() const
 {
+    DetermineOutmostZoomIfZoomStackIsEmpty();
     if (IsCacheInvalid())
     {
         const double min = zoom_stack_.top().minValue();
@@ -52,67 +86,161 @@ QwtIntervalSeriesData* HistogramData1D::GetHistogramData() const
         const unsigned bins = GetCurrentBinNumber();
         const double width = (max - min) / bins;
 
+        const std::vector<double>& values = GetSortedUnmaskedValues();
+        auto begin = std::lower_bound(values.begin(), values.end(), min);
+        const auto end = std::upper_bound(begin, values.end(), max);
+
         QVector<QwtIntervalSample> samples(bins);
         for (unsigned i = 0; i < bins; ++i)
         {
             QwtInterval interval(min + i * width, min + (i + 1) * width);
             interval.setBorderFlags(QwtInterval::ExcludeMaximum);
-            samples[i] = QwtIntervalSample(0, interval);
+
+            // Gleiche Zuordnung wie bei der direkten Berechnung des Bins aus dem Wert,
+            // damit Werte auf den Bingrenzen nicht durch Rundung das Bin wechseln.
+            auto bin_end = end;
+            if (i + 1 < bins && width > 0)
+                bin_end = std::partition_point(begin, end,
+                        [&](double x)
+                        {
+                            return FindBin(x, min, width, bins) <= i;
+                        });
+            samples[i] = QwtIntervalSample(bin_end - begin, interval);
+            begin = bin_end;
         }
 
-        MaskForEach(*data_->vector_, GetMask(),
-            [&](const double& x)
-            {
-                if (x > max || x < min) return;
-                unsigned bin = (x - min) / width;
-                if (bin >= bins) bin = bins - 1;
-                ++samples[bin].value;
-            });
-
-        delete histogramplot_cache_;
-        histogramplot_cache_ = new QwtIntervalSeriesData(samples);
+        if (histogramplot_cache_)
+            histogramplot_cache_->setSamples(samples);
+        else
+            histogramplot_cache_ = new QwtIntervalSeriesData(samples);
         MakeCacheValid();
     }
 
     return histogramplot_cache_;
 }
 
+const std::vector<double>& HistogramData1D::GetSortedUnmaskedValues() const
+{
+    const DataVector& data = *data_;
+    if (sort_order_.empty() && !data.empty())
+    {
+        std::vector<std::pair<double, unsigned long>> pairs;
+        pairs.reserve(data.size());
+        for (unsigned long i = 0; i < data.size(); ++i)
+            if (!std::isnan(data[i]))
+                pairs.emplace_back(data[i], i);
+        std::sort(pairs.begin(), pairs.end());
+        sort_order_.reserve(pairs.size());
+        for (const auto& pair : pairs)
+            sort_order_.push_back(pair.second);
+        sorted_values_invalid_ = true;
+    }
+
+    if (sorted_values_invalid_)
+    {
+        const Mask& mask = GetMask();
+        sorted_values_.clear();
+        sorted_values_.reserve(mask.NumberOfUnmaskedElements());
+        for (unsigned long i : sort_order_)
+            if (mask.IsEnabled(i))
+                sorted_values_.push_back(data[i]);
+        sorted_values_invalid_ = false;
+    }
+
+    return sorted_values_;
+}
+
+bool HistogramData1D::UpdateForMaskChange(
+        const std::vector<unsigned long>& toggled)
+{
+    const DataVector& data = *data_;
+    const Mask& mask = GetMask();
+
+    if (!AreStatisticsInvalid())
+        for (unsigned long i : toggled)
+        {
+            if (mask.IsEnabled(i))
+                statistics_.Add(data[i]);
+            else if (!statistics_.Remove(data[i]))
+            {
+                InvalidateCachedStatistics();
+                break;
+            }
+        }
+
+    if (!IsCacheInvalid())
+    {
+        const double min = zoom_stack_.top().minValue();
+        const double max = zoom_stack_.top().maxValue();
+        const unsigned bins = GetCurrentBinNumber();
+        const double width = (max - min) / bins;
+
+        QVector<QwtIntervalSample> samples = histogramplot_cache_->samples();
+        for (unsigned long i : toggled)
+        {
+            const double x = data[i];
+            if (!(x >= min && x <= max))
+                continue;
+            samples[FindBin(x, min, width, bins)].value += mask.IsEnabled(i) ? 1 : -1;
+        }
+        histogramplot_cache_->setSamples(samples);
+    }
+
+    return true;
+}
+
+void HistogramData1D::InvalidateSortedValues()
+{
+    sorted_values_invalid_ = true;
+}
+
 void HistogramData1D::ZoomIn(QRectF rect)
 {
     if (rect.isEmpty())
         return;
+    DetermineOutmostZoomIfZoomStackIsEmpty();
     zoom_stack_.emplace(rect.left(), rect.right());
     InvalidateCachedHistogram();
 }
 
 void HistogramData1D::ZoomOut()
 {
-    assert(!zoom_stack_.empty());
+    DetermineOutmostZoomIfZoomStackIsEmpty();
     if (zoom_stack_.size() == 1)
         return;
     zoom_stack_.pop();
     InvalidateCachedHistogram();
 }
 
-void HistogramData1D::DetermineOutmostZoomIfZoomStackIsEmpty()
+void HistogramData1D::DetermineOutmostZoomIfZoomStackIsEmpty() const
 {
     if (!zoom_stack_.empty())
         return;
 
-    auto minmax = std::minmax_element(data_->vector_->cbegin(),
-                                      data_->vector_->cend());
-    zoom_stack_.emplace(*minmax.first, *minmax.second);
-
-    InvalidateCachedHistogram();
+    // NaNs (nicht konvergierte Fits) und unendliche Werte dürfen die Grenzen nicht
+    // bestimmen, std::minmax_element liefert mit einem NaN am Anfang sonst NaN.
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    for (double x : *data_)
+        if (std::isfinite(x))
+        {
+            min = std::min(min, x);
+            max = std::max(max, x);
+        }
+    if (min > max)
+        min = max = 0;
+    zoom_stack_.emplace(min, max);
+    // Ohne Zoomstufe kann es noch kein gültiges Histogramm geben, der Cache ist also
+    // bereits ungültig.
 }
 
 void HistogramData1D::MaskWithSelection()
 {
     const QwtInterval& interval = selection_interval_;
     auto& mask = BeginEditMask();
-    assert(mask.size() == data_->vector_->size());
-    for (unsigned long i = 0; i < data_->vector_->size(); ++i)
-        mask[i] = interval.contains((*data_->vector_)[i])
+    assert(mask.size() == data_->size());
+    for (unsigned long i = 0; i < data_->size(); ++i)
+        mask[i] = interval.contains((*data_)[i])
                   != IsSelectionInverted()
                   && mask[i];
     EndEditMask();
@@ -44,12 +44,25 @@ public:
         delete histogramplot_cache_;
     }
 
+    //! Gibt Mittelwert, Varianz, Minimum und Maximum der nicht maskierten Daten zurück.
+    /*!
+     * Sie werden in einem Durchlauf berechnet und bis zur nächsten Maskenänderung gecacht.
+     */
+    const DataStatistics& CalcStatistics() const;
     double CalcMean() const;
     double CalcStdDev() const;
 
+    //! Übernimmt gespeicherte Kenngrößen zur aktuellen Maske.
+    /*!
+     * Dafür müssen die Daten nicht gelesen werden. Sie gelten bis zur nächsten Maskenänderung.
+     */
+    void SetStatistics(const DataStatistics& statistics);
+
     //! Gibt die Histogramdaten zurück.
     /*!
-     * Falls sie nicht gecacht sind, werden sie erst berechnet.
+     * Falls sie nicht gecacht sind, werden sie erst berechnet. Dazu werden in der sortierten
+     * Kopie der nicht maskierten Daten nur die Bingrenzen gesucht, sodass Zoomen und das
+     * Ändern der Binzahl unabhängig von der Zahl der Daten schnell sind.
      */
     QwtIntervalSeriesData* GetHistogramData() const;
 
@@ -67,14 +80,36 @@ public slots:
     //! Zoomt raus. Tut nichts wenn schon auf der äußersten Zoomstufe.
     void ZoomOut();
 
+private slots:
+    void InvalidateSortedValues();
+
+protected:
+    bool UpdateForMaskChange(const std::vector<unsigned long>& toggled);
+
 private:
-    void DetermineOutmostZoomIfZoomStackIsEmpty();
+    //! Legt die äußerste Zoomstufe fest, falls noch keine existiert.
+    /*!
+     * Geschieht erst bei Bedarf, damit beim Öffnen einer Datei die Daten nicht gelesen
+     * werden müssen.
+     */
+    void DetermineOutmostZoomIfZoomStackIsEmpty() const;
+    //! Gibt die nicht maskierten Daten aufsteigend sortiert und ohne NaNs zurück.
+    /*!
+     * Die Sortierreihenfolge aller Daten wird nur einmal bestimmt. Nach einer
+     * Maskenänderung werden die Daten in dieser Reihenfolge lediglich neu gefiltert.
+     */
+    const std::vector<double>& GetSortedUnmaskedValues() const;
 
     boost::shared_ptr<const DataVector> data_;
     QwtInterval selection_interval_;
     double original_result_;
-    std::stack<QwtInterval> zoom_stack_;
+    mutable std::stack<QwtInterval> zoom_stack_;
     mutable QwtIntervalSeriesData* histogramplot_cache_;
+    mutable DataStatistics statistics_;
+    //! Indizes aller Daten außer NaNs, aufsteigend nach Wert sortiert. Leer bis zur ersten Verwendung.
+    mutable std::vector<unsigned long> sort_order_;
+    mutable std::vector<double> sorted_values_;
+    mutable bool sorted_values_invalid_;
 
     HistogramData1D() = default;
     friend class boost::serialization::access;
@@ -124,9 +159,6 @@ private:
         else
             selection_inverted = false;
         SetSelectionInverted(selection_inverted);
-
-        // Bei älteren Dateien könnte der Zoom-Stack möglicherweise leer sein.
-        DetermineOutmostZoomIfZoomStackIsEmpty();
     }
 
     BOOST_SERIALIZATION_SPLIT_MEMBER()
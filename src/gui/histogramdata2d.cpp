@@ -16,6 +16,8 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
+
 #include "histogramdata2d.h"
 
 
@@ -30,40 +32,55 @@ HistogramData2D::HistogramData2D(
     y_data_(y_data),
     original_result_(std::numeric_limits<double>::quiet_NaN(),
                      std::numeric_limits<double>::quiet_NaN()),
-    histogramplot_cache_(nullptr)
+    histogramplot_cache_(nullptr),
+    builder_(x_data, y_data)
 {
-    DetermineOutmostZoomIfZoomStackIsEmpty();
+}
+
+const DataCoStatistics& HistogramData2D::CalcStatistics() const
+{
+    if (AreStatisticsInvalid())
+    {
+        statistics_ = x_data_->CalcStatistics(*y_data_, GetMask());
+        MakeStatisticsValid();
+    }
+    return statistics_;
+}
+
+void HistogramData2D::SetStatistics(const DataCoStatistics& statistics)
+{
+    statistics_ = statistics;
+    MakeStatisticsValid();
 }
 
 double HistogramData2D::CalcXMean() const
 {
-    return x_data_->CalcMean(GetMask());
+    return CalcStatistics().x.mean;
 }
 
 double HistogramData2D::CalcYMean() const
 {
-    return y_data_->CalcMean(GetMask());
+    return CalcStatistics().y.mean;
 }
 
 double HistogramData2D::CalcXStdDev() const
 {
-    return x_data_->CalcStdDev(GetMask());
+    return CalcStatistics().x.StdDev();
 }
 
 double HistogramData2D::CalcYStdDev() const
 {
-    return y_data_->CalcStdDev(GetMask());
+    return CalcStatistics().y.StdDev();
 }
 
 double HistogramData2D::CalcCorrelation() const
 {
-    return x_data_->CalcCorrelation(*y_data_, GetMask());
+    return CalcStatistics().Correlation();
 }
 
-
 QwtMatrixRasterData* HistogramData2D::GetHistogramRasterData() const
 {
-    assert(!zoom_stack_.empty());
+    DetermineOutmostZoomIfZoomStackIsEmpty();
 
     if (IsCacheInvalid())
     {
@@ -72,58 +89,84 @@ QwtMatrixRasterData* HistogramData2D::GetHistogramRasterData() const
         const double min_y = zoom_stack_.top().y.minValue();
         const double max_y = zoom_stack_.top().y.maxValue();
         const unsigned bins = GetCurrentBinNumber();
-        const double width_x = (max_x - min_x) / bins;
-        const double width_y = (max_y - min_y) / bins;
 
-        QVector<double> samples(bins * bins, -2.);
+        builder_.SetWindow(min_x, max_x, min_y, max_y);
+        counts_ = builder_.Build(bins, GetMask());
+        UpdateRasterData();
+        MakeCacheValid();
+    }
 
-        unsigned highest_number_of_samples_in_bin = 0U;
+    return histogramplot_cache_;
+}
 
-        MaskForEach(*x_data_->vector_, *y_data_->vector_, GetMask(),
-            [&](const double& x, const double& y)
-            {
-                if (!zoom_stack_.top().x.contains(x) ||
-                    !zoom_stack_.top().y.contains(y))
-                    return;
-                unsigned index_x = (x - min_x) / width_x;
-                unsigned index_y = (y - min_y) / width_y;
-                if (index_x >= bins) index_x = bins - 1;
-                if (index_y >= bins) index_y = bins - 1;
-                unsigned index = index_x + bins * index_y;
-                if (++samples[index] < 0)
-                    samples[index] = 1.0;
-                if (samples[index] > highest_number_of_samples_in_bin)
-                    highest_number_of_samples_in_bin = samples[index];
-            });
-
-        delete histogramplot_cache_;
+void HistogramData2D::UpdateRasterData() const
+{
+    const unsigned bins = GetCurrentBinNumber();
+    assert(counts_.size() == bins * bins);
+
+    // Leere Bins erhalten einen negativen Wert, damit sie nicht eingefärbt werden.
+    QVector<double> samples(bins * bins);
+    unsigned highest_number_of_samples_in_bin = 0U;
+    for (unsigned i = 0; i < counts_.size(); ++i)
+    {
+        samples[i] = counts_[i] ? counts_[i] : -2.;
+        highest_number_of_samples_in_bin =
+                std::max(highest_number_of_samples_in_bin, counts_[i]);
+    }
+
+    if (!histogramplot_cache_)
         histogramplot_cache_ = new QwtMatrixRasterData();
-        histogramplot_cache_->setValueMatrix(samples, bins);
-        histogramplot_cache_->
-                setResampleMode(QwtMatrixRasterData::NearestNeighbour);
-        histogramplot_cache_->
-                setInterval(Qt::XAxis, zoom_stack_.top().x);
-        histogramplot_cache_->
-                setInterval(Qt::YAxis, zoom_stack_.top().y);
-        histogramplot_cache_->setInterval(
-                Qt::ZAxis, QwtInterval(0, highest_number_of_samples_in_bin));
-        MakeCacheValid();
+    histogramplot_cache_->setValueMatrix(samples, bins);
+    histogramplot_cache_->
+            setResampleMode(QwtMatrixRasterData::NearestNeighbour);
+    histogramplot_cache_->
+            setInterval(Qt::XAxis, zoom_stack_.top().x);
+    histogramplot_cache_->
+            setInterval(Qt::YAxis, zoom_stack_.top().y);
+    histogramplot_cache_->setInterval(
+            Qt::ZAxis, QwtInterval(0, highest_number_of_samples_in_bin));
+}
+
+bool HistogramData2D::UpdateForMaskChange(
+        const std::vector<unsigned long>& toggled)
+{
+    const DataVector& x = *x_data_;
+    const DataVector& y = *y_data_;
+    const Mask& mask = GetMask();
+
+    if (!AreStatisticsInvalid())
+        for (unsigned long i : toggled)
+        {
+            if (mask.IsEnabled(i))
+                statistics_.Add(x[i], y[i]);
+            else if (!statistics_.Remove(x[i], y[i]))
+            {
+                InvalidateCachedStatistics();
+                break;
+            }
+        }
+
+    if (!IsCacheInvalid())
+    {
+        builder_.UpdateCounts(toggled, mask, GetCurrentBinNumber(), counts_);
+        UpdateRasterData();
     }
 
-    return histogramplot_cache_;
+    return true;
 }
 
 void HistogramData2D::ZoomIn(QRectF rect)
 {
     if (rect.isEmpty())
         return;
+    DetermineOutmostZoomIfZoomStackIsEmpty();
     zoom_stack_.emplace(rect.left(), rect.right(), rect.top(), rect.bottom());
     InvalidateCachedHistogram();
 }
 
 void HistogramData2D::ZoomOut()
 {
-    assert(!zoom_stack_.empty());
+    DetermineOutmostZoomIfZoomStackIsEmpty();
     if (zoom_stack_.size() == 1)
         return;
     zoom_stack_.pop();
@@ -132,13 +175,13 @@ void HistogramData2D::ZoomOut()
 
 const QwtInterval& HistogramData2D::GetXInterval() const
 {
-    assert(!zoom_stack_.empty());
+    DetermineOutmostZoomIfZoomStackIsEmpty();
     return zoom_stack_.top().x;
 }
 
 const QwtInterval& HistogramData2D::GetYInterval() const
 {
-    assert(!zoom_stack_.empty());
+    DetermineOutmostZoomIfZoomStackIsEmpty();
     return zoom_stack_.top().y;
 }
 
@@ -146,11 +189,11 @@ void HistogramData2D::MaskWithSelection()
 {
     const QPolygonF& polygon = selection_polygon_;
     auto& mask = BeginEditMask();
-    assert(mask.size() == x_data_->vector_->size());
-    assert(mask.size() == y_data_->vector_->size());
-    for (unsigned long i = 0; i < x_data_->vector_->size(); ++i)
-        mask[i] = polygon.containsPoint(QPointF((*x_data_->vector_)[i],
-                                                (*y_data_->vector_)[i]),
+    assert(mask.size() == x_data_->size());
+    assert(mask.size() == y_data_->size());
+    for (unsigned long i = 0; i < x_data_->size(); ++i)
+        mask[i] = polygon.containsPoint(QPointF((*x_data_)[i],
+                                                (*y_data_)[i]),
                                         Qt::OddEvenFill)
                   != IsSelectionInverted()
                   && mask[i];
@@ -184,29 +227,29 @@ void HistogramData2D::SetOriginalResult(double x, double y)
     original_result_ = QPointF(x, y);
 }
 
-void HistogramData2D::DetermineOutmostZoomIfZoomStackIsEmpty()
+void HistogramData2D::DetermineOutmostZoomIfZoomStackIsEmpty() const
 {
     if (!zoom_stack_.empty())
         return;
 
     const auto& x = *x_data_;
     const auto& y = *y_data_;
-    assert(x.vector_->size());
-    assert(x.vector_->size() == y.vector_->size());
+    assert(x.size());
+    assert(x.size() == y.size());
     double min_x;
     double max_x;
     double min_y;
     double max_y;
-    min_x = max_x = (*x.vector_)[0];
-    min_y = max_y = (*y.vector_)[0];
-    for (unsigned i = 0; i < x.vector_->size(); ++i)
+    min_x = max_x = x[0];
+    min_y = max_y = y[0];
+    for (unsigned i = 0; i < x.size(); ++i)
     {
-        if ((*x.vector_)[i] < min_x) min_x = (*x.vector_)[i];
-        if ((*x.vector_)[i] > max_x) max_x = (*x.vector_)[i];
-        if ((*y.vector_)[i] < min_y) min_y = (*y.vector_)[i];
-        if ((*y.vector_)[i] > max_y) max_y = (*y.vector_)[i];
+        if (x[i] < min_x) min_x = x[i];
+        if (x[i] > max_x) max_x = x[i];
+        if (y[i] < min_y) min_y = y[i];
+        if (y[i] > max_y) max_y = y[i];
     }
     zoom_stack_.emplace(min_x, max_x, min_y, max_y);
-
-    InvalidateCachedHistogram();
+    // Ohne Zoomstufe kann es noch kein gültiges Histogramm geben, der Cache ist also
+    // bereits ungültig.
 }
@@ -25,6 +25,7 @@
 #include <boost/make_shared.hpp>
 
 #include "datavector.h"
+#include "histogrambuilder2d.h"
 
 #include "histogramdata.h"
 
@@ -62,15 +63,24 @@ public:
         delete histogramplot_cache_;
     }
 
+    //! Gibt die Kenngrößen beider Achsen und ihre Kovarianz zurück.
+    /*!
+     * Sie werden in einem Durchlauf berechnet und bis zur nächsten Maskenänderung gecacht.
+     */
+    const DataCoStatistics& CalcStatistics() const;
     double CalcXMean() const;
     double CalcYMean() const;
     double CalcXStdDev() const;
     double CalcYStdDev() const;
     double CalcCorrelation() const;
 
+    //! Übernimmt gespeicherte Kenngrößen zur aktuellen Maske (siehe HistogramData1D).
+    void SetStatistics(const DataCoStatistics& statistics);
+
     //! Gibt das Histogramraster zurück.
     /*!
-     * Falls es nicht gecachet ist, wird es erst berechnet.
+     * Falls es nicht gecachet ist, wird es erst berechnet. Nach einem Zoom werden die Punkte
+     * dazu einmal neu quantisiert, für eine neue Binzahl oder Maske nur neu gezählt.
      */
     QwtMatrixRasterData* GetHistogramRasterData() const;
 
@@ -90,8 +100,14 @@ public slots:
     //! Zoomt raus. Tut nichts wenn schon auf der äußersten Zoomstufe.
     void ZoomOut();
 
+protected:
+    bool UpdateForMaskChange(const std::vector<unsigned long>& toggled);
+
 private:
-    void DetermineOutmostZoomIfZoomStackIsEmpty();
+    //! Legt die äußerste Zoomstufe fest, falls noch keine existiert (siehe HistogramData1D).
+    void DetermineOutmostZoomIfZoomStackIsEmpty() const;
+    //! Überträgt counts_ in histogramplot_cache_.
+    void UpdateRasterData() const;
 
     boost::shared_ptr<const DataVector> x_data_;
     boost::shared_ptr<const DataVector> y_data_;
@@ -99,8 +115,12 @@ private:
     QPointF original_result_;
     double original_result_x_;
     double original_result_y_;
-    std::stack<AxisIntervals> zoom_stack_;
+    mutable std::stack<AxisIntervals> zoom_stack_;
     mutable QwtMatrixRasterData* histogramplot_cache_;
+    mutable DataCoStatistics statistics_;
+    mutable HistogramBuilder2D builder_;
+    //! Zählerstände je Bin zum aktuellen Zoom und zur aktuellen Binzahl.
+    mutable std::vector<unsigned> counts_;
 
     HistogramData2D() = delete;
     friend class boost::serialization::access;
@@ -153,9 +173,6 @@ private:
                 selection_inverted = false;
         }
         SetSelectionInverted(selection_inverted);
-
-        // Bei älteren Dateien könnte der Zoom-Stack möglicherweise leer sein.
-        DetermineOutmostZoomIfZoomStackIsEmpty();
     }
 
     BOOST_SERIALIZATION_SPLIT_MEMBER()
@@ -17,17 +17,28 @@
 
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QLocale>
 #include <QTextCodec>
 
 #include <iostream>
 
+#include "chi2mapbatch.h"
 #include "mainwindow.h"
 // #include "../core/testing/models/manualtest_models.cpp"
 
 int main(int argc, char* argv[])
 {   
     // manualtesting::test();
+    // Ohne Fenster, damit der Batch-Modus auch ohne Display läuft.
+    if (Chi2MapBatch::IsRequested(argc, argv))
+    {
+        QCoreApplication app(argc, argv);
+        std::locale::global(std::locale::classic());
+        QLocale::setDefault(QLocale::c());
+        return Chi2MapBatch::Run(app.arguments());
+    }
+    
     QApplication app(argc, argv);
     std::locale::global(std::locale::classic());
     QLocale::setDefault(QLocale::c());
@@ -24,18 +24,12 @@
 #include <QPushButton>
 #include <QStringList>
 
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/archive/codecvt_null.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
-#include <boost/iostreams/filter/zlib.hpp>
-#include <boost/math/special_functions/nonfinite_num_facets.hpp>
-
 #include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <functional>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 
@@ -53,6 +47,7 @@
 #include "montecarloresultsmodel.h"
 #include "montecarloplotdelegate.h"
 #include "parametersetupmodel.h"
+#include "resultsfilereader.h"
 #include "resultsmodel.h"
 #include "resultswindow.h"
 #include "standardfitresultsmodel.h"
@@ -180,128 +175,27 @@ void MainWindow::OpenResults()
     if (filename.isEmpty())
         return;
     
-    StandardFitResultsModel* results_model(nullptr);
-    MonteCarloResultsModel* monte_carlo_model(nullptr);
-    FitSetup* fit_setup(nullptr);
-    
-    bool file_is_binary;
-    bool opened_successfully = false;
-    std::map<QString, std::string> error_messages;
+    ResultsFileReader reader;
+    bool opened_successfully;
     {
         GlobalWaitCursor wait_cursor;
-        try
-        {
-            std::ifstream ifs(filename.toStdString(), std::ios_base::binary);
-            boost::archive::binary_iarchive ia(ifs);
-            
-            ia >> results_model
-               >> monte_carlo_model
-               >> fit_setup;
-            
-            file_is_binary = true;
-            opened_successfully = true;
-        }
-        catch (std::exception& e)
-        {
-            error_messages["Binary archive"] = e.what();
-        }
-        catch (...)
-        {
-        }
-        
-        // Zum Laden alter unkomprimierter Dateien. Diese können jetzt nicht
-        // mehr erstellt werden.
-        if (!opened_successfully)
-            try
-            {
-                // Die geänderten Locales sind notwendig um Inf und NaN
-                // zuverlässig und platformunabhängig zu speichern.
-                std::locale default_locale(
-                        std::locale::classic(),
-                        new boost::archive::codecvt_null<char>);
-                std::locale in_locale(
-                        default_locale,
-                        new boost::math::nonfinite_num_get<char>);
-                std::ifstream ifs(filename.toStdString());
-                ifs.imbue(in_locale);
-                boost::archive::text_iarchive ia(ifs,
-                                                 boost::archive::no_codecvt);
-                
-                ia >> results_model
-                   >> monte_carlo_model
-                   >> fit_setup;
-                
-                file_is_binary = false;
-                opened_successfully = true;
-            }
-            catch (std::exception& e)
-            {
-                error_messages["Uncompressed portable archive"] = e.what();
-            }
-            catch (...)
-            {
-            }
-
-        if (!opened_successfully)
-            try
-            {
-                // Die geänderten Locales sind notwendig um Inf und NaN
-                // zuverlässig und platformunabhängig zu speichern.
-                std::locale default_locale(
-                        std::locale::classic(),
-                        new boost::archive::codecvt_null<char>);
-                std::locale in_locale(
-                        default_locale,
-                        new boost::math::nonfinite_num_get<char>);
-                std::ifstream ifs(filename.toStdString(),
-                                  std::ios_base::binary);
-                boost::iostreams::filtering_istream f;
-                f.push(boost::iostreams::zlib_decompressor());
-                f.push(ifs);
-                f.imbue(in_locale);
-                boost::archive::text_iarchive ia(f, boost::archive::no_codecvt);
-                
-                ia >> results_model
-                   >> monte_carlo_model
-                   >> fit_setup;
-                
-                file_is_binary = false;
-                opened_successfully = true;
-            }
-            catch (std::exception& e)
-            {
-                error_messages["Compressed portable archive"] = e.what();
-            }
-            catch (...)
-            {
-            }
-        
+        opened_successfully = reader.Read(filename);
     }
-            
+    
     if (!opened_successfully)
     {
-        QString errors;
-        if (error_messages.empty())
-            errors = "unknown error.";
-        for (const auto& error : error_messages)
-            errors.push_back("\n" + error.first + ": " +
-                             QString::fromStdString(error.second));
         QMessageBox::critical(this, APPLICATION_NAME,
-                              "Error opening file:" + errors);
-        delete results_model;
-        delete monte_carlo_model;
-        delete fit_setup;
+                              "Error opening file:" + reader.GetErrorMessage());
         return;
     }
     
+    std::unique_ptr<FitSetup> fit_setup(reader.TakeFitSetup());
     ResultsWindow* results_window = new ResultsWindow();
-    results_window->SetupResultsModelsAndViews(results_model,
-                                               monte_carlo_model,
-                                               fit_setup);
-    results_window->SetFileName(filename, file_is_binary);
+    results_window->SetupResultsModelsAndViews(reader.TakeResultsModel(),
+                                               reader.TakeMonteCarloModel(),
+                                               fit_setup.get());
+    results_window->SetFileName(filename, reader.IsBinary());
     results_window->show();
-        
-    delete fit_setup;
 }
 
 void MainWindow::TakeOverFitSetup()
@@ -20,6 +20,17 @@
 
 #include "mask.h"
 
+namespace
+{
+bool IsConverged(Eigen::LM::Status flag)
+{
+    return flag == Eigen::LM::RelativeReductionTooSmall         ||
+           flag == Eigen::LM::RelativeErrorTooSmall             ||
+           flag == Eigen::LM::RelativeErrorAndReductionTooSmall ||
+           flag == Eigen::LM::CosinusTooSmall;
+}
+}
+
 Mask::Mask(unsigned size) :
     mask_(size, true),
     exit_flags_(boost::make_shared<std::vector<Eigen::LM::Status>>(size)),
@@ -27,8 +38,10 @@ Mask::Mask(unsigned size) :
     old_size_(size),
     n_unmasked_elements_(size),
     per_cent_converged_(0.),
-    per_cent_converged_valid_(false)
+    per_cent_converged_valid_(false),
+    n_converged_(0)
 {
+    PackMask();
 }
 
 Mask::Mask(unsigned size,
@@ -39,14 +52,15 @@ Mask::Mask(unsigned size,
     old_size_(size),
     n_unmasked_elements_(size),
     per_cent_converged_(0.),
-    per_cent_converged_valid_(false)
+    per_cent_converged_valid_(false),
+    n_converged_(0)
 {
+    PackMask();
 }
 
 std::vector<bool>& Mask::BeginEditMask()
 {
     active_ = false;
-    per_cent_converged_valid_ = false;
     old_size_ = mask_.size();
     return mask_;
 }
@@ -55,13 +69,10 @@ void Mask::EndEditMask()
 {
     assert(old_size_ == mask_.size());
     active_ = true;
-    per_cent_converged_valid_ = false;
-    n_unmasked_elements_ = 0;
-    std::for_each(mask_.begin(), mask_.end(),
-                  [&](bool b)
-                  {
-                      if (b) ++n_unmasked_elements_;
-                  });
+    std::vector<std::uint64_t> old_words;
+    old_words.swap(words_);
+    PackMask();
+    ApplyChange(old_words);
 
     emit MaskChanged();
 }
@@ -94,8 +105,11 @@ double Mask::PerCentConverged() const
 void Mask::reset()
 {
     active_ = false;
-    per_cent_converged_valid_ = false;
     std::fill(mask_.begin(), mask_.end(), true);
+    std::vector<std::uint64_t> old_words;
+    old_words.swap(words_);
+    PackMask();
+    ApplyChange(old_words);
 
     emit MaskChanged();
 }
@@ -105,19 +119,52 @@ bool Mask::active() const
     return active_;
 }
 
+void Mask::PackMask()
+{
+    words_.assign((mask_.size() + 63) / 64, 0);
+    for (std::size_t i = 0; i < mask_.size(); ++i)
+        if (mask_[i])
+            words_[i / 64] |= std::uint64_t(1) << (i % 64);
+}
+
+void Mask::ApplyChange(const std::vector<std::uint64_t>& old_words)
+{
+    assert(old_words.size() == words_.size());
+    toggled_.clear();
+    for (std::size_t k = 0; k < words_.size(); ++k)
+        for (std::uint64_t diff = old_words[k] ^ words_[k]; diff; diff &= diff - 1)
+            toggled_.push_back(k * 64 + detail::CountTrailingZeros(diff));
+
+    const bool update_converged =
+            per_cent_converged_valid_ && exit_flags_->size() == mask_.size();
+    for (unsigned long i : toggled_)
+    {
+        const int sign = mask_[i] ? 1 : -1;
+        n_unmasked_elements_ += sign;
+        if (update_converged && IsConverged((*exit_flags_)[i]))
+            n_converged_ += sign;
+    }
+
+    per_cent_converged_valid_ = update_converged;
+    if (update_converged)
+        per_cent_converged_ = double(n_converged_) / NumberOfUnmaskedElements() * 100;
+}
+
+const std::vector<unsigned long>& Mask::GetToggledElements() const
+{
+    return toggled_;
+}
+
 void Mask::CalcPerCentConverged() const
 {
-    unsigned n_converged = 0;
+    n_converged_ = 0;
     MaskForEach(*exit_flags_, *this,
                 [&](Eigen::LM::Status flag)
                 {
-                    if (flag == Eigen::LM::RelativeReductionTooSmall         ||
-                        flag == Eigen::LM::RelativeErrorTooSmall             ||
-                        flag == Eigen::LM::RelativeErrorAndReductionTooSmall ||
-                        flag == Eigen::LM::CosinusTooSmall)
-                        ++n_converged;
+                    if (IsConverged(flag))
+                        ++n_converged_;
                 });
-    per_cent_converged_ = double(n_converged) / NumberOfUnmaskedElements() *100;
+    per_cent_converged_ = double(n_converged_) / NumberOfUnmaskedElements() *100;
     per_cent_converged_valid_ = true;
 }
 
@@ -125,3 +172,8 @@ bool Mask::IsEnabled(unsigned index) const
 {
     return !active() || mask_.at(index);
 }
+
+std::size_t Mask::NumberOfElements() const
+{
+    return mask_.size();
+}
@@ -28,6 +28,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -50,6 +51,15 @@ public:
     void reset();
     bool active() const;
     bool IsEnabled(unsigned index) const;
+    //! Gibt die Zahl aller, auch der maskierten, Elemente zurück.
+    std::size_t NumberOfElements() const;
+    //! Gibt die Indizes der Elemente zurück, die bei der letzten Änderung umgeschaltet wurden.
+    /*!
+      Aufsteigend sortiert. Empfänger von MaskChanged() können damit ihre Ergebnisse
+      anhand der Änderung aktualisieren, statt sie für alle Elemente neu zu berechnen.
+      Ob ein Element jetzt aktiv ist, liefert IsEnabled().
+      */
+    const std::vector<unsigned long>& GetToggledElements() const;
 
 signals:
     void MaskChanged();
@@ -57,18 +67,29 @@ signals:
 private:
     Mask() = default;
     void CalcPerCentConverged() const;
+    //! Überträgt mask_ in die gepackte Darstellung words_.
+    void PackMask();
+    //! Bestimmt toggled_ aus dem Vergleich mit den vorherigen Wörtern und aktualisiert die Zähler.
+    void ApplyChange(const std::vector<std::uint64_t>& old_words);
 
     std::vector<bool> mask_;
+    //! mask_ gepackt zu je 64 Elementen, Bits jenseits des Endes sind 0.
+    /*!
+      Ist die Maske inaktiv, sind alle Bits gesetzt.
+      */
+    std::vector<std::uint64_t> words_;
+    std::vector<unsigned long> toggled_;
     boost::shared_ptr<std::vector<Eigen::LM::Status>> exit_flags_;
     bool active_;
     unsigned old_size_;
     unsigned n_unmasked_elements_;
     mutable double per_cent_converged_;
     mutable double per_cent_converged_valid_;
+    mutable unsigned n_converged_;
 
-    template<class T, class Function>
-    friend void MaskForEach(const std::vector<T>& vec,
-                            const Mask& mask, Function func);
+    template<class Function>
+    friend void MaskForEachRange(std::size_t first, std::size_t last,
+                                 const Mask& mask, Function func);
 
     template<class T, class Function>
     friend void MaskForEach(const std::vector<T>& vec1,
@@ -86,25 +107,110 @@ private:
            & n_unmasked_elements_
            & per_cent_converged_
            & per_cent_converged_valid_;
+        if (Archive::is_loading::value)
+        {
+            PackMask();
+            // n_converged_ wird nicht gespeichert.
+            per_cent_converged_valid_ = false;
+        }
     }
 };
 
 typedef boost::shared_ptr<Mask> SharedMask;
 
-template<class T, class Function>
-void MaskForEach(const std::vector<T>& vec, const Mask& mask, Function func)
+namespace detail
+{
+inline unsigned CountTrailingZeros(std::uint64_t word)
+{
+    assert(word);
+#ifdef __GNUC__
+    return __builtin_ctzll(word);
+#else
+    unsigned n = 0;
+    for (; !(word & 1); word >>= 1) ++n;
+    return n;
+#endif
+}
+}
+
+//! Ruft func(begin, end) für jeden zusammenhängenden Bereich nicht maskierter Elemente in [first, last) auf.
+/*!
+  Die gepackte Maske wird wortweise durchlaufen: leere Wörter werden übersprungen, volle
+  Wörter verlängern den aktuellen Bereich, ohne einzelne Bits zu prüfen. Aneinander
+  grenzende Bereiche werden zusammengefasst, sodass func möglichst lange Schleifen ohne
+  Verzweigungen ausführen kann. Verschiedene Threads können so disjunkte Teilbereiche
+  derselben Maske bearbeiten.
+  \param first Erstes zu berücksichtigendes Element.
+  \param last Element hinter dem letzten zu berücksichtigenden.
+  \param mask Zu verwendende Maske.
+  \param func Funktion der Form void(std::size_t begin, std::size_t end).
+  */
+template<class Function>
+void MaskForEachRange(std::size_t first, std::size_t last,
+                      const Mask& mask, Function func)
 {
-    if (mask.active())
+    if (first >= last)
+        return;
+    if (!mask.active())
+    {
+        func(first, last);
+        return;
+    }
+
+    assert(last <= mask.mask_.size());
+    std::size_t run_begin = first;
+    std::size_t run_end = first;
+    const std::size_t last_word = (last + 63) / 64;
+    for (std::size_t k = first / 64; k < last_word; ++k)
     {
-        assert(vec.size() == mask.mask_.size());
-        auto v = vec.begin();
-        auto m = mask.mask_.begin();
-        for (; v != vec.end(); ++v, ++m)
-            if (*m)
-                func(*v);
+        std::uint64_t word = mask.words_[k];
+        const std::size_t offset = k * 64;
+        if (offset < first)
+            word &= ~std::uint64_t(0) << (first - offset);
+        if (last - offset < 64)
+            word &= ~(~std::uint64_t(0) << (last - offset));
+        while (word)
+        {
+            const unsigned begin_bit = detail::CountTrailingZeros(word);
+            const std::uint64_t rest = ~(word >> begin_bit);
+            const unsigned length = rest ? detail::CountTrailingZeros(rest)
+                                         : 64 - begin_bit;
+            const std::size_t begin = offset + begin_bit;
+            if (begin != run_end)
+            {
+                if (run_end > run_begin) func(run_begin, run_end);
+                run_begin = begin;
+            }
+            run_end = begin + length;
+            word = begin_bit + length < 64
+                    ? word & (~std::uint64_t(0) << (begin_bit + length))
+                    : 0;
+        }
     }
-    else
-        std::for_each(vec.begin(), vec.end(), func);
+    if (run_end > run_begin) func(run_begin, run_end);
+}
+
+//! Ruft func(begin, end) für jeden zusammenhängenden Bereich nicht maskierter Elemente auf.
+/*!
+  \param size Anzahl der Elemente.
+  \param mask Zu verwendende Maske.
+  \param func Funktion der Form void(std::size_t begin, std::size_t end).
+  */
+template<class Function>
+void MaskForEachRange(std::size_t size, const Mask& mask, Function func)
+{
+    assert(!mask.active() || size == mask.NumberOfElements());
+    MaskForEachRange(0, size, mask, func);
+}
+
+template<class T, class Function>
+void MaskForEach(const std::vector<T>& vec, const Mask& mask, Function func)
+{
+    MaskForEachRange(vec.size(), mask,
+                     [&](std::size_t begin, std::size_t end)
+                     {
+                         std::for_each(vec.begin() + begin, vec.begin() + end, func);
+                     });
 }
 
 template<class T, class Function>
@@ -113,24 +219,13 @@ void MaskForEach(const std::vector<T>& vec1,
                  const Mask& mask,
                  Function func)
 {
-    if (mask.active())
-    {
-        assert(vec1.size() == mask.mask_.size() &&
-               vec2.size() == mask.mask_.size());
-        auto v1 = vec1.begin();
-        auto v2 = vec2.begin();
-        auto m = mask.mask_.begin();
-        for (; v1 != vec1.end(); ++v1, ++v2, ++m)
-            if (*m)
-                func(*v1, *v2);
-    }
-    else
-    {
-        auto v1 = vec1.begin();
-        auto v2 = vec2.begin();
-        for (; v1 != vec1.end(); ++v1, ++v2)
-            func(*v1, *v2);
-    }
+    assert(vec1.size() == vec2.size());
+    MaskForEachRange(vec1.size(), mask,
+                     [&](std::size_t begin, std::size_t end)
+                     {
+                         for (std::size_t i = begin; i < end; ++i)
+                             func(vec1[i], vec2[i]);
+                     });
 }
 
 #endif // MASK_H
@@ -19,15 +19,47 @@
 #ifndef MONTECARLOEXPORTER_H
 #define MONTECARLOEXPORTER_H
 
-#include <QVariant>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+#include "core/fitting/fitresults.h"
+
+//! Spaltenweise Sicht auf die zu exportierenden Monte-Carlo-Ergebnisse.
+/*!
+  Die Werte werden nicht kopiert, sondern verweisen auf die Blöcke des
+  MonteCarloResultsModel.
+  */
+struct MonteCarloExportData
+{
+    //! Zu exportierende Daten einer Probe.
+    struct Sample
+    {
+        QString name;
+
+        //! Indizes der nicht maskierten Monte-Carlo-Fits, aufsteigend.
+        std::vector<unsigned> rows;
+
+        //! Werte aller Fits je Spalte, nullptr für die Konvergenzspalte.
+        std::vector<const double*> columns;
+
+        //! Exit-Flags aller Fits.
+        const std::vector<Eigen::LM::Status>* exit_flags;
+    };
+
+    //! Namen der Spalten, ohne die Spalte mit den Probennamen.
+    QStringList column_names;
+
+    std::vector<Sample> samples;
+};
 
 class MonteCarloExporter
 {
 public:
     virtual ~MonteCarloExporter() {}
-    
-    virtual void NextSample() = 0;
-    virtual MonteCarloExporter& operator<<(QVariant in) = 0;
+
+    virtual void Export(const MonteCarloExportData& data) = 0;
 };
 
 #endif // MONTECARLOEXPORTER_H
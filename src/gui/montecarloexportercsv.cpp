@@ -16,43 +16,144 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
-#include <QFileDialog>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
 #include "montecarloexportercsv.h"
 
-MonteCarloExporterCsv::MonteCarloExporterCsv() :
-    file_(),
-    stream_(),
-    is_new_line_(true)
+namespace
+{
+//! Anzahl der Zeilen, die ein Thread am Stück formatiert.
+const unsigned ROWS_PER_CHUNK = 4096;
+
+//! Anzahl der Blöcke je Thread, die formatiert werden, bevor geschrieben wird.
+const unsigned CHUNKS_PER_THREAD = 4;
+
+struct Chunk
+{
+    const MonteCarloExportData::Sample* sample;
+    std::size_t begin;
+    std::size_t end;
+};
+
+//! Hängt die kürzeste Darstellung von x an, die beim Einlesen wieder x ergibt.
+/*!
+  Bei höchstens 15 signifikanten Stellen ist die Rundung auf 15 Stellen bereits die
+  kürzeste Darstellung, da %g abschließende Nullen entfernt. Andernfalls genügen 16
+  oder 17 Stellen.
+  */
+void AppendDouble(double x, std::string& out)
+{
+    if (std::isnan(x))
+    {
+        out += "nan";
+        return;
+    }
+    if (std::isinf(x))
+    {
+        out += x < 0 ? "-inf" : "inf";
+        return;
+    }
+    char buffer[32];
+    for (int precision = 15; precision <= 17; ++precision)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision, x);
+        if (std::strtod(buffer, nullptr) == x)
+            break;
+    }
+    // snprintf verwendet das Dezimaltrennzeichen der C-Locale, die Qt auf die des
+    // Systems setzt.
+    const char decimal_point = *std::localeconv()->decimal_point;
+    if (decimal_point != '.')
+        std::replace(buffer, buffer + std::strlen(buffer), decimal_point, '.');
+    out += buffer;
+}
+
+void FormatChunk(const Chunk& chunk, std::string& out)
+{
+    const MonteCarloExportData::Sample& sample = *chunk.sample;
+    const std::string name(sample.name.toUtf8().constData());
+    out.clear();
+    for (std::size_t i = chunk.begin; i < chunk.end; ++i)
+    {
+        const unsigned row = sample.rows[i];
+        out += name;
+        for (const double* column : sample.columns)
+        {
+            out += ',';
+            if (column)
+                AppendDouble(column[row], out);
+            else
+                out += FitResults::GetExitFlagAsString(sample.exit_flags->at(row));
+        }
+        out += '\n';
+    }
+}
+}
+
+MonteCarloExporterCsv::MonteCarloExporterCsv(const QString& filename) :
+    file_(filename)
 {
-    QString filename = QFileDialog::getSaveFileName(
-            nullptr,
-            "Export Monte Carlo data",
-            QString(),
-            "CSV file (*.csv)",
-            nullptr
-#ifdef __APPLE__
-            ,QFileDialog::DontUseNativeDialog
-#endif
-            );
-    if (filename.isEmpty())
-        throw Canceled();
-    file_.setFileName(filename);
-    file_.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
-    stream_.setDevice(&file_);
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        throw std::runtime_error("Could not open " +
+                                 std::string(filename.toUtf8().constData()) +
+                                 " for writing.");
 }
 
-void MonteCarloExporterCsv::NextSample()
+void MonteCarloExporterCsv::Export(const MonteCarloExportData& data)
 {
-    stream_ << '\n';
-    is_new_line_ = true;
+    std::string header("Name");
+    for (const auto& name : data.column_names)
+    {
+        header += ',';
+        header += name.toUtf8().constData();
+    }
+    header += '\n';
+    Write(header);
+
+    std::vector<Chunk> chunks;
+    for (const auto& sample : data.samples)
+        for (std::size_t begin = 0; begin < sample.rows.size(); begin += ROWS_PER_CHUNK)
+            chunks.push_back({&sample,
+                              begin,
+                              std::min<std::size_t>(begin + ROWS_PER_CHUNK,
+                                                    sample.rows.size())});
+
+    unsigned n_threads = boost::thread::hardware_concurrency();
+    if (n_threads == 0) n_threads = 1;
+
+    const std::size_t chunks_per_round = n_threads * CHUNKS_PER_THREAD;
+    std::vector<std::string> texts(chunks_per_round);
+    for (std::size_t first = 0; first < chunks.size(); first += chunks_per_round)
+    {
+        const std::size_t last = std::min(first + chunks_per_round, chunks.size());
+        boost::thread_group threads;
+        for (unsigned t = 1; t < n_threads; ++t)
+            threads.create_thread([&, t]()
+            {
+                for (std::size_t i = first + t; i < last; i += n_threads)
+                    FormatChunk(chunks[i], texts[i - first]);
+            });
+        for (std::size_t i = first; i < last; i += n_threads)
+            FormatChunk(chunks[i], texts[i - first]);
+        threads.join_all();
+
+        for (std::size_t i = first; i < last; ++i)
+            Write(texts[i - first]);
+    }
 }
 
-MonteCarloExporter& MonteCarloExporterCsv::operator<<(QVariant in)
+void MonteCarloExporterCsv::Write(const std::string& text)
 {
-    if (is_new_line_)
-        is_new_line_ = false;
-    else
-        stream_ << ',';
-    stream_ << in.toString();
-    return *this;
+    if (file_.write(text.data(), text.size()) != qint64(text.size()))
+        throw std::runtime_error("Could not write to " +
+                                 std::string(file_.fileName().toUtf8().constData()) +
+                                 ".");
 }
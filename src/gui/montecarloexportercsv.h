@@ -20,24 +20,29 @@
 #define MONTECARLOEXPORTERCSV_H
 
 #include <QFile>
-#include <QTextStream>
+
+#include <string>
 
 #include "montecarloexporter.h"
 
+//! Schreibt die Monte-Carlo-Ergebnisse als CSV-Datei.
+/*!
+  Die Zeilen werden blockweise von mehreren Threads formatiert und anschließend
+  in der ursprünglichen Reihenfolge geschrieben. Zahlen werden in der kürzesten
+  Darstellung ausgegeben, die beim Einlesen wieder denselben Wert ergibt.
+  */
 class MonteCarloExporterCsv : public MonteCarloExporter
 {
 public:
-    MonteCarloExporterCsv();
-    
-    virtual void NextSample();
-    virtual MonteCarloExporter& operator<<(QVariant in);
-    
-    class Canceled {};
-    
+    //! Öffnet die Datei filename. Wirft std::runtime_error, falls das nicht gelingt.
+    explicit MonteCarloExporterCsv(const QString& filename);
+
+    virtual void Export(const MonteCarloExportData& data);
+
 private:
+    void Write(const std::string& text);
+
     QFile file_;
-    QTextStream stream_;
-    bool is_new_line_;
 };
 
 #endif // MONTECARLOEXPORTERCSV_H
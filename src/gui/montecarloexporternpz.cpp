@@ -0,0 +1,167 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "zipwriter.h"
+
+#include "montecarloexporternpz.h"
+
+namespace
+{
+//! Anzahl der Werte, die gesammelt werden, bevor sie geschrieben werden.
+const std::size_t BUFFER_SIZE = 1 << 16;
+
+const char* const BYTE_ORDER_CHAR = Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? "<" : ">";
+
+//! Beginnt einen Eintrag mit dem Header eines eindimensionalen .npy-Arrays.
+void BeginArray(ZipWriter& zip,
+                QString name,
+                const std::string& descr,
+                std::size_t size)
+{
+    name.replace('/', '_').replace('\\', '_');
+    zip.BeginEntry(std::string(name.toUtf8().constData()) + ".npy");
+
+    std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (" +
+                       std::to_string(size) + ",), }";
+    // Die Daten sollen auf 64 Bytes ausgerichtet beginnen.
+    const std::size_t length = 10 + dict.size() + 1;
+    dict.append((64 - length % 64) % 64, ' ');
+    dict += '\n';
+
+    std::string header("\x93NUMPY\x01\x00", 8);
+    AppendLittleEndian<std::uint16_t>(header, dict.size());
+    header += dict;
+    zip.WriteToEntry(header.data(), header.size());
+}
+
+//! Schreibt eine Spalte von Strings fester Breite (Numpy-Typ U).
+template<class Function>
+void WriteStringArray(ZipWriter& zip,
+                      const QString& name,
+                      const MonteCarloExportData& data,
+                      std::size_t size,
+                      Function get_string)
+{
+    std::size_t width = 1;
+    for (const auto& sample : data.samples)
+        for (unsigned row : sample.rows)
+            width = std::max<std::size_t>(width, get_string(sample, row).size());
+
+    BeginArray(zip, name, BYTE_ORDER_CHAR + std::string("U") + std::to_string(width), size);
+    std::vector<uint> buffer;
+    buffer.reserve(BUFFER_SIZE + width);
+    for (const auto& sample : data.samples)
+        for (unsigned row : sample.rows)
+        {
+            const QVector<uint>& string = get_string(sample, row);
+            buffer.insert(buffer.end(), string.begin(), string.end());
+            buffer.resize(buffer.size() + width - string.size(), 0);
+            if (buffer.size() >= BUFFER_SIZE)
+            {
+                zip.WriteToEntry(buffer.data(), buffer.size() * sizeof(uint));
+                buffer.clear();
+            }
+        }
+    zip.WriteToEntry(buffer.data(), buffer.size() * sizeof(uint));
+    zip.EndEntry();
+}
+
+void WriteDoubleArray(ZipWriter& zip,
+                      const QString& name,
+                      const MonteCarloExportData& data,
+                      std::size_t size,
+                      unsigned column)
+{
+    BeginArray(zip, name, BYTE_ORDER_CHAR + std::string("f8"), size);
+    std::vector<double> buffer;
+    buffer.reserve(BUFFER_SIZE);
+    for (const auto& sample : data.samples)
+    {
+        const double* values = sample.columns[column];
+        for (std::size_t i = 0; i < sample.rows.size(); )
+        {
+            const std::size_t n = std::min(BUFFER_SIZE - buffer.size(), sample.rows.size() - i);
+            for (std::size_t k = 0; k < n; ++k, ++i)
+                buffer.push_back(values[sample.rows[i]]);
+            if (buffer.size() == BUFFER_SIZE)
+            {
+                zip.WriteToEntry(buffer.data(), buffer.size() * sizeof(double));
+                buffer.clear();
+            }
+        }
+    }
+    zip.WriteToEntry(buffer.data(), buffer.size() * sizeof(double));
+    zip.EndEntry();
+}
+}
+
+MonteCarloExporterNpz::MonteCarloExporterNpz(const QString& filename) :
+    file_(filename)
+{
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        throw std::runtime_error("Could not open " +
+                                 std::string(filename.toUtf8().constData()) +
+                                 " for writing.");
+}
+
+void MonteCarloExporterNpz::Export(const MonteCarloExportData& data)
+{
+    std::size_t size = 0;
+    for (const auto& sample : data.samples)
+        size += sample.rows.size();
+
+    ZipWriter zip(file_);
+
+    std::vector<QVector<uint>> names;
+    for (const auto& sample : data.samples)
+        names.push_back(sample.name.toUcs4());
+    WriteStringArray(zip, "Name", data, size,
+                     [&](const MonteCarloExportData::Sample& sample, unsigned)
+                         -> const QVector<uint>&
+                     {
+                         return names[&sample - data.samples.data()];
+                     });
+
+    std::vector<QVector<uint>> exit_flags;
+    for (int flag = Eigen::LM::NotStarted; flag <= Eigen::LM::UserAsked; ++flag)
+        exit_flags.push_back(QString::fromStdString(FitResults::GetExitFlagAsString(
+                static_cast<Eigen::LM::Status>(flag))).toUcs4());
+
+    for (int column = 0; column < data.column_names.size(); ++column)
+    {
+        if (data.samples.empty() || data.samples.front().columns[column])
+            WriteDoubleArray(zip, data.column_names[column], data, size, column);
+        else
+            WriteStringArray(zip, data.column_names[column], data, size,
+                             [&](const MonteCarloExportData::Sample& sample, unsigned row)
+                                 -> const QVector<uint>&
+                             {
+                                 return exit_flags.at(sample.exit_flags->at(row) -
+                                                      Eigen::LM::NotStarted);
+                             });
+    }
+
+    zip.Finish();
+}
@@ -0,0 +1,45 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef MONTECARLOEXPORTERNPZ_H
+#define MONTECARLOEXPORTERNPZ_H
+
+#include <QFile>
+
+#include "montecarloexporter.h"
+
+//! Schreibt die Monte-Carlo-Ergebnisse als NumPy-Archiv (.npz).
+/*!
+  Jede Spalte wird als eindimensionales Array in eine eigene .npy-Datei des
+  unkomprimierten Zip-Archivs geschrieben: Zahlenwerte als Gleitkommazahlen doppelter
+  Genauigkeit, Probennamen und Konvergenz als Unicode-Strings. Mit numpy.load kann
+  auf die Spalten über ihre Namen zugegriffen werden.
+  */
+class MonteCarloExporterNpz : public MonteCarloExporter
+{
+public:
+    //! Öffnet die Datei filename. Wirft std::runtime_error, falls das nicht gelingt.
+    explicit MonteCarloExporterNpz(const QString& filename);
+
+    virtual void Export(const MonteCarloExportData& data);
+
+private:
+    QFile file_;
+};
+
+#endif // MONTECARLOEXPORTERNPZ_H
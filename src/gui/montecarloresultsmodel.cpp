@@ -21,12 +21,14 @@
 #include <algorithm>
 #include <cassert>
 #include <functional>
+#include <limits>
 #include <set>
 
 #include "core/misc/gas.h"
 
 #include "histogramdata1d.h"
 #include "histogramdata2d.h"
+#include "mask.h"
 #include "montecarloexporter.h"
 
 #include "montecarloresultsmodel.h"
@@ -98,8 +100,12 @@ void MonteCarloResultsModel::GetOrCreateDataVisitor::CreatePlotData(
             model_.n_bins_,
             model_.masks_.at(index_.row()),
             model_.monte_carlo_data_.at(index_.row()).at(type));
-    data->SetOriginalResult(model_.GetElement(
-            *model_.original_fit_results_->at(index_.row()), type).toDouble());
+    data->SetOriginalResult(model_.GetDoubleElement(
+            *model_.original_fit_results_->at(index_.row()), type));
+    const auto& stored = model_.stored_statistics_1d_.at(index_.row());
+    auto it = stored.find(type);
+    if (it != stored.end())
+        data->SetStatistics(it->second);
     model_.AddToDataToIndexMapAndConnectSignals(
         data.get(), index_.row(), index_.column());
 }
@@ -119,7 +125,7 @@ void MonteCarloResultsModel::GetOrCreateDataVisitor::CreatePlotData(
 {
     auto& mc_data_x = model_.monte_carlo_data_.at(index_.row()).at(type.first);
     auto& mc_data_y = model_.monte_carlo_data_.at(index_.row()).at(type.second);
-    assert(mc_data_x->vector_->size() == mc_data_y->vector_->size());
+    assert(mc_data_x->size() == mc_data_y->size());
     SharedHistogramData2D& data = model_.plot_data_2d_.at(index_.row())[type];
     data = boost::make_shared<HistogramData2D>(
             model_.n_monte_carlos_,
@@ -128,10 +134,14 @@ void MonteCarloResultsModel::GetOrCreateDataVisitor::CreatePlotData(
             mc_data_x,
             mc_data_y);
     data->SetOriginalResult(
-            model_.GetElement(*model_.original_fit_results_
-                ->at(index_.row()), type.first ).toDouble(),
-            model_.GetElement(*model_.original_fit_results_
-                ->at(index_.row()), type.second).toDouble());
+            model_.GetDoubleElement(*model_.original_fit_results_
+                ->at(index_.row()), type.first ),
+            model_.GetDoubleElement(*model_.original_fit_results_
+                ->at(index_.row()), type.second));
+    const auto& stored = model_.stored_statistics_2d_.at(index_.row());
+    auto it = stored.find(type);
+    if (it != stored.end())
+        data->SetStatistics(it->second);
     model_.AddToDataToIndexMapAndConnectSignals(
         data.get(), index_.row(), index_.column());
 }
@@ -141,7 +151,8 @@ MonteCarloResultsModel::MonteCarloResultsModel(
         const std::vector<ModelParameter>& parameters,
         const std::set<GasType>& gases_in_use,
         unsigned n_monte_carlos,
-        QObject* parent) :
+        QObject* parent,
+        const QList<ExtendedColumnType>& stored_column_types) :
     ResultsModel(
             sample_names,
             parameters,
@@ -149,7 +160,7 @@ MonteCarloResultsModel::MonteCarloResultsModel(
             parent),
     column_types_(PrepareColumnTypes(parameters.size(),
                                      gases_in_use.size())),
-    available_column_types_(GetDoubleColumnTypes()),
+    available_column_types_(PrepareAvailableColumnTypes(stored_column_types)),
     n_monte_carlos_(n_monte_carlos),
     n_bins_(0U),
     monte_carlo_data_(sample_names_.size()),
@@ -164,6 +175,9 @@ MonteCarloResultsModel::MonteCarloResultsModel(
     plot_data_2d_(sample_names_.size()),
     masks_(sample_names_.size()),
     exit_flags_(sample_names_.size()),
+    blocks_(sample_names_.size()),
+    stored_statistics_1d_(sample_names_.size()),
+    stored_statistics_2d_(sample_names_.size()),
     original_fit_results_need_to_be_added_to_plot_data_vectors_(false)
 {
     for (unsigned i = 0; i < sample_names_.size(); ++i)
@@ -171,12 +185,10 @@ MonteCarloResultsModel::MonteCarloResultsModel(
         exit_flags_[i] = boost::make_shared<std::vector<Eigen::LM::Status>>();
         exit_flags_[i]->reserve(n_monte_carlos_);
         masks_[i] = boost::make_shared<Mask>(n_monte_carlos, exit_flags_[i]);
+        // Der Block wird erst mit dem ersten Ergebnis angelegt, damit beim Laden
+        // nicht unnötig Speicher belegt wird.
         for (const auto& col_type : available_column_types_)
-        {
-            auto& new_col = monte_carlo_data_[i][col_type];
-            new_col = boost::make_shared<DataVector>();
-            new_col->vector_->reserve(n_monte_carlos_);
-        }
+            monte_carlo_data_[i][col_type] = boost::make_shared<DataVector>();
     }
 }
 
@@ -185,17 +197,37 @@ MonteCarloResultsModel::~MonteCarloResultsModel()
 }
 
 void MonteCarloResultsModel::ProcessMonteCarloResult(
-    std::shared_ptr<FitResults> results,
+    const FitResults& results,
     const std::vector<std::string>& sample_names,
     const std::vector<std::string>& parameter_names,
     const std::vector<SampleConcentrations>& concentrations)
 {
     assert(!sample_names.empty());
     unsigned i = name_lookup_.at(sample_names.front());
-    for (const auto& col_type : available_column_types_)
-        monte_carlo_data_.at(i).at(col_type)->vector_->
-                emplace_back(GetElement(*results, col_type).toDouble());
-    exit_flags_.at(i)->emplace_back(results->exit_flag);
+    std::vector<Eigen::LM::Status>& exit_flags = *exit_flags_.at(i);
+    const unsigned row = exit_flags.size();
+    assert(row < n_monte_carlos_);
+    if (row >= n_monte_carlos_)
+        return;
+
+    if (!blocks_[i])
+        AllocateBlock(i);
+    GetDoubleElements(results, available_column_types_,
+                      blocks_[i]->data() + row, n_monte_carlos_);
+    exit_flags.emplace_back(results.exit_flag);
+}
+
+void MonteCarloResultsModel::AllocateBlock(unsigned sample)
+{
+    const unsigned n_columns = available_column_types_.size();
+    blocks_[sample] = boost::make_shared<std::vector<double>>(
+            std::size_t(n_monte_carlos_) * n_columns,
+            std::numeric_limits<double>::quiet_NaN());
+    auto block = boost::make_shared<DataBlock>(blocks_[sample]);
+    for (unsigned c = 0; c < n_columns; ++c)
+        monte_carlo_data_[sample][available_column_types_[c]] =
+                boost::make_shared<DataVector>(
+                    block, std::size_t(c) * n_monte_carlos_, n_monte_carlos_);
 }
 
 Qt::ItemFlags MonteCarloResultsModel::flags(const QModelIndex& index) const
@@ -290,30 +322,28 @@ void MonteCarloResultsModel::ExportMonteCarloData(
             });
     col_types.erase(new_end, col_types.end());
 
-    exporter << "Name";
+    MonteCarloExportData data;
     for (auto col : col_types)
-        exporter << GetVariantColumnName(col);
-    exporter.NextSample();
+        data.column_names << GetVariantColumnName(col);
     assert(masks_.size() == monte_carlo_data_.size());
+    data.samples.resize(monte_carlo_data_.size());
     for (unsigned i = 0; i < monte_carlo_data_.size(); ++i)
     {
-        const auto& sample = monte_carlo_data_[i];
-        for (unsigned j = 0; j < n_monte_carlos_; ++j)
-        {
-            if (!masks_.at(i)->IsEnabled(j)) continue;
-            exporter << sample_names_.at(i);
-            for (auto col : col_types)
-            {
-                if (col.first == ColumnType::CONVERGENCE)
-                    exporter << QString::fromStdString(
-                            FitResults::GetExitFlagAsString(
-                                exit_flags_.at(i)->at(j)));
-                else
-                    exporter << (*sample.at(col)->vector_)[j];
-            }
-            exporter.NextSample();
-        }
+        auto& sample = data.samples[i];
+        sample.name = sample_names_.at(i);
+        MaskForEachRange(n_monte_carlos_, *masks_.at(i),
+                         [&](std::size_t begin, std::size_t end)
+                         {
+                             for (std::size_t j = begin; j < end; ++j)
+                                 sample.rows.push_back(j);
+                         });
+        for (auto col : col_types)
+            sample.columns.push_back(col.first == ColumnType::CONVERGENCE ?
+                                         nullptr :
+                                         monte_carlo_data_[i].at(col)->data());
+        sample.exit_flags = exit_flags_.at(i).get();
     }
+    exporter.Export(data);
 }
 
 unsigned MonteCarloResultsModel::NumberOfMonteCarlos() const
@@ -374,6 +404,119 @@ const QList<ColumnTypeVariant> MonteCarloResultsModel::PrepareColumnTypes(
     return cols;
 }
 
+const QList<ExtendedColumnType> MonteCarloResultsModel::PrepareAvailableColumnTypes(
+        const QList<ExtendedColumnType>& stored_column_types) const
+{
+    QList<ExtendedColumnType> cols = GetDoubleColumnTypes();
+    if (stored_column_types.isEmpty())
+        return cols;
+
+    auto new_end = std::remove_if(
+            cols.begin(),
+            cols.end(),
+            [&](const ExtendedColumnType& c)
+            {
+                return !IsAlwaysStored(c) && !stored_column_types.contains(c);
+            });
+    cols.erase(new_end, cols.end());
+
+    return cols;
+}
+
+bool MonteCarloResultsModel::IsAlwaysStored(const ExtendedColumnType& column_type)
+{
+    switch (column_type.first)
+    {
+    case ColumnType::PARAMETER_ESTIMATE:
+    case ColumnType::PARAMETER_ESTIMATE_ERROR:
+    case ColumnType::CORRELATION:
+    case ColumnType::RESIDUAL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+ResultsRequest MonteCarloResultsModel::GetResultsRequest() const
+{
+    return DetermineResultsRequest(available_column_types_);
+}
+
+std::vector<boost::shared_ptr<DataBlock>> MonteCarloResultsModel::GetDataBlocks() const
+{
+    std::vector<boost::shared_ptr<DataBlock>> blocks;
+    std::set<const DataBlock*> seen;
+    for (const auto& sample_data : monte_carlo_data_)
+        for (const auto& column : sample_data)
+            if (seen.insert(column.second->GetBlock().get()).second)
+                blocks.push_back(column.second->GetBlock());
+    return blocks;
+}
+
+bool MonteCarloResultsModel::AreSummaryStatisticsStored() const
+{
+    for (unsigned i = 0; i < monte_carlo_data_.size(); ++i)
+        for (const auto& type : column_types_)
+        {
+            if (const ExtendedColumnType* type_1d = boost::get<ExtendedColumnType>(&type))
+            {
+                if (!stored_statistics_1d_[i].count(*type_1d))
+                    return false;
+            }
+            else if (!stored_statistics_2d_[i].count(boost::get<ColumnType2D>(type)))
+                return false;
+        }
+    return true;
+}
+
+void MonteCarloResultsModel::CalcSummaryStatistics(
+        std::vector<std::map<ExtendedColumnType, DataStatistics>>& statistics_1d,
+        std::vector<std::map<ColumnType2D, DataCoStatistics>>& statistics_2d) const
+{
+    statistics_1d.clear();
+    statistics_2d.clear();
+    statistics_1d.resize(monte_carlo_data_.size());
+    statistics_2d.resize(monte_carlo_data_.size());
+    for (unsigned i = 0; i < monte_carlo_data_.size(); ++i)
+    {
+        const auto& sample_data = monte_carlo_data_[i];
+        const Mask& mask = *masks_[i];
+        for (const auto& type : column_types_)
+        {
+            if (const ExtendedColumnType* type_1d = boost::get<ExtendedColumnType>(&type))
+            {
+                auto it = sample_data.find(*type_1d);
+                if (it != sample_data.end())
+                    statistics_1d[i][*type_1d] = it->second->CalcStatistics(mask);
+                continue;
+            }
+            const ColumnType2D& type_2d = boost::get<ColumnType2D>(type);
+            auto x = sample_data.find(type_2d.first);
+            auto y = sample_data.find(type_2d.second);
+            if (x != sample_data.end() && y != sample_data.end())
+                statistics_2d[i][type_2d] = x->second->CalcStatistics(*y->second, mask);
+        }
+    }
+}
+
+void MonteCarloResultsModel::ApplyStoredStatistics()
+{
+    for (unsigned i = 0; i < plot_data_1d_.size(); ++i)
+        for (const auto& plot_data : plot_data_1d_[i])
+        {
+            auto it = stored_statistics_1d_[i].find(plot_data.first);
+            if (it != stored_statistics_1d_[i].end())
+                plot_data.second->SetStatistics(it->second);
+        }
+    for (unsigned i = 0; i < plot_data_2d_.size(); ++i)
+        for (const auto& plot_data : plot_data_2d_[i])
+        {
+            auto it = stored_statistics_2d_[i].find(plot_data.first);
+            if (it != stored_statistics_2d_[i].end())
+                plot_data.second->SetStatistics(it->second);
+        }
+}
+
 void MonteCarloResultsModel::RecreateDataToIndexMapAndConnectSignals()
 {
     for (auto& object : data_to_index_map_)
@@ -415,8 +558,8 @@ void MonteCarloResultsModel::AddOriginalFitResultsToPlotDataVectors()
     {
         auto& map = plot_data_1d_[i];
         for (auto& plot_data : map)
-            plot_data.second->SetOriginalResult(GetElement(
-                    *original_fit_results_->at(i), plot_data.first).toDouble());
+            plot_data.second->SetOriginalResult(GetDoubleElement(
+                    *original_fit_results_->at(i), plot_data.first));
     }
     for (unsigned i = 0; i < plot_data_2d_.size(); ++i)
     {
@@ -424,10 +567,10 @@ void MonteCarloResultsModel::AddOriginalFitResultsToPlotDataVectors()
         for (auto& plot_data : map)
         {
             plot_data.second->SetOriginalResult(
-                GetElement(*original_fit_results_->at(i),
-                           plot_data.first.first).toDouble(),
-                GetElement(*original_fit_results_->at(i),
-                           plot_data.first.second).toDouble());
+                GetDoubleElement(*original_fit_results_->at(i),
+                           plot_data.first.first),
+                GetDoubleElement(*original_fit_results_->at(i),
+                           plot_data.first.second));
         }
     }
 }
@@ -435,6 +578,9 @@ void MonteCarloResultsModel::AddOriginalFitResultsToPlotDataVectors()
 void MonteCarloResultsModel::UpdatePlot()
 {
     QModelIndex index = data_to_index_map_.at(sender());
+    // Die Maske gehört zur ganzen Probe, daher gelten deren gespeicherte Kenngrößen nicht mehr.
+    stored_statistics_1d_.at(index.row()).clear();
+    stored_statistics_2d_.at(index.row()).clear();
     emit dataChanged(index, index);
     emit AnyDataChanged();
 }
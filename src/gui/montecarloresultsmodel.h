@@ -65,17 +65,25 @@ class MonteCarloResultsModel : public ResultsModel
     Q_OBJECT
 
 public:
+    //! Konstruktor.
+    /*!
+     * \param stored_column_types Spalten, die für jeden Monte-Carlo-Fit
+     * gespeichert werden. Ist die Liste leer, werden alle Spalten gespeichert.
+     * Spalten, für die IsAlwaysStored true liefert, werden immer gespeichert.
+     */
     MonteCarloResultsModel(
             const std::vector<QString>& sample_names,
             const std::vector<ModelParameter>& parameters,
             const std::set<GasType>& gases_in_use,
             unsigned n_monte_carlos,
-            QObject* parent = 0);
+            QObject* parent = 0,
+            const QList<ExtendedColumnType>& stored_column_types =
+                QList<ExtendedColumnType>());
 
     virtual ~MonteCarloResultsModel();
 
     void ProcessMonteCarloResult(
-            std::shared_ptr<FitResults> results,
+            const FitResults& results,
             const std::vector<std::string>& sample_names,
             const std::vector<std::string>& parameter_names,
             const std::vector<SampleConcentrations>& concentrations);
@@ -100,6 +108,25 @@ public:
     const QList<ExtendedColumnType>& GetAvailableColumnTypes() const;
     unsigned NumberOfBins() const;
 
+    //! Gibt die Gaskonzentrationen zurück, die die gespeicherten Spalten benötigen.
+    ResultsRequest GetResultsRequest() const;
+
+    //! Gibt an, ob eine Spalte unabhängig von der Auswahl gespeichert wird.
+    /*!
+     * Das betrifft die Spalten, deren Index von den gefitteten Parametern oder
+     * den verwendeten Gasen abhängt. Sie kosten keine zusätzlichen Berechnungen.
+     */
+    static bool IsAlwaysStored(const ExtendedColumnType& column_type);
+
+    //! Gibt die Speicherblöcke aller Datenreihen zurück, jeden nur einmal und nach Proben geordnet.
+    std::vector<boost::shared_ptr<DataBlock>> GetDataBlocks() const;
+
+    //! Gibt an, ob für alle Proben und Spalten beim Speichern Kenngrößen abgelegt wurden.
+    /*!
+     * Die Zusammenfassung kann dann angezeigt werden, ohne die Speicherblöcke zu laden.
+     */
+    bool AreSummaryStatisticsStored() const;
+
 public slots:
     void SetColumnTypes(const QList<ColumnTypeVariant>& column_types);
     void SetNumberOfBins(int n_bins);
@@ -114,10 +141,24 @@ private:
     static const QList<ColumnTypeVariant> PrepareColumnTypes(
             unsigned n_parameters, unsigned n_gases);
 
+    const QList<ExtendedColumnType> PrepareAvailableColumnTypes(
+            const QList<ExtendedColumnType>& stored_column_types) const;
+
+    //! Legt den Speicherblock einer Probe an und die Datenreihen als Ausschnitte davon.
+    void AllocateBlock(unsigned sample);
+
     void RecreateDataToIndexMapAndConnectSignals();
     void AddToDataToIndexMapAndConnectSignals(
             HistogramDataBase* data, int line, int column) const;
 
+    //! Bestimmt die Kenngrößen aller Spalten zur aktuellen Maske, wie sie gespeichert werden.
+    void CalcSummaryStatistics(
+            std::vector<std::map<ExtendedColumnType, DataStatistics>>& statistics_1d,
+            std::vector<std::map<ColumnType2D, DataCoStatistics>>& statistics_2d) const;
+
+    //! Übergibt die gespeicherten Kenngrößen an die bereits angelegten Histogramme.
+    void ApplyStoredStatistics();
+
     //! \brief Wird benötigt um auch bei älteren Save-Files die Fitergebnisse
     //! in den MC-Plots anzuzeigen.
     void AddOriginalFitResultsToPlotDataVectors();
@@ -145,6 +186,21 @@ private:
     std::vector<SharedMask> masks_;
     std::vector<boost::shared_ptr<std::vector<Eigen::LM::Status>>> exit_flags_;
 
+    //! Monte-Carlo-Ergebnisse je Probe, spaltenweise (Spalten wie in available_column_types_).
+    /*!
+     * Wird nur zum Einlesen neuer Ergebnisse benötigt und nicht gespeichert; die Datenreihen
+     * in monte_carlo_data_ verweisen auf diese Blöcke.
+     */
+    std::vector<boost::shared_ptr<std::vector<double>>> blocks_;
+
+    //! Beim Laden gelesene Kenngrößen je Probe und Spalte zur gespeicherten Maske.
+    /*!
+     * Neu angelegte Histogramme übernehmen sie. Ändert sich ein Histogramm einer Probe und
+     * damit womöglich deren Maske, werden die Kenngrößen dieser Probe verworfen.
+     */
+    std::vector<std::map<ExtendedColumnType, DataStatistics>> stored_statistics_1d_;
+    std::vector<std::map<ColumnType2D, DataCoStatistics>> stored_statistics_2d_;
+
     mutable std::map<QObject*, QModelIndex> data_to_index_map_;
 
     //! \brief Wird benötigt um auch bei älteren Save-Files die Fitergebnisse
@@ -210,6 +266,12 @@ private:
            << plot_data_2d_
            << masks_
            << exit_flags_;
+
+        std::vector<std::map<ExtendedColumnType, DataStatistics>> statistics_1d;
+        std::vector<std::map<ColumnType2D, DataCoStatistics>> statistics_2d;
+        CalcSummaryStatistics(statistics_1d, statistics_2d);
+        ar << statistics_1d
+           << statistics_2d;
     }
 
     template<class Archive>
@@ -257,13 +319,21 @@ private:
         if (version < 1)
             original_fit_results_need_to_be_added_to_plot_data_vectors_ = true;
 
+        // Ältere Dateien enthalten keine Kenngrößen, sie werden dann aus den Daten berechnet.
+        if (version >= 4)
+            ar >> stored_statistics_1d_
+               >> stored_statistics_2d_;
+        stored_statistics_1d_.resize(monte_carlo_data_.size());
+        stored_statistics_2d_.resize(monte_carlo_data_.size());
+
         RecreateDataToIndexMapAndConnectSignals();
+        ApplyStoredStatistics();
     }
 
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
-BOOST_CLASS_VERSION(MonteCarloResultsModel, 3)
+BOOST_CLASS_VERSION(MonteCarloResultsModel, 4)
 
 namespace boost { namespace serialization {
 template<class Archive>
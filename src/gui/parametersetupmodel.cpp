@@ -20,8 +20,6 @@
 #include <cassert>
 #include <stdexcept>
 
-#include "core/misc/templates.h"
-
 #include "parametersetupmodel.h"
 
 ParameterSetupModel::ParameterSetupModel(QObject* parent) :
@@ -188,8 +186,7 @@ double ParameterSetupModel::GetValue(QString parameter_name,
     int i = parameter_names_in_header_.indexOf(parameter_name);
     if (i < 0) throw ParameterNotInHeaderError(parameter_name);
          
-    unsigned j = TransformSequenceIndexToSkipElements(
-            samples_enabled_states_, sample_number, [](bool b) { return b; });
+    unsigned j = samples_enabled_states_.Select(sample_number);
         
     return values_.at(i).at(j);
 }
@@ -225,7 +222,7 @@ void ParameterSetupModel::SetSampleNames(
     }
     else
         row_count_ = 0;
-    samples_enabled_states_ = std::vector<bool>(new_sample_names.size(), true);
+    samples_enabled_states_ = RankSelectBitVector(new_sample_names.size(), true);
     emit LineNumberChanged();
 }
 
@@ -238,10 +235,10 @@ void ParameterSetupModel::InitializeValues()
 
 void ParameterSetupModel::DisableSample(unsigned int index)
 {
-    samples_enabled_states_.at(index) = false;
+    samples_enabled_states_.Set(index, false);
 }
 
 void ParameterSetupModel::EnableSample(unsigned int index)
 {
-    samples_enabled_states_.at(index) = true;
+    samples_enabled_states_.Set(index, true);
 }
@@ -22,11 +22,14 @@
 #include <QAbstractTableModel>
 #include <QStringList>
 
+#include <boost/serialization/split_member.hpp>
 #include <boost/serialization/vector.hpp>
 
 #include <string>
 #include <vector>
 
+#include "core/misc/rankselectbitvector.h"
+
 #include "serializationhelpers.h"
 
 class ParameterSetupModel : public QAbstractTableModel
@@ -88,26 +91,50 @@ private:
      * Äußerer Vektor: Spalten; Innerer Vektor: Zeilen
      */
     std::vector<std::vector<double>> values_;
-    std::vector<bool> samples_enabled_states_;
+    RankSelectBitVector samples_enabled_states_;
     
     bool immutable_;
 
     friend class boost::serialization::access;
     
     template<class Archive>
-    void serialize(Archive& ar, const unsigned int version);
+    void save(Archive& ar, const unsigned int version) const;
+
+    template<class Archive>
+    void load(Archive& ar, const unsigned int version);
+
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
 template<class Archive>
-void ParameterSetupModel::serialize(Archive& ar, const unsigned int version)
+void ParameterSetupModel::save(Archive& ar, const unsigned int version) const
+{
+    std::vector<bool> samples_enabled_states(samples_enabled_states_.size());
+    for (unsigned i = 0; i < samples_enabled_states.size(); ++i)
+        samples_enabled_states[i] = samples_enabled_states_[i];
+    ar << column_count_
+       << row_count_
+       << sample_names_
+       << parameter_names_in_header_
+       << parameter_names_
+       << values_
+       << samples_enabled_states;
+}
+
+template<class Archive>
+void ParameterSetupModel::load(Archive& ar, const unsigned int version)
 {
-    ar & column_count_
-       & row_count_
-       & sample_names_
-       & parameter_names_in_header_
-       & parameter_names_
-       & values_
-       & samples_enabled_states_;
+    std::vector<bool> samples_enabled_states;
+    ar >> column_count_
+       >> row_count_
+       >> sample_names_
+       >> parameter_names_in_header_
+       >> parameter_names_
+       >> values_
+       >> samples_enabled_states;
+    samples_enabled_states_.clear();
+    for (bool enabled : samples_enabled_states)
+        samples_enabled_states_.push_back(enabled);
 }
 
 #endif // PARAMETERSETUPMODEL_H
\ No newline at end of file
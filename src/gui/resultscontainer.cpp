@@ -0,0 +1,446 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "datavector.h"
+#include "fitsetup.h"
+#include "histogramdata1d.h"
+#include "histogramdata2d.h"
+#include "montecarloplotdelegate.h"
+#include "montecarloresultsmodel.h"
+#include "standardfitresultsmodel.h"
+
+#include "resultscontainer.h"
+
+namespace
+{
+const char MAGIC[8] = {'P', 'A', 'N', 'G', 'A', 'R', 'C', '\x1a'};
+const std::uint32_t FORMAT_VERSION = 2;
+
+//! Größe der unabhängig voneinander komprimierten Teile eines Abschnitts.
+/*!
+ * Seit Version 2 werden Abschnitte in solche Teile zerlegt, damit auch einzelne große
+ * Blöcke parallel komprimiert und entpackt werden können.
+ */
+const std::size_t FRAME_SIZE = 1 << 22;
+
+struct FileHeader
+{
+    std::uint32_t version;
+    //! Zufällige Kennung, an der nachzuladende Blöcke erkennen, ob die Datei ersetzt wurde.
+    std::uint64_t file_id;
+    std::uint64_t index_offset;
+};
+
+struct Frame
+{
+    std::uint64_t offset;
+    std::uint64_t compressed_size;
+    std::uint64_t size;
+};
+
+typedef std::vector<Frame> ChunkInfo;
+
+//! Ruft func(i) für alle i < n auf, verteilt auf alle Kerne.
+/*!
+ * Wirft eine der Ausnahmen, die in func aufgetreten sind.
+ */
+template<class Function>
+void ParallelFor(std::size_t n, Function func)
+{
+    unsigned n_threads = boost::thread::hardware_concurrency();
+    if (n_threads == 0) n_threads = 1;
+    n_threads = std::min<std::size_t>(n_threads, n);
+
+    std::atomic<std::size_t> next(0);
+    boost::mutex mutex;
+    std::exception_ptr error;
+    auto work = [&]()
+    {
+        try
+        {
+            for (std::size_t i; (i = next++) < n; )
+                func(i);
+        }
+        catch (...)
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            if (!error)
+                error = std::current_exception();
+            next = n;
+        }
+    };
+
+    boost::thread_group threads;
+    for (unsigned t = 1; t < n_threads; ++t)
+        threads.create_thread(work);
+    work();
+    threads.join_all();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+template<class T>
+void WriteValue(std::ostream& os, T value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<class T>
+T ReadValue(std::istream& is)
+{
+    T value;
+    is.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+std::string Compress(const char* data, std::size_t size)
+{
+    std::string compressed;
+    boost::iostreams::filtering_ostream f;
+    f.push(boost::iostreams::zlib_compressor());
+    f.push(boost::iostreams::back_inserter(compressed));
+    f.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    f.write(data, size);
+    f.reset();
+    return compressed;
+}
+
+//! Entpackt einen Abschnitt und prüft dabei dessen Größe.
+std::string Decompress(const std::string& compressed, std::uint64_t size)
+{
+    std::string data;
+    data.reserve(size);
+    boost::iostreams::filtering_ostream f;
+    f.push(boost::iostreams::zlib_decompressor());
+    f.push(boost::iostreams::back_inserter(data));
+    f.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    f.write(compressed.data(), compressed.size());
+    f.reset();
+    if (data.size() != size)
+        throw std::runtime_error("Corrupt results container.");
+    return data;
+}
+
+void OpenForReading(std::ifstream& ifs, const std::string& filename)
+{
+    ifs.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    ifs.open(filename, std::ios_base::binary);
+}
+
+FileHeader ReadFileHeader(std::istream& is)
+{
+    char magic[sizeof(MAGIC)];
+    is.read(magic, sizeof(magic));
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("Not a results container.");
+    FileHeader header;
+    header.version = ReadValue<std::uint32_t>(is);
+    if (header.version > FORMAT_VERSION)
+        throw std::runtime_error("The file was created by a newer version.");
+    header.file_id = ReadValue<std::uint64_t>(is);
+    header.index_offset = ReadValue<std::uint64_t>(is);
+    return header;
+}
+
+//! Liest das Inhaltsverzeichnis einer Datei der Formatversion version.
+std::vector<ChunkInfo> ReadIndex(std::istream& is, std::uint32_t version)
+{
+    const std::uint32_t n_chunks = ReadValue<std::uint32_t>(is);
+    std::vector<ChunkInfo> chunks(n_chunks);
+    for (auto& chunk : chunks)
+    {
+        // Bis Version 1 bestand jeder Abschnitt aus einem Teil.
+        const std::uint32_t n_frames = version >= 2 ? ReadValue<std::uint32_t>(is) : 1;
+        chunk.resize(n_frames);
+        for (auto& frame : chunk)
+        {
+            frame.offset = ReadValue<std::uint64_t>(is);
+            frame.compressed_size = ReadValue<std::uint64_t>(is);
+            frame.size = ReadValue<std::uint64_t>(is);
+        }
+    }
+    return chunks;
+}
+
+std::uint64_t GetSize(const ChunkInfo& chunk)
+{
+    std::uint64_t size = 0;
+    for (const auto& frame : chunk)
+        size += frame.size;
+    return size;
+}
+
+//! Liest einen Abschnitt und entpackt seine Teile parallel.
+std::string ReadChunk(std::istream& is, const ChunkInfo& chunk)
+{
+    std::vector<std::string> compressed(chunk.size());
+    for (std::size_t i = 0; i < chunk.size(); ++i)
+    {
+        compressed[i].resize(chunk[i].compressed_size);
+        is.seekg(chunk[i].offset);
+        is.read(&compressed[i][0], compressed[i].size());
+    }
+
+    std::vector<std::uint64_t> starts(1, 0);
+    for (const auto& frame : chunk)
+        starts.push_back(starts.back() + frame.size);
+
+    std::string data(starts.back(), '\0');
+    ParallelFor(chunk.size(), [&](std::size_t i)
+    {
+        const std::string frame = Decompress(compressed[i], chunk[i].size);
+        std::copy(frame.begin(), frame.end(), data.begin() + starts[i]);
+    });
+    return data;
+}
+
+//! Liest einen Block beim ersten Zugriff auf eine seiner Datenreihen.
+std::vector<double> LoadBlock(const std::string& filename,
+                              std::uint64_t file_id,
+                              const ChunkInfo& chunk)
+{
+    std::ifstream ifs;
+    OpenForReading(ifs, filename);
+    if (ReadFileHeader(ifs).file_id != file_id)
+        throw std::runtime_error("The results file " + filename +
+                                 " has been replaced since it was opened.");
+    const std::string data = ReadChunk(ifs, chunk);
+    if (data.size() % sizeof(double))
+        throw std::runtime_error("Corrupt data block in " + filename + ".");
+    std::vector<double> values(data.size() / sizeof(double));
+    std::memcpy(values.data(), data.data(), data.size());
+    return values;
+}
+
+//! Sammelt beim Speichern die Blöcke der Datenreihen.
+class BlockCollector : public DataBlockStore
+{
+public:
+    unsigned Add(const boost::shared_ptr<std::vector<double>>& values)
+    {
+        auto it = ids_.find(values.get());
+        if (it != ids_.end())
+            return it->second;
+        const unsigned id = blocks_.size();
+        ids_[values.get()] = id;
+        blocks_.push_back(values);
+        return id;
+    }
+
+    boost::shared_ptr<DataBlock> Get(unsigned)
+    {
+        throw std::logic_error("BlockCollector can only be used for saving.");
+    }
+
+    const std::vector<boost::shared_ptr<std::vector<double>>>& GetBlocks() const
+    {
+        return blocks_;
+    }
+
+private:
+    std::vector<boost::shared_ptr<std::vector<double>>> blocks_;
+    std::map<const std::vector<double>*, unsigned> ids_;
+};
+
+//! Stellt beim Lesen Blöcke bereit, die erst beim ersten Zugriff geladen werden.
+class LazyBlockStore : public DataBlockStore
+{
+public:
+    LazyBlockStore(const std::string& filename,
+                   std::uint64_t file_id,
+                   const std::vector<ChunkInfo>& chunks) :
+        filename_(filename),
+        file_id_(file_id),
+        chunks_(chunks),
+        blocks_()
+    {
+    }
+
+    unsigned Add(const boost::shared_ptr<std::vector<double>>&)
+    {
+        throw std::logic_error("LazyBlockStore can only be used for loading.");
+    }
+
+    boost::shared_ptr<DataBlock> Get(unsigned id)
+    {
+        if (std::size_t(id) + 1 >= chunks_.size())
+            throw std::runtime_error("Reference to missing data block.");
+        auto& block = blocks_[id];
+        if (!block)
+        {
+            const std::string filename = filename_;
+            const std::uint64_t file_id = file_id_;
+            const ChunkInfo chunk = chunks_[id + 1];
+            block = boost::make_shared<DataBlock>([filename, file_id, chunk]()
+            {
+                return LoadBlock(filename, file_id, chunk);
+            });
+        }
+        return block;
+    }
+
+private:
+    const std::string filename_;
+    const std::uint64_t file_id_;
+    const std::vector<ChunkInfo> chunks_;
+    std::map<unsigned, boost::shared_ptr<DataBlock>> blocks_;
+};
+}
+
+bool ResultsContainer::IsContainer(const QString& filename)
+{
+    std::ifstream ifs(filename.toStdString(), std::ios_base::binary);
+    char magic[sizeof(MAGIC)];
+    return ifs.read(magic, sizeof(magic)) &&
+           std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void ResultsContainer::Write(const QString& filename,
+                             StandardFitResultsModel* results_model,
+                             MonteCarloResultsModel* monte_carlo_model,
+                             FitSetup* fit_setup,
+                             const ProgressCallback& progress)
+{
+    BlockCollector collector;
+    std::ostringstream archive;
+    {
+        DataBlockStore::Activation activation(collector);
+        boost::archive::binary_oarchive oa(archive);
+        oa << results_model
+           << monte_carlo_model
+           << fit_setup;
+    }
+    const std::string header = archive.str();
+
+    // Alle Abschnitte in Teile zerlegen, die dann parallel komprimiert werden.
+    struct Job
+    {
+        const char* data;
+        std::size_t size;
+        std::string compressed;
+    };
+    std::vector<Job> jobs;
+    std::vector<std::size_t> frames_per_chunk;
+    auto add_chunk = [&](const char* data, std::size_t size)
+    {
+        std::size_t n_frames = 0;
+        for (std::size_t start = 0; start < size || n_frames == 0; start += FRAME_SIZE)
+        {
+            jobs.push_back({data + start, std::min(FRAME_SIZE, size - start), std::string()});
+            ++n_frames;
+        }
+        frames_per_chunk.push_back(n_frames);
+    };
+    add_chunk(header.data(), header.size());
+    for (const auto& block : collector.GetBlocks())
+        add_chunk(reinterpret_cast<const char*>(block->data()),
+                  block->size() * sizeof(double));
+
+    boost::mutex progress_mutex;
+    std::size_t n_compressed = 0;
+    ParallelFor(jobs.size(), [&](std::size_t i)
+    {
+        jobs[i].compressed = Compress(jobs[i].data, jobs[i].size);
+        if (progress)
+        {
+            boost::lock_guard<boost::mutex> lock(progress_mutex);
+            progress(100 * ++n_compressed / jobs.size());
+        }
+    });
+
+    std::random_device random_device;
+    const std::uint64_t file_id =
+            (std::uint64_t(random_device()) << 32) ^ random_device();
+
+    std::ofstream ofs(filename.toStdString(), std::ios_base::binary);
+    ofs.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    ofs.write(MAGIC, sizeof(MAGIC));
+    WriteValue<std::uint32_t>(ofs, FORMAT_VERSION);
+    WriteValue<std::uint64_t>(ofs, file_id);
+    const std::streamoff index_offset_position = ofs.tellp();
+    WriteValue<std::uint64_t>(ofs, 0);
+
+    std::vector<std::uint64_t> offsets;
+    for (const auto& job : jobs)
+    {
+        offsets.push_back(ofs.tellp());
+        ofs.write(job.compressed.data(), job.compressed.size());
+    }
+
+    const std::uint64_t index_offset = ofs.tellp();
+    WriteValue<std::uint32_t>(ofs, frames_per_chunk.size());
+    std::size_t i = 0;
+    for (std::size_t n_frames : frames_per_chunk)
+    {
+        WriteValue<std::uint32_t>(ofs, n_frames);
+        for (std::size_t end = i + n_frames; i < end; ++i)
+        {
+            WriteValue<std::uint64_t>(ofs, offsets[i]);
+            WriteValue<std::uint64_t>(ofs, jobs[i].compressed.size());
+            WriteValue<std::uint64_t>(ofs, jobs[i].size);
+        }
+    }
+
+    ofs.seekp(index_offset_position);
+    WriteValue<std::uint64_t>(ofs, index_offset);
+}
+
+void ResultsContainer::Read(const QString& filename,
+                            StandardFitResultsModel*& results_model,
+                            MonteCarloResultsModel*& monte_carlo_model,
+                            FitSetup*& fit_setup)
+{
+    std::ifstream ifs;
+    OpenForReading(ifs, filename.toStdString());
+    const FileHeader header = ReadFileHeader(ifs);
+
+    ifs.seekg(header.index_offset);
+    const std::vector<ChunkInfo> chunks = ReadIndex(ifs, header.version);
+    if (chunks.empty())
+        throw std::runtime_error("The results container is empty.");
+
+    const std::string archive = ReadChunk(ifs, chunks[0]);
+
+    LazyBlockStore store(filename.toStdString(), header.file_id, chunks);
+    DataBlockStore::Activation activation(store);
+    std::istringstream iss(archive);
+    boost::archive::binary_iarchive ia(iss);
+    ia >> results_model
+       >> monte_carlo_model
+       >> fit_setup;
+}
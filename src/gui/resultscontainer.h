@@ -0,0 +1,77 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RESULTSCONTAINER_H
+#define RESULTSCONTAINER_H
+
+#include <QString>
+
+#include <functional>
+
+class FitSetup;
+class MonteCarloResultsModel;
+class StandardFitResultsModel;
+
+//! Containerformat für binäre Ergebnisdateien.
+/*!
+ * Aufbau (Zahlen in der Bytereihenfolge des Systems, wie beim binären Archiv):
+ * - Kennung (8 Bytes), Formatversion (uint32), Position des Inhaltsverzeichnisses (uint64)
+ * - Abschnitte, zerlegt in Teile von höchstens 4 MiB, die jeweils für sich mit zlib
+ *   komprimiert sind und daher parallel komprimiert und entpackt werden
+ * - Inhaltsverzeichnis: Zahl der Abschnitte (uint32), je Abschnitt die Zahl seiner Teile
+ *   (uint32) und je Teil Position sowie komprimierte und unkomprimierte Größe (je uint64)
+ *
+ * Abschnitt 0 enthält die Modelle und das FitSetup als binäres Archiv. Die Datenreihen der
+ * Monte-Carlo-Ergebnisse verweisen darin nur auf ihre Speicherblöcke (siehe DataBlockStore),
+ * Block i liegt in Abschnitt i + 1. Beim Öffnen wird nur Abschnitt 0 gelesen; die Blöcke
+ * werden erst entpackt, wenn ein Plot oder eine Statistik sie benötigt. Die Kenngrößen der
+ * Monte-Carlo-Zusammenfassung liegen mit dem MonteCarloResultsModel ebenfalls in Abschnitt 0.
+ */
+class ResultsContainer
+{
+public:
+    //! Erhält den Fortschritt beim Speichern in Prozent. Wird aus Arbeitsthreads aufgerufen.
+    typedef std::function<void(int)> ProgressCallback;
+
+    //! Prüft anhand der Kennung am Dateianfang, ob filename ein Container ist.
+    static bool IsContainer(const QString& filename);
+
+    //! Speichert die Ergebnisse.
+    /*!
+     * Die Datei wird erst geöffnet, wenn alle Abschnitte im Speicher vorliegen. Daher
+     * kann auch in die Datei gespeichert werden, aus der noch Blöcke nachgeladen werden.
+     * Wirft bei Fehlern eine von std::exception abgeleitete Ausnahme.
+     */
+    static void Write(const QString& filename,
+                      StandardFitResultsModel* results_model,
+                      MonteCarloResultsModel* monte_carlo_model,
+                      FitSetup* fit_setup,
+                      const ProgressCallback& progress = ProgressCallback());
+
+    //! Liest die Ergebnisse.
+    /*!
+     * Wirft bei Fehlern eine von std::exception abgeleitete Ausnahme. Bereits gelesene
+     * Objekte müssen dann vom Aufrufer gelöscht werden.
+     */
+    static void Read(const QString& filename,
+                     StandardFitResultsModel*& results_model,
+                     MonteCarloResultsModel*& monte_carlo_model,
+                     FitSetup*& fit_setup);
+};
+
+#endif // RESULTSCONTAINER_H
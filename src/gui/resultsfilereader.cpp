@@ -0,0 +1,215 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/codecvt_null.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/math/special_functions/nonfinite_num_facets.hpp>
+
+#include <fstream>
+#include <locale>
+#include <stdexcept>
+
+#include "fitsetup.h"
+#include "histogramdata1d.h"
+#include "histogramdata2d.h"
+#include "montecarloplotdelegate.h"
+#include "montecarloresultsmodel.h"
+#include "resultscontainer.h"
+#include "resultsmodel.h"
+#include "standardfitresultsmodel.h"
+
+#include "resultsfilereader.h"
+
+ResultsFileReader::ResultsFileReader() :
+    results_model_(nullptr),
+    monte_carlo_model_(nullptr),
+    fit_setup_(nullptr),
+    is_binary_(false),
+    error_message_()
+{
+}
+
+ResultsFileReader::~ResultsFileReader()
+{
+    Clear();
+}
+
+ResultsFileReader::Format ResultsFileReader::DetectFormat(const QString& filename)
+{
+    if (ResultsContainer::IsContainer(filename))
+        return Format::CONTAINER;
+
+    static const std::string SIGNATURE = "serialization::archive";
+
+    std::ifstream ifs(filename.toStdString(), std::ios_base::binary);
+    char buffer[40];
+    ifs.read(buffer, sizeof(buffer));
+    const std::string start(buffer, ifs.gcount());
+
+    // Textarchive beginnen mit der Länge der Signatur als Text, binäre Archive
+    // mit der Länge als size_t (4 oder 8 Bytes).
+    if (start.compare(0, 3 + SIGNATURE.size(), "22 " + SIGNATURE) == 0)
+        return Format::PORTABLE_ARCHIVE;
+    if (start.size() >= 8 + SIGNATURE.size() && start[0] == 22 &&
+        (start.compare(4, SIGNATURE.size(), SIGNATURE) == 0 ||
+         start.compare(8, SIGNATURE.size(), SIGNATURE) == 0))
+        return Format::BINARY_ARCHIVE;
+
+    // zlib-Kopf (RFC 1950): Deflate mit 32 KiB Fenster, Prüfsumme über die ersten
+    // beiden Bytes.
+    if (start.size() >= 2)
+    {
+        const unsigned char cmf = start[0];
+        const unsigned char flg = start[1];
+        if ((cmf & 0x0f) == 8 && (cmf >> 4) <= 7 && (cmf * 256 + flg) % 31 == 0)
+            return Format::COMPRESSED_PORTABLE_ARCHIVE;
+    }
+    return Format::UNKNOWN;
+}
+
+bool ResultsFileReader::Read(const QString& filename)
+{
+    Clear();
+    error_message_.clear();
+
+    // Die geänderten Locales sind notwendig um Inf und NaN zuverlässig und
+    // platformunabhängig zu speichern.
+    std::locale default_locale(std::locale::classic(),
+                               new boost::archive::codecvt_null<char>);
+    std::locale in_locale(default_locale,
+                          new boost::math::nonfinite_num_get<char>);
+
+    try
+    {
+        switch (DetectFormat(filename))
+        {
+        case Format::CONTAINER:
+            ResultsContainer::Read(filename,
+                                   results_model_,
+                                   monte_carlo_model_,
+                                   fit_setup_);
+            is_binary_ = true;
+            return true;
+
+        case Format::BINARY_ARCHIVE:
+        {
+            // Binäre Archive wurden vor Einführung des Containerformats geschrieben.
+            std::ifstream ifs(filename.toStdString(), std::ios_base::binary);
+            boost::archive::binary_iarchive ia(ifs);
+            ReadArchive(ia);
+            is_binary_ = true;
+            return true;
+        }
+
+        case Format::PORTABLE_ARCHIVE:
+        {
+            // Unkomprimierte Dateien werden nur noch unter OSX geschrieben.
+            std::ifstream ifs(filename.toStdString());
+            ifs.imbue(in_locale);
+            boost::archive::text_iarchive ia(ifs, boost::archive::no_codecvt);
+            ReadArchive(ia);
+            is_binary_ = false;
+            return true;
+        }
+
+        case Format::COMPRESSED_PORTABLE_ARCHIVE:
+        {
+            std::ifstream ifs(filename.toStdString(), std::ios_base::binary);
+            boost::iostreams::filtering_istream f;
+            f.push(boost::iostreams::zlib_decompressor());
+            f.push(ifs);
+            f.imbue(in_locale);
+            boost::archive::text_iarchive ia(f, boost::archive::no_codecvt);
+            ReadArchive(ia);
+            is_binary_ = false;
+            return true;
+        }
+
+        case Format::UNKNOWN:
+            if (!std::ifstream(filename.toStdString()))
+                error_message_ = "The file could not be opened.";
+            else
+                error_message_ = "Unknown file format.";
+            break;
+        }
+    }
+    catch (std::exception& e)
+    {
+        error_message_ = e.what();
+    }
+    catch (...)
+    {
+    }
+    Clear();
+
+    return false;
+}
+
+QString ResultsFileReader::GetErrorMessage() const
+{
+    if (error_message_.empty())
+        return "unknown error.";
+    return "\n" + QString::fromStdString(error_message_);
+}
+
+bool ResultsFileReader::IsBinary() const
+{
+    return is_binary_;
+}
+
+StandardFitResultsModel* ResultsFileReader::TakeResultsModel()
+{
+    StandardFitResultsModel* model = results_model_;
+    results_model_ = nullptr;
+    return model;
+}
+
+MonteCarloResultsModel* ResultsFileReader::TakeMonteCarloModel()
+{
+    MonteCarloResultsModel* model = monte_carlo_model_;
+    monte_carlo_model_ = nullptr;
+    return model;
+}
+
+FitSetup* ResultsFileReader::TakeFitSetup()
+{
+    FitSetup* fit_setup = fit_setup_;
+    fit_setup_ = nullptr;
+    return fit_setup;
+}
+
+template<class Archive>
+void ResultsFileReader::ReadArchive(Archive& ia)
+{
+    ia >> results_model_
+       >> monte_carlo_model_
+       >> fit_setup_;
+}
+
+void ResultsFileReader::Clear()
+{
+    delete results_model_;
+    delete monte_carlo_model_;
+    delete fit_setup_;
+    results_model_ = nullptr;
+    monte_carlo_model_ = nullptr;
+    fit_setup_ = nullptr;
+}
@@ -0,0 +1,86 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RESULTSFILEREADER_H
+#define RESULTSFILEREADER_H
+
+#include <QString>
+
+#include <string>
+
+class FitSetup;
+class MonteCarloResultsModel;
+class StandardFitResultsModel;
+
+//! Liest mit ResultsWindow gespeicherte Ergebnisdateien.
+/*!
+ * Nicht übernommene Objekte werden mit dem Leser gelöscht.
+ */
+class ResultsFileReader
+{
+public:
+    //! Formate, in denen Ergebnisdateien vorliegen können.
+    enum class Format
+    {
+        CONTAINER,
+        BINARY_ARCHIVE,
+        PORTABLE_ARCHIVE,
+        COMPRESSED_PORTABLE_ARCHIVE,
+        UNKNOWN
+    };
+
+    ResultsFileReader();
+    ~ResultsFileReader();
+
+    //! Bestimmt das Format einer Datei anhand ihrer ersten Bytes.
+    static Format DetectFormat(const QString& filename);
+
+    //! Liest die Datei mit dem Decoder des erkannten Formats.
+    /*!
+     * \return Wahr, falls die Datei gelesen werden konnte.
+     */
+    bool Read(const QString& filename);
+
+    //! Beschreibt, woran das Lesen gescheitert ist.
+    QString GetErrorMessage() const;
+
+    //! Gibt an, ob die Datei im binären Format vorlag.
+    bool IsBinary() const;
+
+    StandardFitResultsModel* TakeResultsModel();
+    MonteCarloResultsModel* TakeMonteCarloModel();
+    FitSetup* TakeFitSetup();
+
+private:
+    ResultsFileReader(const ResultsFileReader&) = delete;
+    ResultsFileReader& operator=(const ResultsFileReader&) = delete;
+
+    void Clear();
+
+    //! Liest die Modelle aus einem Boost-Archiv.
+    template<class Archive>
+    void ReadArchive(Archive& ia);
+
+    StandardFitResultsModel* results_model_;
+    MonteCarloResultsModel* monte_carlo_model_;
+    FitSetup* fit_setup_;
+    bool is_binary_;
+    std::string error_message_;
+};
+
+#endif // RESULTSFILEREADER_H
@@ -131,109 +131,73 @@ const QList<ExtendedColumnType> ResultsModel::GetDoubleColumnTypes() const
     return available_column_types;
 }
 
+ResultsRequest ResultsModel::DetermineResultsRequest(
+        const QList<ExtendedColumnType>& column_types) const
+{
+    ResultsRequest request;
+    for (const auto& column_type : column_types)
+    {
+        const GasType gas = static_cast<GasType>(column_type.second);
+        switch (column_type.first)
+        {
+        case ColumnType::EQUILIBRIUM_CONCENTRATION:
+            request.Request(gas, ResultsRequest::EQUILIBRIUM_VALUE);
+            break;
+        case ColumnType::EQUILIBRIUM_CONCENTRATION_ERROR:
+            request.Request(gas, ResultsRequest::EQUILIBRIUM_ERROR);
+            break;
+        case ColumnType::MODEL_CONCENTRATION:
+            request.Request(gas, ResultsRequest::MODEL_VALUE);
+            break;
+        case ColumnType::MODEL_CONCENTRATION_ERROR:
+            request.Request(gas, ResultsRequest::MODEL_ERROR);
+            break;
+        case ColumnType::MEASURED_CONCENTRATION:
+        case ColumnType::MEASURED_CONCENTRATION_ERROR:
+            request.Request(gas, ResultsRequest::MEASURED);
+            break;
+        case ColumnType::DELTA_NEON:
+        case ColumnType::DELTA_NEON_ERROR:
+            request.Request(Gas::NE, ResultsRequest::MEASURED |
+                                     ResultsRequest::EQUILIBRIUM_VALUE |
+                                     ResultsRequest::EQUILIBRIUM_ERROR);
+            break;
+        case ColumnType::RAD_HE:
+        case ColumnType::RAD_HE_ERROR:
+        case ColumnType::RAD_HE3:
+        case ColumnType::RAD_HE3_ERROR:
+            request.Request(Gas::HE, ResultsRequest::MEASURED |
+                                     ResultsRequest::MODEL_VALUE |
+                                     ResultsRequest::MODEL_ERROR);
+            break;
+        default:
+            break;
+        }
+    }
+    return request;
+}
+
 QVariant ResultsModel::GetElement( //(note) Für einen Column Type, welche werden alle abgefragt?
         const FitResults& results,
         const ExtendedColumnType& column_type) const
 {
     try
     {
-        unsigned i = column_type.second; //Hier wird Gas gewählt
         switch (column_type.first)
         {
             case ColumnType::DEGREES_OF_FREEDOM:
                 return results.degrees_of_freedom;
-            case ColumnType::CHI_SQUARE:
-                return results.chi_square;
-            case ColumnType::CHI:
-                return std::sqrt(results.chi_square);
             case ColumnType::PROBABILITY:
-            {
-                using boost::math::cdf;
-                using boost::math::chi_squared;
                 if (std::isnan(results.chi_square) ||
                     results.degrees_of_freedom <= 0)
                     return "nan";
-                else
-                    return 100. * (1. - cdf(
-                        chi_squared(results.degrees_of_freedom),
-                        results.chi_square));
-            }
-            case ColumnType::PARAMETER_ESTIMATE:
-                return results.best_estimate(i);
-            case ColumnType::PARAMETER_ESTIMATE_ERROR:
-                return results.deviations.size() ?
-                        results.deviations(i) :
-                        std::numeric_limits<double>::quiet_NaN();
+                break;
             case ColumnType::CONVERGENCE:
                 return QString::fromStdString(results.GetExitFlagAsString());
-            case ColumnType::CORRELATION:
-            {
-                const auto indices = GetCovarianceMatrixIndexes(i);
-                return results.CorrelationCoefficient(indices.first,
-                                                      indices.second);
-            }
-            case ColumnType::RESIDUAL:
-                return GetResidualForGas(results, i);
-            case ColumnType::DELTA_NEON:
-                return GetDeltaNeon(results);
-            case ColumnType::DELTA_NEON_ERROR:
-                 return GetDeltaNeonError(results);
-            case ColumnType::RAD_HE:
-                return (results.measured_concentrations.at(0).at(                    
-                        static_cast<GasType>(0)).value
-                        - results.model_concentrations.at(0).at(
-                        static_cast<GasType>(0)).value);
-            case ColumnType::RAD_HE_ERROR:
-                return std::sqrt(
-                    std::pow(
-                        results.measured_concentrations.at(0).at(
-                        static_cast<GasType>(0)).error,
-                        2.0
-                    )
-                    + std::pow(
-                        results.model_concentrations.at(0).at(
-                        static_cast<GasType>(i)).error,
-                        2.0
-                    )
-                );
-            case ColumnType::RAD_HE3:
-                return 0.00000002*( //(todo): in physical properties!
-                        results.measured_concentrations.at(0).at(                    
-                        static_cast<GasType>(0)).value
-                        - results.model_concentrations.at(0).at(
-                        static_cast<GasType>(0)).value);
-            case ColumnType::RAD_HE3_ERROR: 
-                return 0.00000002*std::sqrt(
-                    std::pow(
-                        results.measured_concentrations.at(0).at(
-                        static_cast<GasType>(0)).error,
-                        2.0
-                    )
-                    + std::pow(
-                        results.model_concentrations.at(0).at(
-                        static_cast<GasType>(i)).error,
-                        2.0
-                    )
-                );
-            case ColumnType::EQUILIBRIUM_CONCENTRATION:
-                return results.equilibrium_concentrations.at(0).at(
-                        static_cast<GasType>(i)).value;
-            case ColumnType::EQUILIBRIUM_CONCENTRATION_ERROR:
-                return results.equilibrium_concentrations.at(0).at(
-                        static_cast<GasType>(i)).error;
-            case ColumnType::MODEL_CONCENTRATION:
-                return results.model_concentrations.at(0).at(
-                        static_cast<GasType>(i)).value;
-            case ColumnType::MODEL_CONCENTRATION_ERROR:
-                return results.model_concentrations.at(0).at(
-                        static_cast<GasType>(i)).error;
-            case ColumnType::MEASURED_CONCENTRATION:
-                return results.measured_concentrations.at(0).at(
-                        static_cast<GasType>(i)).value;
-            case ColumnType::MEASURED_CONCENTRATION_ERROR:
-                return results.measured_concentrations.at(0).at(
-                        static_cast<GasType>(i)).error;
+            default:
+                break;
         }
+        return CalcDoubleElement(results, column_type);
     }
     catch (...)
     {
@@ -241,6 +205,145 @@ QVariant ResultsModel::GetElement( //(note) Für einen Column Type, welche werde
     return QVariant();
 }
 
+double ResultsModel::GetDoubleElement(
+        const FitResults& results,
+        const ExtendedColumnType& column_type) const
+{
+    switch (column_type.first)
+    {
+        case ColumnType::DEGREES_OF_FREEDOM:
+            return results.degrees_of_freedom;
+        case ColumnType::CONVERGENCE:
+            return std::numeric_limits<double>::quiet_NaN();
+        default:
+            break;
+    }
+    try
+    {
+        return CalcDoubleElement(results, column_type);
+    }
+    catch (...)
+    {
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+void ResultsModel::GetDoubleElements(
+        const FitResults& results,
+        const QList<ExtendedColumnType>& column_types,
+        double* values,
+        std::size_t stride) const
+{
+    for (const auto& column_type : column_types)
+    {
+        *values = GetDoubleElement(results, column_type);
+        values += stride;
+    }
+}
+
+double ResultsModel::CalcDoubleElement(
+        const FitResults& results,
+        const ExtendedColumnType& column_type) const
+{
+    unsigned i = column_type.second; //Hier wird Gas gewählt
+    switch (column_type.first)
+    {
+        case ColumnType::CHI_SQUARE:
+            return results.chi_square;
+        case ColumnType::CHI:
+            return std::sqrt(results.chi_square);
+        case ColumnType::PROBABILITY:
+        {
+            using boost::math::cdf;
+            using boost::math::chi_squared;
+            if (std::isnan(results.chi_square) ||
+                results.degrees_of_freedom <= 0)
+                return std::numeric_limits<double>::quiet_NaN();
+            else
+                return 100. * (1. - cdf(
+                    chi_squared(results.degrees_of_freedom),
+                    results.chi_square));
+        }
+        case ColumnType::PARAMETER_ESTIMATE:
+            return results.best_estimate(i);
+        case ColumnType::PARAMETER_ESTIMATE_ERROR:
+            return results.deviations.size() ?
+                    results.deviations(i) :
+                    std::numeric_limits<double>::quiet_NaN();
+        case ColumnType::CORRELATION:
+        {
+            const auto indices = GetCovarianceMatrixIndexes(i);
+            return results.CorrelationCoefficient(indices.first,
+                                                  indices.second);
+        }
+        case ColumnType::RESIDUAL:
+            return GetResidualForGas(results, i);
+        case ColumnType::DELTA_NEON:
+            return GetDeltaNeon(results);
+        case ColumnType::DELTA_NEON_ERROR:
+             return GetDeltaNeonError(results);
+        case ColumnType::RAD_HE:
+            return (results.measured_concentrations.at(0).at(                    
+                    static_cast<GasType>(0)).value
+                    - results.model_concentrations.at(0).at(
+                    static_cast<GasType>(0)).value);
+        case ColumnType::RAD_HE_ERROR:
+            return std::sqrt(
+                std::pow(
+                    results.measured_concentrations.at(0).at(
+                    static_cast<GasType>(0)).error,
+                    2.0
+                )
+                + std::pow(
+                    results.model_concentrations.at(0).at(
+                    static_cast<GasType>(i)).error,
+                    2.0
+                )
+            );
+        case ColumnType::RAD_HE3:
+            return 0.00000002*( //(todo): in physical properties!
+                    results.measured_concentrations.at(0).at(                    
+                    static_cast<GasType>(0)).value
+                    - results.model_concentrations.at(0).at(
+                    static_cast<GasType>(0)).value);
+        case ColumnType::RAD_HE3_ERROR: 
+            return 0.00000002*std::sqrt(
+                std::pow(
+                    results.measured_concentrations.at(0).at(
+                    static_cast<GasType>(0)).error,
+                    2.0
+                )
+                + std::pow(
+                    results.model_concentrations.at(0).at(
+                    static_cast<GasType>(i)).error,
+                    2.0
+                )
+            );
+        case ColumnType::EQUILIBRIUM_CONCENTRATION:
+            return results.equilibrium_concentrations.at(0).at(
+                    static_cast<GasType>(i)).value;
+        case ColumnType::EQUILIBRIUM_CONCENTRATION_ERROR:
+            return results.equilibrium_concentrations.at(0).at(
+                    static_cast<GasType>(i)).error;
+        case ColumnType::MODEL_CONCENTRATION:
+            return results.model_concentrations.at(0).at(
+                    static_cast<GasType>(i)).value;
+        case ColumnType::MODEL_CONCENTRATION_ERROR:
+            return results.model_concentrations.at(0).at(
+                    static_cast<GasType>(i)).error;
+        case ColumnType::MEASURED_CONCENTRATION:
+            return results.measured_concentrations.at(0).at(
+                    static_cast<GasType>(i)).value;
+        case ColumnType::MEASURED_CONCENTRATION_ERROR:
+            return results.measured_concentrations.at(0).at(
+                    static_cast<GasType>(i)).error;
+        case ColumnType::DEGREES_OF_FREEDOM:
+        case ColumnType::CONVERGENCE:
+            break;
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
 QString ResultsModel::GetColumnName(const ExtendedColumnType& type) const
 {
     unsigned i = type.second;
@@ -25,6 +25,7 @@
 #include <set>
 
 #include "core/fitting/fitresultsprocessor.h"
+#include "core/fitting/resultsrequest.h"
 #include "core/models/modelparameter.h"
 
 enum class ColumnType
@@ -74,9 +75,31 @@ public:
     const QList<ExtendedColumnType> GetAvailableColumnTypes() const;
     const QList<ExtendedColumnType> GetDoubleColumnTypes() const;
 
+    //! Bestimmt die Gaskonzentrationen, die für die übergebenen Spalten berechnet werden müssen.
+    ResultsRequest DetermineResultsRequest(
+            const QList<ExtendedColumnType>& column_types) const;
+
 protected:
     QVariant GetElement(const FitResults& results,
                         const ExtendedColumnType& column_type) const;
+    //! Gibt den Wert einer Spalte als Zahl zurück, ohne den Umweg über QVariant.
+    /*!
+     * Für Spalten ohne Zahlenwert oder fehlende Werte wird NaN zurückgegeben.
+     */
+    double GetDoubleElement(const FitResults& results,
+                            const ExtendedColumnType& column_type) const;
+    //! Berechnet die Werte mehrerer Spalten eines Ergebnisses auf einmal.
+    /*!
+     * \param values Ziel für den Wert der ersten Spalte.
+     * \param stride Abstand der Ziele aufeinanderfolgender Spalten in values.
+     */
+    void GetDoubleElements(const FitResults& results,
+                           const QList<ExtendedColumnType>& column_types,
+                           double* values,
+                           std::size_t stride = 1) const;
+    //! Berechnet den Wert einer Spalte mit Zahlenwert, wirft bei fehlenden Konzentrationen.
+    double CalcDoubleElement(const FitResults& results,
+                             const ExtendedColumnType& column_type) const;
     double GetResidualForGas(const FitResults& results,
                              unsigned gas_index) const;
     double GetDeltaNeon(const FitResults& results) const;
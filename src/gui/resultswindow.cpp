@@ -17,13 +17,15 @@
 
 
 #include <QCloseEvent>
+#include <QCoreApplication>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QStatusBar>
 #include <QPushButton>
 
 #include <fstream>
 
-#include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/codecvt_null.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
@@ -32,8 +34,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <memory>
 
 #include "commons.h"
+#include "datablockloadingthread.h"
+#include "datavector.h"
 #include "fitsetup.h"
 #include "fitsetupwidget.h"
 #include "histogramdata1d.h"
@@ -41,9 +47,12 @@
 #include "histogramplot.h"
 #include "mainwindow.h"
 #include "montecarloexportercsv.h"
+#include "montecarloexporternpz.h"
 #include "montecarloplotdelegate.h"
 #include "montecarloresultsmodel.h"
 #include "montecarlosummaryproxymodel.h"
+#include "resultscontainer.h"
+#include "savingthread.h"
 #include "setupmontecarloplotsdialog.h"
 #include "standardfitresultsmodel.h"
 
@@ -56,7 +65,9 @@ ResultsWindow::ResultsWindow() :
     results_model_(nullptr),
     monte_carlo_model_(nullptr),
     fit_setup_(new FitSetup(this)),
-    n_monte_carlos_(0U)
+    n_monte_carlos_(0U),
+    loading_thread_(nullptr),
+    monte_carlo_summary_ready_(false)
 {
     MainWindow::theMainWindow->AddWindowToOpenWindowsVector(this);
     ui->setupUi(this);
@@ -102,6 +113,11 @@ ResultsWindow::ResultsWindow() :
 
 ResultsWindow::~ResultsWindow()
 {
+    if (loading_thread_)
+    {
+        loading_thread_->Cancel();
+        loading_thread_->wait();
+    }
     delete ui;
 }
 
@@ -154,8 +170,76 @@ void ResultsWindow::SetupResultsModelsAndViews(
             *fit_setup_->GetConcentrationsModel()->GetRunData());
     monte_carlo_model_->SetOriginalResults(results_model_->GetResultsVector());
     ui->results_view->setModel(results_model_);
-    ui->monte_carlo_plots_view->setModel(monte_carlo_model_);
     n_monte_carlos_ = monte_carlo_model_->NumberOfMonteCarlos();
+
+    bool anySamples = results_model->rowCount() != 0;
+    ui->save_results_as_csv_button->setEnabled(anySamples);
+
+    ui->results_view->resizeColumnsToContents();
+    ui->results_view->resizeRowsToContents();
+
+    ui->results_label_recommending_monte_carlos->setVisible(
+            results_model_->DoesAnySampleNeedMonteCarlo());;
+
+    UpdateWindowTitle();
+
+    // Die Fitergebnisse sind sofort sichtbar. Noch nicht geladene Monte-Carlo-Daten
+    // werden im Hintergrund gelesen und die Histogramme danach eingerichtet. Die
+    // Zusammenfassung kommt mit den in der Datei gespeicherten Kenngrößen aus.
+    SetMonteCarloSummaryEnabled(false);
+    SetMonteCarloPlotsEnabled(false);
+    std::vector<boost::shared_ptr<DataBlock>> blocks =
+            monte_carlo_model_->GetDataBlocks();
+    if (DataBlockLoadingThread::AllLoaded(blocks))
+    {
+        SetupMonteCarloViews();
+        return;
+    }
+    if (monte_carlo_model_->AreSummaryStatisticsStored())
+        SetupMonteCarloSummaryView();
+
+    loading_thread_ = new DataBlockLoadingThread(std::move(blocks), this);
+    connect(loading_thread_, SIGNAL(finished()),
+            this, SLOT(MonteCarloDataLoaded()));
+    statusBar()->showMessage("Loading Monte Carlo results...");
+    loading_thread_->start();
+}
+
+void ResultsWindow::MonteCarloDataLoaded()
+{
+    statusBar()->clearMessage();
+    if (!loading_thread_->SuccessfullyCompleted())
+    {
+        QMessageBox::critical(this, APPLICATION_NAME,
+                              loading_thread_->GetErrorMessage());
+        return;
+    }
+    SetupMonteCarloViews();
+}
+
+void ResultsWindow::SetupMonteCarloViews()
+{
+    if (!monte_carlo_summary_ready_)
+        SetupMonteCarloSummaryView();
+    SetupMonteCarloPlotsView();
+}
+
+void ResultsWindow::SetupMonteCarloSummaryView()
+{
+    if (n_monte_carlos_)
+        connect(mc_summary_proxy_model_, SIGNAL(layoutChanged()),
+                ui->monte_carlo_summary_view, SLOT(resizeColumnsToContents()));
+    mc_summary_proxy_model_->SetSourceModel(monte_carlo_model_);
+    ui->monte_carlo_summary_view->resizeColumnsToContents();
+    ui->monte_carlo_summary_view->resizeRowsToContents();
+    monte_carlo_summary_ready_ = true;
+
+    SetMonteCarloSummaryEnabled(results_model_->rowCount() != 0 && n_monte_carlos_);
+}
+
+void ResultsWindow::SetupMonteCarloPlotsView()
+{
+    ui->monte_carlo_plots_view->setModel(monte_carlo_model_);
     if (n_monte_carlos_)
     {
         unsigned n_bins;
@@ -180,32 +264,24 @@ void ResultsWindow::SetupResultsModelsAndViews(
                 monte_carlo_model_, SLOT(SetNumberOfBins(int)));
         connect(monte_carlo_model_, SIGNAL(layoutChanged()),
                 ui->monte_carlo_plots_view, SLOT(resizeColumnsToContents()));
-        connect(mc_summary_proxy_model_, SIGNAL(layoutChanged()),
-                ui->monte_carlo_summary_view, SLOT(resizeColumnsToContents()));
     }
 
-    bool anySamples = results_model->rowCount() != 0;
-    ui->save_results_as_csv_button->setEnabled(anySamples);
-    bool hasMonteCarloResults = anySamples && n_monte_carlos_;
-
-    ui->tab_widget->setTabEnabled(1, hasMonteCarloResults);
-    ui->tab_widget->setTabEnabled(2, hasMonteCarloResults);
-    ui->action_choose_monte_carlo_plots->setEnabled(hasMonteCarloResults);
-    ui->action_export_monte_carlo_data ->setEnabled(hasMonteCarloResults);
-
-    mc_summary_proxy_model_->SetSourceModel(monte_carlo_model_);
-
-    ui->results_view->resizeColumnsToContents();
-    ui->results_view->resizeRowsToContents();
     ui->monte_carlo_plots_view->resizeColumnsToContents();
     ui->monte_carlo_plots_view->resizeRowsToContents();
-    ui->monte_carlo_summary_view->resizeColumnsToContents();
-    ui->monte_carlo_summary_view->resizeRowsToContents();
 
-    ui->results_label_recommending_monte_carlos->setVisible(
-            results_model_->DoesAnySampleNeedMonteCarlo());;
+    SetMonteCarloPlotsEnabled(results_model_->rowCount() != 0 && n_monte_carlos_);
+}
 
-    UpdateWindowTitle();
+void ResultsWindow::SetMonteCarloSummaryEnabled(bool enabled)
+{
+    ui->tab_widget->setTabEnabled(1, enabled);
+}
+
+void ResultsWindow::SetMonteCarloPlotsEnabled(bool enabled)
+{
+    ui->tab_widget->setTabEnabled(2, enabled);
+    ui->action_choose_monte_carlo_plots->setEnabled(enabled);
+    ui->action_export_monte_carlo_data ->setEnabled(enabled);
 }
 
 void ResultsWindow::SetFileName(QString file_name, bool is_binary)
@@ -253,15 +329,37 @@ void ResultsWindow::OpenMonteCarloSetupDialog()
 
 void ResultsWindow::ExportMonteCarloData()
 {
+    QString filter_csv("CSV file (*.csv)");
+    QString filter_npz("NumPy archive (*.npz)");
+    QString selected_filter;
+    QString filename = QFileDialog::getSaveFileName(
+            this,
+            "Export Monte Carlo data",
+            QString(),
+            filter_csv + ";;" + filter_npz,
+            &selected_filter
+#ifdef __APPLE__
+            ,QFileDialog::DontUseNativeDialog
+#endif
+            );
+
+    if (filename.isEmpty()) return;
+
     try
     {
-        MonteCarloExporterCsv exporter;
+        std::unique_ptr<MonteCarloExporter> exporter;
+        if (selected_filter == filter_npz)
+            exporter.reset(new MonteCarloExporterNpz(filename));
+        else
+            exporter.reset(new MonteCarloExporterCsv(filename));
         monte_carlo_model_->ExportMonteCarloData(
-                exporter,
+                *exporter,
                 results_model_->GetAvailableColumnTypes());
     }
-    catch (MonteCarloExporterCsv::Canceled)
+    catch (std::exception& e)
     {
+        QMessageBox::critical(this, APPLICATION_NAME,
+                              QString("Error: ") + e.what());
     }
 }
 
@@ -270,20 +368,20 @@ bool ResultsWindow::Save()
     if (windowFilePath().isEmpty())
         return SaveAs();
 
-    bool saved = false;
-    try
+    const QString filename = windowFilePath();
+    const bool is_binary = is_binary_;
+    StandardFitResultsModel* results_model = results_model_;
+    MonteCarloResultsModel* monte_carlo_model = monte_carlo_model_;
+    FitSetup* fit_setup = fit_setup_;
+    SavingThread thread([=](const std::function<void(int)>& progress)
     {
-        GlobalWaitCursor wait_cursor;
-        if (is_binary_)
+        if (is_binary)
         {
-            std::ofstream ofs(windowFilePath().toStdString(),
-                              std::ios_base::binary);
-            ofs.exceptions(std::iostream::badbit  |
-                           std::iostream::failbit);
-            boost::archive::binary_oarchive oa(ofs);
-            oa << results_model_
-               << monte_carlo_model_
-               << fit_setup_;
+            ResultsContainer::Write(filename,
+                                    results_model,
+                                    monte_carlo_model,
+                                    fit_setup,
+                                    progress);
         }
         else
         {
@@ -295,7 +393,7 @@ bool ResultsWindow::Save()
             std::locale out_locale(
                     default_locale,
                     new boost::math::nonfinite_num_put<char>);
-            std::ofstream ofs(windowFilePath().toStdString(),
+            std::ofstream ofs(filename.toStdString(),
                               std::ios_base::binary);
             ofs.exceptions(std::iostream::badbit  |
                            std::iostream::failbit);
@@ -310,24 +408,40 @@ bool ResultsWindow::Save()
             f.push(ofs);
             f.imbue(out_locale);
             boost::archive::text_oarchive oa(f, boost::archive::no_codecvt);
-            oa << results_model_
-               << monte_carlo_model_
-               << fit_setup_;
+            oa << results_model
+               << monte_carlo_model
+               << fit_setup;
         }
-        saved = true;
-    }
-    catch (std::exception& e)
-    {
-        QMessageBox::critical(this,
-                              APPLICATION_NAME,
-                              QString("Error: ") + e.what());
-    }
-    catch (...)
+    });
+
     {
-        QMessageBox::critical(this,
-                              APPLICATION_NAME,
-                              QString("Error: unknown error"));
+        GlobalWaitCursor wait_cursor;
+
+        // Der Dialog ist modal, sodass die Ergebnisse während des Speicherns nicht
+        // verändert werden können.
+        QProgressDialog progressdialog(this);
+        progressdialog.setWindowModality(Qt::WindowModal);
+        progressdialog.setLabelText("Saving results...");
+        progressdialog.setCancelButton(nullptr);
+        progressdialog.setAutoReset(false);
+        // Das portable Format meldet keinen Fortschritt.
+        progressdialog.setRange(0, is_binary ? 100 : 0);
+        progressdialog.setMinimumDuration(500);
+        progressdialog.setValue(0);
+        connect(&thread, SIGNAL(ProgressChanged(int)),
+                &progressdialog, SLOT(setValue(int)));
+        connect(&thread, SIGNAL(finished()),
+                &progressdialog, SLOT(accept()));
+
+        thread.start();
+        progressdialog.exec();
+        while (!thread.wait(50))
+            QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
     }
+
+    const bool saved = thread.SuccessfullyCompleted();
+    if (!saved)
+        QMessageBox::critical(this, APPLICATION_NAME, thread.GetErrorMessage());
     setWindowModified(!saved);
     return saved;
 }
@@ -23,6 +23,7 @@
 
 #include <memory>
 
+class DataBlockLoadingThread;
 class FitSetup;
 class MainWindow;
 class MonteCarloResultsModel;
@@ -61,9 +62,19 @@ private slots:
     void RequestFitSetupTakeOver();
     void SetWindowModified();
     void UpdateWindowTitle();
+    void MonteCarloDataLoaded();
 
 private:
     void InitializeFitSetupWidget();
+
+    //! Richtet die Monte-Carlo-Ansichten ein, sobald alle Daten geladen sind.
+    void SetupMonteCarloViews();
+    //! Richtet die Zusammenfassung ein, mit gespeicherten Kenngrößen auch schon vor dem Laden.
+    void SetupMonteCarloSummaryView();
+    void SetupMonteCarloPlotsView();
+    void SetMonteCarloSummaryEnabled(bool enabled);
+    //! Schaltet die Histogramme und die Aktionen um, die alle Monte-Carlo-Daten benötigen.
+    void SetMonteCarloPlotsEnabled(bool enabled);
     void FlushWindowFilePath();
 
     Ui::ResultsWindow* ui;
@@ -76,6 +87,11 @@ private:
 
     unsigned n_monte_carlos_;
 
+    //! Lädt die Monte-Carlo-Daten geöffneter Dateien im Hintergrund.
+    DataBlockLoadingThread* loading_thread_;
+
+    bool monte_carlo_summary_ready_;
+
     bool is_binary_;
 };
 
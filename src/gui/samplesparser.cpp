@@ -0,0 +1,206 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/spirit/include/qi_parse.hpp>
+#include <boost/spirit/include/qi_real.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+
+#include "samplesparser.h"
+
+namespace
+{
+const unsigned N_FIELDS = 11;
+
+const char* const FORMAT_DESCRIPTION =
+        "A line must consist of the sample name and the following concentrations, "
+        "all separated by commas or tabs: He, He err, Ne, Ne err, Ar, Ar err, Kr, "
+        "Kr err, Xe, Xe err.";
+
+const char* FindLineEnd(const char* position, const char* end)
+{
+    while (position != end && *position != '\n' && *position != '\r')
+        ++position;
+    return position;
+}
+
+//! Gibt den Anfang der nächsten Zeile zurück.
+const char* SkipLineEnd(const char* line_end, const char* end)
+{
+    if (line_end == end)
+        return end;
+    if (*line_end == '\r' && line_end + 1 != end && line_end[1] == '\n')
+        return line_end + 2;
+    return line_end + 1;
+}
+
+bool IsWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+}
+
+const std::size_t SamplesParser::CHUNK_SIZE = 1 << 20;
+
+void SamplesParser::Parse(const char* begin, const char* end)
+{
+    samples_.clear();
+    malformed_lines_.clear();
+
+    // UTF-8-BOM
+    if (end - begin >= 3 && std::equal(begin, begin + 3, "\xef\xbb\xbf"))
+        begin += 3;
+
+    std::vector<Chunk> chunks;
+    for (const char* position = begin; position != end; )
+    {
+        Chunk chunk;
+        chunk.begin = position;
+        chunk.end = position = FindChunkEnd(
+                    position + std::min<std::size_t>(CHUNK_SIZE, end - position),
+                    end);
+        chunks.push_back(std::move(chunk));
+    }
+
+    unsigned n_threads = boost::thread::hardware_concurrency();
+    if (n_threads == 0) n_threads = 1;
+    n_threads = std::min<std::size_t>(n_threads, chunks.size());
+
+    if (n_threads <= 1)
+    {
+        for (auto& chunk : chunks)
+            ParseChunk(chunk);
+    }
+    else
+    {
+        std::atomic<unsigned> counter(0);
+        boost::thread_group threads;
+        for (unsigned i = 0; i < n_threads; ++i)
+            threads.create_thread([&chunks, &counter]()
+            {
+                unsigned j;
+                while ((j = counter++) < chunks.size())
+                    ParseChunk(chunks[j]);
+            });
+        threads.join_all();
+    }
+
+    std::size_t n_samples = 0;
+    for (const auto& chunk : chunks)
+        n_samples += chunk.samples.size();
+    samples_.reserve(n_samples);
+
+    // Die Zeilennummern der Abschnitte beginnen jeweils bei 1.
+    unsigned long first_line = 0;
+    for (auto& chunk : chunks)
+    {
+        std::move(chunk.samples.begin(), chunk.samples.end(),
+                  std::back_inserter(samples_));
+        for (auto& line : chunk.malformed_lines)
+        {
+            line.line_number += first_line;
+            malformed_lines_.push_back(std::move(line));
+        }
+        first_line += chunk.n_lines;
+    }
+}
+
+std::vector<Sample>& SamplesParser::GetSamples()
+{
+    return samples_;
+}
+
+const std::vector<SamplesParser::MalformedLine>&
+SamplesParser::GetMalformedLines() const
+{
+    return malformed_lines_;
+}
+
+const char* SamplesParser::FindChunkEnd(const char* position, const char* end)
+{
+    if (position == end)
+        return end;
+    // Nicht zwischen \r und \n trennen.
+    if (position[-1] == '\r' && *position == '\n')
+        return position + 1;
+    if (position[-1] == '\n' || position[-1] == '\r')
+        return position;
+    return SkipLineEnd(FindLineEnd(position, end), end);
+}
+
+void SamplesParser::ParseChunk(Chunk& chunk)
+{
+    chunk.n_lines = 0;
+    for (const char* position = chunk.begin; position != chunk.end; )
+    {
+        const char* line_end = FindLineEnd(position, chunk.end);
+        ++chunk.n_lines;
+        if (line_end != position && *position != '#')
+        {
+            Sample sample;
+            if (ParseLine(position, line_end, sample))
+                chunk.samples.push_back(std::move(sample));
+            else
+                chunk.malformed_lines.push_back({chunk.n_lines, FORMAT_DESCRIPTION});
+        }
+        position = SkipLineEnd(line_end, chunk.end);
+    }
+}
+
+bool SamplesParser::ParseLine(const char* begin, const char* end, Sample& sample)
+{
+    char separator;
+    if (std::count(begin, end, ',') == N_FIELDS - 1)
+        separator = ',';
+    else if (std::count(begin, end, '\t') == N_FIELDS - 1)
+        separator = '\t';
+    else
+        return false;
+
+    const char* field_end = std::find(begin, end, separator);
+    sample.first.assign(begin, field_end);
+
+    for (unsigned i = 0; i < 5; ++i)
+    {
+        const char* value_begin = field_end + 1;
+        const char* value_end = std::find(value_begin, end, separator);
+        const char* error_begin = value_end + 1;
+        field_end = std::find(error_begin, end, separator);
+
+        double value;
+        double error;
+        if (ParseNumber(value_begin, value_end, value) &&
+            ParseNumber(error_begin, field_end, error))
+            sample.second[static_cast<GasType>(i)] = Data(value, error);
+    }
+    return true;
+}
+
+bool SamplesParser::ParseNumber(const char* begin, const char* end, double& value)
+{
+    while (begin != end && IsWhitespace(*begin))
+        ++begin;
+    while (begin != end && IsWhitespace(end[-1]))
+        --end;
+    return begin != end &&
+           boost::spirit::qi::parse(begin, end, boost::spirit::qi::double_, value) &&
+           begin == end;
+}
@@ -0,0 +1,85 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SAMPLESPARSER_H
+#define SAMPLESPARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "core/misc/typedefs.h"
+
+//! Liest Proben aus CSV-Text.
+/*!
+ * Jede Zeile enthält den Probennamen und die Konzentrationen von He, Ne, Ar, Kr und Xe
+ * jeweils mit Fehler, durch Kommas oder Tabulatoren getrennt. Leere Zeilen und Zeilen,
+ * die mit # beginnen, werden übergangen. Nicht lesbare Konzentrationen (etwa leere
+ * Felder) lassen das Gas in der Probe weg.
+ *
+ * Große Texte werden in an Zeilenenden ausgerichtete Abschnitte zerlegt, die parallel
+ * gelesen werden.
+ */
+class SamplesParser
+{
+public:
+    //! Zeile, die nicht gelesen werden konnte.
+    struct MalformedLine
+    {
+        //! Zeilennummer, beginnend bei 1.
+        unsigned long line_number;
+        std::string message;
+    };
+
+    //! Größe der Abschnitte, die parallel gelesen werden.
+    static const std::size_t CHUNK_SIZE;
+
+    //! Liest den Text zwischen begin und end.
+    /*!
+     * Als Zeilenende gelten \\n, \\r\\n und \\r.
+     */
+    void Parse(const char* begin, const char* end);
+
+    //! Gibt die gelesenen Proben in der Reihenfolge der Datei zurück.
+    std::vector<Sample>& GetSamples();
+
+    //! Gibt die nicht lesbaren Zeilen zurück.
+    const std::vector<MalformedLine>& GetMalformedLines() const;
+
+private:
+    struct Chunk
+    {
+        Chunk() : begin(nullptr), end(nullptr), n_lines(0) {}
+
+        const char* begin;
+        const char* end;
+        unsigned long n_lines;
+        std::vector<Sample> samples;
+        std::vector<MalformedLine> malformed_lines;
+    };
+
+    static const char* FindChunkEnd(const char* position, const char* end);
+    static void ParseChunk(Chunk& chunk);
+    static bool ParseLine(const char* begin, const char* end, Sample& sample);
+    static bool ParseNumber(const char* begin, const char* end, double& value);
+
+    std::vector<Sample> samples_;
+    std::vector<MalformedLine> malformed_lines_;
+};
+
+#endif // SAMPLESPARSER_H
@@ -16,24 +16,42 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
-#include <algorithm>
-#include <stdexcept>
+#include <exception>
 
-template <class Vec, class Pred>
-unsigned TransformSequenceIndexToSkipElements(Vec vec,
-                                              unsigned index,
-                                              Pred pred)
+#include "savingthread.h"
+
+SavingThread::SavingThread(SaveFunction save) :
+    save_(save),
+    success_(false),
+    error_message_()
+{
+}
+
+void SavingThread::run()
+{
+    try
+    {
+        save_([this](int per_cent) { emit ProgressChanged(per_cent); });
+    }
+    catch (std::exception& e)
+    {
+        error_message_ = QString("Error: ") + e.what();
+        return;
+    }
+    catch (...)
+    {
+        error_message_ = "Error: unknown error";
+        return;
+    }
+    success_ = true;
+}
+
+bool SavingThread::SuccessfullyCompleted() const
+{
+    return success_;
+}
+
+const QString& SavingThread::GetErrorMessage() const
 {
-    auto it = std::find_if(vec.cbegin(), vec.cend(), pred);
-    if (it == vec.cend())
-        throw std::out_of_range("Index out of range.");
-    
-    for (unsigned i = 0; i < index; ++i)
-        while (true)
-        {
-            if (++it == vec.cend())
-                throw std::out_of_range("Index out of range.");
-            if (pred(*it)) break;
-        }
-    return it - vec.begin();
-}
\ No newline at end of file
+    return error_message_;
+}
@@ -0,0 +1,52 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SAVINGTHREAD_H
+#define SAVINGTHREAD_H
+
+#include <QString>
+#include <QThread>
+
+#include <functional>
+
+//! Speichert Ergebnisse im Hintergrund, damit die Oberfläche nicht blockiert.
+class SavingThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    //! Speicherfunktion. Erhält eine Funktion, über die sie den Fortschritt in Prozent meldet.
+    typedef std::function<void(const std::function<void(int)>&)> SaveFunction;
+
+    explicit SavingThread(SaveFunction save);
+    virtual void run();
+    bool SuccessfullyCompleted() const;
+
+    //! Gibt die Fehlermeldung zurück, falls das Speichern fehlgeschlagen ist.
+    const QString& GetErrorMessage() const;
+
+signals:
+    void ProgressChanged(int per_cent);
+
+private:
+    SaveFunction save_;
+    bool success_;
+    QString error_message_;
+};
+
+#endif // SAVINGTHREAD_H
@@ -56,6 +56,19 @@ inline void serialize(Archive& ar, FitResults& res, const unsigned version)
        & res.model_concentrations
        & res.equilibrium_concentrations
        & res.measured_concentrations;
+
+    if (version >= 1)
+        ar & res.local_minima
+           & res.n_starts_completed
+           & res.n_starts_pruned
+           & res.n_starts_skipped;
+}
+
+template<class Archive>
+inline void serialize(Archive& ar, LocalMinimum& m, const unsigned version)
+{
+    ar & m.chi_square
+       & m.best_estimate;
 }
 
 template<class Archive>
@@ -238,6 +251,7 @@ BOOST_SERIALIZATION_SPLIT_FREE(QwtInterval)
 BOOST_SERIALIZATION_SPLIT_FREE(QPolygonF)
 BOOST_SERIALIZATION_SPLIT_FREE(QStringList)
 
+BOOST_CLASS_VERSION(FitResults, 1)
 BOOST_CLASS_VERSION(ModelParameter, 1)
 
 #endif //SERIALIZATIONHELPERS_H
@@ -19,6 +19,7 @@
 #include <QBrush>
 
 #include <cassert>
+#include <cmath>
 
 #include "core/misc/rundata.h"
 
@@ -54,6 +55,7 @@ void StandardFitResultsModel::ProcessResult(
 
     beginInsertRows(QModelIndex(), results_->size(), results_->size());
     results_->push_back(results);
+    CalcValues(results_->size() - 1);
     endInsertRows();
 
     sample_needs_monte_carlo_initialized_ = false;
@@ -88,18 +90,31 @@ QVariant StandardFitResultsModel::data(const QModelIndex& index, int role) const
         switch (role)
         {
             case Qt::DisplayRole:
-                return GetElement(*results_->at(index.row()),
-                                  column_types_.at(index.column()));
+            {
+                const auto& column_type = column_types_.at(index.column());
+                double value = GetValue(index.row(), index.column());
+                // Die Konvergenz wird als Text angezeigt, fehlende Werte leer oder als "nan".
+                if (column_type.first == ColumnType::CONVERGENCE || std::isnan(value))
+                    return GetElement(*results_->at(index.row()), column_type);
+                if (column_type.first == ColumnType::DEGREES_OF_FREEDOM)
+                    return static_cast<int>(value);
+                return value;
+            }
             case Qt::ForegroundRole:
-                return IsParameterInNormalRange(
-                               *results_->at(index.row()),
-                               column_types_.at(index.column())) ?
+                return IsParameterInNormalRange(index.row(), index.column()) ?
                            QBrush(Qt::black) :
                            QBrush(Qt::red);
             case Qt::BackgroundRole:
                 return DoesSampleNeedMonteCarlo(index.row()) ?
                            QBrush(QColor(255, 255, 200)) :
                            QBrush(Qt::white);
+            case Qt::ToolTipRole:
+            {
+                const ColumnType type = column_types_.at(index.column()).first;
+                if (type == ColumnType::CHI_SQUARE || type == ColumnType::CONVERGENCE)
+                    return GetLocalMinimaText(*results_->at(index.row()));
+                break;
+            }
             default:
                 break;
         }
@@ -113,18 +128,21 @@ QVariant StandardFitResultsModel::data(const QModelIndex& index, int role) const
 void StandardFitResultsModel::AddUnusedConcentrations(const RunData& run_data)
 {
     assert(results_->size() == run_data.EnabledSize());
-    auto input_concentrations = run_data.concentrations_begin();
-    for (auto sample : *results_)
+    for (unsigned i = 0; i < results_->size(); ++i)
     {
+        const unsigned index = run_data.GetIndexOfEnabledSample(i);
+        auto& measured_concentrations =
+                (*results_)[i]->measured_concentrations.at(0);
         for (GasType gas = Gas::begin; gas != Gas::end; ++gas)
         {
-            if (!sample->measured_concentrations.at(0).count(gas) &&
-                input_concentrations->count(gas))
-                sample->measured_concentrations.at(0)[gas] =
-                        input_concentrations->at(gas);
+            if (!measured_concentrations.count(gas) &&
+                run_data.HasGas(index, gas))
+                measured_concentrations[gas] =
+                        Data(run_data.GetValues(gas)[index],
+                             run_data.GetErrors(gas)[index]);
         }
-        ++input_concentrations;
     }
+    RecalculateValues();
 }
 
 std::shared_ptr<const StandardFitResultsModel::ResultsVector>
@@ -133,22 +151,68 @@ StandardFitResultsModel::GetResultsVector() const
     return results_;
 }
 
-bool StandardFitResultsModel::IsParameterInNormalRange(
-        const FitResults& results,
-        const ExtendedColumnType& column_type) const
+void StandardFitResultsModel::CalcValues(unsigned row)
+{
+    const unsigned n_columns = column_types_.size();
+    values_.resize((row + 1) * n_columns);
+    GetDoubleElements(*results_->at(row), column_types_, values_.data() + row * n_columns);
+}
+
+void StandardFitResultsModel::RecalculateValues()
+{
+    values_.clear();
+    for (unsigned row = 0; row < results_->size(); ++row)
+        CalcValues(row);
+}
+
+double StandardFitResultsModel::GetValue(unsigned row, unsigned column) const
+{
+    return values_.at(row * column_types_.size() + column);
+}
+
+QVariant StandardFitResultsModel::GetLocalMinimaText(const FitResults& results) const
+{
+    const unsigned n_starts = results.n_starts_completed +
+                              results.n_starts_pruned +
+                              results.n_starts_skipped;
+    if (n_starts == 0)
+        return QVariant();
+
+    QString text = QString("%1 distinct minima from %2 starting points "
+                           "(%3 completed, %4 aborted, %5 not started):")
+            .arg(results.local_minima.size())
+            .arg(n_starts)
+            .arg(results.n_starts_completed)
+            .arg(results.n_starts_pruned)
+            .arg(results.n_starts_skipped);
+    for (const auto& minimum : results.local_minima)
+    {
+        text += "\nχ²=" + QString::number(minimum.chi_square) + ": ";
+        for (int i = 0; i < minimum.best_estimate.size() && i < int(n_parameters_); ++i)
+        {
+            if (i) text += ", ";
+            text += QString::fromStdString(parameters_[i].name) + "=" +
+                    QString::number(minimum.best_estimate[i]);
+        }
+    }
+    return text;
+}
+
+bool StandardFitResultsModel::IsParameterInNormalRange(unsigned row, unsigned column) const
 {
+    const auto& column_type = column_types_.at(column);
     unsigned i = column_type.second;
     switch (column_type.first)
     {
         case ColumnType::PARAMETER_ESTIMATE:
         {
-            double val = GetElement(results, column_type).toDouble();
+            double val = GetValue(row, column);
             return (val > parameters_.at(i).lowest_normal_value ) &&
                    (val < parameters_.at(i).highest_normal_value);
         }
         case ColumnType::PARAMETER_ESTIMATE_ERROR:
         {
-            double val = GetElement(results, column_type).toDouble();
+            double val = GetValue(row, column);
             return (val < parameters_.at(i).highest_normal_error) && (val > 0.);
         }
         default:
@@ -171,16 +235,16 @@ bool StandardFitResultsModel::DoesSampleNeedMonteCarlo(
     {
         sample_needs_monte_carlo_.clear();
         sample_needs_monte_carlo_.resize(results_->size(), false);
-        for (const auto& column_type : column_types_)
+        for (int column = 0; column < column_types_.size(); ++column)
         {
+            const auto& column_type = column_types_.at(column);
             if (column_type.first != ColumnType::PARAMETER_ESTIMATE &&
                 column_type.first != ColumnType::PARAMETER_ESTIMATE_ERROR)
                 continue;
             for (unsigned i = 0; i < results_->size(); ++i)
                 sample_needs_monte_carlo_.at(i) =
                         sample_needs_monte_carlo_.at(i) |
-                        !IsParameterInNormalRange(*results_->at(i),
-                                                  column_type);
+                        !IsParameterInNormalRange(i, column);
         }
         sample_needs_monte_carlo_initialized_ = true;
     }
@@ -29,6 +29,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "serializationhelpers.h"
 
@@ -72,8 +73,18 @@ public:
     bool DoesAnySampleNeedMonteCarlo() const;
 
 private:
-    bool IsParameterInNormalRange(const FitResults& results,
-                                  const ExtendedColumnType& column_type) const;
+    //! Berechnet die Zeile values_ eines Ergebnisses.
+    void CalcValues(unsigned row);
+    //! Berechnet values_ für alle Ergebnisse neu.
+    void RecalculateValues();
+    //! Gibt den zwischengespeicherten Wert eines Elements zurück.
+    double GetValue(unsigned row, unsigned column) const;
+
+    //! \brief Beschreibt für Fits von mehreren Startpunkten die gefundenen Minima,
+    //! sonst leer.
+    QVariant GetLocalMinimaText(const FitResults& results) const;
+
+    bool IsParameterInNormalRange(unsigned row, unsigned column) const;
     bool DoesSampleNeedMonteCarlo(unsigned sample_number) const;
 
     friend class boost::serialization::access;
@@ -104,6 +115,7 @@ private:
         //! um sich const_cast und save/load_construct_data zu sparen.
         const_cast<QList<ExtendedColumnType>&>(column_types_) =
                 QList<ExtendedColumnType>::fromStdList(column_types);
+        RecalculateValues();
     }
 
     BOOST_SERIALIZATION_SPLIT_MEMBER()
@@ -113,6 +125,13 @@ private:
 
     const QList<ExtendedColumnType> column_types_;
 
+    //! Zahlenwerte aller Spalten je Ergebnis, zeilenweise. Wird nicht gespeichert.
+    /*!
+     * Abgeleitete Größen wie die Wahrscheinlichkeit oder Delta-Neon werden so nur einmal
+     * je Ergebnis berechnet und nicht bei jedem Neuzeichnen der Views.
+     */
+    std::vector<double> values_;
+
     mutable bool sample_needs_monte_carlo_initialized_;
     mutable std::vector<bool> sample_needs_monte_carlo_;
 };
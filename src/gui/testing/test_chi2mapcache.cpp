@@ -0,0 +1,117 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include "chi2mapcache.h"
+
+namespace
+{
+struct Chi2MapCacheFixture
+{
+    Chi2MapCacheFixture()
+    {
+        key.sample = 0;
+        key.x_parameter = 0;
+        key.y_parameter = 1;
+
+        // 4×4-Raster auf [0, 4)×[0, 4), χ² = 10 * i + j. Die beste Schätzung
+        // des einzigen Parameters kennzeichnet den Punkt.
+        layer.rect = QRectF(0., 0., 4., 4.);
+        layer.raster = QSize(4, 4);
+        layer.chi2_values.resize(4, 4);
+        layer.results.Reset(4, 4, 1);
+        FitResults fit_results;
+        fit_results.exit_flag = Eigen::LM::RelativeErrorTooSmall;
+        fit_results.best_estimate.resize(1);
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+            {
+                layer.chi2_values(i, j) = 10. * i + j;
+                fit_results.best_estimate(0) = 100. * i + j;
+                layer.results.SetResults(i, j, fit_results);
+            }
+        cache.Store(key, layer);
+    }
+
+    unsigned Lookup(const Chi2MapCache::Key& lookup_key,
+                    const QRectF& rect,
+                    const QSize& raster)
+    {
+        chi2_values.setConstant(raster.width(), raster.height(), -1.);
+        results.Reset(raster.width(), raster.height(), 1);
+        return cache.Lookup(lookup_key, rect, raster,
+                            chi2_values, results, preview, preview_results);
+    }
+
+    Chi2MapCache cache;
+    Chi2MapCache::Key key;
+    Chi2MapCache::Layer layer;
+    Eigen::MatrixXd chi2_values;
+    Chi2MapCache::ResultsGrid results;
+    Eigen::MatrixXd preview;
+    Chi2MapCache::ResultsGrid preview_results;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Chi2MapCache_tests, Chi2MapCacheFixture)
+
+BOOST_AUTO_TEST_CASE(Lookup_PannedView_ReuseOverlap)
+{
+    BOOST_CHECK_EQUAL(Lookup(key, QRectF(2., 0., 4., 4.), QSize(4, 4)), 8);
+    BOOST_CHECK_EQUAL(chi2_values(0, 3), 23.);
+    BOOST_CHECK_EQUAL(chi2_values(1, 0), 30.);
+    BOOST_CHECK(results.HasResults(1, 0));
+    BOOST_CHECK_EQUAL(results.GetBestEstimate(1, 0)(0), 300.);
+    BOOST_CHECK_EQUAL(results.GetExitFlag(1, 0), Eigen::LM::RelativeErrorTooSmall);
+    BOOST_CHECK(!results.HasResults(2, 0));
+    BOOST_CHECK_EQUAL(chi2_values(2, 0), -1.);
+}
+
+BOOST_AUTO_TEST_CASE(Lookup_ZoomedIn_OnlyPreview)
+{
+    BOOST_CHECK_EQUAL(Lookup(key, QRectF(0., 0., 2., 2.), QSize(4, 4)), 0);
+    BOOST_CHECK_EQUAL(preview(2, 2), 11.);
+    BOOST_CHECK(preview_results.HasResults(2, 2));
+    BOOST_CHECK_EQUAL(preview_results.GetBestEstimate(2, 2)(0), 101.);
+}
+
+BOOST_AUTO_TEST_CASE(Lookup_ZoomedOut_CoarserPointsCovered)
+{
+    BOOST_CHECK_EQUAL(Lookup(key, QRectF(0., 0., 8., 8.), QSize(4, 4)), 4);
+    BOOST_CHECK_EQUAL(chi2_values(1, 1), 22.);
+    BOOST_CHECK(std::isnan(preview(2, 2)));
+}
+
+BOOST_AUTO_TEST_CASE(Lookup_OtherFixedParameters_NothingFound)
+{
+    Chi2MapCache::Key other_key(key);
+    other_key.fixed_parameters.push_back(std::make_pair(2, 1.));
+    BOOST_CHECK_EQUAL(Lookup(other_key, layer.rect, layer.raster), 0);
+    BOOST_CHECK(!preview_results.HasResults(0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(Clear_NothingFound)
+{
+    cache.Clear();
+    BOOST_CHECK_EQUAL(Lookup(key, layer.rect, layer.raster), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "contourplotdata.h"
+
+BOOST_AUTO_TEST_SUITE(ContourPlotData_tests)
+
+namespace
+{
+//! Plot mit 2x2 Punkten auf [0, 2] x [0, 2], χ² = x-Index + 10 * y-Index.
+ContourPlotFitter::Plot CreatePlot()
+{
+    ContourPlotFitter::Plot plot;
+    plot.rect = QRectF(0., 0., 2., 2.);
+    plot.raster = QSize(2, 2);
+    plot.chi2_values.resize(2, 2);
+    plot.chi2_values << 0., 10.,
+                        1., 11.;
+    return plot;
+}
+}
+
+BOOST_AUTO_TEST_CASE(FillRasterNearest)
+{
+    const ContourPlotFitter::Plot plot = CreatePlot();
+    const std::vector<double> xs = {-0.5, 0.2, 1.5, 2.};
+    const std::vector<double> ys = {0.9, 1.1};
+    std::vector<double> values(xs.size() * ys.size());
+
+    ContourPlotData::FillRaster(plot, false, xs, ys, values.data());
+
+    BOOST_CHECK(std::isnan(values[0]));
+    BOOST_CHECK_EQUAL(values[1], 0.);
+    BOOST_CHECK_EQUAL(values[2], 1.);
+    BOOST_CHECK_EQUAL(values[3], 1.);
+    BOOST_CHECK(std::isnan(values[4]));
+    BOOST_CHECK_EQUAL(values[5], 10.);
+    BOOST_CHECK_EQUAL(values[6], 11.);
+    BOOST_CHECK_EQUAL(values[7], 11.);
+}
+
+BOOST_AUTO_TEST_CASE(FillRasterBilinear)
+{
+    ContourPlotFitter::Plot plot = CreatePlot();
+    // Die Werte gelten für die Zellmitten bei 0.5 und 1.5.
+    const std::vector<double> xs = {0.25, 0.5, 1., 1.75};
+    const std::vector<double> ys = {1.};
+    std::vector<double> values(xs.size() * ys.size());
+
+    ContourPlotData::FillRaster(plot, true, xs, ys, values.data());
+
+    BOOST_CHECK_CLOSE(values[0], 5. , 1e-10);
+    BOOST_CHECK_CLOSE(values[1], 5. , 1e-10);
+    BOOST_CHECK_CLOSE(values[2], 5.5, 1e-10);
+    BOOST_CHECK_CLOSE(values[3], 6. , 1e-10);
+
+    // Fehlt ein Nachbar, wird der Wert der Zelle selbst verwendet.
+    plot.chi2_values(1, 1) = std::numeric_limits<double>::quiet_NaN();
+    ContourPlotData::FillRaster(plot, true, xs, ys, values.data());
+    BOOST_CHECK_CLOSE(values[1], 10., 1e-10);
+    BOOST_CHECK(std::isnan(values[3]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,354 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "contourplotfitter.h"
+
+//! Steuert die Auftragsverteilung von ContourPlotFitter ohne Arbeiter-Threads.
+/*!
+ * Die Tests übernehmen die Rolle der Arbeiter-Threads und von ProcessResults:
+ * Sie holen die Kacheln ab, tragen vorgegebene χ²-Werte ein und schließen die
+ * adaptiven Durchgänge ab. So sind die Ergebnisse unabhängig vom Zeitverhalten.
+ */
+struct ContourPlotFitterTestAccess
+{
+    typedef std::pair<int, int> Point;
+    typedef double (*Chi2Function)(int, int);
+
+    explicit ContourPlotFitterTestAccess(const QSize& raster) :
+        fitter(nullptr),
+        claims(raster.width() * raster.height(), 0)
+    {
+        fitter.SetFitArea(QRectF(0., 0., 1., 1.), raster);
+        fitter.PrepareVariables();
+        fitter.results_.Reset(raster.width(), raster.height(), 1);
+    }
+
+    int width() const { return fitter.data_raster_.width(); }
+    int height() const { return fitter.data_raster_.height(); }
+
+    //! Trägt das Ergebnis eines Punkts ein, wie es ein Arbeiter-Thread täte.
+    void SetResult(int i, int j, double chi2)
+    {
+        FitResults results;
+        results.chi_square = chi2;
+        results.best_estimate = Eigen::VectorXd::Constant(1, chi2);
+        results.exit_flag = Eigen::LM::RelativeReductionTooSmall;
+        fitter.chi2_values_(i, j) = chi2;
+        fitter.results_.SetResults(i, j, results);
+    }
+
+    void CreateJobs()
+    {
+        fitter.CreateJobs();
+    }
+
+    //! Reserviert die nächste Kachel, falsch wenn keine mehr folgen.
+    bool ClaimTile(unsigned& tile_index)
+    {
+        try
+        {
+            tile_index = fitter.ClaimTile();
+            return true;
+        }
+        catch (ContourPlotFitter::NoJobsLeft)
+        {
+            return false;
+        }
+    }
+
+    bool HasTile() const
+    {
+        return fitter.next_tile_.load() < fitter.n_tiles_.load();
+    }
+
+    unsigned NumberOfTiles() const
+    {
+        return fitter.n_tiles_.load();
+    }
+
+    //! Gibt die Blockgröße des Durchgangs zurück, zu dem die Kachel gehört.
+    int GetBlocksize(unsigned tile_index) const
+    {
+        return fitter.plot_stack_infos_.at(fitter.tiles_[tile_index].level).blocksize;
+    }
+
+    double GetLeafValue(int i, int j) const
+    {
+        return fitter.leaf_values_(i, j);
+    }
+
+    //! Fittet die Punkte einer Kachel mit f und zählt sie.
+    void ProcessTile(unsigned tile_index, Chi2Function f)
+    {
+        const ContourPlotFitter::Tile& tile = fitter.tiles_[tile_index];
+        for (unsigned p = tile.begin; p < tile.end; ++p)
+        {
+            const ContourPlotFitter::JobParameters& params = fitter.tile_points_[p];
+            BOOST_CHECK_EQUAL(params.blocksize, GetBlocksize(tile_index));
+            ++claims[params.i * height() + params.j];
+            SetResult(params.i, params.j, f(params.i, params.j));
+        }
+    }
+
+    //! Arbeitet alle Durchgänge des adaptiven Modus ab.
+    /*!
+     * Vor jedem Abschluss eines Durchgangs wird check mit den Zellen und der
+     * Blockgröße aufgerufen, danach mit den verfeinerten Zellen.
+     */
+    template<class Check>
+    void RunAdaptive(Chi2Function f, Check check)
+    {
+        fitter.CreateAdaptiveJobs();
+        while (true)
+        {
+            BOOST_REQUIRE(HasTile() || fitter.all_jobs_prepared_);
+            if (!HasTile())
+                break;
+            unsigned tile_index;
+            while (HasTile() && ClaimTile(tile_index))
+                ProcessTile(tile_index, f);
+
+            const std::vector<Point> cells = fitter.adaptive_cells_;
+            const int blocksize = fitter.adaptive_blocksize_;
+            fitter.FinishAdaptiveLevel();
+            check(cells, blocksize, fitter.adaptive_cells_);
+            fitter.StartAdaptiveLevel();
+        }
+    }
+
+    ContourPlotFitter fitter;
+    //! Wie oft jeder Punkt (Index i * Höhe + j) gefittet wurde.
+    std::vector<int> claims;
+};
+
+namespace
+{
+typedef ContourPlotFitterTestAccess::Point Point;
+
+const double CONTOUR_LEVELS[] = {2.30, 6.18};
+
+//! Paraboloid mit dem Minimum 0 bei (28, 28), Vielfache von 1/16.
+double ValueAt(int i, int j)
+{
+    return ((i - 28) * (i - 28) + (j - 28) * (j - 28)) / 16.;
+}
+
+//! Bildet die erwartete Verfeinerung eines Durchgangs unabhängig nach.
+/*!
+ * Jeder Punkt einer Zelle erhält den Wert ihres Stützpunkts. Eine Zelle wird
+ * geteilt, wenn sie das bisher kleinste χ² enthält oder χ² zwischen ihrem
+ * Stützpunkt und einem der angrenzenden Punkte eine Kontur kreuzt.
+ */
+class RefinementModel
+{
+public:
+    RefinementModel(int width, int height) :
+        width_(width),
+        height_(height),
+        leaf_values_(width * height, std::numeric_limits<double>::quiet_NaN()),
+        chi2_min_(std::numeric_limits<double>::infinity())
+    {
+    }
+
+    std::set<Point> Refine(const std::vector<Point>& cells, int blocksize)
+    {
+        for (const Point& cell : cells)
+        {
+            const double chi2 = ValueAt(SamplePoint(cell, blocksize));
+            chi2_min_ = std::min(chi2_min_, chi2);
+            for (int x = cell.first; x < std::min(cell.first + blocksize, width_); ++x)
+                for (int y = cell.second; y < std::min(cell.second + blocksize, height_); ++y)
+                    leaf_values_[x * height_ + y] = chi2;
+        }
+
+        std::set<Point> refined;
+        if (blocksize == 1)
+            return refined;
+        for (const Point& cell : cells)
+        {
+            if (!CrossesContour(cell, blocksize))
+                continue;
+            for (int x = cell.first; x < std::min(cell.first + blocksize, width_);
+                 x += blocksize / 2)
+                for (int y = cell.second; y < std::min(cell.second + blocksize, height_);
+                     y += blocksize / 2)
+                    refined.insert(Point(x, y));
+        }
+        return refined;
+    }
+
+private:
+    static double ValueAt(const Point& point)
+    {
+        return ::ValueAt(point.first, point.second);
+    }
+
+    Point SamplePoint(const Point& cell, int blocksize) const
+    {
+        const int offset = blocksize == 1 ? 0 : (blocksize + 1) / 2;
+        return Point(std::min(cell.first + offset, width_ - 1),
+                     std::min(cell.second + offset, height_ - 1));
+    }
+
+    bool CrossesContour(const Point& cell, int blocksize) const
+    {
+        const Point sample = SamplePoint(cell, blocksize);
+        const double chi2 = ValueAt(sample);
+        if (chi2 == chi2_min_)
+            return true;
+
+        const Point neighbours[] = {
+            Point(cell.first - 1, sample.second),
+            Point(cell.first + blocksize, sample.second),
+            Point(sample.first, cell.second - 1),
+            Point(sample.first, cell.second + blocksize)
+        };
+        for (const Point& neighbour : neighbours)
+        {
+            if (neighbour.first < 0 || neighbour.first >= width_ ||
+                neighbour.second < 0 || neighbour.second >= height_)
+                continue;
+            const double neighbour_chi2 =
+                    leaf_values_[neighbour.first * height_ + neighbour.second];
+            for (double level : CONTOUR_LEVELS)
+                if ((chi2 < chi2_min_ + level) != (neighbour_chi2 < chi2_min_ + level))
+                    return true;
+        }
+        return false;
+    }
+
+    const int width_;
+    const int height_;
+    std::vector<double> leaf_values_;
+    double chi2_min_;
+};
+}
+
+BOOST_AUTO_TEST_SUITE(ContourPlotFitter_tests)
+
+BOOST_AUTO_TEST_CASE(CreateJobs_CachedPoints_EveryOtherPointFittedOnce)
+{
+    ContourPlotFitterTestAccess access(QSize(13, 9));
+    const std::vector<Point> cached = {Point(0, 0), Point(8, 8), Point(5, 3)};
+    for (const Point& point : cached)
+        access.SetResult(point.first, point.second, 1.);
+
+    access.CreateJobs();
+
+    // Kacheln werden genau einmal und in der Reihenfolge der Durchgänge vergeben.
+    std::vector<int> blocksizes;
+    unsigned expected_tile = 0;
+    unsigned tile_index;
+    while (access.ClaimTile(tile_index))
+    {
+        BOOST_CHECK_EQUAL(tile_index, expected_tile++);
+        blocksizes.push_back(access.GetBlocksize(tile_index));
+        access.ProcessTile(tile_index, ValueAt);
+    }
+    BOOST_CHECK_EQUAL(expected_tile, access.NumberOfTiles());
+    BOOST_CHECK(std::is_sorted(blocksizes.rbegin(), blocksizes.rend()));
+
+    for (int i = 0; i < access.width(); ++i)
+        for (int j = 0; j < access.height(); ++j)
+        {
+            const bool is_cached = std::count(cached.begin(), cached.end(), Point(i, j)) > 0;
+            BOOST_CHECK_EQUAL(access.claims[i * access.height() + j], is_cached ? 0 : 1);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(ClaimTile_SeveralThreads_EveryTileClaimedOnce)
+{
+    ContourPlotFitterTestAccess access(QSize(64, 48));
+    access.CreateJobs();
+
+    const unsigned n_threads = 4;
+    std::vector<std::vector<unsigned>> claimed(n_threads);
+    boost::thread_group threads;
+    for (unsigned t = 0; t < n_threads; ++t)
+        threads.create_thread([&access, &claimed, t]()
+                              {
+                                  unsigned tile_index;
+                                  while (access.ClaimTile(tile_index))
+                                      claimed[t].push_back(tile_index);
+                              });
+    threads.join_all();
+
+    std::vector<unsigned> all;
+    for (const auto& tiles : claimed)
+        all.insert(all.end(), tiles.begin(), tiles.end());
+    std::sort(all.begin(), all.end());
+    BOOST_REQUIRE_EQUAL(all.size(), access.NumberOfTiles());
+    for (unsigned t = 0; t < all.size(); ++t)
+        BOOST_CHECK_EQUAL(all[t], t);
+
+    for (unsigned t : all)
+        access.ProcessTile(t, ValueAt);
+    BOOST_CHECK(std::all_of(access.claims.begin(), access.claims.end(),
+                            [](int n) { return n == 1; }));
+}
+
+BOOST_AUTO_TEST_CASE(AdaptiveRefinement_Paraboloid_OnlyCellsCrossingContoursSplit)
+{
+    ContourPlotFitterTestAccess access(QSize(64, 64));
+    access.fitter.SetAdaptiveRefinement(true);
+    access.fitter.SetContourLevels(std::vector<double>(std::begin(CONTOUR_LEVELS),
+                                                       std::end(CONTOUR_LEVELS)));
+    // Nur die Konturen und das Minimum sollen eine Verfeinerung auslösen.
+    access.fitter.SetRefinementThreshold(std::numeric_limits<double>::infinity());
+
+    RefinementModel model(access.width(), access.height());
+    std::vector<int> blocksizes;
+    access.RunAdaptive(ValueAt,
+                       [&](const std::vector<Point>& cells, int blocksize,
+                           const std::vector<Point>& refined)
+                       {
+                           blocksizes.push_back(blocksize);
+                           const std::set<Point> expected = model.Refine(cells, blocksize);
+                           const std::set<Point> actual(refined.begin(), refined.end());
+                           BOOST_CHECK_EQUAL(actual.size(), refined.size());
+                           BOOST_CHECK(actual == expected);
+                       });
+
+    // Bis zum vollen Raster verfeinert, aber nur entlang der Konturen.
+    BOOST_REQUIRE(!blocksizes.empty());
+    BOOST_CHECK_EQUAL(blocksizes.front(), 8);
+    BOOST_CHECK_EQUAL(blocksizes.back(), 1);
+    int n_fitted = 0;
+    for (int claims : access.claims)
+    {
+        BOOST_CHECK(claims <= 1);
+        n_fitted += claims;
+    }
+    BOOST_CHECK(n_fitted < access.width() * access.height() / 2);
+
+    // Jeder Punkt hat den Wert der feinsten Zelle, in der er liegt.
+    for (int i = 0; i < access.width(); ++i)
+        for (int j = 0; j < access.height(); ++j)
+            BOOST_CHECK(std::isfinite(access.GetLeafValue(i, j)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
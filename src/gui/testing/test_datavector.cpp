@@ -16,9 +16,17 @@
 // along with Panga.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
+#include <cmath>
+#include <map>
+#include <sstream>
+
 #include "datavector.h"
 #include "mask.h"
 
@@ -35,6 +43,41 @@ struct DataVectorFixture
     DataVector vector;
     Mask mask;
 };
+
+//! Hält die Blöcke im Speicher und lädt sie beim Lesen erst beim ersten Zugriff.
+class InMemoryBlockStore : public DataBlockStore
+{
+public:
+    InMemoryBlockStore() : n_loads(0) {}
+
+    unsigned Add(const boost::shared_ptr<std::vector<double>>& values)
+    {
+        for (unsigned i = 0; i < saved.size(); ++i)
+            if (saved[i] == values)
+                return i;
+        saved.push_back(values);
+        return saved.size() - 1;
+    }
+
+    boost::shared_ptr<DataBlock> Get(unsigned id)
+    {
+        auto& block = loaded[id];
+        if (!block)
+        {
+            std::vector<double> values = *saved.at(id);
+            block = boost::make_shared<DataBlock>([this, values]()
+            {
+                ++n_loads;
+                return values;
+            });
+        }
+        return block;
+    }
+
+    std::vector<boost::shared_ptr<std::vector<double>>> saved;
+    std::map<unsigned, boost::shared_ptr<DataBlock>> loaded;
+    unsigned n_loads;
+};
 }
 
 BOOST_FIXTURE_TEST_SUITE(DataVector_tests, DataVectorFixture)
@@ -79,8 +122,104 @@ BOOST_AUTO_TEST_CASE(CalcStdDev_AllPointsDisabled_ReturnNAN)
     BOOST_CHECK(std::isnan(vector.CalcStdDev(mask)));
 }
 
+BOOST_AUTO_TEST_CASE(CalcStatistics_DisableFirstPointWithMask_ReturnMinMax)
+{
+    std::vector<bool>& m = mask.BeginEditMask();
+    m[0] = false;
+    mask.EndEditMask();
+    DataStatistics statistics = vector.CalcStatistics(mask);
+    BOOST_CHECK_EQUAL(statistics.n, 4);
+    BOOST_CHECK_CLOSE(statistics.mean, 3.5, 1e-10);
+    BOOST_CHECK_CLOSE(statistics.min, 2., 1e-10);
+    BOOST_CHECK_CLOSE(statistics.max, 5., 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(DataVector_SerializeWithBlockStore_LoadsSharedBlockOnFirstAccess)
+{
+    auto block = boost::make_shared<std::vector<double>>(std::vector<double>{1, 2, 3, 4});
+    std::vector<boost::shared_ptr<DataVector>> vectors{
+            boost::make_shared<DataVector>(block, 0, 2),
+            boost::make_shared<DataVector>(block, 2, 2)};
+
+    InMemoryBlockStore store;
+    std::stringstream stream;
+    {
+        DataBlockStore::Activation activation(store);
+        boost::archive::text_oarchive oa(stream);
+        oa << vectors;
+    }
+    BOOST_CHECK_EQUAL(store.saved.size(), 1);
+
+    std::vector<boost::shared_ptr<DataVector>> loaded;
+    {
+        DataBlockStore::Activation activation(store);
+        boost::archive::text_iarchive ia(stream);
+        ia >> loaded;
+    }
+    BOOST_REQUIRE_EQUAL(loaded.size(), 2);
+    BOOST_CHECK_EQUAL(loaded[1]->size(), 2);
+    BOOST_CHECK_EQUAL(store.n_loads, 0);
+
+    BOOST_CHECK_EQUAL((*loaded[1])[1], 4);
+    BOOST_CHECK_EQUAL((*loaded[0])[0], 1);
+    BOOST_CHECK_EQUAL(store.n_loads, 1);
+    BOOST_CHECK(DataBlockStore::GetActive() == nullptr);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_AUTO_TEST_CASE(DataVector_CalcStatistics_LargeMaskedVector_MatchesTwoPassResult)
+{
+    // Großer Offset und mehrere Blöcke prüfen die numerische Stabilität der
+    // Blockkombination, das Muster der Maske die Verarbeitung der gepackten Wörter.
+    const unsigned size = 1000;
+    std::vector<double> data(size);
+    std::vector<double> data2(size);
+    for (unsigned i = 0; i < size; ++i)
+    {
+        data[i] = 1e9 + (i * 37 % 101) * 0.01;
+        data2[i] = (i * 37 % 101) * 0.02 + std::sin(i * 0.1);
+    }
+    Mask mask(size);
+    std::vector<bool>& m = mask.BeginEditMask();
+    for (unsigned i = 0; i < size; ++i)
+        m[i] = (i / 70) % 3 != 1 && i % 11 != 0;
+    mask.EndEditMask();
+
+    unsigned n = 0;
+    double mean = 0.;
+    double mean2 = 0.;
+    for (unsigned i = 0; i < size; ++i)
+        if (m[i])
+        {
+            ++n;
+            mean += data[i];
+            mean2 += data2[i];
+        }
+    mean /= n;
+    mean2 /= n;
+    double sum_of_squares = 0.;
+    double sum_of_squares2 = 0.;
+    double sum_of_products = 0.;
+    for (unsigned i = 0; i < size; ++i)
+        if (m[i])
+        {
+            sum_of_squares += (data[i] - mean) * (data[i] - mean);
+            sum_of_squares2 += (data2[i] - mean2) * (data2[i] - mean2);
+            sum_of_products += (data[i] - mean) * (data2[i] - mean2);
+        }
+
+    DataCoStatistics statistics = DataVector(data).CalcStatistics(DataVector(data2), mask);
+    BOOST_CHECK_EQUAL(statistics.x.n, n);
+    BOOST_CHECK_EQUAL(mask.NumberOfUnmaskedElements(), n);
+    BOOST_CHECK_CLOSE(statistics.x.mean, mean, 1e-12);
+    BOOST_CHECK_CLOSE(statistics.x.Variance(), sum_of_squares / (n - 1), 1e-6);
+    BOOST_CHECK_CLOSE(statistics.y.Variance(), sum_of_squares2 / (n - 1), 1e-9);
+    BOOST_CHECK_CLOSE(statistics.Correlation(),
+                      sum_of_products / std::sqrt(sum_of_squares * sum_of_squares2),
+                      1e-6);
+}
+
 namespace
 {
 struct TwoDataVectorsFixture : public DataVectorFixture
@@ -121,4 +260,63 @@ BOOST_AUTO_TEST_CASE(CalcCorrelation_AllPointsDisabled_ReturnNAN)
     BOOST_CHECK(std::isnan(vector.CalcCorrelation(vector2, mask)));
 }
 
+BOOST_AUTO_TEST_CASE(DataCoStatistics_AddAndRemovePairs_MatchesRecalculation)
+{
+    DataCoStatistics statistics = vector.CalcStatistics(vector2, mask);
+    const DataVector& x = vector;
+    const DataVector& y = vector2;
+
+    // Das mittlere Element ist weder Minimum noch Maximum und kann exakt entfernt werden.
+    BOOST_CHECK(statistics.Remove(x[2], y[2]));
+    std::vector<bool>& m = mask.BeginEditMask();
+    m[2] = false;
+    mask.EndEditMask();
+    DataCoStatistics expected = vector.CalcStatistics(vector2, mask);
+    BOOST_CHECK_EQUAL(statistics.x.n, expected.x.n);
+    BOOST_CHECK_CLOSE(statistics.x.mean, expected.x.mean, 1e-10);
+    BOOST_CHECK_CLOSE(statistics.x.Variance(), expected.x.Variance(), 1e-10);
+    BOOST_CHECK_CLOSE(statistics.Correlation(), expected.Correlation(), 1e-10);
+
+    statistics.Add(x[2], y[2]);
+    mask.reset();
+    expected = vector.CalcStatistics(vector2, mask);
+    BOOST_CHECK_CLOSE(statistics.y.mean, expected.y.mean, 1e-10);
+    BOOST_CHECK_CLOSE(statistics.Correlation(), expected.Correlation(), 1e-10);
+
+    // Das Maximum lässt sich nicht entfernen, ohne neu zu rechnen.
+    BOOST_CHECK(!statistics.x.Remove(x[4]));
+}
+
+BOOST_AUTO_TEST_CASE(DataVector_SerializeWithBlockStore_LoadsSharedBlockOnFirstAccess)
+{
+    auto block = boost::make_shared<std::vector<double>>(std::vector<double>{1, 2, 3, 4});
+    std::vector<boost::shared_ptr<DataVector>> vectors{
+            boost::make_shared<DataVector>(block, 0, 2),
+            boost::make_shared<DataVector>(block, 2, 2)};
+
+    InMemoryBlockStore store;
+    std::stringstream stream;
+    {
+        DataBlockStore::Activation activation(store);
+        boost::archive::text_oarchive oa(stream);
+        oa << vectors;
+    }
+    BOOST_CHECK_EQUAL(store.saved.size(), 1);
+
+    std::vector<boost::shared_ptr<DataVector>> loaded;
+    {
+        DataBlockStore::Activation activation(store);
+        boost::archive::text_iarchive ia(stream);
+        ia >> loaded;
+    }
+    BOOST_REQUIRE_EQUAL(loaded.size(), 2);
+    BOOST_CHECK_EQUAL(loaded[1]->size(), 2);
+    BOOST_CHECK_EQUAL(store.n_loads, 0);
+
+    BOOST_CHECK_EQUAL((*loaded[1])[1], 4);
+    BOOST_CHECK_EQUAL((*loaded[0])[0], 1);
+    BOOST_CHECK_EQUAL(store.n_loads, 1);
+    BOOST_CHECK(DataBlockStore::GetActive() == nullptr);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
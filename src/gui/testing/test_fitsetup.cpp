@@ -0,0 +1,77 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <sstream>
+
+#include "fitsetup.h"
+
+BOOST_AUTO_TEST_SUITE(FitSetup_tests)
+
+BOOST_AUTO_TEST_CASE(SetNumberOfStarts_LessThanOne_UseOneStart)
+{
+    FitSetup fit_setup;
+    BOOST_CHECK_EQUAL(fit_setup.GetNumberOfStarts(), 1);
+    fit_setup.SetNumberOfStarts(0);
+    BOOST_CHECK_EQUAL(fit_setup.GetNumberOfStarts(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(SetTimeBudget_Negative_Unlimited)
+{
+    FitSetup fit_setup;
+    BOOST_CHECK_EQUAL(fit_setup.GetTimeBudget(), 0.);
+    fit_setup.SetTimeBudget(-1.);
+    BOOST_CHECK_EQUAL(fit_setup.GetTimeBudget(), 0.);
+}
+
+BOOST_AUTO_TEST_CASE(SaveAndLoad_MultiStartAndMonteCarloSettings_KeepSettings)
+{
+    FitSetup fit_setup;
+    fit_setup.SetNumberOfStarts(8);
+    fit_setup.SetTimeBudget(2.5);
+    const QList<ExtendedColumnType> column_types =
+            {{ColumnType::MODEL_CONCENTRATION, Gas::NE}};
+    fit_setup.SetMonteCarloColumnTypes(column_types);
+
+    FitSetup copy(fit_setup);
+    BOOST_CHECK_EQUAL(copy.GetNumberOfStarts(), 8);
+    BOOST_CHECK_EQUAL(copy.GetTimeBudget(), 2.5);
+    BOOST_CHECK(copy.GetMonteCarloColumnTypes() == column_types);
+
+    std::stringstream stream;
+    {
+        boost::archive::text_oarchive oa(stream);
+        const FitSetup* saved = &fit_setup;
+        oa << saved;
+    }
+    FitSetup* loaded = nullptr;
+    {
+        boost::archive::text_iarchive ia(stream);
+        ia >> loaded;
+    }
+    std::unique_ptr<FitSetup> loaded_guard(loaded);
+    BOOST_CHECK_EQUAL(loaded->GetNumberOfStarts(), 8);
+    BOOST_CHECK_EQUAL(loaded->GetTimeBudget(), 2.5);
+    BOOST_CHECK(loaded->GetMonteCarloColumnTypes() == column_types);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
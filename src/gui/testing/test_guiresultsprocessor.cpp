@@ -0,0 +1,80 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+#include "core/fitting/levenbergmarquardtfitter.h"
+#include "core/fitting/noblefitfunction.h"
+#include "guiresultsprocessor.h"
+#include "montecarloresultsmodel.h"
+
+#include "core/testing/fitting/cefitsetup.h"
+
+BOOST_AUTO_TEST_SUITE(GuiResultsProcessor_tests)
+
+BOOST_AUTO_TEST_CASE(GetMonteCarloResultsRequest_NoColumnTypes_RequestEverything)
+{
+    GuiResultsProcessor processor({"X"}, {"A", "F", "T"}, {Gas::NE, Gas::AR}, 2);
+
+    const ResultsRequest request = processor.GetMonteCarloResultsRequest();
+    BOOST_CHECK(request.IsRequested(Gas::NE, ResultsRequest::EVERYTHING));
+    BOOST_CHECK(request.IsRequested(Gas::XE, ResultsRequest::EVERYTHING));
+}
+
+BOOST_AUTO_TEST_CASE(GetMonteCarloResultsRequest_RestrictedColumnTypes_SkipUnrequestedOutputs)
+{
+    GuiResultsProcessor processor(
+            {"X"},
+            {"A", "F", "T"},
+            {Gas::NE, Gas::AR, Gas::KR, Gas::XE},
+            2,
+            {{ColumnType::MODEL_CONCENTRATION, Gas::NE}});
+
+    const ResultsRequest request = processor.GetMonteCarloResultsRequest();
+    BOOST_CHECK(request.IsRequested(Gas::NE, ResultsRequest::MODEL_VALUE));
+    BOOST_CHECK(!request.IsRequested(Gas::NE, ResultsRequest::EVERYTHING &
+                                              ~ResultsRequest::MODEL_VALUE));
+    for (GasType gas : {Gas::HE, Gas::AR, Gas::KR, Gas::XE})
+        BOOST_CHECK(!request.IsRequested(gas, ResultsRequest::EVERYTHING));
+
+    const MonteCarloResultsModel* model = qobject_cast<const MonteCarloResultsModel*>(
+            processor.GetMonteCarloResultsModel());
+    BOOST_REQUIRE(model);
+    const QList<ExtendedColumnType>& stored = model->GetAvailableColumnTypes();
+    BOOST_CHECK(stored.contains(ExtendedColumnType(ColumnType::MODEL_CONCENTRATION, Gas::NE)));
+    BOOST_CHECK(!stored.contains(ExtendedColumnType(ColumnType::MODEL_CONCENTRATION, Gas::AR)));
+    BOOST_CHECK(!stored.contains(ExtendedColumnType(ColumnType::CHI_SQUARE, 0)));
+    BOOST_CHECK(stored.contains(ExtendedColumnType(ColumnType::PARAMETER_ESTIMATE, 2)));
+    BOOST_CHECK(stored.contains(ExtendedColumnType(ColumnType::PARAMETER_ESTIMATE_ERROR, 2)));
+
+    CeFitSetup setup;
+    LevenbergMarquardtFitter fitter(std::make_shared<NobleFitFunction>(
+            setup.model, setup.GetParameterMap(), setup.concentrations));
+    fitter.SetResultsRequest(request);
+    std::shared_ptr<FitResults> results = fitter.fit(
+            std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+
+    BOOST_CHECK(results->equilibrium_concentrations[0].empty());
+    BOOST_CHECK(results->measured_concentrations[0].empty());
+    BOOST_REQUIRE_EQUAL(results->model_concentrations[0].size(), 1);
+    BOOST_CHECK(results->model_concentrations[0].count(Gas::NE));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/make_shared.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "datavector.h"
+#include "histogrambuilder2d.h"
+#include "mask.h"
+
+namespace
+{
+std::vector<unsigned> CountNaively(const std::vector<double>& x,
+                                   const std::vector<double>& y,
+                                   const Mask& mask,
+                                   unsigned bins,
+                                   double min_x, double max_x,
+                                   double min_y, double max_y)
+{
+    std::vector<unsigned> counts(bins * bins);
+    for (unsigned i = 0; i < x.size(); ++i)
+    {
+        if (!mask.IsEnabled(i) ||
+            !(x[i] >= min_x && x[i] <= max_x && y[i] >= min_y && y[i] <= max_y))
+            continue;
+        unsigned index_x = (x[i] - min_x) / (max_x - min_x) * bins;
+        unsigned index_y = (y[i] - min_y) / (max_y - min_y) * bins;
+        if (index_x >= bins) index_x = bins - 1;
+        if (index_y >= bins) index_y = bins - 1;
+        ++counts[index_x + bins * index_y];
+    }
+    return counts;
+}
+}
+
+BOOST_AUTO_TEST_CASE(HistogramBuilder2D_SmallData_CountsPointsPerBin)
+{
+    auto x = boost::make_shared<DataVector>(
+            std::vector<double>({0., 0.3, 0.5, 1., 0.9, 2., std::nan("")}));
+    auto y = boost::make_shared<DataVector>(
+            std::vector<double>({0., 0.3, 0.5, 1., 0.1, 0.5, 0.5}));
+    Mask mask(7);
+    HistogramBuilder2D builder(x, y);
+    builder.SetWindow(0., 1., 0., 1.);
+
+    // Punkte außerhalb und NaNs werden nicht gezählt, der obere Rand gehört zum letzten Bin.
+    std::vector<unsigned> counts = builder.Build(2, mask);
+    std::vector<unsigned> expected = {2, 1, 0, 2};
+    BOOST_CHECK_EQUAL_COLLECTIONS(counts.begin(), counts.end(),
+                                  expected.begin(), expected.end());
+
+    std::vector<bool>& m = mask.BeginEditMask();
+    m[0] = false;
+    m[3] = false;
+    mask.EndEditMask();
+    counts = builder.Build(2, mask);
+    expected = {1, 1, 0, 1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(counts.begin(), counts.end(),
+                                  expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(HistogramBuilder2D_ManyPointsSeveralThreads_MatchesDirectCount)
+{
+    const unsigned size = 300000;
+    std::vector<double> x(size);
+    std::vector<double> y(size);
+    for (unsigned i = 0; i < size; ++i)
+    {
+        x[i] = (i * 7919 % 1000) * 0.01;
+        y[i] = std::sin(i * 0.001) * 4.;
+    }
+    Mask mask(size);
+    std::vector<bool>& m = mask.BeginEditMask();
+    for (unsigned i = 0; i < size; ++i)
+        m[i] = i % 7 != 0 && (i / 1000) % 5 != 2;
+    mask.EndEditMask();
+
+    HistogramBuilder2D builder(boost::make_shared<DataVector>(x),
+                               boost::make_shared<DataVector>(y));
+    builder.SetNumberOfThreads(3);
+    // Bei Zweierpotenzen als Binzahl und Ausschnittsbreite ist die Quantisierung exakt.
+    builder.SetWindow(2., 6., -2., 2.);
+    for (unsigned bins : {1u, 16u, 64u})
+    {
+        std::vector<unsigned> counts = builder.Build(bins, mask);
+        std::vector<unsigned> expected =
+                CountNaively(x, y, mask, bins, 2., 6., -2., 2.);
+        BOOST_CHECK_EQUAL_COLLECTIONS(counts.begin(), counts.end(),
+                                      expected.begin(), expected.end());
+    }
+}
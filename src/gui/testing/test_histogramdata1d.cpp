@@ -0,0 +1,193 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <boost/make_shared.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <qwt_series_data.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "datavector.h"
+#include "histogramdata1d.h"
+#include "mask.h"
+#include "sharedbinnumber.h"
+
+namespace
+{
+//! Zählt die Werte direkt, mit derselben Zuordnung zu den Bins wie beim Maskieren.
+std::vector<unsigned> CountDirectly(const std::vector<double>& values,
+                                    const Mask& mask,
+                                    double min, double max,
+                                    unsigned bins)
+{
+    const double width = (max - min) / bins;
+    std::vector<unsigned> counts(bins);
+    for (unsigned i = 0; i < values.size(); ++i)
+    {
+        const double x = values[i];
+        if (!mask.IsEnabled(i) || !(x >= min && x <= max))
+            continue;
+        unsigned bin = static_cast<unsigned>((x - min) / width);
+        if (bin >= bins) bin = bins - 1;
+        ++counts[bin];
+    }
+    return counts;
+}
+
+std::vector<unsigned> GetCounts(const HistogramData1D& histogram)
+{
+    const QwtIntervalSeriesData& data = *histogram.GetHistogramData();
+    std::vector<unsigned> counts;
+    for (std::size_t i = 0; i < data.size(); ++i)
+        counts.push_back(static_cast<unsigned>(data.sample(i).value));
+    return counts;
+}
+
+void CheckCounts(const HistogramData1D& histogram,
+                 const std::vector<double>& values,
+                 double min, double max,
+                 unsigned bins)
+{
+    const std::vector<unsigned> counts = GetCounts(histogram);
+    const std::vector<unsigned> expected =
+            CountDirectly(values, histogram.GetMask(), min, max, bins);
+    BOOST_CHECK_EQUAL_COLLECTIONS(counts.begin(), counts.end(),
+                                  expected.begin(), expected.end());
+}
+
+//! Werte auf und direkt neben den Grenzen von zehn Bins zwischen 0 und 1.
+std::vector<double> CreateValuesAtBinEdges()
+{
+    std::vector<double> values;
+    for (int i = 0; i <= 10; ++i)
+    {
+        const double edge = i / 10.;
+        values.push_back(edge);
+        if (i > 0)
+            values.push_back(std::nextafter(edge, 0.));
+        if (i < 10)
+            values.push_back(std::nextafter(edge, 1.));
+    }
+    values.push_back(std::numeric_limits<double>::quiet_NaN());
+    values.push_back(1.);
+    values.push_back(0.3);
+    return values;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(HistogramData1D_tests)
+
+BOOST_AUTO_TEST_CASE(GetHistogramData_ValuesAtBinEdges_MatchDirectCount)
+{
+    const std::vector<double> values = CreateValuesAtBinEdges();
+    SharedBinNumber bins(10);
+    SharedMask mask(boost::make_shared<Mask>(values.size()));
+    HistogramData1D histogram(values.size(), bins, mask,
+                              boost::make_shared<DataVector>(values));
+
+    CheckCounts(histogram, values, 0., 1., 10);
+    unsigned total = 0;
+    for (unsigned count : GetCounts(histogram))
+        total += count;
+    BOOST_CHECK_EQUAL(total, values.size() - 1);
+
+    const QwtIntervalSeriesData& data = *histogram.GetHistogramData();
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        BOOST_CHECK_EQUAL(data.sample(i).interval.minValue(), i * 0.1);
+        BOOST_CHECK_EQUAL(data.sample(i).interval.maxValue(), (i + 1) * 0.1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GetHistogramData_MaskChangedAndZoomed_MatchDirectCount)
+{
+    const std::vector<double> values = CreateValuesAtBinEdges();
+    SharedBinNumber bins(10);
+    SharedMask mask(boost::make_shared<Mask>(values.size()));
+    HistogramData1D histogram(values.size(), bins, mask,
+                              boost::make_shared<DataVector>(values));
+    CheckCounts(histogram, values, 0., 1., 10);
+
+    // Einzelne Werte auf Bingrenzen werden schrittweise aus dem gecachten
+    // Histogramm entfernt, viele führen zur Neuberechnung.
+    std::vector<bool>& m = mask->BeginEditMask();
+    for (unsigned i = 0; i < values.size(); ++i)
+        if (values[i] == 0.3 || values[i] == 0.5 || values[i] == 1.)
+            m[i] = false;
+    mask->EndEditMask();
+    CheckCounts(histogram, values, 0., 1., 10);
+
+    std::vector<bool>& m2 = mask->BeginEditMask();
+    for (unsigned i = 0; i < m2.size(); i += 2)
+        m2[i] = false;
+    mask->EndEditMask();
+    CheckCounts(histogram, values, 0., 1., 10);
+
+    histogram.ZoomIn(QRectF(0.25, 0., 0.5, 1.));
+    CheckCounts(histogram, values, 0.25, 0.75, 10);
+
+    mask->BeginEditMask().assign(values.size(), true);
+    mask->EndEditMask();
+    CheckCounts(histogram, values, 0.25, 0.75, 10);
+
+    histogram.ZoomOut();
+    CheckCounts(histogram, values, 0., 1., 10);
+}
+
+BOOST_AUTO_TEST_CASE(GetHistogramData_RoundedValues_MatchDirectCount)
+{
+    // Vielfache von 0.01 fallen bei vielen Binzahlen auf oder knapp neben Bingrenzen.
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 100);
+    std::vector<double> values(10000);
+    for (double& value : values)
+        value = distribution(generator) * 0.01;
+    values.front() = 0.;
+    values.back() = 1.;
+
+    SharedMask mask(boost::make_shared<Mask>(values.size()));
+    for (unsigned n_bins : {3u, 7u, 10u, 25u, 100u})
+    {
+        SharedBinNumber bins(n_bins);
+        HistogramData1D histogram(values.size(), bins, mask,
+                                  boost::make_shared<DataVector>(values));
+        CheckCounts(histogram, values, 0., 1., n_bins);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GetHistogramData_NaNFirst_ZoomSpansFiniteValues)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const std::vector<double> values{nan, 2., -1., nan, 3.,
+                                     std::numeric_limits<double>::infinity()};
+    SharedBinNumber bins(4);
+    SharedMask mask(boost::make_shared<Mask>(values.size()));
+    HistogramData1D histogram(values.size(), bins, mask,
+                              boost::make_shared<DataVector>(values));
+
+    const QwtIntervalSeriesData& data = *histogram.GetHistogramData();
+    BOOST_REQUIRE_EQUAL(data.size(), 4);
+    BOOST_CHECK_EQUAL(data.sample(0).interval.minValue(), -1.);
+    BOOST_CHECK_EQUAL(data.sample(3).interval.maxValue(), 3.);
+    CheckCounts(histogram, values, -1., 3., 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <boost/make_shared.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <vector>
+
+#include "mask.h"
+
+namespace
+{
+struct MaskFixture
+{
+    MaskFixture() :
+        exit_flags(boost::make_shared<std::vector<Eigen::LM::Status>>(
+                       100, Eigen::LM::RelativeErrorTooSmall)),
+        mask(100, exit_flags)
+    {
+        for (unsigned i = 0; i < 100; i += 4)
+            (*exit_flags)[i] = Eigen::LM::TooManyFunctionEvaluation;
+    }
+
+    boost::shared_ptr<std::vector<Eigen::LM::Status>> exit_flags;
+    Mask mask;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Mask_tests, MaskFixture)
+
+BOOST_AUTO_TEST_CASE(EndEditMask_DisableSomeElements_ReportsToggledElements)
+{
+    BOOST_CHECK_CLOSE(mask.PerCentConverged(), 75., 1e-10);
+
+    std::vector<bool>& m = mask.BeginEditMask();
+    m[0] = m[1] = m[70] = m[99] = false;
+    mask.EndEditMask();
+    std::vector<unsigned long> expected = {0, 1, 70, 99};
+    BOOST_CHECK_EQUAL_COLLECTIONS(mask.GetToggledElements().begin(),
+                                  mask.GetToggledElements().end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(mask.NumberOfUnmaskedElements(), 96u);
+    BOOST_CHECK_CLOSE(mask.PerCentConverged(), 72. / 96. * 100., 1e-10);
+
+    mask.BeginEditMask();
+    m[1] = true;
+    m[2] = false;
+    mask.EndEditMask();
+    expected = {1, 2};
+    BOOST_CHECK_EQUAL_COLLECTIONS(mask.GetToggledElements().begin(),
+                                  mask.GetToggledElements().end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(mask.NumberOfUnmaskedElements(), 96u);
+    BOOST_CHECK_CLOSE(mask.PerCentConverged(), 72. / 96. * 100., 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(Reset_AfterInvert_TogglesAllElementsBack)
+{
+    mask.InvertMask();
+    BOOST_CHECK_EQUAL(mask.GetToggledElements().size(), 100u);
+    BOOST_CHECK_EQUAL(mask.NumberOfUnmaskedElements(), 0u);
+
+    mask.reset();
+    BOOST_CHECK_EQUAL(mask.GetToggledElements().size(), 100u);
+    BOOST_CHECK_EQUAL(mask.NumberOfUnmaskedElements(), 100u);
+    BOOST_CHECK_CLOSE(mask.PerCentConverged(), 75., 1e-10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,383 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <boost/crc.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <QBuffer>
+#include <QTemporaryFile>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "montecarloexportercsv.h"
+#include "montecarloexporternpz.h"
+#include "zipwriter.h"
+
+namespace
+{
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+const double INF = std::numeric_limits<double>::infinity();
+
+//! Zwei Proben mit je einer maskierten Zeile und Werten, die schwer exakt zu speichern sind.
+struct ExportDataFixture
+{
+    // Je Probe vier Fits, die Spalte A im Block ab 0, Ne/Ar ab 4. Die Werte 99 sind
+    // maskiert und dürfen nicht exportiert werden.
+    ExportDataFixture() :
+        values_a({0.1, 99., 1. / 3, -2.5e-310,
+                  1.7976931348623157e308, 99., 5e-324, 0.30000000000000004}),
+        values_b({-0., 123456789012345678., NaN, 99.,
+                  INF, -INF, 2. / 3, 99.}),
+        exit_flags_a({Eigen::LM::RelativeReductionTooSmall,
+                      Eigen::LM::UserAsked,
+                      Eigen::LM::UserAsked,
+                      Eigen::LM::TooManyFunctionEvaluation}),
+        exit_flags_b({Eigen::LM::ImproperInputParameters,
+                      Eigen::LM::CosinusTooSmall,
+                      Eigen::LM::RelativeErrorTooSmall,
+                      Eigen::LM::UserAsked})
+    {
+        data.column_names << "A" << "Convergence" << "Ne/Ar";
+
+        MonteCarloExportData::Sample a;
+        a.name = "a";
+        a.rows = {0, 2, 3};
+        a.columns = {values_a.data(), nullptr, values_a.data() + 4};
+        a.exit_flags = &exit_flags_a;
+        data.samples.push_back(a);
+
+        MonteCarloExportData::Sample b;
+        b.name = "bb";
+        b.rows = {0, 1, 2};
+        b.columns = {values_b.data(), nullptr, values_b.data() + 4};
+        b.exit_flags = &exit_flags_b;
+        data.samples.push_back(b);
+    }
+
+    //! Erwartete Werte einer Spalte über alle nicht maskierten Zeilen.
+    std::vector<double> ExpectedColumn(unsigned column) const
+    {
+        std::vector<double> expected;
+        for (const auto& sample : data.samples)
+            for (unsigned row : sample.rows)
+                expected.push_back(sample.columns[column][row]);
+        return expected;
+    }
+
+    std::vector<std::string> ExpectedNames() const
+    {
+        std::vector<std::string> expected;
+        for (const auto& sample : data.samples)
+            expected.insert(expected.end(), sample.rows.size(),
+                            sample.name.toUtf8().constData());
+        return expected;
+    }
+
+    std::vector<std::string> ExpectedExitFlags() const
+    {
+        std::vector<std::string> expected;
+        for (const auto& sample : data.samples)
+            for (unsigned row : sample.rows)
+                expected.push_back(FitResults::GetExitFlagAsString(sample.exit_flags->at(row)));
+        return expected;
+    }
+
+    std::vector<double> values_a;
+    std::vector<double> values_b;
+    std::vector<Eigen::LM::Status> exit_flags_a;
+    std::vector<Eigen::LM::Status> exit_flags_b;
+    MonteCarloExportData data;
+};
+
+//! Vergleicht die Bitmuster, damit auch -0 und NaN geprüft werden.
+void CheckBitwiseEqual(double actual, double expected)
+{
+    if (std::isnan(expected))
+    {
+        BOOST_CHECK(std::isnan(actual));
+        return;
+    }
+    std::uint64_t actual_bits, expected_bits;
+    std::memcpy(&actual_bits, &actual, sizeof(double));
+    std::memcpy(&expected_bits, &expected, sizeof(double));
+    BOOST_CHECK_MESSAGE(actual_bits == expected_bits,
+                        "Read " << actual << ", expected " << expected);
+}
+
+std::string ReadFile(const QString& filename)
+{
+    std::ifstream file(filename.toLocal8Bit().constData(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+}
+
+template<class T>
+T ReadLittleEndian(const std::string& bytes, std::size_t position)
+{
+    BOOST_REQUIRE_LE(position + sizeof(T), bytes.size());
+    std::uint64_t value = 0;
+    for (unsigned i = 0; i < sizeof(T); ++i)
+        value |= std::uint64_t(static_cast<unsigned char>(bytes[position + i])) << (8 * i);
+    return static_cast<T>(value);
+}
+
+//! Liest die Einträge eines unkomprimierten Zip-Archivs und prüft dabei Header und CRCs.
+std::map<std::string, std::string> ReadZipEntries(const std::string& archive)
+{
+    BOOST_REQUIRE_GE(archive.size(), 22u);
+    const std::size_t end_record = archive.size() - 22;
+    BOOST_REQUIRE_EQUAL(ReadLittleEndian<std::uint32_t>(archive, end_record), 0x06054b50u);
+    const unsigned n_entries = ReadLittleEndian<std::uint16_t>(archive, end_record + 10);
+    BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint16_t>(archive, end_record + 8), n_entries);
+    const std::uint32_t directory_size = ReadLittleEndian<std::uint32_t>(archive, end_record + 12);
+    const std::uint32_t directory_offset = ReadLittleEndian<std::uint32_t>(archive, end_record + 16);
+    BOOST_REQUIRE_EQUAL(directory_offset + directory_size, end_record);
+
+    std::map<std::string, std::string> entries;
+    std::size_t position = directory_offset;
+    std::size_t expected_offset = 0;
+    for (unsigned i = 0; i < n_entries; ++i)
+    {
+        BOOST_REQUIRE_EQUAL(ReadLittleEndian<std::uint32_t>(archive, position), 0x02014b50u);
+        BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint16_t>(archive, position + 10), 0);
+        const std::uint32_t crc = ReadLittleEndian<std::uint32_t>(archive, position + 16);
+        const std::uint32_t size = ReadLittleEndian<std::uint32_t>(archive, position + 20);
+        BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint32_t>(archive, position + 24), size);
+        const unsigned name_length = ReadLittleEndian<std::uint16_t>(archive, position + 28);
+        const unsigned extra_length = ReadLittleEndian<std::uint16_t>(archive, position + 30);
+        const unsigned comment_length = ReadLittleEndian<std::uint16_t>(archive, position + 32);
+        const std::uint32_t offset = ReadLittleEndian<std::uint32_t>(archive, position + 42);
+        const std::string name = archive.substr(position + 46, name_length);
+        position += 46 + name_length + extra_length + comment_length;
+
+        // Die Einträge folgen lückenlos aufeinander.
+        BOOST_CHECK_EQUAL(offset, expected_offset);
+        BOOST_REQUIRE_EQUAL(ReadLittleEndian<std::uint32_t>(archive, offset), 0x04034b50u);
+        BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint16_t>(archive, offset + 8), 0);
+        BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint32_t>(archive, offset + 14), crc);
+        BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint32_t>(archive, offset + 18), size);
+        BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint32_t>(archive, offset + 22), size);
+        BOOST_REQUIRE_EQUAL(ReadLittleEndian<std::uint16_t>(archive, offset + 26), name_length);
+        const unsigned local_extra_length = ReadLittleEndian<std::uint16_t>(archive, offset + 28);
+        BOOST_CHECK_EQUAL(archive.substr(offset + 30, name_length), name);
+
+        const std::size_t data_offset = offset + 30 + name_length + local_extra_length;
+        BOOST_REQUIRE_LE(data_offset + size, directory_offset);
+        const std::string data = archive.substr(data_offset, size);
+        boost::crc_32_type checksum;
+        checksum.process_bytes(data.data(), data.size());
+        BOOST_CHECK_EQUAL(checksum.checksum(), crc);
+
+        entries[name] = data;
+        expected_offset = data_offset + size;
+    }
+    BOOST_CHECK_EQUAL(expected_offset, directory_offset);
+    BOOST_CHECK_EQUAL(position, end_record);
+    return entries;
+}
+
+//! Prüft den Header eines eindimensionalen .npy-Arrays und gibt dessen Daten zurück.
+std::string ReadNpyArray(const std::string& npy,
+                         const std::string& descr,
+                         std::size_t size)
+{
+    BOOST_REQUIRE_GE(npy.size(), 10u);
+    BOOST_CHECK_EQUAL(npy.substr(0, 8), std::string("\x93NUMPY\x01\x00", 8));
+    const std::size_t header_length = ReadLittleEndian<std::uint16_t>(npy, 8);
+    BOOST_CHECK_EQUAL((10 + header_length) % 64, 0u);
+    const std::string header = npy.substr(10, header_length);
+    BOOST_CHECK_EQUAL(header.back(), '\n');
+    const char byte_order = Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? '<' : '>';
+    BOOST_CHECK_MESSAGE(header.find("'descr': '" + (byte_order + descr) + "'") != std::string::npos,
+                        header);
+    BOOST_CHECK(header.find("'fortran_order': False") != std::string::npos);
+    BOOST_CHECK_MESSAGE(header.find("'shape': (" + std::to_string(size) + ",)") !=
+                            std::string::npos,
+                        header);
+    return npy.substr(10 + header_length);
+}
+
+//! Liest ein .npy-Array von Strings fester Breite, die nur aus ASCII-Zeichen bestehen.
+std::vector<std::string> ReadNpyStrings(const std::string& npy, unsigned width, std::size_t size)
+{
+    const std::string data = ReadNpyArray(npy, "U" + std::to_string(width), size);
+    BOOST_REQUIRE_EQUAL(data.size(), size * width * 4);
+    std::vector<std::string> strings(size);
+    for (std::size_t i = 0; i < size; ++i)
+        for (unsigned j = 0; j < width; ++j)
+        {
+            std::uint32_t c;
+            std::memcpy(&c, data.data() + (i * width + j) * 4, 4);
+            if (c)
+                strings[i] += static_cast<char>(c);
+        }
+    return strings;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(MonteCarloExporter_tests, ExportDataFixture)
+
+BOOST_AUTO_TEST_CASE(ExportCsv_ParseValues_BitwiseEqual)
+{
+    QTemporaryFile file;
+    BOOST_REQUIRE(file.open());
+    {
+        MonteCarloExporterCsv exporter(file.fileName());
+        exporter.Export(data);
+    }
+
+    std::istringstream csv(ReadFile(file.fileName()));
+    std::string line;
+    BOOST_REQUIRE(std::getline(csv, line));
+    BOOST_CHECK_EQUAL(line, "Name,A,Convergence,Ne/Ar");
+
+    const std::vector<std::string> names = ExpectedNames();
+    const std::vector<std::string> exit_flags = ExpectedExitFlags();
+    const std::vector<double> a = ExpectedColumn(0);
+    const std::vector<double> ne_ar = ExpectedColumn(2);
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        BOOST_REQUIRE(std::getline(csv, line));
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ','))
+            fields.push_back(field);
+        BOOST_REQUIRE_EQUAL(fields.size(), 4);
+        BOOST_CHECK_EQUAL(fields[0], names[i]);
+        CheckBitwiseEqual(std::strtod(fields[1].c_str(), nullptr), a[i]);
+        BOOST_CHECK_EQUAL(fields[2], exit_flags[i]);
+        CheckBitwiseEqual(std::strtod(fields[3].c_str(), nullptr), ne_ar[i]);
+    }
+    BOOST_CHECK(!std::getline(csv, line));
+}
+
+BOOST_AUTO_TEST_CASE(ExportNpz_ParseArchive_ValidEntriesAndBitwiseEqualValues)
+{
+    QTemporaryFile file;
+    BOOST_REQUIRE(file.open());
+    {
+        MonteCarloExporterNpz exporter(file.fileName());
+        exporter.Export(data);
+    }
+
+    const std::map<std::string, std::string> entries = ReadZipEntries(ReadFile(file.fileName()));
+    BOOST_REQUIRE_EQUAL(entries.size(), 4);
+    BOOST_REQUIRE(entries.count("Name.npy"));
+    BOOST_REQUIRE(entries.count("A.npy"));
+    BOOST_REQUIRE(entries.count("Convergence.npy"));
+    BOOST_REQUIRE(entries.count("Ne_Ar.npy"));
+
+    const std::size_t size = ExpectedNames().size();
+    BOOST_CHECK(ReadNpyStrings(entries.at("Name.npy"), 2, size) == ExpectedNames());
+
+    const std::vector<std::string> exit_flags = ExpectedExitFlags();
+    std::size_t width = 0;
+    for (const auto& flag : exit_flags)
+        width = std::max(width, flag.size());
+    BOOST_CHECK(ReadNpyStrings(entries.at("Convergence.npy"), width, size) == exit_flags);
+
+    const std::pair<const char*, unsigned> columns[] = {{"A.npy", 0}, {"Ne_Ar.npy", 2}};
+    for (const auto& column : columns)
+    {
+        const std::string values = ReadNpyArray(entries.at(column.first), "f8", size);
+        BOOST_REQUIRE_EQUAL(values.size(), size * sizeof(double));
+        const std::vector<double> expected = ExpectedColumn(column.second);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            double value;
+            std::memcpy(&value, values.data() + i * sizeof(double), sizeof(double));
+            CheckBitwiseEqual(value, expected[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ZipWriter_tests)
+
+BOOST_AUTO_TEST_CASE(Finish_ArchiveReachesSizeLimit_Succeeds)
+{
+    // Lokaler Header 30 + 1, Daten 10, zentraler Eintrag 46 + 1, Endsatz 22.
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    ZipWriter zip(buffer, 110);
+    zip.BeginEntry("a");
+    zip.WriteToEntry("0123456789", 10);
+    zip.EndEntry();
+    zip.Finish();
+
+    BOOST_CHECK_EQUAL(buffer.size(), 110);
+    const std::map<std::string, std::string> entries =
+            ReadZipEntries(std::string(buffer.data().constData(), buffer.size()));
+    BOOST_REQUIRE_EQUAL(entries.size(), 1);
+    BOOST_CHECK_EQUAL(entries.at("a"), "0123456789");
+}
+
+BOOST_AUTO_TEST_CASE(Finish_ArchiveExceedsSizeLimit_Throws)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    ZipWriter zip(buffer, 109);
+    zip.BeginEntry("a");
+    zip.WriteToEntry("0123456789", 10);
+    zip.EndEntry();
+
+    BOOST_CHECK_THROW(zip.Finish(), std::runtime_error);
+    BOOST_CHECK_EQUAL(buffer.size(), 41);
+}
+
+BOOST_AUTO_TEST_CASE(WriteToEntry_EntryExceedsSizeLimit_ThrowsBeforeWriting)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    ZipWriter zip(buffer, 100);
+    zip.BeginEntry("a");
+    const std::string data(69, 'x');
+    zip.WriteToEntry(data.data(), data.size());
+
+    BOOST_CHECK_THROW(zip.WriteToEntry(data.data(), 1), std::runtime_error);
+    BOOST_CHECK_EQUAL(buffer.size(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(BeginEntry_MoreThan65535Entries_Throws)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    ZipWriter zip(buffer);
+    for (unsigned i = 0; i < 65535; ++i)
+    {
+        zip.BeginEntry("a");
+        zip.EndEntry();
+    }
+
+    BOOST_CHECK_THROW(zip.BeginEntry("a"), std::runtime_error);
+    zip.Finish();
+    const std::string archive(buffer.data().constData(), buffer.size());
+    BOOST_CHECK_EQUAL(ReadLittleEndian<std::uint16_t>(archive, archive.size() - 12), 65535);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
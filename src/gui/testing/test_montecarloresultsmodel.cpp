@@ -0,0 +1,192 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "core/fitting/fitresults.h"
+#include "montecarloexporter.h"
+#include "montecarloresultsmodel.h"
+
+namespace
+{
+//! Werte einer Probe, wie sie exportiert wurden.
+struct ExportedSample
+{
+    std::vector<unsigned> rows;
+    std::vector<std::vector<double>> columns;
+    std::vector<Eigen::LM::Status> exit_flags;
+};
+
+//! Kopiert die exportierten Werte, die nur während Export gültig sind.
+class CopyingExporter : public MonteCarloExporter
+{
+public:
+    explicit CopyingExporter(unsigned n_monte_carlos) :
+        n_monte_carlos_(n_monte_carlos)
+    {
+    }
+
+    void Export(const MonteCarloExportData& data)
+    {
+        for (const auto& sample : data.samples)
+        {
+            ExportedSample exported;
+            exported.rows = sample.rows;
+            for (const double* column : sample.columns)
+                exported.columns.push_back(column ?
+                        std::vector<double>(column, column + n_monte_carlos_) :
+                        std::vector<double>());
+            exported.exit_flags = *sample.exit_flags;
+            samples.push_back(exported);
+        }
+    }
+
+    std::vector<ExportedSample> samples;
+
+private:
+    const unsigned n_monte_carlos_;
+};
+
+//! Ergebnis eines Monte-Carlo-Fits mit zwei Parametern.
+FitResults CreateResults(double chi_square, double a, double b,
+                         Eigen::LM::Status exit_flag)
+{
+    FitResults results;
+    results.chi_square = chi_square;
+    results.best_estimate = Eigen::Vector2d(a, b);
+    results.deviations = Eigen::Vector2d(0.1, 0.2);
+    results.covariance_matrix = 0.01 * Eigen::Matrix2d::Identity();
+    results.n_iterations = 1;
+    results.degrees_of_freedom = 3;
+    results.exit_flag = exit_flag;
+    return results;
+}
+
+//! Wie LevenbergMarquardtFitter::fit ein Ergebnis ohne brauchbare Werte liefert.
+FitResults CreateFailedResults()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    FitResults results = CreateResults(nan, nan, nan, Eigen::LM::ImproperInputParameters);
+    results.deviations.setConstant(2, nan);
+    results.covariance_matrix.setConstant(2, 2, nan);
+    return results;
+}
+
+struct MonteCarloResultsModelFixture
+{
+    MonteCarloResultsModelFixture() :
+        n_monte_carlos(3),
+        model({"X", "Y"}, {"A", "B"}, {Gas::NE, Gas::AR}, n_monte_carlos, nullptr,
+              {{ColumnType::CHI_SQUARE, 0}}),
+        column_types({{ColumnType::CHI_SQUARE, 0},
+                      {ColumnType::PARAMETER_ESTIMATE, 0},
+                      {ColumnType::PARAMETER_ESTIMATE, 1},
+                      {ColumnType::CONVERGENCE, 0}})
+    {
+    }
+
+    void Process(const std::string& sample, const FitResults& results)
+    {
+        model.ProcessMonteCarloResult(results, {sample}, {"A", "B"}, {});
+    }
+
+    std::vector<ExportedSample> Export() const
+    {
+        CopyingExporter exporter(n_monte_carlos);
+        model.ExportMonteCarloData(exporter, column_types);
+        return exporter.samples;
+    }
+
+    const unsigned n_monte_carlos;
+    MonteCarloResultsModel model;
+    const QList<ExtendedColumnType> column_types;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(MonteCarloResultsModel_tests, MonteCarloResultsModelFixture)
+
+BOOST_AUTO_TEST_CASE(ProcessMonteCarloResult_InterleavedSamples_ColumnsPerSample)
+{
+    // Die Ergebnisse kommen in der Reihenfolge, in der die Fits fertig werden.
+    Process("Y", CreateResults(10., 11., 12., Eigen::LM::RelativeReductionTooSmall));
+    Process("X", CreateResults(1., 2., 3., Eigen::LM::RelativeReductionTooSmall));
+    Process("Y", CreateResults(20., 21., 22., Eigen::LM::RelativeErrorTooSmall));
+    Process("Y", CreateResults(30., 31., 32., Eigen::LM::TooManyFunctionEvaluation));
+    Process("X", CreateResults(4., 5., 6., Eigen::LM::RelativeErrorTooSmall));
+    Process("X", CreateResults(7., 8., 9., Eigen::LM::RelativeReductionTooSmall));
+
+    const std::vector<ExportedSample> samples = Export();
+    BOOST_REQUIRE_EQUAL(samples.size(), 2);
+
+    const std::vector<std::vector<double>> expected_x = {{1., 4., 7.},
+                                                         {2., 5., 8.},
+                                                         {3., 6., 9.}};
+    const std::vector<std::vector<double>> expected_y = {{10., 20., 30.},
+                                                         {11., 21., 31.},
+                                                         {12., 22., 32.}};
+    for (unsigned c = 0; c < 3; ++c)
+    {
+        BOOST_CHECK_EQUAL_COLLECTIONS(samples[0].columns[c].begin(),
+                                      samples[0].columns[c].end(),
+                                      expected_x[c].begin(), expected_x[c].end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(samples[1].columns[c].begin(),
+                                      samples[1].columns[c].end(),
+                                      expected_y[c].begin(), expected_y[c].end());
+    }
+    BOOST_CHECK(samples[0].columns[3].empty());
+
+    BOOST_REQUIRE_EQUAL(samples[1].exit_flags.size(), 3);
+    BOOST_CHECK_EQUAL(samples[1].exit_flags[0], Eigen::LM::RelativeReductionTooSmall);
+    BOOST_CHECK_EQUAL(samples[1].exit_flags[2], Eigen::LM::TooManyFunctionEvaluation);
+    BOOST_CHECK_EQUAL(samples[0].rows.size(), n_monte_carlos);
+}
+
+BOOST_AUTO_TEST_CASE(ProcessMonteCarloResult_FailedAndMissingRuns_NaN)
+{
+    Process("X", CreateResults(1., 2., 3., Eigen::LM::RelativeReductionTooSmall));
+    Process("X", CreateFailedResults());
+    Process("Y", CreateFailedResults());
+
+    const std::vector<ExportedSample> samples = Export();
+    BOOST_REQUIRE_EQUAL(samples.size(), 2);
+
+    // Fehlgeschlagene Fits hinterlassen NaNs, nicht gelieferte Fits ebenfalls.
+    const ExportedSample& x = samples[0];
+    for (unsigned c = 0; c < 3; ++c)
+    {
+        BOOST_REQUIRE_EQUAL(x.columns[c].size(), n_monte_carlos);
+        BOOST_CHECK(!std::isnan(x.columns[c][0]));
+        BOOST_CHECK(std::isnan(x.columns[c][1]));
+        BOOST_CHECK(std::isnan(x.columns[c][2]));
+    }
+    BOOST_CHECK_EQUAL(x.columns[0][0], 1.);
+    BOOST_REQUIRE_EQUAL(x.exit_flags.size(), 2);
+    BOOST_CHECK_EQUAL(x.exit_flags[1], Eigen::LM::ImproperInputParameters);
+
+    const ExportedSample& y = samples[1];
+    for (unsigned c = 0; c < 3; ++c)
+        for (double value : y.columns[c])
+            BOOST_CHECK(std::isnan(value));
+    BOOST_CHECK_EQUAL(y.exit_flags.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,358 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <boost/test/unit_test.hpp>
+
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "core/fitting/levenbergmarquardtfitter.h"
+#include "core/fitting/noblefitfunction.h"
+#include "fitsetup.h"
+#include "guiresultsprocessor.h"
+#include "histogramdata1d.h"
+#include "histogramdata2d.h"
+#include "montecarloresultsmodel.h"
+#include "resultscontainer.h"
+#include "standardfitresultsmodel.h"
+
+#include "core/testing/fitting/cefitsetup.h"
+
+namespace
+{
+//! Position des Inhaltsverzeichnisses im Dateikopf (nach Kennung, Version und file_id).
+const std::size_t INDEX_OFFSET_POSITION = 8 + 4 + 8;
+
+struct Frame
+{
+    std::uint64_t offset;
+    std::uint64_t compressed_size;
+    std::uint64_t size;
+};
+
+std::string ReadFile(const QString& filename)
+{
+    std::ifstream file(filename.toLocal8Bit().constData(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const QString& filename, const std::string& contents)
+{
+    std::ofstream file(filename.toLocal8Bit().constData(),
+                       std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+    BOOST_REQUIRE(file);
+}
+
+template<class T>
+T Get(const std::string& bytes, std::size_t& position)
+{
+    BOOST_REQUIRE_LE(position + sizeof(T), bytes.size());
+    T value;
+    std::memcpy(&value, bytes.data() + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+}
+
+template<class T>
+void Append(std::string& bytes, T value)
+{
+    bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+//! Liest das Inhaltsverzeichnis eines Containers der Version 2 (siehe ResultsContainer).
+std::vector<std::vector<Frame>> ReadIndex(const std::string& container)
+{
+    std::size_t position = 8;
+    BOOST_REQUIRE_EQUAL(Get<std::uint32_t>(container, position), 2);
+    position = INDEX_OFFSET_POSITION;
+    position = Get<std::uint64_t>(container, position);
+
+    std::vector<std::vector<Frame>> chunks(Get<std::uint32_t>(container, position));
+    for (auto& chunk : chunks)
+    {
+        chunk.resize(Get<std::uint32_t>(container, position));
+        for (auto& frame : chunk)
+        {
+            frame.offset = Get<std::uint64_t>(container, position);
+            frame.compressed_size = Get<std::uint64_t>(container, position);
+            frame.size = Get<std::uint64_t>(container, position);
+        }
+    }
+    BOOST_CHECK_EQUAL(position, container.size());
+    return chunks;
+}
+
+//! Schreibt einen Container in Version 1 um, in der jeder Abschnitt nur ein Teil ist.
+void ConvertToVersion1(const QString& filename)
+{
+    std::string container = ReadFile(filename);
+    const std::vector<std::vector<Frame>> chunks = ReadIndex(container);
+
+    std::size_t position = INDEX_OFFSET_POSITION;
+    container.resize(Get<std::uint64_t>(container, position));
+    Append<std::uint32_t>(container, chunks.size());
+    for (const auto& chunk : chunks)
+    {
+        BOOST_REQUIRE_EQUAL(chunk.size(), 1);
+        Append(container, chunk[0].offset);
+        Append(container, chunk[0].compressed_size);
+        Append(container, chunk[0].size);
+    }
+    const std::uint32_t version = 1;
+    std::memcpy(&container[8], &version, sizeof(version));
+    WriteFile(filename, container);
+}
+
+//! Die von ResultsContainer::Read erzeugten Objekte.
+struct LoadedResults
+{
+    explicit LoadedResults(const QString& filename)
+    {
+        StandardFitResultsModel* results_model = nullptr;
+        MonteCarloResultsModel* monte_carlo_model = nullptr;
+        FitSetup* fit_setup = nullptr;
+        try
+        {
+            ResultsContainer::Read(filename, results_model, monte_carlo_model, fit_setup);
+        }
+        catch (...)
+        {
+            delete results_model;
+            delete monte_carlo_model;
+            delete fit_setup;
+            throw;
+        }
+        results.reset(results_model);
+        monte_carlo.reset(monte_carlo_model);
+        setup.reset(fit_setup);
+    }
+
+    std::unique_ptr<StandardFitResultsModel> results;
+    std::unique_ptr<MonteCarloResultsModel> monte_carlo;
+    std::unique_ptr<FitSetup> setup;
+};
+
+//! Ergebnisse zweier Proben mit je einem Monte-Carlo-Block.
+struct ResultsFixture
+{
+    explicit ResultsFixture(unsigned n_monte_carlos = 3) :
+        processor({"a", "b"}, {"A", "F", "T"}, {Gas::NE, Gas::AR}, n_monte_carlos,
+                  {{ColumnType::CHI_SQUARE, 0}}),
+        results_model(qobject_cast<StandardFitResultsModel*>(processor.GetResultsModel())),
+        monte_carlo_model(qobject_cast<MonteCarloResultsModel*>(
+                processor.GetMonteCarloResultsModel()))
+    {
+        BOOST_REQUIRE(results_model);
+        BOOST_REQUIRE(monte_carlo_model);
+        BOOST_REQUIRE(file.open());
+        fit_setup.SetName("container test");
+
+        CeFitSetup setup;
+        LevenbergMarquardtFitter fitter(std::make_shared<NobleFitFunction>(
+                setup.model, setup.GetParameterMap(), setup.concentrations));
+        std::shared_ptr<const FitParameterConfig> pconf(
+                std::make_shared<FitParameterConfig>(setup.fit_parameter_config));
+        for (const std::string sample : {"a", "b"})
+        {
+            std::shared_ptr<FitResults> results = fitter.fit(pconf);
+            results_model->ProcessResult(boost::make_shared<FitResults>(*results),
+                                         {sample}, {"A", "F", "T"}, setup.concentrations);
+            // Die Monte-Carlo-Ergebnisse unterscheiden sich, damit verwechselte Zeilen
+            // oder Blöcke auffallen.
+            for (unsigned i = 0; i < std::min(n_monte_carlos, 3u); ++i)
+            {
+                results->best_estimate[0] = 0.001 * (i + 1) + (sample == "b");
+                monte_carlo_model->ProcessMonteCarloResult(
+                        *results, {sample}, {"A", "F", "T"}, setup.concentrations);
+            }
+        }
+    }
+
+    void Write()
+    {
+        ResultsContainer::Write(file.fileName(), results_model, monte_carlo_model, &fit_setup);
+    }
+
+    //! Vergleicht die Werte aller Monte-Carlo-Blöcke mit den gespeicherten.
+    void CheckMonteCarloBlocks(const MonteCarloResultsModel& loaded) const
+    {
+        const auto expected = monte_carlo_model->GetDataBlocks();
+        const auto actual = loaded.GetDataBlocks();
+        BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i)
+        {
+            // Die Blöcke werden erst beim ersten Zugriff geladen.
+            BOOST_CHECK(!actual[i]->IsLoaded());
+            const std::vector<double>& expected_values = *expected[i]->GetValues();
+            const std::vector<double>& actual_values = *actual[i]->GetValues();
+            BOOST_REQUIRE_EQUAL(actual_values.size(), expected_values.size());
+            BOOST_CHECK(std::memcmp(actual_values.data(), expected_values.data(),
+                                    actual_values.size() * sizeof(double)) == 0);
+        }
+    }
+
+    QTemporaryFile file;
+    GuiResultsProcessor processor;
+    StandardFitResultsModel* results_model;
+    MonteCarloResultsModel* monte_carlo_model;
+    FitSetup fit_setup;
+};
+
+//! Ergebnisse, deren Monte-Carlo-Blöcke in mehrere Teile zerlegt werden.
+struct LargeResultsFixture : ResultsFixture
+{
+    // Mit den immer gespeicherten Spalten ergeben sich Blöcke von mehr als 4 MiB.
+    LargeResultsFixture() : ResultsFixture(50000) {}
+};
+}
+
+BOOST_AUTO_TEST_SUITE(ResultsContainer_tests)
+
+BOOST_FIXTURE_TEST_CASE(WriteAndRead_CurrentVersion_RestoresResults, ResultsFixture)
+{
+    Write();
+    BOOST_CHECK(ResultsContainer::IsContainer(file.fileName()));
+
+    LoadedResults loaded(file.fileName());
+    BOOST_CHECK(loaded.setup->GetName() == "container test");
+    const auto expected = results_model->GetResultsVector();
+    const auto actual = loaded.results->GetResultsVector();
+    BOOST_REQUIRE_EQUAL(actual->size(), expected->size());
+    for (std::size_t i = 0; i < actual->size(); ++i)
+    {
+        BOOST_CHECK_EQUAL((*actual)[i]->chi_square, (*expected)[i]->chi_square);
+        BOOST_CHECK((*actual)[i]->best_estimate == (*expected)[i]->best_estimate);
+    }
+    BOOST_CHECK_EQUAL(loaded.monte_carlo->NumberOfMonteCarlos(),
+                      monte_carlo_model->NumberOfMonteCarlos());
+    CheckMonteCarloBlocks(*loaded.monte_carlo);
+}
+
+BOOST_FIXTURE_TEST_CASE(WriteAndRead_LargeBlocks_SplitIntoFramesAndRestored,
+                        LargeResultsFixture)
+{
+    Write();
+    const std::vector<std::vector<Frame>> chunks = ReadIndex(ReadFile(file.fileName()));
+    BOOST_REQUIRE_EQUAL(chunks.size(), 3);
+    BOOST_CHECK_GE(chunks[1].size(), 2u);
+    BOOST_CHECK_EQUAL(chunks[1][0].size, 1u << 22);
+
+    LoadedResults loaded(file.fileName());
+    CheckMonteCarloBlocks(*loaded.monte_carlo);
+}
+
+BOOST_FIXTURE_TEST_CASE(Read_Version1File_RestoresResults, ResultsFixture)
+{
+    Write();
+    ConvertToVersion1(file.fileName());
+
+    LoadedResults loaded(file.fileName());
+    BOOST_CHECK(loaded.setup->GetName() == "container test");
+    BOOST_CHECK_EQUAL(loaded.results->GetResultsVector()->size(), 2);
+    CheckMonteCarloBlocks(*loaded.monte_carlo);
+}
+
+BOOST_FIXTURE_TEST_CASE(Read_SummaryStatisticsStored_SummaryWithoutLoadingBlocks, ResultsFixture)
+{
+    Write();
+    LoadedResults loaded(file.fileName());
+    MonteCarloResultsModel& monte_carlo = *loaded.monte_carlo;
+    monte_carlo.SetOriginalResults(loaded.results->GetResultsVector());
+    monte_carlo_model->SetOriginalResults(results_model->GetResultsVector());
+    BOOST_CHECK(monte_carlo.AreSummaryStatisticsStored());
+
+    BOOST_REQUIRE_EQUAL(monte_carlo.columnCount(), monte_carlo_model->columnCount());
+    for (int row = 0; row < monte_carlo.rowCount(); ++row)
+        for (int column = 0; column < monte_carlo.columnCount(); ++column)
+        {
+            HistogramData expected = qvariant_cast<HistogramData>(
+                    monte_carlo_model->index(row, column).data());
+            HistogramData actual = qvariant_cast<HistogramData>(
+                    monte_carlo.index(row, column).data());
+            if (SharedHistogramData1D* data = boost::get<SharedHistogramData1D>(&actual))
+            {
+                const DataStatistics& statistics = (*data)->CalcStatistics();
+                const DataStatistics& expected_statistics =
+                        boost::get<SharedHistogramData1D>(expected)->CalcStatistics();
+                BOOST_CHECK_EQUAL(statistics.n, expected_statistics.n);
+                BOOST_CHECK_EQUAL(statistics.mean, expected_statistics.mean);
+                BOOST_CHECK_EQUAL(statistics.sum_of_squares, expected_statistics.sum_of_squares);
+            }
+            else
+            {
+                const DataCoStatistics& statistics =
+                        boost::get<SharedHistogramData2D>(actual)->CalcStatistics();
+                const DataCoStatistics& expected_statistics =
+                        boost::get<SharedHistogramData2D>(expected)->CalcStatistics();
+                BOOST_CHECK_EQUAL(statistics.x.mean, expected_statistics.x.mean);
+                BOOST_CHECK_EQUAL(statistics.y.mean, expected_statistics.y.mean);
+                BOOST_CHECK_EQUAL(statistics.sum_of_products,
+                                  expected_statistics.sum_of_products);
+            }
+        }
+    // Die Zusammenfassung benötigt keinen der Blöcke.
+    for (const auto& block : monte_carlo.GetDataBlocks())
+        BOOST_CHECK(!block->IsLoaded());
+
+    // Nach einer Maskenänderung gelten die gespeicherten Kenngrößen nicht mehr.
+    HistogramData data = qvariant_cast<HistogramData>(monte_carlo.index(0, 0).data());
+    HistogramDataBase::GetBase(data)->InvertMask();
+    BOOST_CHECK(!monte_carlo.AreSummaryStatisticsStored());
+}
+
+BOOST_FIXTURE_TEST_CASE(LoadBlock_FileReplacedAfterReading_Throws, ResultsFixture)
+{
+    Write();
+    LoadedResults loaded(file.fileName());
+
+    // Beim erneuten Speichern erhält die Datei eine neue Kennung.
+    Write();
+
+    const auto blocks = loaded.monte_carlo->GetDataBlocks();
+    BOOST_REQUIRE(!blocks.empty());
+    BOOST_CHECK_THROW(blocks.front()->GetValues(), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(LoadBlock_CorruptFrame_ThrowsFromParallelDecompression,
+                        LargeResultsFixture)
+{
+    Write();
+    std::string container = ReadFile(file.fileName());
+    const std::vector<std::vector<Frame>> chunks = ReadIndex(container);
+    BOOST_REQUIRE_GE(chunks[1].size(), 2u);
+    // Ungültiger zlib-Header im zweiten Teil.
+    container[chunks[1][1].offset] = '\xff';
+    container[chunks[1][1].offset + 1] = '\xff';
+    WriteFile(file.fileName(), container);
+
+    LoadedResults loaded(file.fileName());
+    const auto blocks = loaded.monte_carlo->GetDataBlocks();
+    BOOST_CHECK_THROW(blocks[0]->GetValues(), std::exception);
+    BOOST_CHECK_NO_THROW(blocks[1]->GetValues());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <QTemporaryFile>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "fitsetup.h"
+#include "montecarloresultsmodel.h"
+#include "resultscontainer.h"
+#include "resultsfilereader.h"
+#include "standardfitresultsmodel.h"
+
+namespace
+{
+//! Stellt eine temporäre Datei bereit, die die Tests beschreiben.
+struct TemporaryFileFixture
+{
+    TemporaryFileFixture()
+    {
+        BOOST_REQUIRE(file.open());
+        filename = file.fileName();
+    }
+
+    void WriteFile(const std::string& contents) const
+    {
+        std::ofstream ofs(filename.toLocal8Bit().constData(),
+                          std::ios_base::binary | std::ios_base::trunc);
+        ofs.write(contents.data(), contents.size());
+        BOOST_REQUIRE(ofs);
+    }
+
+    ResultsFileReader::Format DetectFormat() const
+    {
+        return ResultsFileReader::DetectFormat(filename);
+    }
+
+    QTemporaryFile file;
+    QString filename;
+};
+
+std::string SaveFitSetup(bool binary)
+{
+    FitSetup fit_setup;
+    const FitSetup* saved = &fit_setup;
+    std::ostringstream oss;
+    if (binary)
+    {
+        boost::archive::binary_oarchive oa(oss);
+        oa << saved;
+    }
+    else
+    {
+        boost::archive::text_oarchive oa(oss);
+        oa << saved;
+    }
+    return oss.str();
+}
+
+std::string Compress(const std::string& data)
+{
+    std::string compressed;
+    boost::iostreams::filtering_ostream f;
+    f.push(boost::iostreams::zlib_compressor());
+    f.push(boost::iostreams::back_inserter(compressed));
+    f.write(data.data(), data.size());
+    f.reset();
+    return compressed;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(ResultsFileReader_tests, TemporaryFileFixture)
+
+BOOST_AUTO_TEST_CASE(DetectFormat_Container_Container)
+{
+    StandardFitResultsModel results_model({}, {}, {});
+    MonteCarloResultsModel monte_carlo_model({}, {}, {}, 0);
+    FitSetup fit_setup;
+    ResultsContainer::Write(filename, &results_model, &monte_carlo_model, &fit_setup);
+
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::CONTAINER);
+}
+
+BOOST_AUTO_TEST_CASE(DetectFormat_BinaryArchive_BinaryArchive)
+{
+    WriteFile(SaveFitSetup(true));
+
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::BINARY_ARCHIVE);
+}
+
+BOOST_AUTO_TEST_CASE(DetectFormat_TextArchive_PortableArchive)
+{
+    WriteFile(SaveFitSetup(false));
+
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::PORTABLE_ARCHIVE);
+}
+
+BOOST_AUTO_TEST_CASE(DetectFormat_CompressedTextArchive_CompressedPortableArchive)
+{
+    WriteFile(Compress(SaveFitSetup(false)));
+
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::COMPRESSED_PORTABLE_ARCHIVE);
+}
+
+BOOST_AUTO_TEST_CASE(DetectFormat_TruncatedHeaders_Unknown)
+{
+    // Kürzer als die Kennung des Containers.
+    WriteFile("PANGARC");
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::UNKNOWN);
+
+    // Archive, die vor dem Ende der Signatur abbrechen.
+    WriteFile(SaveFitSetup(true).substr(0, 12));
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::UNKNOWN);
+    WriteFile(SaveFitSetup(false).substr(0, 12));
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::UNKNOWN);
+
+    WriteFile("");
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::UNKNOWN);
+}
+
+BOOST_AUTO_TEST_CASE(DetectFormat_OtherFiles_Unknown)
+{
+    WriteFile("# Not a results file\n");
+    BOOST_CHECK(DetectFormat() == ResultsFileReader::Format::UNKNOWN);
+
+    BOOST_CHECK(ResultsFileReader::DetectFormat(filename + ".missing") ==
+                ResultsFileReader::Format::UNKNOWN);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
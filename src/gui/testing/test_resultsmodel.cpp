@@ -21,6 +21,8 @@
 
 #include <boost/math/distributions.hpp>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -28,10 +30,13 @@
 
 #include <QString>
 
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include "core/fitting/fitresults.h"
+#include "core/misc/rundata.h"
 #include "standardfitresultsmodel.h"
 
 #include "core/testing/fitting/fitresults_mock.h"
@@ -418,4 +423,156 @@ BOOST_AUTO_TEST_CASE(headerData_RequestAtDifferentCols_ReturnAppropriateHeaders)
                               toStdString());
 }
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_SUITE_END()
+namespace
+{
+//! Spalten bei zwei Parametern und fünf Gasen.
+const int CHI_SQUARE_COLUMN = 1;
+const int PROBABILITY_COLUMN = 2;
+const int MEASURED_HE_COLUMN = 38;
+const int MEASURED_XE_COLUMN = 46;
+const int MEASURED_XE_ERROR_COLUMN = 47;
+
+//! Fitergebnis mit gemessenem He, aber ohne Xe. Anders als MockFitResults serialisierbar.
+boost::shared_ptr<FitResults> CreateResults(double chi_square)
+{
+    auto results = boost::make_shared<FitResults>();
+    results->chi_square = chi_square;
+    results->best_estimate = Eigen::Vector2d(1., 2.);
+    results->deviations = Eigen::Vector2d(0.1, 0.2);
+    results->covariance_matrix = 0.01 * Eigen::Matrix2d::Identity();
+    results->n_iterations = 0;
+    results->degrees_of_freedom = 1;
+    results->equilibrium_concentrations.resize(1);
+    results->model_concentrations.resize(1);
+    results->measured_concentrations.resize(1);
+    for (GasType gas = Gas::begin; gas != Gas::end; ++gas)
+    {
+        results->equilibrium_concentrations[0][gas] = Data(0, 0);
+        results->model_concentrations      [0][gas] = Data(0, 0);
+    }
+    results->measured_concentrations[0][Gas::HE] = Data(3., 0.3);
+    return results;
+}
+
+struct StandardFitResultsModelValuesFixture
+{
+    StandardFitResultsModelValuesFixture() :
+        model({"X", "Y"}, {"A", "B"}, {Gas::HE, Gas::NE, Gas::AR, Gas::KR, Gas::XE})
+    {
+    }
+
+    void ProcessResults(double chi_square)
+    {
+        model.ProcessResult(CreateResults(chi_square), {"X"}, {"A", "B"}, {});
+    }
+
+    double GetValue(int row, int column) const
+    {
+        return model.data(model.index(row, column)).toDouble();
+    }
+
+    StandardFitResultsModel model;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(StandardFitResultsModel_values_tests,
+                         StandardFitResultsModelValuesFixture)
+
+BOOST_AUTO_TEST_CASE(ProcessResult_SecondResult_ValuesOfBothRows)
+{
+    ProcessResults(1.);
+    BOOST_CHECK_CLOSE(GetValue(0, CHI_SQUARE_COLUMN), 1., 1e-10);
+
+    ProcessResults(2.);
+    BOOST_CHECK_CLOSE(GetValue(0, CHI_SQUARE_COLUMN), 1., 1e-10);
+    BOOST_CHECK_CLOSE(GetValue(1, CHI_SQUARE_COLUMN), 2., 1e-10);
+    BOOST_CHECK(GetValue(0, PROBABILITY_COLUMN) > GetValue(1, PROBABILITY_COLUMN));
+}
+
+BOOST_AUTO_TEST_CASE(AddUnusedConcentrations_UnusedGas_ValuesRecalculated)
+{
+    ProcessResults(1.);
+    ProcessResults(2.);
+    BOOST_CHECK(GetValue(1, MEASURED_XE_COLUMN) != 5.);
+
+    RunData run_data;
+    for (const std::string& name : {"X", "Y"})
+    {
+        SampleConcentrations concentrations;
+        concentrations[Gas::HE] = Data(4., 0.4);
+        concentrations[Gas::XE] = Data(5., 0.5);
+        run_data.Add(std::make_pair(name, concentrations));
+    }
+    model.AddUnusedConcentrations(run_data);
+
+    for (int row = 0; row < 2; ++row)
+    {
+        BOOST_CHECK_CLOSE(GetValue(row, MEASURED_XE_COLUMN), 5., 1e-10);
+        BOOST_CHECK_CLOSE(GetValue(row, MEASURED_XE_ERROR_COLUMN), 0.5, 1e-10);
+        // Bereits gemessene Gase bleiben unverändert.
+        BOOST_CHECK_CLOSE(GetValue(row, MEASURED_HE_COLUMN), 3., 1e-10);
+    }
+    BOOST_CHECK_CLOSE(GetValue(1, CHI_SQUARE_COLUMN), 2., 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(load_SavedModel_ValuesRecalculated)
+{
+    ProcessResults(1.);
+    ProcessResults(2.);
+
+    std::stringstream archive;
+    {
+        const StandardFitResultsModel* saved = &model;
+        boost::archive::binary_oarchive oa(archive);
+        oa << saved;
+    }
+    StandardFitResultsModel* loaded_ptr = nullptr;
+    {
+        boost::archive::binary_iarchive ia(archive);
+        ia >> loaded_ptr;
+    }
+    std::unique_ptr<StandardFitResultsModel> loaded(loaded_ptr);
+
+    BOOST_REQUIRE_EQUAL(loaded->rowCount(), 2);
+    for (int row = 0; row < 2; ++row)
+        for (int column : {CHI_SQUARE_COLUMN, PROBABILITY_COLUMN, MEASURED_HE_COLUMN})
+            BOOST_CHECK_CLOSE(loaded->data(loaded->index(row, column)).toDouble(),
+                              GetValue(row, column), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(data_SeveralStartingPoints_ToolTipListsLocalMinima)
+{
+    ProcessResults(1.);
+    boost::shared_ptr<FitResults> results = CreateResults(2.);
+    results->local_minima.push_back(LocalMinimum{2., Eigen::Vector2d(1., 2.)});
+    results->local_minima.push_back(LocalMinimum{7., Eigen::Vector2d(3., 4.)});
+    results->n_starts_completed = 3;
+    results->n_starts_pruned = 1;
+    model.ProcessResult(results, {"Y"}, {"A", "B"}, {});
+
+    const QModelIndex single_start = model.index(0, CHI_SQUARE_COLUMN);
+    BOOST_CHECK(!model.data(single_start, Qt::ToolTipRole).isValid());
+
+    const QModelIndex multi_start = model.index(1, CHI_SQUARE_COLUMN);
+    const QString tool_tip = model.data(multi_start, Qt::ToolTipRole).toString();
+    BOOST_CHECK(tool_tip.startsWith("2 distinct minima from 4 starting points"));
+    BOOST_CHECK(tool_tip.contains("χ²=7: A=3, B=4"));
+
+    std::stringstream archive;
+    {
+        const StandardFitResultsModel* saved = &model;
+        boost::archive::binary_oarchive oa(archive);
+        oa << saved;
+    }
+    StandardFitResultsModel* loaded_ptr = nullptr;
+    {
+        boost::archive::binary_iarchive ia(archive);
+        ia >> loaded_ptr;
+    }
+    std::unique_ptr<StandardFitResultsModel> loaded(loaded_ptr);
+    BOOST_CHECK(loaded->data(loaded->index(1, CHI_SQUARE_COLUMN), Qt::ToolTipRole).toString() ==
+                tool_tip);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
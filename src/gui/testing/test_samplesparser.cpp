@@ -0,0 +1,105 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+#include "samplesparser.h"
+
+namespace
+{
+void Parse(SamplesParser& parser, const std::string& text)
+{
+    parser.Parse(text.data(), text.data() + text.size());
+}
+}
+
+BOOST_AUTO_TEST_SUITE(SamplesParser_tests)
+
+BOOST_AUTO_TEST_CASE(Parse_CommaAndTabSeparatedLines_ReadsAllConcentrations)
+{
+    SamplesParser parser;
+    Parse(parser,
+          "# comment\n"
+          "A,1,0.1,2,0.2,3,0.3,4,0.4,5,0.5\r\n"
+          "\n"
+          "B\t1e-8\t2e-10\t \t\t3\t0.3\t4\t0.4\t5\t0.5\r"
+          "C,1,0.1,2,0.2,3,0.3,4,0.4,5,0.5");
+
+    const auto& samples = parser.GetSamples();
+    BOOST_REQUIRE_EQUAL(samples.size(), 3u);
+    BOOST_CHECK(parser.GetMalformedLines().empty());
+
+    BOOST_CHECK_EQUAL(samples[0].first, "A");
+    BOOST_CHECK_EQUAL(samples[0].second.size(), 5u);
+    BOOST_CHECK_EQUAL(samples[0].second.at(Gas::XE).value, 5.);
+    BOOST_CHECK_EQUAL(samples[0].second.at(Gas::XE).error, 0.5);
+
+    // Leere Felder lassen das Gas weg.
+    BOOST_CHECK_EQUAL(samples[1].first, "B");
+    BOOST_CHECK_EQUAL(samples[1].second.size(), 4u);
+    BOOST_CHECK(!samples[1].second.count(Gas::NE));
+    BOOST_CHECK_EQUAL(samples[1].second.at(Gas::HE).value, 1e-8);
+
+    BOOST_CHECK_EQUAL(samples[2].first, "C");
+}
+
+BOOST_AUTO_TEST_CASE(Parse_MalformedLines_ReportsLineNumbers)
+{
+    SamplesParser parser;
+    Parse(parser,
+          "A,1,0.1,2,0.2,3,0.3,4,0.4,5,0.5\r\n"
+          "B,1,0.1\r\n"
+          "C,1,0.1,2,0.2,3,0.3,4,0.4,5,0.5\r\n"
+          "D,1,0.1,2,0.2,3,0.3,4,0.4,5,0.5,6\r\n");
+
+    BOOST_CHECK_EQUAL(parser.GetSamples().size(), 2u);
+    const auto& malformed_lines = parser.GetMalformedLines();
+    BOOST_REQUIRE_EQUAL(malformed_lines.size(), 2u);
+    BOOST_CHECK_EQUAL(malformed_lines[0].line_number, 2u);
+    BOOST_CHECK_EQUAL(malformed_lines[1].line_number, 4u);
+}
+
+BOOST_AUTO_TEST_CASE(Parse_TextLargerThanOneChunk_KeepsOrderAndLineNumbers)
+{
+    const unsigned n_lines = 3 * SamplesParser::CHUNK_SIZE / 30;
+    std::string text;
+    for (unsigned i = 0; i < n_lines; ++i)
+    {
+        if (i % 1000 == 999)
+            text += "malformed\r\n";
+        else
+            text += std::to_string(i) + ",1,0.1,2,0.2,3,0.3,4,0.4,5,0.5\r\n";
+    }
+
+    SamplesParser parser;
+    Parse(parser, text);
+
+    const auto& samples = parser.GetSamples();
+    const auto& malformed_lines = parser.GetMalformedLines();
+    BOOST_REQUIRE_EQUAL(samples.size() + malformed_lines.size(), n_lines);
+    for (unsigned i = 0, j = 0; i < n_lines; ++i)
+        if (i % 1000 != 999)
+            BOOST_REQUIRE_EQUAL(samples[j++].first, std::to_string(i));
+    for (unsigned i = 0; i < malformed_lines.size(); ++i)
+        BOOST_CHECK_EQUAL(malformed_lines[i].line_number, 1000u * (i + 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
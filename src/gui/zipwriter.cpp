@@ -0,0 +1,133 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include <QIODevice>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "zipwriter.h"
+
+ZipWriter::ZipWriter(QIODevice& device, std::uint64_t size_limit) :
+    device_(device),
+    size_limit_(std::min<std::uint64_t>(size_limit,
+                                        std::numeric_limits<std::uint32_t>::max())),
+    entries_(),
+    crc_(),
+    entry_size_(0)
+{
+}
+
+void ZipWriter::BeginEntry(const std::string& name)
+{
+    if (entries_.size() >= std::numeric_limits<std::uint16_t>::max())
+        throw std::runtime_error("Zip archives without Zip64 cannot hold more than "
+                                 "65535 entries.");
+    if (name.size() > std::numeric_limits<std::uint16_t>::max())
+        throw std::runtime_error("Zip entry name too long.");
+
+    entries_.push_back({name, 0, 0, static_cast<std::uint32_t>(device_.pos())});
+    crc_.reset();
+    entry_size_ = 0;
+    Write(LocalHeader(entries_.back()));
+}
+
+void ZipWriter::WriteToEntry(const void* data, std::size_t size)
+{
+    Write(data, size);
+    crc_.process_bytes(data, size);
+    entry_size_ += size;
+}
+
+void ZipWriter::EndEntry()
+{
+    Entry& entry = entries_.back();
+    entry.crc = crc_.checksum();
+    // Das Archiv ist nicht größer als size_limit_, also auch der Eintrag nicht.
+    entry.size = static_cast<std::uint32_t>(entry_size_);
+    const qint64 end = device_.pos();
+    device_.seek(entry.offset);
+    Write(LocalHeader(entry));
+    device_.seek(end);
+}
+
+void ZipWriter::Finish()
+{
+    const std::uint32_t directory_offset = static_cast<std::uint32_t>(device_.pos());
+    std::string directory;
+    for (const auto& entry : entries_)
+    {
+        AppendLittleEndian<std::uint32_t>(directory, 0x02014b50);
+        AppendLittleEndian<std::uint16_t>(directory, 20);
+        AppendCommonFields(directory, entry);
+        AppendLittleEndian<std::uint16_t>(directory, 0); // Kommentarlänge
+        AppendLittleEndian<std::uint16_t>(directory, 0); // Startdiskette
+        AppendLittleEndian<std::uint16_t>(directory, 0); // interne Attribute
+        AppendLittleEndian<std::uint32_t>(directory, 0); // externe Attribute
+        AppendLittleEndian<std::uint32_t>(directory, entry.offset);
+        directory += entry.name;
+    }
+    std::string end_record;
+    AppendLittleEndian<std::uint32_t>(end_record, 0x06054b50);
+    AppendLittleEndian<std::uint16_t>(end_record, 0);
+    AppendLittleEndian<std::uint16_t>(end_record, 0);
+    AppendLittleEndian<std::uint16_t>(end_record, entries_.size());
+    AppendLittleEndian<std::uint16_t>(end_record, entries_.size());
+    AppendLittleEndian<std::uint32_t>(end_record, directory.size());
+    AppendLittleEndian<std::uint32_t>(end_record, directory_offset);
+    AppendLittleEndian<std::uint16_t>(end_record, 0);
+    Write(directory + end_record);
+}
+
+void ZipWriter::AppendCommonFields(std::string& out, const Entry& entry)
+{
+    AppendLittleEndian<std::uint16_t>(out, 20);      // benötigte Version
+    AppendLittleEndian<std::uint16_t>(out, 0x0800);  // Namen in UTF-8
+    AppendLittleEndian<std::uint16_t>(out, 0);       // nicht komprimiert
+    AppendLittleEndian<std::uint16_t>(out, 0);       // Uhrzeit
+    AppendLittleEndian<std::uint16_t>(out, 0x21);    // 1.1.1980
+    AppendLittleEndian<std::uint32_t>(out, entry.crc);
+    AppendLittleEndian<std::uint32_t>(out, entry.size);
+    AppendLittleEndian<std::uint32_t>(out, entry.size);
+    AppendLittleEndian<std::uint16_t>(out, entry.name.size());
+    AppendLittleEndian<std::uint16_t>(out, 0);       // Länge des Extrafelds
+}
+
+std::string ZipWriter::LocalHeader(const Entry& entry)
+{
+    std::string header;
+    AppendLittleEndian<std::uint32_t>(header, 0x04034b50);
+    AppendCommonFields(header, entry);
+    header += entry.name;
+    return header;
+}
+
+void ZipWriter::Write(const std::string& data)
+{
+    Write(data.data(), data.size());
+}
+
+void ZipWriter::Write(const void* data, std::size_t size)
+{
+    if (std::uint64_t(device_.pos()) + size > size_limit_)
+        throw std::runtime_error("Zip archives without Zip64 cannot be larger than 4 GiB.");
+    if (device_.write(static_cast<const char*>(data), size) != qint64(size))
+        throw std::runtime_error("Could not write the Zip archive: " +
+                                 std::string(device_.errorString().toUtf8().constData()));
+}
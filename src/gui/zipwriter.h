@@ -0,0 +1,93 @@
+// Copyright © 2014 Michael Jung
+// 
+// This file is part of Panga.
+// 
+// Panga is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// Panga is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with Panga.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include <boost/crc.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+class QIODevice;
+
+//! Hängt value in Little-Endian-Byte-Reihenfolge an out an.
+template<class T>
+void AppendLittleEndian(std::string& out, T value)
+{
+    for (unsigned i = 0; i < sizeof(T); ++i)
+        out += static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xff);
+}
+
+//! Schreibt ein unkomprimiertes Zip-Archiv, dessen Einträge nacheinander gestreamt werden.
+/*!
+  Prüfsumme und Größe eines Eintrags werden nach dem Schreiben seiner Daten in den
+  lokalen Header eingetragen. Zip64 wird nicht unterstützt: Das Archiv darf höchstens
+  4 GiB groß werden und 65535 Einträge enthalten. Beides wird vor dem Schreiben geprüft,
+  sodass bei Überschreitung std::runtime_error geworfen wird, ohne ein Archiv mit
+  abgeschnittenen Positionsangaben zu erzeugen.
+  */
+class ZipWriter
+{
+public:
+    //! Konstruktor.
+    /*!
+      \param device Geöffnetes Gerät, in das geschrieben wird. Es muss wahlfreien Zugriff
+        erlauben.
+      \param size_limit Maximale Größe des Archivs in Bytes.
+      */
+    explicit ZipWriter(QIODevice& device,
+                       std::uint64_t size_limit = std::numeric_limits<std::uint32_t>::max());
+
+    void BeginEntry(const std::string& name);
+    void WriteToEntry(const void* data, std::size_t size);
+    void EndEntry();
+
+    //! Schreibt das zentrale Verzeichnis. Danach dürfen keine Einträge mehr folgen.
+    void Finish();
+
+private:
+    struct Entry
+    {
+        std::string name;
+        std::uint32_t crc;
+        std::uint32_t size;
+        std::uint32_t offset;
+    };
+
+    //! Felder ab "benötigte Version", die lokaler und zentraler Header gemeinsam haben.
+    static void AppendCommonFields(std::string& out, const Entry& entry);
+
+    static std::string LocalHeader(const Entry& entry);
+
+    void Write(const std::string& data);
+
+    //! Schreibt an die aktuelle Position. Wirft, falls das Archiv size_limit_ überschreiten würde.
+    void Write(const void* data, std::size_t size);
+
+    QIODevice& device_;
+    const std::uint64_t size_limit_;
+    std::vector<Entry> entries_;
+    boost::crc_32_type crc_;
+    std::uint64_t entry_size_;
+};
+
+#endif // ZIPWRITER_H